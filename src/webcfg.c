@@ -87,6 +87,9 @@ static int g_cloud_forcesync_retry_started = 0;
 /*                             Function Prototypes                            */
 /*----------------------------------------------------------------------------*/
 void *WebConfigMultipartTask(void *status);
+static void *WebConfigDBInitTask(void *start);
+static void logStartupPhase(const char *phase, struct timespec *start);
+static void waitSyncBackoff(int backoff);
 /*----------------------------------------------------------------------------*/
 /*                             External Functions                             */
 /*----------------------------------------------------------------------------*/
@@ -120,29 +123,55 @@ void *WebConfigMultipartTask(void *status)
 	int value = 0;
 	int wait_flag = 1;
 	int maintenance_count = 0;
+	long long sync_retry_time = 0;
+	long long next_retry = 0;
 	time_t t;
 	struct timespec ts;
+	struct timespec boot_start;
+	pthread_t dbThreadId;
+	int db_err = 0;
 	Status = (unsigned long)status;
 
+	clock_gettime(CLOCK_MONOTONIC, &boot_start);
+
+	//DB decode does not depend on the other init steps, load it in parallel.
+	WebcfgDebug("initDB %s\n", WEBCFG_DB_FILE);
+	db_err = pthread_create(&dbThreadId, NULL, WebConfigDBInitTask, (void *) &boot_start);
+	if(db_err != 0)
+	{
+		WebcfgError("Error creating WebConfigDBInitTask thread :[%s], load DB inline\n", strerror(db_err));
+		WebConfigDBInitTask((void *) &boot_start);
+	}
+
 	initWebcfgProperties(WEBCFG_PROPERTIES_FILE);
+	//Apply later edits of the properties file without a restart.
+	initWebcfgPropertiesWatcher(WEBCFG_PROPERTIES_FILE);
+	logStartupPhase("properties", &boot_start);
 
 	//start webconfig notification thread.
 	initWebConfigNotifyTask();
+	logStartupPhase("notify_task", &boot_start);
 
 #ifdef FEATURE_SUPPORT_AKER
 	WebcfgInfo("FEATURE_SUPPORT_AKER initWebConfigClient\n");
 	initWebConfigClient();
+	logStartupPhase("aker_client", &boot_start);
 #endif
-	WebcfgDebug("initDB %s\n", WEBCFG_DB_FILE);
-
-	initDB(WEBCFG_DB_FILE);
 
 	//To disable supplementary sync for RDKV platforms
 #if (!defined(RDK_PERSISTENT_PATH_VIDEO) && !defined(FEATURE_SUPPORT_MQTTCM))
 
 	initMaintenanceTimer();
+	logStartupPhase("maintenance_timer", &boot_start);
 #endif
 
+	//Events update DB and tmp lists, so DB load must complete before event processing starts.
+	if(db_err == 0)
+	{
+		pthread_join(dbThreadId, NULL);
+	}
+	logStartupPhase("db_ready", &boot_start);
+
 	//The event handler intialisation is disabled in RDKV platforms as blob type is not applicable
 	if(get_global_eventFlag() == 0)
 	{
@@ -150,10 +179,12 @@ void *WebConfigMultipartTask(void *status)
 		initEventHandlingTask();
 		processWebcfgEvents();
 		set_global_eventFlag();
+		logStartupPhase("event_task", &boot_start);
 	}
 
 	WebcfgInfo("Webconfig is ready to process requests. set webcfgReady to true\n");
 	set_webcfgReady(true);
+	logStartupPhase("ready", &boot_start);
 #if !defined (FEATURE_SUPPORT_MQTTCM)
 	//For Primary sync set flag to 0
 	set_global_supplementarySync(0);
@@ -163,8 +194,11 @@ void *WebConfigMultipartTask(void *status)
 	//For supplementary sync set flag to 1
 	set_global_supplementarySync(1);
 
+	SupplementaryDocs_t *spList = NULL;
 	SupplementaryDocs_t *spDocs = NULL;
-	spDocs = get_global_spInfoHead();
+	//Walk a copy, a properties reload during the syncs frees the live list.
+	spList = copySupplementaryDocsList();
+	spDocs = spList;
 
 	while(spDocs != NULL)
 	{
@@ -175,6 +209,7 @@ void *WebConfigMultipartTask(void *status)
 		}
 		spDocs = spDocs->next;
 	}
+	freeSupplementaryDocsList(spList);
 
 	//Resetting the supplementary sync
 	set_global_supplementarySync(0);
@@ -232,8 +267,10 @@ void *WebConfigMultipartTask(void *status)
 					WEBCFG_FREE(ForceSyncTransID);
 				}
 				WebcfgDebug("Triggered Supplementary doc boot sync\n");
+				SupplementaryDocs_t *spList = NULL;
 				SupplementaryDocs_t *sp = NULL;
-				sp = get_global_spInfoHead();
+				spList = copySupplementaryDocsList();
+				sp = spList;
 
 				while(sp != NULL)
 				{
@@ -244,6 +281,7 @@ void *WebConfigMultipartTask(void *status)
 					}
 					sp = sp->next;
 				}
+				freeSupplementaryDocsList(spList);
 
 				initMaintenanceTimer();
 				maintenance_doc_sync = 0;//Maintenance trigger flag
@@ -286,16 +324,27 @@ void *WebConfigMultipartTask(void *status)
 		}
 		else
 		{
-			set_retry_timer(900);
-			set_global_retry_timestamp(0);
-			failedDocsRetry();			
-			if(get_global_retry_timestamp() != 0)
+			failedDocsRetry();
+			//Wake exactly at the earliest queued retry deadline.
+			next_retry = getNextRetryDeadline();
+			if(next_retry == 0)
+			{
+				set_retry_timer(900);
+			}
+			else
 			{
-				set_retry_timer(retrySyncSeconds());
+				set_retry_timer((next_retry > (long long)ts.tv_sec) ? (int)(next_retry - ts.tv_sec) : 0);
 			}
 			ts.tv_sec += get_retry_timer();
 			WebcfgInfo("The retry triggers at %s\n", printTime((long long)ts.tv_sec));
 		}
+		//A sync deferred after 429 or Retry-After wakes the loop before the maintenance or retry timer.
+		sync_retry_time = get_global_sync_retry_time();
+		if(sync_retry_time != 0 && ((retry_flag == 0 && maintenance_doc_sync == 0) || sync_retry_time < (long long)ts.tv_sec))
+		{
+			ts.tv_sec = sync_retry_time;
+			WebcfgInfo("The deferred sync triggers at %s\n", printTime(sync_retry_time));
+		}
 		if(get_global_webcfg_forcedsync_needed() == 1 || get_cloud_forcesync_retry_needed() == 1)
 		{
 			if(get_cloud_forcesync_retry_needed() == 1)
@@ -310,7 +359,7 @@ void *WebConfigMultipartTask(void *status)
 			wait_flag = 1;
 			rv = 0;
 		}
-		else if(retry_flag == 1 || maintenance_doc_sync == 1)
+		else if(retry_flag == 1 || maintenance_doc_sync == 1 || sync_retry_time != 0)
 		{
 			WebcfgDebug("B4 sync_condition pthread_cond_timedwait\n");
 			set_maintenanceSync(false);
@@ -378,11 +427,15 @@ void *WebConfigMultipartTask(void *status)
 		}
 		else if(rv == ETIMEDOUT && !g_shutdown)
 		{
-			if(get_doc_fail() == 1)
+			if(sync_retry_time != 0 && checkRetryTimer(sync_retry_time))
+			{
+				set_global_sync_retry_time(0);
+				forced_sync = 1;
+				WebcfgInfo("Deferred sync timer expired, trigger sync with cloud\n");
+			}
+			else if(get_doc_fail() == 1)
 			{
 				set_doc_fail(0);
-				set_retry_timer(900);
-				set_global_retry_timestamp(0);
 				failedDocsRetry();
 				WebcfgDebug("After the failedDocsRetry\n");
 			}
@@ -420,12 +473,21 @@ void *WebConfigMultipartTask(void *status)
 	pthread_cond_signal (get_global_notify_con());
 	pthread_mutex_unlock (get_global_notify_mut());
 
+#ifdef FEATURE_SUPPORT_MQTTCM
+	WebcfgDebug("MQTT workers: pthread_join\n");
+	stopMqttWorkers();
+#endif
+
 	if(get_global_eventFlag())
 	{
 		pthread_mutex_lock (get_global_event_mut());
 		pthread_cond_signal (get_global_event_con());
 		pthread_mutex_unlock (get_global_event_mut());
 
+		pthread_mutex_lock (get_global_expire_timer_mut());
+		pthread_cond_signal (get_global_expire_timer_con());
+		pthread_mutex_unlock (get_global_expire_timer_mut());
+
 		WebcfgDebug("event process thread: pthread_join\n");
 		JoinThread (get_global_process_threadid());
 
@@ -448,8 +510,7 @@ void *WebConfigMultipartTask(void *status)
 	reset_successDocCount();
 	set_maintenanceSync(false);
 	set_global_maintenance_time(0);
-	set_global_retry_timestamp(0);
-	set_retry_timer(0);
+	resetSyncBackoff();
 	set_global_supplementarySync(0);
 	set_global_webcfg_forcedsync_needed(0);
 	set_global_webcfg_forcedsync_started(0);
@@ -462,8 +523,10 @@ void *WebConfigMultipartTask(void *status)
 	delete_tmp_list();
 
 	WebcfgDebug("webcfgdb_destroy\n");
-	webcfgdb_destroy (get_global_db_node() );
+	webconfig_db_data_t *db_node = get_global_db_node();
+	set_global_db_loaded(0);
 	reset_db_node();
+	webcfgdb_destroy (db_node);
 	
 
 	WebcfgDebug("multipart_destroy\n");
@@ -611,6 +674,7 @@ void processWebconfgSync(int status, char* docname)
 	char *transaction_uuid =NULL;
 	char ct[256] = {0};
 	size_t dataSize=0;
+	int backoff = 0;
 
 	WebcfgDebug("========= Start of processWebconfgSync =============\n");
 	while(1)
@@ -629,6 +693,7 @@ void processWebconfgSync(int status, char* docname)
 			retry_count=0;
 			break;
 		}
+		set_global_retry_after(0);
 		configRet = webcfg_http_request(&webConfigData, r_count, status, &res_code, &transaction_uuid, ct, &dataSize, docname);
 		if(configRet == 0)
 		{
@@ -643,9 +708,22 @@ void processWebconfgSync(int status, char* docname)
 		{
 			WebcfgError("Failed to get webConfigData from cloud\n");
 			WEBCFG_FREE(transaction_uuid);
+			res_code = 0;
+		}
+		backoff = getSyncBackoffSeconds(res_code);
+		//Server asked to come back later, hand the retry to the main loop instead of blocking here.
+		if(get_global_retry_after() > 0 && !get_global_supplementarySync())
+		{
+			scheduleSyncRetry(backoff);
+			break;
+		}
+		WebcfgInfo("webcfg_http_request backoff is %d seconds\n", backoff);
+		waitSyncBackoff(backoff);
+		if(get_global_shutdown())
+		{
+			WebcfgInfo("Shutdown during sync backoff, exiting processWebconfgSync\n");
+			break;
 		}
-		WebcfgInfo("webcfg_http_request BACKOFF_SLEEP_DELAY_SEC is %d seconds\n", BACKOFF_SLEEP_DELAY_SEC);
-		sleep(BACKOFF_SLEEP_DELAY_SEC);
 		retry_count++;
 		r_count++;
 		if(retry_count <= 3)
@@ -674,6 +752,7 @@ int handlehttpResponse(long response_code, char *webConfigData, int retry_count,
 	if(response_code == 304)
 	{
 		WebcfgInfo("webConfig is in sync with cloud. response_code:%ld\n", response_code);
+		resetSyncBackoff();
 		getRootDocVersionFromDBCache(&db_root_version, &db_root_string, &subdocList);
 		addWebConfgNotifyMsg(NULL, db_root_version, NULL, NULL, transaction_uuid, 0, "status", 0, db_root_string, response_code);
 		if(db_root_string !=NULL)
@@ -686,6 +765,7 @@ int handlehttpResponse(long response_code, char *webConfigData, int retry_count,
 	else if(response_code == 200)
 	{
 		WebcfgDebug("webConfig is not in sync with cloud. response_code:%ld\n", response_code);
+		resetSyncBackoff();
 
 		if(webConfigData !=NULL && (strlen(webConfigData)>0))
 		{
@@ -736,6 +816,7 @@ int handlehttpResponse(long response_code, char *webConfigData, int retry_count,
 	else if(response_code == 204)
 	{
 		WebcfgInfo("No configuration available for this device. response_code:%ld\n", response_code);
+		resetSyncBackoff();
 		getRootDocVersionFromDBCache(&db_root_version, &db_root_string, &subdocList);
 		addWebConfgNotifyMsg(NULL, db_root_version, NULL, NULL, transaction_uuid, 0, "status", 0, db_root_string, response_code);
 		if(db_root_string !=NULL)
@@ -748,13 +829,19 @@ int handlehttpResponse(long response_code, char *webConfigData, int retry_count,
 	else if(response_code == 403)
 	{
 		WebcfgError("Token is expired, fetch new token. response_code:%ld\n", response_code);
-		createNewAuthToken(get_global_auth_token(), TOKEN_SIZE, get_deviceMAC(), get_global_serialNum() );
-		WebcfgDebug("createNewAuthToken done in 403 case\n");
+		//New token is created when the retry builds its request headers.
+		invalidateAuthToken();
+		WebcfgDebug("Auth token invalidated in 403 case\n");
 		err = 1;
 	}
 	else if(response_code == 429)
 	{
 		WebcfgInfo("No action required from client. response_code:%ld\n", response_code);
+		//Throttled primary sync is retried later with jittered backoff so the fleet does not return at once.
+		if(!get_global_supplementarySync())
+		{
+			scheduleSyncRetry(getSyncBackoffSeconds(response_code));
+		}
 		getRootDocVersionFromDBCache(&db_root_version, &db_root_string, &subdocList);
 		addWebConfgNotifyMsg(NULL, db_root_version, NULL, NULL, transaction_uuid, 0, "status", 0, db_root_string, response_code);
 		if(db_root_string !=NULL)
@@ -952,3 +1039,45 @@ void JoinThread (pthread_t threadId)
 		WebcfgError("Error joining thread threadId\n");
 	}
 }
+
+//Sleep out the sync backoff on sync_condition, so a forced sync or shutdown signal cuts it short.
+static void waitSyncBackoff(int backoff)
+{
+	struct timespec ts;
+	int rv = ETIMEDOUT;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += backoff;
+	pthread_mutex_lock(&sync_mutex);
+	if(!g_shutdown)
+	{
+		rv = pthread_cond_timedwait(&sync_condition, &sync_mutex, &ts);
+	}
+	pthread_mutex_unlock(&sync_mutex);
+	if(rv == 0)
+	{
+		WebcfgInfo("Sync backoff interrupted, retrying now\n");
+	}
+}
+
+static void *WebConfigDBInitTask(void *start)
+{
+	struct timespec db_start;
+
+	clock_gettime(CLOCK_MONOTONIC, &db_start);
+	initDB(WEBCFG_DB_FILE);
+	logStartupPhase("db_load", &db_start);
+	logStartupPhase("db_load_done", (struct timespec *)start);
+	return NULL;
+}
+
+//Logs elapsed time since start so the boot window before webcfgReady can be tracked.
+static void logStartupPhase(const char *phase, struct timespec *start)
+{
+	struct timespec now;
+	long elapsed_ms = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed_ms = ((now.tv_sec - start->tv_sec) * 1000) + ((now.tv_nsec - start->tv_nsec) / 1000000);
+	WebcfgInfo("Startup timeline: %s at %ld ms\n", phase, elapsed_ms);
+}
@@ -582,8 +582,7 @@ static char* parsePayloadForAkerStatus(char *payload)
 
 static void handleAkerStatus(int status, char *payload)
 {
-	char data[MAX_BUF_SIZE] = {0};
-	char *eventData = NULL;
+	webcfg_event_t event;
 	uint16_t err = 0;
 	char* result = NULL;
 	webconfig_tmp_data_t * docNode = NULL;
@@ -592,11 +591,14 @@ static void handleAkerStatus(int status, char *payload)
 	{
 		case 201:
 		case 200:
-			snprintf(data,sizeof(data),"aker,%hu,%u,ACK,%u",akerTransId,akerDocVersion,0);
+			setWebcfgEvent(&event, "aker", akerTransId, akerDocVersion, "ACK", 0);
 		break;
 		case 534:
 		case 535:
-			snprintf(data,sizeof(data),"aker,%hu,%u,NACK,%u,aker,%d,%s",akerTransId,akerDocVersion,0,status,payload);
+			setWebcfgEvent(&event, "aker", akerTransId, akerDocVersion, "NACK", 0);
+			snprintf(event.process_name, sizeof(event.process_name), "%s", "aker");
+			event.err_code = status;
+			event.failure_reason = (payload != NULL && payload[0] != '\0') ? strdup(payload) : NULL;
 		break;
 		default:
 			WebcfgError("Invalid status code %d\n",status);
@@ -614,9 +616,8 @@ static void handleAkerStatus(int status, char *payload)
 			WEBCFG_FREE(result);
 			return;
 	}
-	WebcfgDebug("data: %s\n",data);
-	eventData = data;
-	webcfgCallback(eventData, NULL);
+	WebcfgDebug("aker event: %s,%hu,%u,%s\n", event.subdoc_name, event.trans_id, event.version, event.status);
+	addEventToQueue(&event);
 }
 
 static void free_crud_message(wrp_msg_t *msg)
@@ -14,6 +14,10 @@
  * limitations under the License.
  */
 
+#include <time.h>
+#include <unistd.h>
+#include <base64.h>
+#include <cJSON.h>
 #include "webcfg_multipart.h"
 #include "webcfg_auth.h"
 #include "webcfg_generic.h"
@@ -21,6 +25,10 @@
 /*----------------------------------------------------------------------------*/
 /*                                   Macros                                   */
 /*----------------------------------------------------------------------------*/
+//Cached token is refreshed this long before its exp claim.
+#define AUTH_TOKEN_REFRESH_MARGIN_SEC	300
+//Lifetime assumed for tokens without a readable exp claim.
+#define AUTH_TOKEN_DEFAULT_TTL_SEC	600
 char webpa_auth_token[4096]={'\0'};
 char serialNum[64]={'\0'};
 /*----------------------------------------------------------------------------*/
@@ -31,10 +39,14 @@ char serialNum[64]={'\0'};
 /*                            File Scoped Variables                           */
 /*----------------------------------------------------------------------------*/
 static int flag_unk = 0;
+static time_t auth_token_expiry = 0;
+static int auth_token_create = 0;
 /*----------------------------------------------------------------------------*/
 /*                             Function Prototypes                            */
 /*----------------------------------------------------------------------------*/
 void execute_token_script(char *token, char *name, size_t len, char *mac, char *serNum);
+static time_t getAuthTokenExpiry(const char *token);
+static void updateAuthTokenExpiry(void);
 /*----------------------------------------------------------------------------*/
 /*                             External Functions                             */
 /*----------------------------------------------------------------------------*/
@@ -49,9 +61,22 @@ char* get_global_serialNum()
     return serialNum;
 }
 
+time_t get_global_auth_token_expiry()
+{
+    return auth_token_expiry;
+}
+
+//Drops the cached token after the server rejected it, the next fetch creates a new one.
+void invalidateAuthToken()
+{
+	auth_token_expiry = 0;
+	auth_token_create = 1;
+}
+
 /*
 * Fetches authorization token from the output of read script. If read script returns "ERROR"
-* it will call createNewAuthToken to create and read new token
+* it will call createNewAuthToken to create and read new token. The token is reused until
+* shortly before it expires, so the scripts only run when a new token is needed.
 */
 
 void getAuthToken()
@@ -59,6 +84,13 @@ void getAuthToken()
 	//local var to update webpa_auth_token only in success case
 	char output[4069] = {'\0'} ;
 	char *serial_number=NULL;
+
+	if((strlen(webpa_auth_token) > 0) && (time(NULL) + AUTH_TOKEN_REFRESH_MARGIN_SEC < auth_token_expiry))
+	{
+		WebcfgDebug("Using cached auth token, expires at %ld\n", (long)auth_token_expiry);
+		return;
+	}
+	auth_token_expiry = 0;
 	memset (webpa_auth_token, 0, sizeof(webpa_auth_token));
 
 	if( strlen(WEBPA_READ_HEADER) !=0 && strlen(WEBPA_CREATE_HEADER) !=0)
@@ -89,7 +121,14 @@ void getAuthToken()
 				}
 			}
 
-			if( strlen(serialNum)>0 )
+			if( strlen(serialNum)>0 && auth_token_create )
+			{
+				WebcfgInfo("Auth token was rejected, proceeding to create new token\n");
+				createNewAuthToken(webpa_auth_token, sizeof(webpa_auth_token), get_deviceMAC(), serialNum );
+				auth_token_create = 0;
+				updateAuthTokenExpiry();
+			}
+			else if( strlen(serialNum)>0 )
 			{
 				WebcfgInfo("Proceed to execute_token_script function\n");
 				execute_token_script(output, WEBPA_READ_HEADER, sizeof(output), get_deviceMAC(), serialNum);
@@ -109,6 +148,7 @@ void getAuthToken()
 					WebcfgInfo("update webpa_auth_token in success case\n");
 					webcfgStrncpy(webpa_auth_token, output, sizeof(webpa_auth_token));
 				}
+				updateAuthTokenExpiry();
 			}
 			else
 			{
@@ -153,12 +193,11 @@ void createNewAuthToken(char *newToken, size_t len, char *hw_mac, char* hw_seria
 
 void execute_token_script(char *token, char *name, size_t len, char *mac, char *serNum)
 {
-    FILE* out = NULL, *file = NULL;
+    FILE* out = NULL;
     char command[MAX_BUF_SIZE] = {'\0'};
     if(strlen(name)>0)
     {
-        file = fopen(name, "r");
-        if(file)
+        if(access(name, F_OK) == 0)
         {
             snprintf(command,sizeof(command),"%s %s %s",name,serNum,mac);
             WebcfgInfo("execute_token_script command is initiated\n");
@@ -170,7 +209,6 @@ void execute_token_script(char *token, char *name, size_t len, char *mac, char *
                 pclose(out);
                 WebcfgInfo("execute_token_script command is success\n");
             }
-            fclose(file);
         }
         else
         {
@@ -178,3 +216,88 @@ void execute_token_script(char *token, char *name, size_t len, char *mac, char *
         }
     }
 }
+
+/*----------------------------------------------------------------------------*/
+/*                             Internal functions                             */
+/*----------------------------------------------------------------------------*/
+
+//Reads the exp claim from the JWT payload, returns 0 when the token has none.
+static time_t getAuthTokenExpiry(const char *token)
+{
+	const char *start = NULL;
+	const char *end = NULL;
+	char *payload = NULL;
+	char *decoded = NULL;
+	size_t len = 0, padded = 0, size = 0, i = 0;
+	cJSON *json = NULL;
+	cJSON *exp = NULL;
+	time_t expiry = 0;
+
+	start = strchr(token, '.');
+	if(start == NULL)
+	{
+		return 0;
+	}
+	start++;
+	end = strchr(start, '.');
+	if(end == NULL || end == start)
+	{
+		return 0;
+	}
+	len = end - start;
+	padded = (len + 3) & ~((size_t)3);
+	payload = (char *)malloc(padded + 1);
+	decoded = (char *)malloc(b64_get_decoded_buffer_size(padded) + 1);
+	if(payload != NULL && decoded != NULL)
+	{
+		//JWT segments are base64url without padding.
+		for(i = 0; i < len; i++)
+		{
+			payload[i] = (start[i] == '-') ? '+' : ((start[i] == '_') ? '/' : start[i]);
+		}
+		for(; i < padded; i++)
+		{
+			payload[i] = '=';
+		}
+		payload[padded] = '\0';
+		size = b64_decode((const uint8_t *)payload, padded, (uint8_t *)decoded);
+		if(size > 0)
+		{
+			decoded[size] = '\0';
+			json = cJSON_Parse(decoded);
+			if(json != NULL)
+			{
+				exp = cJSON_GetObjectItem(json, "exp");
+				if(exp != NULL && exp->type == cJSON_Number && exp->valuedouble > 0)
+				{
+					expiry = (time_t)exp->valuedouble;
+				}
+				cJSON_Delete(json);
+			}
+		}
+	}
+	if(payload != NULL)
+	{
+		WEBCFG_FREE(payload);
+	}
+	if(decoded != NULL)
+	{
+		WEBCFG_FREE(decoded);
+	}
+	return expiry;
+}
+
+static void updateAuthTokenExpiry(void)
+{
+	if((strlen(webpa_auth_token) == 0) || (strcmp(webpa_auth_token, "ERROR") == 0))
+	{
+		auth_token_expiry = 0;
+		return;
+	}
+	auth_token_expiry = getAuthTokenExpiry(webpa_auth_token);
+	if(auth_token_expiry == 0)
+	{
+		auth_token_expiry = time(NULL) + AUTH_TOKEN_DEFAULT_TTL_SEC;
+	}
+	WebcfgInfo("Auth token cached until %ld\n", (long)auth_token_expiry);
+}
@@ -17,6 +17,7 @@
 #define WEBCFGAUTH_H
 
 #include <stdint.h>
+#include <time.h>
 #if !defined FEATURE_SUPPORT_MQTTCM
 #include <curl/curl.h>
 #endif
@@ -42,5 +43,7 @@ void getAuthToken();
 void createNewAuthToken(char *newToken, size_t len, char *hw_mac, char* hw_serial_number);
 char* get_global_auth_token();
 char* get_global_serialNum();
+time_t get_global_auth_token_expiry();
+void invalidateAuthToken();
 
 #endif
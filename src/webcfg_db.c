@@ -19,8 +19,13 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <sys/mman.h>
 #include <msgpack.h>
 #include <pthread.h>
+#include <sched.h>
 #include "webcfg_helpers.h"
 #include "webcfg_multipart.h"
 #include "webcfg_param.h"
@@ -28,10 +33,17 @@
 #include "webcfg_db.h"
 #include "webcfg_pack.h"
 #include "webcfg_timer.h"
+#if defined(WEBCONFIG_BIN_SUPPORT)
+#include "webcfg_rbus.h"
+#endif
 /*----------------------------------------------------------------------------*/
 /*                                   Macros                                   */
 /*----------------------------------------------------------------------------*/
-/* none */
+#define INTERN_NOMEM_ERR_DETAILS	"unknown_error"
+#define BLOB_CACHE_MAGIC		0x43424357	/* "WCBC" */
+#define BLOB_CACHE_VERSION		1
+#define BLOB_CACHE_MAX_SIZE		(512 * 1024)
+#define BLOB_CACHE_SUFFIX		".blob"
 
 /*----------------------------------------------------------------------------*/
 /*                               Data Structures                              */
@@ -44,6 +56,38 @@ enum {
     WD_INVALID_WD_OBJECT,
 };
 
+//On-disk layout of a cache entry, the payload follows the header.
+typedef struct blob_cache_hdr
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t etag;
+	uint32_t crc;
+	uint64_t data_size;
+} blob_cache_hdr_t;
+
+//Immutable copy of one list, shared by the snapshots published while current.
+typedef struct list_copy
+{
+	webconfig_db_data_t *db_list;
+	webconfig_tmp_data_t *tmp_list;
+	int refcount;
+} list_copy_t;
+
+//Free-form error_details shared by the tmp nodes and snapshots that hold it.
+typedef struct interned_err_detail
+{
+	char *str;
+	int refcount;
+	struct interned_err_detail *next;
+} interned_err_detail_t;
+
+typedef struct retry_doc
+{
+	char *name;
+	long long deadline;
+} retry_doc_t;
+
 enum {
     BD_OK                       = HELPERS_OK,
     BD_OUT_OF_MEMORY            = HELPERS_OUT_OF_MEMORY,
@@ -57,12 +101,36 @@ enum {
 /*----------------------------------------------------------------------------*/
 static webconfig_tmp_data_t * g_head = NULL;
 static blob_t * webcfgdb_blob = NULL;
+static unsigned long webcfgdb_blob_generation = 0;
 static webconfig_db_data_t* webcfgdb_data = NULL;
 pthread_mutex_t webconfig_db_mut=PTHREAD_MUTEX_INITIALIZER;
 pthread_mutex_t webconfig_tmp_data_mut=PTHREAD_MUTEX_INITIALIZER;
 static int numOfMpDocs = 0;
 static int success_doc_count = 0;
 static int doc_fail_flag = 0;
+//Set once initDB has run, the DB list is not authoritative before that.
+static int db_loaded = 0;
+//Published before the first list change, never freed.
+static webcfg_db_snapshot_t empty_snapshot = { NULL, NULL, 1, 1, NULL, NULL };
+//Published snapshot, holds one reference on it until replaced.
+static webcfg_db_snapshot_t *g_snapshot = &empty_snapshot;
+static unsigned long db_generation = 1;
+//Readers between loading g_snapshot and taking their reference.
+static int snapshot_readers = 0;
+static pthread_mutex_t webconfig_snapshot_mut=PTHREAD_MUTEX_INITIALIZER;
+static const char *tmp_status_str[] = { "none", "pending_apply", "pending", "success", "failed" };
+//Fixed vocabulary, never freed. Anything else is refcounted in interned_err_details.
+static const char *fixed_err_details[] = { "none", "failed_retrying", "max_retry_reached", "doc_rejected", "aker_service_unavailable", INTERN_NOMEM_ERR_DETAILS };
+static interned_err_detail_t *interned_err_details = NULL;
+static pthread_mutex_t webconfig_intern_mut=PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t webconfig_blob_cache_mut=PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t blob_cache_crc_once = PTHREAD_ONCE_INIT;
+static uint32_t blob_cache_crc_table[256];
+//Min-heap of failed docs ordered by retry deadline.
+static retry_doc_t *retry_queue = NULL;
+static int retry_queue_len = 0;
+static int retry_queue_size = 0;
+static pthread_mutex_t retry_queue_mut=PTHREAD_MUTEX_INITIALIZER;
 /*----------------------------------------------------------------------------*/
 /*                             Function Prototypes                            */
 /*----------------------------------------------------------------------------*/
@@ -72,12 +140,50 @@ int process_webcfgdb( webconfig_db_data_t *wd, msgpack_object *obj );
 int process_webcfgdbblob( blob_struct_t *bd, msgpack_object *obj );
 int process_webcfgdbblobparams( blob_data_t *e, msgpack_object_map *map );
 
+static void appendToDBList(webconfig_db_data_t *webcfgdb);
+static webconfig_db_data_t * copyDBList(webconfig_db_data_t *head);
+static webconfig_tmp_data_t * copyTmpList(webconfig_tmp_data_t *head);
+static list_copy_t * newListCopy(webconfig_db_data_t *db_list, webconfig_tmp_data_t *tmp_list);
+static list_copy_t * retainListCopy(list_copy_t *copy);
+static void releaseListCopy(list_copy_t *copy);
+static void freeListCopyNodes(webconfig_db_data_t *db_list, webconfig_tmp_data_t *tmp_list);
+static void publishSnapshot(list_copy_t *db_copy, list_copy_t *tmp_copy);
+static void publishDBList(void);
+static void publishTmpList(void);
+static void freeSnapshot(webcfg_db_snapshot_t *snap);
+static void initBlobCacheCrcTable(void);
+static uint32_t blobCacheCrc32(const char *data, size_t len);
+static int blobCachePath(const char *name, const char *suffix, char *path, size_t path_len);
+static void evictBlobCache(const char *keep);
+static void storeCommittedBlobCacheDoc(const char *docname, uint32_t version);
+static void pushRetryDoc(const char *name, long long deadline);
+static void siftDownRetryQueue(int pos);
+static WEBCFG_STATUS loadDBFile(char * db_file_path);
+
 /*----------------------------------------------------------------------------*/
 /*                             External Functions                             */
 /*----------------------------------------------------------------------------*/
 
 //To initialize the DB when DB file is present
 WEBCFG_STATUS initDB(char * db_file_path )
+{
+	WEBCFG_STATUS ret = loadDBFile(db_file_path);
+
+	set_global_db_loaded(1);
+	return ret;
+}
+
+int get_global_db_loaded(void)
+{
+	return __atomic_load_n(&db_loaded, __ATOMIC_ACQUIRE);
+}
+
+void set_global_db_loaded(int loaded)
+{
+	__atomic_store_n(&db_loaded, loaded, __ATOMIC_RELEASE);
+}
+
+static WEBCFG_STATUS loadDBFile(char * db_file_path)
 {
      FILE *fp = NULL;
      int fd ;
@@ -94,6 +200,8 @@ WEBCFG_STATUS initDB(char * db_file_path )
      if (fd == -1)
      {
 	WebcfgError("Failed to open file %s\n", db_file_path);
+	//No DB after a factory reset, cached payloads can no longer be verified.
+	clearBlobCache();
 	return WEBCFG_FAILURE;
      }
 
@@ -155,7 +263,7 @@ WEBCFG_STATUS initDB(char * db_file_path )
          webcfgdb_destroy (dm );
      }
      WEBCFG_FREE(data);
-     generateBlob();
+     //Blob for Data param is generated on first get_DB_BLOB(), not at boot.
      return WEBCFG_SUCCESS;
      
 }
@@ -179,11 +287,20 @@ WEBCFG_STATUS addNewDocEntry(size_t count)
 }
 
 //generateBlob function is used to pack webconfig_tmp_data_t and webconfig_db_data_t
+//Blob is packed on first use and reused until the DB/tmp lists change.
 WEBCFG_STATUS generateBlob()
 {
     size_t webcfgdbBlobPackSize = -1;
     void * data = NULL;
+    webcfg_db_snapshot_t *snap = NULL;
 
+    snap = acquireDBSnapshot();
+    if((webcfgdb_blob != NULL) && (snap != NULL) && (webcfgdb_blob_generation == snap->generation))
+    {
+	WebcfgDebug("DB lists unchanged, reuse existing webcfgdb_blob\n");
+	releaseDBSnapshot(snap);
+	return WEBCFG_SUCCESS;
+    }
     if(webcfgdb_blob)
     {
 	WebcfgDebug("Delete existing webcfgdb_blob.\n");
@@ -192,9 +309,11 @@ WEBCFG_STATUS generateBlob()
 	webcfgdb_blob = NULL;
     }
     WebcfgDebug("Generate new blob\n");
-    if(webcfgdb_data != NULL || g_head != NULL)
+    if(snap != NULL && (snap->db_list != NULL || snap->tmp_list != NULL))
     {
-        webcfgdbBlobPackSize = webcfgdb_blob_pack(webcfgdb_data, g_head, &data);
+        webcfgdbBlobPackSize = webcfgdb_blob_pack(snap->db_list, snap->tmp_list, &data);
+        webcfgdb_blob_generation = snap->generation;
+        releaseDBSnapshot(snap);
         webcfgdb_blob = (blob_t *)malloc(sizeof(blob_t));
         if(webcfgdb_blob != NULL)
         {
@@ -214,6 +333,7 @@ WEBCFG_STATUS generateBlob()
     }
     else
     {
+        releaseDBSnapshot(snap);
         WebcfgError("Failed in packing blob\n");
         return WEBCFG_FAILURE;
     }
@@ -359,6 +479,7 @@ void set_global_db_node(webconfig_db_data_t *tmp)
 {
     pthread_mutex_lock (&webconfig_db_mut);
     webcfgdb_data = tmp ;
+    publishDBList();
     pthread_mutex_unlock (&webconfig_db_mut);
 }
 
@@ -375,6 +496,7 @@ void reset_db_node()
 {
 	pthread_mutex_lock (&webconfig_db_mut);
     	webcfgdb_data = NULL;
+	publishDBList();
     	pthread_mutex_unlock (&webconfig_db_mut);
 }
 
@@ -382,6 +504,7 @@ void set_global_tmp_node(webconfig_tmp_data_t *new)
 {
     pthread_mutex_lock (&webconfig_tmp_data_mut);
     g_head = new;
+    publishTmpList();
     pthread_mutex_unlock (&webconfig_tmp_data_mut);
 }
 
@@ -470,11 +593,11 @@ WEBCFG_STATUS addToTmpList()
 					WebcfgInfo("Primary sync , update global root version to tmp list\n");
 					new_node->version = get_global_root();
 				}
-				new_node->status = strdup("pending");
+				new_node->status = TMP_STATUS_PENDING;
 				//For root, isSupplementarySync is always 0 as root version is for primary sync.
 				new_node->isSupplementarySync = 0;
 				WebcfgDebug("new_node->isSupplementarySync is %d\n", new_node->isSupplementarySync);
-				new_node->error_details = strdup("none");
+				new_node->error_details = internErrorDetails("none");
 				new_node->error_code = 0;
 				new_node->trans_id = 0;
 				new_node->retry_count = 0;
@@ -495,9 +618,9 @@ WEBCFG_STATUS addToTmpList()
 					new_node->name = strdup(mp_node->name_space);
 					WebcfgDebug("mp_node->name_space is %s\n", mp_node->name_space);
 					new_node->version = mp_node->etag;
-					new_node->status = strdup("pending_apply");
+					new_node->status = TMP_STATUS_PENDING_APPLY;
 					new_node->isSupplementarySync = mp_node->isSupplementarySync;
-					new_node->error_details = strdup("none");
+					new_node->error_details = internErrorDetails("none");
 					new_node->error_code = 0;
 					new_node->trans_id = 0;
 					new_node->retry_count = 0;
@@ -506,7 +629,7 @@ WEBCFG_STATUS addToTmpList()
 
 					WebcfgDebug("new_node->name is %s\n", new_node->name);
 					WebcfgDebug("new_node->version is %lu\n", (long)new_node->version);
-					WebcfgDebug("new_node->status is %s\n", new_node->status);
+					WebcfgDebug("new_node->status is %s\n", tmpStatusToString(new_node->status));
 					WebcfgDebug("new_node->isSupplementarySync is %d\n", new_node->isSupplementarySync);
 					WebcfgDebug("new_node->error_details is %s\n", new_node->error_details);
 					WebcfgDebug("new_node->retry_count is %d\n", new_node->retry_count);
@@ -525,6 +648,7 @@ WEBCFG_STATUS addToTmpList()
 			if (g_head == NULL)
 			{
 				g_head = new_node;
+				publishTmpList();
 				pthread_mutex_unlock (&webconfig_tmp_data_mut);
 			}
 			else
@@ -537,6 +661,7 @@ WEBCFG_STATUS addToTmpList()
 					temp=temp->next;
 				}
 				temp->next=new_node;
+				publishTmpList();
 				pthread_mutex_unlock (&webconfig_tmp_data_mut);
 			}
 
@@ -557,7 +682,11 @@ WEBCFG_STATUS checkDBList(char *docname, uint32_t version, char* rootstr)
 	WEBCFG_STATUS checkStatus = WEBCFG_SUCCESS;
 	checkStatus = updateDBlist(docname, version, rootstr);
 
-	if((checkStatus != WEBCFG_SUCCESS) && (checkStatus != WEBCFG_NO_CHANGE))
+	if(checkStatus == WEBCFG_SUCCESS)
+	{
+		storeCommittedBlobCacheDoc(docname, version);
+	}
+	else if(checkStatus != WEBCFG_NO_CHANGE)
 	{
 		webconfig_db_data_t * webcfgdb = NULL;
 		webcfgdb = (webconfig_db_data_t *) malloc (sizeof(webconfig_db_data_t));
@@ -577,6 +706,10 @@ WEBCFG_STATUS checkDBList(char *docname, uint32_t version, char* rootstr)
 			webcfgdb->next = NULL;
 
 			addToDBList(webcfgdb);
+			storeCommittedBlobCacheDoc(docname, version);
+#ifdef WEBCONFIG_BIN_SUPPORT
+			publishDBChangeEvent(docname, version, tmpStatusToString(TMP_STATUS_SUCCESS));
+#endif
 			if(webcfgdb->root_string !=NULL)
 			{
 				WebcfgInfo("webcfgdb->name added to DB %s webcfgdb->version %lu webcfgdb->root_string %s\n",webcfgdb->name, (long)webcfgdb->version, webcfgdb->root_string);
@@ -647,7 +780,12 @@ WEBCFG_STATUS updateDBlist(char *docname, uint32_t version, char* rootstr)
 
 			webcfgdb->version = version;
 			WebcfgDebug("webcfgdb %s is updated to version %lu webcfgdb->root_string %s with root_string %s\n", docname, (long)webcfgdb->version, webcfgdb->root_string, rootstr);
+			publishDBList();
 			pthread_mutex_unlock (&webconfig_db_mut);
+#ifdef WEBCONFIG_BIN_SUPPORT
+			//Version 0 is only written by a subdoc force reset.
+			publishDBChangeEvent(docname, version, (version == 0) ? DB_CHANGE_STATUS_RESET : tmpStatusToString(TMP_STATUS_SUCCESS));
+#endif
 			WebcfgDebug("mutex_unlock if docname is webcfgdb name\n");
 			return WEBCFG_SUCCESS;
 		}
@@ -658,7 +796,7 @@ WEBCFG_STATUS updateDBlist(char *docname, uint32_t version, char* rootstr)
 	return WEBCFG_FAILURE;
 }
 //update version, status for each doc
-WEBCFG_STATUS updateTmpList(webconfig_tmp_data_t *temp, char *docname, uint32_t version, char *status, char *error_details, uint16_t error_code, uint16_t trans_id, int retry)
+WEBCFG_STATUS updateTmpList(webconfig_tmp_data_t *temp, char *docname, uint32_t version, const char *status, const char *error_details, uint16_t error_code, uint16_t trans_id, int retry)
 {
 	if (NULL != temp)
 	{
@@ -667,19 +805,13 @@ WEBCFG_STATUS updateTmpList(webconfig_tmp_data_t *temp, char *docname, uint32_t
 		WebcfgDebug("mutex_lock in updateTmpList\n");
 		if( strcmp(docname, temp->name) == 0)
 		{
+			WEBCFG_TMP_STATUS new_status = tmpStatusFromString(status);
+			const char *old_error_details = temp->error_details;
+
 			temp->version = version;
-			if(strcmp(temp->status, status) !=0)
-			{
-				WEBCFG_FREE(temp->status);
-				temp->status = NULL;
-				temp->status = strdup(status);
-			}
-			if(strcmp(temp->error_details, error_details) !=0)
-			{
-				WEBCFG_FREE(temp->error_details);
-				temp->error_details = NULL;
-				temp->error_details = strdup(error_details);
-			}
+			temp->status = new_status;
+			temp->error_details = internErrorDetails(error_details);
+			releaseErrorDetails(old_error_details);
 			temp->error_code = error_code;
 			temp->trans_id = trans_id;
 			WebcfgDebug("updateTmpList: retry %d\n", retry);
@@ -688,7 +820,8 @@ WEBCFG_STATUS updateTmpList(webconfig_tmp_data_t *temp, char *docname, uint32_t
 				WebcfgDebug("updateTmpList: reset temp->retry_count\n");
 				temp->retry_count = 0;
 			}
-			WebcfgInfo("doc %s is updated to version %lu status %s error_details %s error_code %lu trans_id %lu temp->retry_count %d\n", docname, (long)temp->version, temp->status, temp->error_details, (long)temp->error_code, (long)temp->trans_id, temp->retry_count);
+			WebcfgInfo("doc %s is updated to version %lu status %s error_details %s error_code %lu trans_id %lu temp->retry_count %d\n", docname, (long)temp->version, tmpStatusToString(temp->status), temp->error_details, (long)temp->error_code, (long)temp->trans_id, temp->retry_count);
+			publishTmpList();
 			pthread_mutex_unlock (&webconfig_tmp_data_mut);
 			WebcfgDebug("mutex_unlock in current temp details\n");
 			return WEBCFG_SUCCESS;
@@ -737,14 +870,14 @@ WEBCFG_STATUS deleteFromTmpList(char* doc_name, webconfig_tmp_data_t **next_node
 
 			WebcfgDebug("Deleting the node entries\n");
 			WEBCFG_FREE( curr_node->name );
-			WEBCFG_FREE( curr_node->status );
-			WEBCFG_FREE( curr_node->error_details );
+			releaseErrorDetails(curr_node->error_details);
 			WEBCFG_FREE( curr_node->cloud_trans_id);
 			WEBCFG_FREE( curr_node );
 			curr_node = NULL;
 			WebcfgDebug("Deleted successfully and returning..\n");
 			numOfMpDocs =numOfMpDocs - 1;
 			WebcfgDebug("numOfMpDocs after delete is %d\n", numOfMpDocs);
+			publishTmpList();
 			pthread_mutex_unlock (&webconfig_tmp_data_mut);
 			return WEBCFG_SUCCESS;
 		}
@@ -761,23 +894,26 @@ void delete_tmp_list()
 {
    webconfig_tmp_data_t *temp = NULL;
    webconfig_tmp_data_t *head = NULL;
-   head = get_global_tmp_node();
+
+	//Detach the list under the lock, the nodes are freed after.
+	pthread_mutex_lock (&webconfig_tmp_data_mut);
+	head = g_head;
+	g_head = NULL;
+	publishTmpList();
+	pthread_mutex_unlock (&webconfig_tmp_data_mut);
 
     while(head != NULL)
     {
         temp = head;
 	head = head->next;
-	WebcfgDebug("Delete node--> temp->name %s temp->version %lu temp->status %s temp->isSupplementarySync %d temp->error_details %s temp->error_code %lu temp->trans_id %lu temp->retry_count %d temp->cloud_trans_id %s\n",temp->name, (long)temp->version, temp->status, temp->isSupplementarySync, temp->error_details, (long)temp->error_code, (long)temp->trans_id, temp->retry_count, temp->cloud_trans_id);
+	WebcfgDebug("Delete node--> temp->name %s temp->version %lu temp->status %s temp->isSupplementarySync %d temp->error_details %s temp->error_code %lu temp->trans_id %lu temp->retry_count %d temp->cloud_trans_id %s\n",temp->name, (long)temp->version, tmpStatusToString(temp->status), temp->isSupplementarySync, temp->error_details, (long)temp->error_code, (long)temp->trans_id, temp->retry_count, temp->cloud_trans_id);
+	releaseErrorDetails(temp->error_details);
 	WEBCFG_FREE(temp->name);
-	WEBCFG_FREE(temp->status);
-	WEBCFG_FREE(temp->error_details);
 	WEBCFG_FREE(temp->cloud_trans_id);
 	free(temp);
 	temp = NULL;
     }
-	pthread_mutex_lock (&webconfig_tmp_data_mut);
-    	g_head = NULL;
-	pthread_mutex_unlock (&webconfig_tmp_data_mut);
+	deleteRetryQueue();
     	WebcfgDebug("mutex_unlock Deleted all docs from tmp list\n");
 }
 
@@ -793,7 +929,7 @@ void delete_tmp_docs_list()
 	//skip root delete
 	if((strcmp(temp->name, "root") !=0) && (temp->isSupplementarySync == get_global_supplementarySync()))
 	{
-		WebcfgDebug("Delete node--> temp->name %s temp->version %lu temp->status %s temp->isSupplementarySync %d temp->error_details %s temp->error_code %lu temp->trans_id %lu temp->retry_count %d temp->cloud_trans_id %s\n",temp->name, (long)temp->version, temp->status, temp->isSupplementarySync, temp->error_details, (long)temp->error_code, (long)temp->trans_id, temp->retry_count, temp->cloud_trans_id);
+		WebcfgDebug("Delete node--> temp->name %s temp->version %lu temp->status %s temp->isSupplementarySync %d temp->error_details %s temp->error_code %lu temp->trans_id %lu temp->retry_count %d temp->cloud_trans_id %s\n",temp->name, (long)temp->version, tmpStatusToString(temp->status), temp->isSupplementarySync, temp->error_details, (long)temp->error_code, (long)temp->trans_id, temp->retry_count, temp->cloud_trans_id);
 		deleteFromTmpList(temp->name, &next_node); 
 		temp = next_node;
 		continue;
@@ -811,9 +947,9 @@ void release_success_docs_tmplist()
     WebcfgDebug("Inside release_success_docs_list()\n");
     while(temp != NULL)
     {
-	if((temp->status != NULL) && (strcmp(temp->status, "success") ==0))
+	if(temp->status == TMP_STATUS_SUCCESS)
 	{
-		WebcfgDebug("Delete node--> temp->name %s temp->version %lu temp->status %s temp->isSupplementarySync %d temp->error_details %s temp->error_code %lu temp->trans_id %lu temp->retry_count %d temp->cloud_trans_id %s\n",temp->name, (long)temp->version, temp->status, temp->isSupplementarySync, temp->error_details, (long)temp->error_code, (long)temp->trans_id, temp->retry_count, temp->cloud_trans_id);
+		WebcfgDebug("Delete node--> temp->name %s temp->version %lu temp->status %s temp->isSupplementarySync %d temp->error_details %s temp->error_code %lu temp->trans_id %lu temp->retry_count %d temp->cloud_trans_id %s\n",temp->name, (long)temp->version, tmpStatusToString(temp->status), temp->isSupplementarySync, temp->error_details, (long)temp->error_code, (long)temp->trans_id, temp->retry_count, temp->cloud_trans_id);
 		deleteFromTmpList(temp->name,&next_node);
 		temp = next_node;
 		continue;	
@@ -960,16 +1096,28 @@ int process_webcfgdb( webconfig_db_data_t *wd, msgpack_object *obj )
             else
             {
                 wd->next = NULL;
-                addToDBList(wd);
+                appendToDBList(wd);
                
             }
         }
+	pthread_mutex_lock (&webconfig_db_mut);
+	publishDBList();
+	pthread_mutex_unlock (&webconfig_db_mut);
     }
 
     return 0;
 }
 
 void addToDBList(webconfig_db_data_t *webcfgdb)
+{
+      appendToDBList(webcfgdb);
+      pthread_mutex_lock (&webconfig_db_mut);
+      publishDBList();
+      pthread_mutex_unlock (&webconfig_db_mut);
+}
+
+//Decode path appends all docs first and publishes the snapshot once.
+static void appendToDBList(webconfig_db_data_t *webcfgdb)
 {
       pthread_mutex_lock (&webconfig_db_mut); 
       if(webcfgdb_data == NULL)
@@ -1232,7 +1380,11 @@ int writebase64ToDBFile(char *base64_file_path, char *data)
 webconfig_tmp_data_t * getTmpNode(char *docname)
 {
 	webconfig_tmp_data_t *temp = NULL;
-	temp = get_global_tmp_node();
+
+	//Returns the live node, its fields change only through the locked setters
+	//(updateTmpList, updateFailureTimeStamp, incrementTmpRetryCount).
+	pthread_mutex_lock (&webconfig_tmp_data_mut);
+	temp = g_head;
 
 	//Traverse through doc list & fetch required doc.
 	while (NULL != temp)
@@ -1240,15 +1392,32 @@ webconfig_tmp_data_t * getTmpNode(char *docname)
 		WebcfgDebug("getTmpNode: temp->name %s, temp->version %lu\n",temp->name, (long)temp->version);
 		if( strcmp(docname, temp->name) == 0)
 		{
-			WebcfgDebug("subdoc node : name %s version %lu status %s error_details %s error_code %hu trans_id %hu temp->retry_count %d temp->cloud_trans_id %s\n", temp->name, (long)temp->version, temp->status, temp->error_details, temp->error_code, temp->trans_id, temp->retry_count, temp->cloud_trans_id);
+			WebcfgDebug("subdoc node : name %s version %lu status %s error_details %s error_code %hu trans_id %hu temp->retry_count %d temp->cloud_trans_id %s\n", temp->name, (long)temp->version, tmpStatusToString(temp->status), temp->error_details, temp->error_code, temp->trans_id, temp->retry_count, temp->cloud_trans_id);
+			pthread_mutex_unlock (&webconfig_tmp_data_mut);
 			return temp;
 		}
 		temp= temp->next;
 	}
+	pthread_mutex_unlock (&webconfig_tmp_data_mut);
 	WebcfgDebug("getTmpNode failed for doc %s\n", docname);
 	return NULL;
 }
 
+//Bumps retry_count under the tmp list lock and returns the new count, -1 if temp is NULL.
+int incrementTmpRetryCount(webconfig_tmp_data_t *temp)
+{
+	int count = -1;
+
+	if (NULL != temp)
+	{
+		pthread_mutex_lock (&webconfig_tmp_data_mut);
+		count = ++temp->retry_count;
+		publishTmpList();
+		pthread_mutex_unlock (&webconfig_tmp_data_mut);
+	}
+	return count;
+}
+
 //update retry_timestamp for each doc
 WEBCFG_STATUS updateFailureTimeStamp(webconfig_tmp_data_t *temp, char *docname, long long timestamp)
 {
@@ -1259,9 +1428,17 @@ WEBCFG_STATUS updateFailureTimeStamp(webconfig_tmp_data_t *temp, char *docname,
 		WebcfgDebug("mutex_lock in updateFailureTimeStamp\n");
 		if( strcmp(docname, temp->name) == 0)
 		{
+			//The doc already has an entry queued for this deadline.
+			int queued = (temp->retry_timestamp == timestamp);
+
 			temp->retry_timestamp = timestamp;
 			WebcfgInfo("doc %s retry timestamp updated as %s\n", docname, printTime(timestamp));
+			publishTmpList();
 			pthread_mutex_unlock (&webconfig_tmp_data_mut);
+			if(!queued)
+			{
+				pushRetryDoc(docname, timestamp);
+			}
 			WebcfgDebug("mutex_unlock in current temp details\n");
 			return WEBCFG_SUCCESS;
 		}
@@ -1271,3 +1448,788 @@ WEBCFG_STATUS updateFailureTimeStamp(webconfig_tmp_data_t *temp, char *docname,
 	WebcfgError("updateFailureTimeStamp failed as doc %s is not in tmp list\n", docname);
 	return WEBCFG_FAILURE;
 }
+
+//Pops the earliest retry entry when its deadline is at or before now, caller frees name.
+int popDueRetryDoc(long long now, char **name, long long *deadline)
+{
+	pthread_mutex_lock (&retry_queue_mut);
+	if(retry_queue_len == 0 || retry_queue[0].deadline > now)
+	{
+		pthread_mutex_unlock (&retry_queue_mut);
+		return 0;
+	}
+	*name = retry_queue[0].name;
+	*deadline = retry_queue[0].deadline;
+	retry_queue[0] = retry_queue[--retry_queue_len];
+	siftDownRetryQueue(0);
+	pthread_mutex_unlock (&retry_queue_mut);
+	return 1;
+}
+
+//Earliest queued retry deadline, 0 when nothing is queued.
+long long getNextRetryDeadline()
+{
+	long long deadline = 0;
+
+	pthread_mutex_lock (&retry_queue_mut);
+	if(retry_queue_len > 0)
+	{
+		deadline = retry_queue[0].deadline;
+	}
+	pthread_mutex_unlock (&retry_queue_mut);
+	return deadline;
+}
+
+void deleteRetryQueue()
+{
+	int i = 0;
+
+	pthread_mutex_lock (&retry_queue_mut);
+	for(i = 0; i < retry_queue_len; i++)
+	{
+		WEBCFG_FREE(retry_queue[i].name);
+	}
+	retry_queue_len = 0;
+	pthread_mutex_unlock (&retry_queue_mut);
+}
+
+/* Writers publish a new snapshot while still holding the list lock they
+ * changed, so the published view never lags behind the lists. Only the
+ * changed list is copied, the other one is shared with the old snapshot.
+ * webconfig_snapshot_mut just orders concurrent writers, readers never take it. */
+static void publishSnapshot(list_copy_t *db_copy, list_copy_t *tmp_copy)
+{
+	webcfg_db_snapshot_t *snap = NULL;
+	webcfg_db_snapshot_t *old = NULL;
+
+	snap = (webcfg_db_snapshot_t *)malloc(sizeof(webcfg_db_snapshot_t));
+	if(snap == NULL)
+	{
+		WebcfgError("Failed in memory allocation for db snapshot\n");
+		releaseListCopy(db_copy);
+		releaseListCopy(tmp_copy);
+		return;
+	}
+	memset(snap, 0, sizeof(webcfg_db_snapshot_t));
+	snap->refcount = 1;
+
+	pthread_mutex_lock (&webconfig_snapshot_mut);
+	old = g_snapshot;
+	snap->db_copy = (db_copy != NULL) ? db_copy : retainListCopy(old->db_copy);
+	snap->tmp_copy = (tmp_copy != NULL) ? tmp_copy : retainListCopy(old->tmp_copy);
+	snap->db_list = (snap->db_copy != NULL) ? snap->db_copy->db_list : NULL;
+	snap->tmp_list = (snap->tmp_copy != NULL) ? snap->tmp_copy->tmp_list : NULL;
+	snap->generation = ++db_generation;
+	__atomic_store_n(&g_snapshot, snap, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock (&webconfig_snapshot_mut);
+
+	//A reader that loaded the old pointer takes its reference before leaving.
+	while(__atomic_load_n(&snapshot_readers, __ATOMIC_SEQ_CST) != 0)
+	{
+		sched_yield();
+	}
+	WebcfgDebug("Published db snapshot generation %lu\n", snap->generation);
+	releaseDBSnapshot(old);
+}
+
+//Caller holds webconfig_db_mut.
+static void publishDBList(void)
+{
+	publishSnapshot(newListCopy(copyDBList(webcfgdb_data), NULL), NULL);
+}
+
+//Caller holds webconfig_tmp_data_mut.
+static void publishTmpList(void)
+{
+	publishSnapshot(NULL, newListCopy(NULL, copyTmpList(g_head)));
+}
+
+webcfg_db_snapshot_t * acquireDBSnapshot()
+{
+	webcfg_db_snapshot_t *snap = NULL;
+
+	__atomic_add_fetch(&snapshot_readers, 1, __ATOMIC_SEQ_CST);
+	snap = __atomic_load_n(&g_snapshot, __ATOMIC_SEQ_CST);
+	if(snap != &empty_snapshot)
+	{
+		__atomic_add_fetch(&snap->refcount, 1, __ATOMIC_SEQ_CST);
+	}
+	__atomic_sub_fetch(&snapshot_readers, 1, __ATOMIC_SEQ_CST);
+	return snap;
+}
+
+void releaseDBSnapshot(webcfg_db_snapshot_t *snap)
+{
+	if((snap == NULL) || (snap == &empty_snapshot))
+	{
+		return;
+	}
+
+	if(__atomic_sub_fetch(&snap->refcount, 1, __ATOMIC_ACQ_REL) == 0)
+	{
+		freeSnapshot(snap);
+	}
+}
+
+webconfig_tmp_data_t * getSnapshotTmpNode(webcfg_db_snapshot_t *snap, const char *docname)
+{
+	webconfig_tmp_data_t *temp = (snap != NULL) ? snap->tmp_list : NULL;
+
+	while((temp != NULL) && (strcmp(docname, temp->name) != 0))
+	{
+		temp = temp->next;
+	}
+	return temp;
+}
+
+static list_copy_t * newListCopy(webconfig_db_data_t *db_list, webconfig_tmp_data_t *tmp_list)
+{
+	list_copy_t *copy = NULL;
+
+	copy = (list_copy_t *)malloc(sizeof(list_copy_t));
+	if(copy == NULL)
+	{
+		WebcfgError("Failed in memory allocation for list copy\n");
+		freeListCopyNodes(db_list, tmp_list);
+		return NULL;
+	}
+	copy->db_list = db_list;
+	copy->tmp_list = tmp_list;
+	copy->refcount = 1;
+	return copy;
+}
+
+static list_copy_t * retainListCopy(list_copy_t *copy)
+{
+	if(copy != NULL)
+	{
+		__atomic_add_fetch(&copy->refcount, 1, __ATOMIC_RELAXED);
+	}
+	return copy;
+}
+
+static void releaseListCopy(list_copy_t *copy)
+{
+	if((copy != NULL) && (__atomic_sub_fetch(&copy->refcount, 1, __ATOMIC_ACQ_REL) == 0))
+	{
+		freeListCopyNodes(copy->db_list, copy->tmp_list);
+		free(copy);
+	}
+}
+
+static webconfig_db_data_t * copyDBList(webconfig_db_data_t *head)
+{
+	webconfig_db_data_t *copy = NULL;
+	webconfig_db_data_t **tail = &copy;
+
+	while(head != NULL)
+	{
+		webconfig_db_data_t *node = (webconfig_db_data_t *)malloc(sizeof(webconfig_db_data_t));
+		if(node == NULL)
+		{
+			WebcfgError("Failed in memory allocation for db snapshot node\n");
+			break;
+		}
+		memset(node, 0, sizeof(webconfig_db_data_t));
+		node->name = (head->name != NULL) ? strdup(head->name) : NULL;
+		node->version = head->version;
+		node->root_string = (head->root_string != NULL) ? strdup(head->root_string) : NULL;
+		*tail = node;
+		tail = &node->next;
+		head = head->next;
+	}
+	return copy;
+}
+
+static webconfig_tmp_data_t * copyTmpList(webconfig_tmp_data_t *head)
+{
+	webconfig_tmp_data_t *copy = NULL;
+	webconfig_tmp_data_t **tail = &copy;
+
+	while(head != NULL)
+	{
+		webconfig_tmp_data_t *node = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+		if(node == NULL)
+		{
+			WebcfgError("Failed in memory allocation for tmp snapshot node\n");
+			break;
+		}
+		memset(node, 0, sizeof(webconfig_tmp_data_t));
+		node->name = (head->name != NULL) ? strdup(head->name) : NULL;
+		node->cloud_trans_id = (head->cloud_trans_id != NULL) ? strdup(head->cloud_trans_id) : NULL;
+		node->version = head->version;
+		node->status = head->status;
+		node->error_details = internErrorDetails(head->error_details);
+		node->retry_count = head->retry_count;
+		node->error_code = head->error_code;
+		node->trans_id = head->trans_id;
+		node->isSupplementarySync = head->isSupplementarySync;
+		node->retry_timestamp = head->retry_timestamp;
+		*tail = node;
+		tail = &node->next;
+		head = head->next;
+	}
+	return copy;
+}
+
+static void freeListCopyNodes(webconfig_db_data_t *db_list, webconfig_tmp_data_t *tmp_list)
+{
+	webconfig_db_data_t *db = NULL;
+	webconfig_tmp_data_t *tmp = NULL;
+
+	while(db_list != NULL)
+	{
+		db = db_list;
+		db_list = db->next;
+		if(db->name != NULL)
+		{
+			free(db->name);
+		}
+		if(db->root_string != NULL)
+		{
+			free(db->root_string);
+		}
+		free(db);
+	}
+	while(tmp_list != NULL)
+	{
+		tmp = tmp_list;
+		tmp_list = tmp->next;
+		if(tmp->name != NULL)
+		{
+			free(tmp->name);
+		}
+		if(tmp->cloud_trans_id != NULL)
+		{
+			free(tmp->cloud_trans_id);
+		}
+		releaseErrorDetails(tmp->error_details);
+		free(tmp);
+	}
+}
+
+static void freeSnapshot(webcfg_db_snapshot_t *snap)
+{
+	releaseListCopy(snap->db_copy);
+	releaseListCopy(snap->tmp_copy);
+	free(snap);
+}
+
+const char * tmpStatusToString(WEBCFG_TMP_STATUS status)
+{
+	if((unsigned int)status > TMP_STATUS_FAILED)
+	{
+		return tmp_status_str[TMP_STATUS_NONE];
+	}
+	return tmp_status_str[status];
+}
+
+WEBCFG_TMP_STATUS tmpStatusFromString(const char *status)
+{
+	int i;
+
+	if(status != NULL)
+	{
+		for(i = TMP_STATUS_PENDING_APPLY; i <= TMP_STATUS_FAILED; i++)
+		{
+			if(strcmp(status, tmp_status_str[i]) == 0)
+			{
+				return (WEBCFG_TMP_STATUS)i;
+			}
+		}
+		if(strcmp(status, tmp_status_str[TMP_STATUS_NONE]) != 0)
+		{
+			WebcfgError("Invalid tmp status %s\n", status);
+		}
+	}
+	return TMP_STATUS_NONE;
+}
+
+const char * internErrorDetails(const char *error_details)
+{
+	interned_err_detail_t *entry = NULL;
+	size_t i;
+
+	if(error_details == NULL)
+	{
+		return NULL;
+	}
+
+	for(i = 0; i < sizeof(fixed_err_details)/sizeof(fixed_err_details[0]); i++)
+	{
+		if(strcmp(fixed_err_details[i], error_details) == 0)
+		{
+			return fixed_err_details[i];
+		}
+	}
+
+	pthread_mutex_lock (&webconfig_intern_mut);
+	for(entry = interned_err_details; entry != NULL; entry = entry->next)
+	{
+		if(strcmp(entry->str, error_details) == 0)
+		{
+			entry->refcount++;
+			pthread_mutex_unlock (&webconfig_intern_mut);
+			return entry->str;
+		}
+	}
+	entry = (interned_err_detail_t *)malloc(sizeof(interned_err_detail_t));
+	if(entry != NULL)
+	{
+		entry->str = strdup(error_details);
+		if(entry->str == NULL)
+		{
+			WEBCFG_FREE(entry);
+		}
+	}
+	if(entry == NULL)
+	{
+		pthread_mutex_unlock (&webconfig_intern_mut);
+		WebcfgError("Failed to intern error_details %s\n", error_details);
+		return INTERN_NOMEM_ERR_DETAILS;
+	}
+	entry->refcount = 1;
+	entry->next = interned_err_details;
+	interned_err_details = entry;
+	pthread_mutex_unlock (&webconfig_intern_mut);
+	WebcfgDebug("Interned error_details %s\n", entry->str);
+	return entry->str;
+}
+
+void releaseErrorDetails(const char *error_details)
+{
+	interned_err_detail_t *entry = NULL;
+	interned_err_detail_t **link = NULL;
+
+	if(error_details == NULL)
+	{
+		return;
+	}
+	pthread_mutex_lock (&webconfig_intern_mut);
+	//Fixed entries and strings not from internErrorDetails() are not in the list.
+	for(link = &interned_err_details; *link != NULL; link = &(*link)->next)
+	{
+		entry = *link;
+		if(entry->str == error_details)
+		{
+			if(--entry->refcount == 0)
+			{
+				*link = entry->next;
+				WEBCFG_FREE(entry->str);
+				WEBCFG_FREE(entry);
+			}
+			break;
+		}
+	}
+	pthread_mutex_unlock (&webconfig_intern_mut);
+}
+
+WEBCFG_STATUS writeBlobCacheDoc(const char *name, uint32_t etag, const char *data, size_t data_size)
+{
+	char path[256] = {'\0'};
+	char tmp_path[256] = {'\0'};
+	blob_cache_hdr_t hdr;
+	blob_cache_hdr_t old;
+	FILE *fp = NULL;
+	int fd = -1;
+	int written = 0;
+
+	if(data == NULL || data_size == 0 || (data_size + sizeof(hdr)) > BLOB_CACHE_MAX_SIZE)
+	{
+		WebcfgError("Invalid payload for blob cache\n");
+		return WEBCFG_FAILURE;
+	}
+	if(!blobCachePath(name, BLOB_CACHE_SUFFIX, path, sizeof(path)) || !blobCachePath(name, ".tmp", tmp_path, sizeof(tmp_path)))
+	{
+		WebcfgError("Invalid subdoc name for blob cache\n");
+		return WEBCFG_FAILURE;
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = BLOB_CACHE_MAGIC;
+	hdr.version = BLOB_CACHE_VERSION;
+	hdr.etag = etag;
+	hdr.crc = blobCacheCrc32(data, data_size);
+	hdr.data_size = data_size;
+
+	pthread_mutex_lock (&webconfig_blob_cache_mut);
+	//Same name, etag and content already on disk, nothing to write.
+	fd = open(path, O_RDONLY);
+	if(fd >= 0)
+	{
+		if((read(fd, &old, sizeof(old)) == (ssize_t)sizeof(old)) && (memcmp(&old, &hdr, sizeof(hdr)) == 0))
+		{
+			close(fd);
+			pthread_mutex_unlock (&webconfig_blob_cache_mut);
+			WebcfgDebug("subdoc %s etag %lu already in blob cache\n", name, (long)etag);
+			return WEBCFG_SUCCESS;
+		}
+		close(fd);
+	}
+
+	if(mkdir(WEBCFG_BLOB_CACHE_DIR, 0700) != 0 && errno != EEXIST)
+	{
+		pthread_mutex_unlock (&webconfig_blob_cache_mut);
+		WebcfgError("Failed to create %s, %s\n", WEBCFG_BLOB_CACHE_DIR, strerror(errno));
+		return WEBCFG_FAILURE;
+	}
+
+	fp = fopen(tmp_path, "wb");
+	if(fp != NULL)
+	{
+		//No fsync, this runs on the sync path. A torn entry after power loss fails the
+		//CRC or the DB version check on fetch and is dropped there.
+		written = (fwrite(&hdr, sizeof(hdr), 1, fp) == 1) && (fwrite(data, data_size, 1, fp) == 1) && (fflush(fp) == 0);
+		fclose(fp);
+	}
+	//rename keeps the previous entry intact until the new one is complete.
+	if(!written || rename(tmp_path, path) != 0)
+	{
+		unlink(tmp_path);
+		pthread_mutex_unlock (&webconfig_blob_cache_mut);
+		WebcfgError("Failed to write subdoc %s to blob cache\n", name);
+		return WEBCFG_FAILURE;
+	}
+	evictBlobCache(path);
+	pthread_mutex_unlock (&webconfig_blob_cache_mut);
+	WebcfgInfo("subdoc %s etag %lu size %zu stored in blob cache\n", name, (long)etag, data_size);
+	return WEBCFG_SUCCESS;
+}
+
+WEBCFG_STATUS fetchBlobCacheDoc(const char *name, blob_cache_ref_t *ref)
+{
+	char path[256] = {'\0'};
+	struct stat st;
+	const blob_cache_hdr_t *hdr = NULL;
+	void *map = NULL;
+	uint32_t db_version = 0;
+	int fd = -1;
+
+	if(ref == NULL || !blobCachePath(name, BLOB_CACHE_SUFFIX, path, sizeof(path)))
+	{
+		return WEBCFG_FAILURE;
+	}
+	memset(ref, 0, sizeof(blob_cache_ref_t));
+
+	fd = open(path, O_RDONLY);
+	if(fd < 0)
+	{
+		WebcfgDebug("subdoc %s is not in blob cache\n", name);
+		return WEBCFG_FAILURE;
+	}
+	if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(blob_cache_hdr_t))
+	{
+		close(fd);
+		WebcfgError("blob cache entry %s is truncated\n", path);
+		deleteBlobCacheDoc(name);
+		return WEBCFG_FAILURE;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED)
+	{
+		WebcfgError("mmap of %s failed, %s\n", path, strerror(errno));
+		return WEBCFG_FAILURE;
+	}
+
+	hdr = (const blob_cache_hdr_t *) map;
+	if(hdr->magic != BLOB_CACHE_MAGIC || hdr->version != BLOB_CACHE_VERSION || hdr->data_size != (uint64_t)(st.st_size - sizeof(blob_cache_hdr_t)) || hdr->crc != blobCacheCrc32((const char *) map + sizeof(blob_cache_hdr_t), hdr->data_size))
+	{
+		munmap(map, st.st_size);
+		WebcfgError("blob cache entry %s failed verification, removing it\n", path);
+		deleteBlobCacheDoc(name);
+		return WEBCFG_FAILURE;
+	}
+	//Only serve the version the DB says is applied. Until the DB is loaded, or
+	//while the doc is not in it, the entry is kept for a later fetch.
+	if(!get_global_db_loaded() || getDBDocVersion(name, &db_version) != WEBCFG_SUCCESS)
+	{
+		WebcfgDebug("subdoc %s has no DB version yet, blob cache entry not served\n", name);
+		munmap(map, st.st_size);
+		return WEBCFG_FAILURE;
+	}
+	if(db_version != hdr->etag)
+	{
+		WebcfgError("blob cache entry %s etag %lu does not match DB, removing it\n", path, (long)hdr->etag);
+		munmap(map, st.st_size);
+		deleteBlobCacheDoc(name);
+		return WEBCFG_FAILURE;
+	}
+
+	ref->etag = hdr->etag;
+	ref->data = (const char *) map + sizeof(blob_cache_hdr_t);
+	ref->data_size = hdr->data_size;
+	ref->map = map;
+	ref->map_len = st.st_size;
+	WebcfgInfo("subdoc %s etag %lu served from blob cache\n", name, (long)ref->etag);
+	return WEBCFG_SUCCESS;
+}
+
+void releaseBlobCacheDoc(blob_cache_ref_t *ref)
+{
+	if(ref != NULL && ref->map != NULL)
+	{
+		munmap(ref->map, ref->map_len);
+		memset(ref, 0, sizeof(blob_cache_ref_t));
+	}
+}
+
+WEBCFG_STATUS deleteBlobCacheDoc(const char *name)
+{
+	char path[256] = {'\0'};
+
+	if(!blobCachePath(name, BLOB_CACHE_SUFFIX, path, sizeof(path)))
+	{
+		return WEBCFG_FAILURE;
+	}
+	pthread_mutex_lock (&webconfig_blob_cache_mut);
+	if(unlink(path) != 0 && errno != ENOENT)
+	{
+		pthread_mutex_unlock (&webconfig_blob_cache_mut);
+		WebcfgError("Failed to remove %s, %s\n", path, strerror(errno));
+		return WEBCFG_FAILURE;
+	}
+	pthread_mutex_unlock (&webconfig_blob_cache_mut);
+	return WEBCFG_SUCCESS;
+}
+
+//Removes every cached payload, used when the DB they were committed to is gone.
+void clearBlobCache()
+{
+	char path[512] = {'\0'};
+	struct dirent *entry = NULL;
+	size_t len = 0;
+	DIR *dir = NULL;
+
+	pthread_mutex_lock (&webconfig_blob_cache_mut);
+	dir = opendir(WEBCFG_BLOB_CACHE_DIR);
+	if(dir == NULL)
+	{
+		pthread_mutex_unlock (&webconfig_blob_cache_mut);
+		return;
+	}
+	while((entry = readdir(dir)) != NULL)
+	{
+		len = strlen(entry->d_name);
+		if(len <= strlen(BLOB_CACHE_SUFFIX) || strcmp(entry->d_name + len - strlen(BLOB_CACHE_SUFFIX), BLOB_CACHE_SUFFIX) != 0)
+		{
+			continue;
+		}
+		snprintf(path, sizeof(path), "%s/%s", WEBCFG_BLOB_CACHE_DIR, entry->d_name);
+		unlink(path);
+	}
+	closedir(dir);
+	pthread_mutex_unlock (&webconfig_blob_cache_mut);
+	WebcfgInfo("blob cache cleared\n");
+}
+
+WEBCFG_STATUS getDBDocVersion(const char *docname, uint32_t *version)
+{
+	webconfig_db_data_t *webcfgdb = NULL;
+	WEBCFG_STATUS status = WEBCFG_FAILURE;
+
+	if(docname == NULL || version == NULL)
+	{
+		return WEBCFG_FAILURE;
+	}
+	pthread_mutex_lock (&webconfig_db_mut);
+	for(webcfgdb = webcfgdb_data; webcfgdb != NULL; webcfgdb = webcfgdb->next)
+	{
+		if(webcfgdb->name != NULL && strcmp(docname, webcfgdb->name) == 0)
+		{
+			*version = webcfgdb->version;
+			status = WEBCFG_SUCCESS;
+			break;
+		}
+	}
+	pthread_mutex_unlock (&webconfig_db_mut);
+	return status;
+}
+
+//Caches the payload of a subdoc once its version is committed to the DB.
+static void storeCommittedBlobCacheDoc(const char *docname, uint32_t version)
+{
+	multipartdocs_t *mp_doc = NULL;
+
+	if(docname == NULL || strcmp(docname, "root") == 0)
+	{
+		return;
+	}
+	mp_doc = acquireMpDoc(docname);
+	if(mp_doc == NULL)
+	{
+		return;
+	}
+	if(mp_doc->etag == version)
+	{
+		writeBlobCacheDoc(mp_doc->name_space, mp_doc->etag, mp_doc->data, mp_doc->data_size);
+	}
+	releaseMpDoc(mp_doc);
+}
+
+static void initBlobCacheCrcTable(void)
+{
+	uint32_t i, j, c;
+
+	for(i = 0; i < 256; i++)
+	{
+		c = i;
+		for(j = 0; j < 8; j++)
+		{
+			c = (c & 1) ? (0xEDB88320U ^ (c >> 1)) : (c >> 1);
+		}
+		blob_cache_crc_table[i] = c;
+	}
+}
+
+//CRC-32 (IEEE) of the cached payload.
+static uint32_t blobCacheCrc32(const char *data, size_t len)
+{
+	const unsigned char *p = (const unsigned char *) data;
+	uint32_t crc = 0xFFFFFFFFU;
+	size_t i;
+
+	pthread_once(&blob_cache_crc_once, initBlobCacheCrcTable);
+	for(i = 0; i < len; i++)
+	{
+		crc = blob_cache_crc_table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return crc ^ 0xFFFFFFFFU;
+}
+
+//Subdoc names become file names, anything that could leave the cache dir is rejected.
+static int blobCachePath(const char *name, const char *suffix, char *path, size_t path_len)
+{
+	const char *p = NULL;
+	int n = 0;
+
+	if(name == NULL || name[0] == '\0' || name[0] == '.')
+	{
+		return 0;
+	}
+	for(p = name; *p != '\0'; p++)
+	{
+		if(!(isalnum((unsigned char)*p) || *p == '_' || *p == '-' || *p == '.'))
+		{
+			return 0;
+		}
+	}
+	n = snprintf(path, path_len, "%s/%s%s", WEBCFG_BLOB_CACHE_DIR, name, suffix);
+	return (n > 0 && (size_t)n < path_len);
+}
+
+//Drop the least recently written entries until the cache fits BLOB_CACHE_MAX_SIZE.
+static void evictBlobCache(const char *keep)
+{
+	char path[512] = {'\0'};
+	char oldest[512] = {'\0'};
+	struct dirent *entry = NULL;
+	struct stat st;
+	time_t oldest_mtime = 0;
+	size_t total = 0;
+	size_t len = 0;
+	DIR *dir = NULL;
+
+	while(1)
+	{
+		dir = opendir(WEBCFG_BLOB_CACHE_DIR);
+		if(dir == NULL)
+		{
+			return;
+		}
+		total = 0;
+		oldest[0] = '\0';
+		while((entry = readdir(dir)) != NULL)
+		{
+			len = strlen(entry->d_name);
+			if(len <= strlen(BLOB_CACHE_SUFFIX) || strcmp(entry->d_name + len - strlen(BLOB_CACHE_SUFFIX), BLOB_CACHE_SUFFIX) != 0)
+			{
+				continue;
+			}
+			snprintf(path, sizeof(path), "%s/%s", WEBCFG_BLOB_CACHE_DIR, entry->d_name);
+			if(stat(path, &st) != 0)
+			{
+				continue;
+			}
+			total += st.st_size;
+			if(strcmp(path, keep) != 0 && (oldest[0] == '\0' || st.st_mtime < oldest_mtime))
+			{
+				oldest_mtime = st.st_mtime;
+				strncpy(oldest, path, sizeof(oldest) - 1);
+			}
+		}
+		closedir(dir);
+		if(total <= BLOB_CACHE_MAX_SIZE || oldest[0] == '\0')
+		{
+			return;
+		}
+		WebcfgInfo("blob cache size %zu exceeds limit, evicting %s\n", total, oldest);
+		unlink(oldest);
+	}
+}
+
+//Entries superseded by a later timestamp stay queued and are skipped when popped.
+static void pushRetryDoc(const char *name, long long deadline)
+{
+	retry_doc_t *queue = NULL;
+	retry_doc_t entry;
+	int pos = 0;
+
+	entry.name = strdup(name);
+	if(entry.name == NULL)
+	{
+		WebcfgError("Failed to queue retry for doc %s\n", name);
+		return;
+	}
+	entry.deadline = deadline;
+
+	pthread_mutex_lock (&retry_queue_mut);
+	if(retry_queue_len == retry_queue_size)
+	{
+		queue = (retry_doc_t *)realloc(retry_queue, sizeof(retry_doc_t) * (retry_queue_size ? retry_queue_size * 2 : 8));
+		if(queue == NULL)
+		{
+			pthread_mutex_unlock (&retry_queue_mut);
+			WebcfgError("Failed to queue retry for doc %s\n", name);
+			WEBCFG_FREE(entry.name);
+			return;
+		}
+		retry_queue = queue;
+		retry_queue_size = retry_queue_size ? retry_queue_size * 2 : 8;
+	}
+	pos = retry_queue_len++;
+	while(pos > 0 && retry_queue[(pos - 1) / 2].deadline > deadline)
+	{
+		retry_queue[pos] = retry_queue[(pos - 1) / 2];
+		pos = (pos - 1) / 2;
+	}
+	retry_queue[pos] = entry;
+	pthread_mutex_unlock (&retry_queue_mut);
+}
+
+//Caller holds retry_queue_mut.
+static void siftDownRetryQueue(int pos)
+{
+	retry_doc_t entry;
+	int child = 0;
+
+	if(retry_queue_len == 0)
+	{
+		return;
+	}
+	entry = retry_queue[pos];
+	while((child = 2 * pos + 1) < retry_queue_len)
+	{
+		if(child + 1 < retry_queue_len && retry_queue[child + 1].deadline < retry_queue[child].deadline)
+		{
+			child++;
+		}
+		if(retry_queue[child].deadline >= entry.deadline)
+		{
+			break;
+		}
+		retry_queue[pos] = retry_queue[child];
+		pos = child;
+	}
+	retry_queue[pos] = entry;
+}
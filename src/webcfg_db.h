@@ -38,23 +38,49 @@
 #define WEBCFG_DB_FILE 	    "/tmp/webconfig_db.bin"
 #endif
 
+#if defined(DEVICE_CAMERA)
+#define WEBCFG_BLOB_CACHE_DIR      "/opt/webconfig_cache"
+#elif defined(BUILD_YOCTO) && ! defined(DEVICE_EXTENDER)
+#if defined(RDK_PERSISTENT_PATH_VIDEO)
+#define WEBCFG_BLOB_CACHE_DIR      "/opt/webconfig_cache"
+#else
+#define WEBCFG_BLOB_CACHE_DIR      "/nvram/webconfig_cache"
+#endif
+#elif defined(DEVICE_EXTENDER)
+#define WEBCFG_BLOB_CACHE_DIR      "/usr/opensync/data/webconfig_cache"
+#else
+#define WEBCFG_BLOB_CACHE_DIR      "/tmp/webconfig_cache"
+#endif
+
 /*----------------------------------------------------------------------------*/
 /*                               Data Structures                              */
 /*----------------------------------------------------------------------------*/
 
+typedef enum
+{
+	TMP_STATUS_NONE = 0,
+	TMP_STATUS_PENDING_APPLY,
+	TMP_STATUS_PENDING,
+	TMP_STATUS_SUCCESS,
+	TMP_STATUS_FAILED
+} WEBCFG_TMP_STATUS;
+
+/* Fields touched on every state transition are kept together ahead of the
+ * heap owned strings. error_details comes from internErrorDetails() and is
+ * dropped with releaseErrorDetails(), never freed directly. */
 typedef struct webconfig_tmp_data
 {
-        char * name;
-        uint32_t version;
-        char * status;
-	char * error_details;
-	int retry_count;
+	WEBCFG_TMP_STATUS status;
+	uint32_t version;
 	uint16_t error_code;
 	uint16_t trans_id;
+	int retry_count;
 	int isSupplementarySync;
 	long long retry_timestamp;
+	const char * error_details;
+	char * name;
 	char * cloud_trans_id;
-        struct webconfig_tmp_data *next;
+	struct webconfig_tmp_data *next;
 } webconfig_tmp_data_t;
 
 typedef struct webconfig_db_data{
@@ -64,6 +90,30 @@ typedef struct webconfig_db_data{
         struct webconfig_db_data *next;
 }webconfig_db_data_t;
 
+/* Immutable copy of the DB and tmp lists handed to readers. A snapshot is
+ * never modified once published and is freed when its last reference is
+ * released. db_copy/tmp_copy are private to webcfg_db.c. */
+typedef struct webcfg_db_snapshot
+{
+	webconfig_db_data_t *db_list;
+	webconfig_tmp_data_t *tmp_list;
+	unsigned long generation;
+	int refcount;
+	struct list_copy *db_copy;
+	struct list_copy *tmp_copy;
+} webcfg_db_snapshot_t;
+
+/* Subdoc payload served from the on-disk cache. data points into a read
+ * only mapping of the cache file, release with releaseBlobCacheDoc(). */
+typedef struct blob_cache_ref
+{
+	uint32_t etag;
+	const char *data;
+	size_t data_size;
+	void *map;
+	size_t map_len;
+} blob_cache_ref_t;
+
 typedef struct blob{
 	char *data;
 	size_t len;
@@ -106,6 +156,10 @@ blob_struct_t* decodeBlobData(const void * buf, size_t len);
 
 WEBCFG_STATUS initDB(char * db_file_path);
 
+int get_global_db_loaded(void);
+
+void set_global_db_loaded(int loaded);
+
 WEBCFG_STATUS addNewDocEntry(size_t count);
 
 int writeToDBFile(char * db_file_path, char * data, size_t size);
@@ -128,10 +182,15 @@ WEBCFG_STATUS addToTmpList();
 
 void addToDBList(webconfig_db_data_t *webcfgdb);
 
-WEBCFG_STATUS updateTmpList(webconfig_tmp_data_t *temp, char *docname, uint32_t version, char *status, char *error_details, uint16_t error_code, uint16_t trans_id, int retry);
+WEBCFG_STATUS updateTmpList(webconfig_tmp_data_t *temp, char *docname, uint32_t version, const char *status, const char *error_details, uint16_t error_code, uint16_t trans_id, int retry);
 
 WEBCFG_STATUS deleteFromTmpList(char* doc_name, webconfig_tmp_data_t **next_node);
 
+/**
+ *  Live tmp node of docname, for writers to pass to the locked setters
+ *  (updateTmpList, updateFailureTimeStamp, incrementTmpRetryCount). Read-only
+ *  lookups use getSnapshotTmpNode() instead.
+ */
 webconfig_tmp_data_t * getTmpNode(char *docname);
 
 void delete_tmp_list();
@@ -190,4 +249,99 @@ webconfig_db_data_t* decodeData(const void * data, size_t len);
 const char* webcfgdbparam_strerror( int errnum );
 
 WEBCFG_STATUS updateFailureTimeStamp(webconfig_tmp_data_t *temp, char *docname, long long timestamp);
+
+int incrementTmpRetryCount(webconfig_tmp_data_t *temp);
+
+/**
+ *  Failed docs are queued by retry deadline when updateFailureTimeStamp()
+ *  records one. popDueRetryDoc() returns 1 with the earliest entry due at
+ *  now (name must be freed by the caller), 0 when none is due.
+ */
+int popDueRetryDoc(long long now, char **name, long long *deadline);
+
+long long getNextRetryDeadline();
+
+void deleteRetryQueue();
+
+/**
+ *  Get a consistent read-only view of the DB and tmp lists. Writers publish
+ *  the snapshot under the list lock, readers only take a reference on it and
+ *  never lock or allocate. Must be released with releaseDBSnapshot().
+ *
+ *  @return snapshot, never NULL
+ */
+webcfg_db_snapshot_t * acquireDBSnapshot();
+
+void releaseDBSnapshot(webcfg_db_snapshot_t *snap);
+
+/**
+ *  Tmp node of docname in snap, valid until the snapshot is released.
+ *
+ *  @return node, NULL if docname is not in the tmp list
+ */
+webconfig_tmp_data_t * getSnapshotTmpNode(webcfg_db_snapshot_t *snap, const char *docname);
+
+/**
+ *  Map between tmp list status and the status string used in the
+ *  Data blob and logs ("pending_apply", "pending", "success", "failed").
+ */
+const char * tmpStatusToString(WEBCFG_TMP_STATUS status);
+
+WEBCFG_TMP_STATUS tmpStatusFromString(const char *status);
+
+/**
+ *  Return the interned copy of error_details. The common values are static,
+ *  any other string is shared and refcounted, so each call must be paired
+ *  with releaseErrorDetails().
+ *
+ *  @param error_details string to intern
+ *
+ *  @return interned string, NULL if error_details is NULL
+ */
+const char * internErrorDetails(const char *error_details);
+
+/**
+ *  Drop a reference taken with internErrorDetails(). Strings that did not
+ *  come from internErrorDetails() are ignored.
+ */
+void releaseErrorDetails(const char *error_details);
+
+/**
+ *  Store a subdoc payload in the persistent cache, replacing any older etag
+ *  of the same subdoc. Called once the etag is committed to the DB. Oldest
+ *  entries are evicted to keep the cache bounded.
+ *
+ *  @param name subdoc name
+ *  @param etag subdoc version
+ *  @param data msgpack payload
+ *  @param data_size payload size in bytes
+ *
+ *  @return WEBCFG_SUCCESS when the payload is on disk
+ */
+WEBCFG_STATUS writeBlobCacheDoc(const char *name, uint32_t etag, const char *data, size_t data_size);
+
+/**
+ *  Map a cached subdoc payload after verifying its checksum and that its
+ *  etag is the version in the DB. A corrupted or stale entry is removed and
+ *  reported as a miss.
+ *
+ *  @param name subdoc name
+ *  @param ref filled in on success
+ *
+ *  @return WEBCFG_SUCCESS on hit, WEBCFG_FAILURE otherwise
+ */
+WEBCFG_STATUS fetchBlobCacheDoc(const char *name, blob_cache_ref_t *ref);
+
+void releaseBlobCacheDoc(blob_cache_ref_t *ref);
+
+WEBCFG_STATUS deleteBlobCacheDoc(const char *name);
+
+void clearBlobCache();
+
+/**
+ *  Version of docname as committed in the DB.
+ *
+ *  @return WEBCFG_SUCCESS when docname is in the DB
+ */
+WEBCFG_STATUS getDBDocVersion(const char *docname, uint32_t *version);
 #endif
@@ -34,10 +34,46 @@
 /*----------------------------------------------------------------------------*/
 /*                                   Macros                                   */
 /*----------------------------------------------------------------------------*/
+/* Interned subdoc table capacity, must be a power of 2. */
+#define SUBDOC_STATE_TABLE_SIZE		64
+/* Subdocs whose ACK toggles connected client notification. */
+#define SUBDOC_FLAG_CLIENT_NOTIFY	0x1
+/* Superseded component transaction ids remembered per subdoc. */
+#define SUBDOC_STALE_TXID_MAX		4
 
 /*----------------------------------------------------------------------------*/
 /*                               Data Structures                              */
 /*----------------------------------------------------------------------------*/
+typedef struct _subdoc_state
+{
+	char name[EVENT_NAME_LEN];
+	uint32_t hash;
+	unsigned int flags;
+	WEBCFG_SUBDOC_STATE state;
+	//last accepted component response, for duplicate and stale suppression
+	int has_last;
+	WEBCFG_EVENT_TYPE last_type;
+	uint16_t last_trans_id;
+	uint32_t last_version;
+	uint32_t last_timeout;
+	char last_status[EVENT_STATUS_LEN];
+	uint16_t stale_txids[SUBDOC_STALE_TXID_MAX];
+	int stale_count;
+	//tmp list version a component NACKed, valid while nack_failed is set
+	int nack_failed;
+	uint32_t failed_version;
+	//entries beyond the table are chained, see lookupSubdocState
+	struct _subdoc_state *next;
+} subdoc_state_t;
+
+//Events that did not fit in the ring but must not be lost.
+typedef struct _event_overflow
+{
+	webcfg_event_t event;
+	struct _event_overflow *next;
+} event_overflow_t;
+
+typedef WEBCFG_EVENT_TYPE (*event_handler_t)(webcfg_event_t *event, webconfig_tmp_data_t *subdoc_node, subdoc_state_t *entry);
 /*----------------------------------------------------------------------------*/
 /*                            File Scoped Variables                           */
 /*----------------------------------------------------------------------------*/
@@ -46,9 +82,29 @@ static pthread_t processThreadId = 0;
 pthread_mutex_t event_mut=PTHREAD_MUTEX_INITIALIZER;
 pthread_cond_t event_con=PTHREAD_COND_INITIALIZER;
 pthread_mutex_t expire_timer_mut=PTHREAD_MUTEX_INITIALIZER;
-event_data_t *eventDataQ = NULL;
+pthread_cond_t expire_timer_con=PTHREAD_COND_INITIALIZER;
+static int expire_timer_con_init = 0;
+/* Bounded MPSC ring: producers claim slots with CAS on eventQ_tail, the
+ * single consumer advances eventQ_head. Slot seq holds the round base
+ * (pos & ~mask) when free and round base + 1 when filled, so the zeroed
+ * array is a valid empty queue. */
+static event_slot_t eventQ[WEBCFG_EVENT_QUEUE_SIZE];
+static unsigned long eventQ_head = 0;
+static unsigned long eventQ_tail = 0;
+static unsigned long eventQ_hwm = 0;
+static unsigned long eventQ_dropped = 0;
+/* Apply outcomes that find the ring full go to this list, guarded by event_mut.
+ * While it is not empty new events queue behind it to keep their order. */
+static event_overflow_t *eventOverflowQ = NULL;
+static event_overflow_t *eventOverflowTail = NULL;
+static int eventOverflowCount = 0;
 static expire_timer_t * g_timer_head = NULL;
 static int numOfEvents = 0;
+/* Subdoc lifecycle states, open addressed by name hash. Accessed only by the event consumer thread. */
+static subdoc_state_t subdocStates[SUBDOC_STATE_TABLE_SIZE];
+static subdoc_state_t *subdocStateOverflow = NULL;
+static subdoc_state_t subdocStateScratch;
+static unsigned long event_suppressed = 0;
 /*----------------------------------------------------------------------------*/
 /*                             Function Prototypes                            */
 /*----------------------------------------------------------------------------*/
@@ -56,10 +112,54 @@ void* blobEventHandler();
 void* processSubdocEvents();
 
 int checkWebcfgTimer();
-int addToEventQueue(char *buf);
+static int getFromEventQueue(webcfg_event_t *event);
+static int addEventToOverflow(webcfg_event_t *event);
+static int isEventReady(void);
+static const char *getEventField(const char *str, char *dst, size_t len);
+static void processSubdocEvent(webcfg_event_t *event);
+static subdoc_state_t *lookupSubdocState(const char *docname, int create);
+static void initSubdocState(subdoc_state_t *entry, const char *docname, uint32_t hash);
+static int isGatedEvent(webcfg_event_t *event, webconfig_tmp_data_t *subdoc_node, subdoc_state_t *entry);
+static WEBCFG_EVENT_TYPE handleAckEvent(webcfg_event_t *event, webconfig_tmp_data_t *subdoc_node, subdoc_state_t *entry);
+static WEBCFG_EVENT_TYPE handleNackEvent(webcfg_event_t *event, webconfig_tmp_data_t *subdoc_node, subdoc_state_t *entry);
+static WEBCFG_EVENT_TYPE handleExpireEvent(webcfg_event_t *event, webconfig_tmp_data_t *subdoc_node, subdoc_state_t *entry);
+static WEBCFG_EVENT_TYPE handleTimeoutEvent(webcfg_event_t *event, webconfig_tmp_data_t *subdoc_node, subdoc_state_t *entry);
+static WEBCFG_EVENT_TYPE handleRestartEvent(webcfg_event_t *event, webconfig_tmp_data_t *subdoc_node, subdoc_state_t *entry);
+static void applySubdocSuccess(webconfig_tmp_data_t *subdoc_node, webcfg_event_t *event);
+static WEBCFG_EVENT_TYPE retrySubdocFromTmp(webconfig_tmp_data_t *subdoc_node, webcfg_event_t *event, uint32_t version);
+static void handleRetryFailure(webconfig_tmp_data_t *subdoc_node, char *docname, uint32_t version);
+static int isSuppressedEvent(webcfg_event_t *event, subdoc_state_t *entry);
+static void recordAcceptedEvent(webcfg_event_t *event, subdoc_state_t *entry);
+
+/* Event handlers indexed by WEBCFG_EVENT_TYPE. A handler returns the outcome
+ * fed to subdocTransitions, EVENT_TYPE_NONE when the event is not accepted. */
+static const event_handler_t eventHandlers[EVENT_TYPE_MAX] =
+{
+	[EVENT_TYPE_ACK] = handleAckEvent,
+	[EVENT_TYPE_NACK] = handleNackEvent,
+	[EVENT_TYPE_EXPIRE] = handleExpireEvent,
+	[EVENT_TYPE_TIMEOUT] = handleTimeoutEvent,
+	[EVENT_TYPE_COMP_INIT] = handleRestartEvent,
+	[EVENT_TYPE_CRASH] = handleRestartEvent,
+};
+
+/* Next subdoc state for [current state][event outcome]. EXPIRE and restart
+ * events for a doc that failed with NACK, and timer expiries for an applied
+ * doc, are skipped by isGatedEvent before they reach a handler, so the
+ * failed row only sees them once a newer version is in the tmp list. */
+static const WEBCFG_SUBDOC_STATE subdocTransitions[SUBDOC_STATE_MAX][EVENT_TYPE_MAX] =
+{
+	[SUBDOC_STATE_PENDING_APPLY] = { SUBDOC_STATE_PENDING_APPLY, SUBDOC_STATE_APPLIED, SUBDOC_STATE_FAILED, SUBDOC_STATE_RETRYING, SUBDOC_STATE_PENDING, SUBDOC_STATE_RETRYING, SUBDOC_STATE_RETRYING },
+	[SUBDOC_STATE_PENDING]       = { SUBDOC_STATE_PENDING, SUBDOC_STATE_APPLIED, SUBDOC_STATE_FAILED, SUBDOC_STATE_RETRYING, SUBDOC_STATE_PENDING, SUBDOC_STATE_RETRYING, SUBDOC_STATE_RETRYING },
+	[SUBDOC_STATE_APPLIED]       = { SUBDOC_STATE_APPLIED, SUBDOC_STATE_APPLIED, SUBDOC_STATE_FAILED, SUBDOC_STATE_APPLIED, SUBDOC_STATE_PENDING, SUBDOC_STATE_RETRYING, SUBDOC_STATE_RETRYING },
+	[SUBDOC_STATE_FAILED]        = { SUBDOC_STATE_FAILED, SUBDOC_STATE_APPLIED, SUBDOC_STATE_FAILED, SUBDOC_STATE_RETRYING, SUBDOC_STATE_PENDING, SUBDOC_STATE_RETRYING, SUBDOC_STATE_RETRYING },
+	[SUBDOC_STATE_RETRYING]      = { SUBDOC_STATE_RETRYING, SUBDOC_STATE_APPLIED, SUBDOC_STATE_FAILED, SUBDOC_STATE_RETRYING, SUBDOC_STATE_PENDING, SUBDOC_STATE_RETRYING, SUBDOC_STATE_RETRYING },
+};
 void sendSuccessNotification(webconfig_tmp_data_t *subdoc_node, char *name, uint32_t version, uint16_t txid);
 void createTimerExpiryEvent(char *docName, uint16_t transid);
 void handleConnectedClientNotify(char *status);
+static void setTimerDeadline(expire_timer_t *node);
+static int getNextTimerDeadline(struct timespec *deadline);
 /*----------------------------------------------------------------------------*/
 /*                             External Functions                             */
 /*----------------------------------------------------------------------------*/
@@ -82,6 +182,31 @@ pthread_mutex_t *get_global_event_mut(void)
 {
     return &event_mut;
 }
+pthread_cond_t *get_global_expire_timer_con(void)
+{
+    return &expire_timer_con;
+}
+
+pthread_mutex_t *get_global_expire_timer_mut(void)
+{
+    return &expire_timer_mut;
+}
+
+unsigned long get_global_event_queue_hwm(void)
+{
+    return __atomic_load_n(&eventQ_hwm, __ATOMIC_RELAXED);
+}
+
+unsigned long get_global_event_queue_dropped(void)
+{
+    return __atomic_load_n(&eventQ_dropped, __ATOMIC_RELAXED);
+}
+
+unsigned long get_global_event_suppressed(void)
+{
+    return __atomic_load_n(&event_suppressed, __ATOMIC_RELAXED);
+}
+
 expire_timer_t * get_global_timer_node(void)	
 {
     expire_timer_t * tmp = NULL;
@@ -118,6 +243,18 @@ void free_event_params_struct(event_params_t *param)
 void initEventHandlingTask()
 {
 	int err = 0;
+	pthread_condattr_t attr;
+
+	//Doc timer deadlines are on CLOCK_MONOTONIC so wall clock changes do not shift expiry.
+	if(!expire_timer_con_init)
+	{
+		pthread_condattr_init(&attr);
+		pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+		pthread_cond_init(&expire_timer_con, &attr);
+		pthread_condattr_destroy(&attr);
+		expire_timer_con_init = 1;
+	}
+
 	err = pthread_create(&EventThreadId, NULL, blobEventHandler, NULL);
 	if (err != 0)
 	{
@@ -137,6 +274,7 @@ void* blobEventHandler()
 	char *expired_doc= NULL;
 	uint16_t tx_id = 0;
 	expire_timer_t *expired_node = NULL;
+	struct timespec deadline;
 
 	ret = registerWebcfgEvent(webcfgCallback);
 	if(ret)
@@ -148,7 +286,7 @@ void* blobEventHandler()
 		WebcfgError("registerWebcfgEvent failed\n");
 	}
 
-	/* Loop to check timer expiry. When timer is not running, loop is active but wont check expiry until next timer starts. */
+	/* Loop to check timer expiry. Sleeps until the nearest doc timer deadline, or until a timer is started when none is running. */
 	while(FOREVER())
 	{
 		if (checkTimerExpired (&expired_doc))
@@ -171,13 +309,24 @@ void* blobEventHandler()
 		}
 		else
 		{
-			WebcfgDebug("Waiting at timer loop of 5s\n");
-			sleep(5);
+			pthread_mutex_lock (&expire_timer_mut);
 			if (get_global_shutdown())
 			{
 				WebcfgDebug("g_shutdown true, break timer expire events\n");
+				pthread_mutex_unlock (&expire_timer_mut);
 				break;
 			}
+			if (getNextTimerDeadline(&deadline))
+			{
+				WebcfgDebug("Waiting at timer loop for next doc deadline\n");
+				pthread_cond_timedwait(&expire_timer_con, &expire_timer_mut, &deadline);
+			}
+			else
+			{
+				WebcfgDebug("No doc timer running, waiting at timer loop\n");
+				pthread_cond_wait(&expire_timer_con, &expire_timer_mut);
+			}
+			pthread_mutex_unlock (&expire_timer_mut);
 		}
 	}
 	ret = unregisterWebcfgEvent();
@@ -193,57 +342,213 @@ void* blobEventHandler()
 }
 
 //Call back function to be executed when webconfigSignal signal is received from component.
+//Components still send comma separated strings, they are converted to a typed event here.
 void webcfgCallback(char *Info, void* user_data)
 {
-	char *buff = NULL;
+	webcfg_event_t event;
+	uint16_t err = 0;
+	char* errmsg = NULL;
+
 	WebcfgInfo("Received webconfig event signal Info %s\n", Info);
 	WebcfgDebug("user_data %s\n", (char*) user_data);
 
-	buff = strdup(Info);
-	addToEventQueue(buff);
+	if(parseEventString(Info, &event) == WEBCFG_SUCCESS)
+	{
+		addEventToQueue(&event);
+	}
+	else
+	{
+		WebcfgError("Failed to parse event Data\n");
+		err = getStatusErrorCodeAndMessage(COMPONENT_EVENT_PARSE_FAILURE, &errmsg);
+		WebcfgDebug("The error_details is %s and err_code is %d\n", errmsg, err);
+		addWebConfgNotifyMsg(NULL, 0, "failed", errmsg, NULL ,0, "status", err, NULL, 200);
+		WEBCFG_FREE(errmsg);
+	}
 }
 
-//Producer adds event data to queue
+//Compatibility wrapper for comma separated event strings, buf is freed. Returns 0 when queued.
 int addToEventQueue(char *buf)
 {
-	event_data_t *Data;
+	webcfg_event_t event;
+	int rv = 1;
+
+	if(parseEventString(buf, &event) == WEBCFG_SUCCESS)
+	{
+		rv = addEventToQueue(&event);
+	}
+	WEBCFG_FREE(buf);
+	return rv;
+}
+
+//Fill a typed event record for internal producers.
+void setWebcfgEvent(webcfg_event_t *event, const char *name, uint16_t trans_id, uint32_t version, const char *status, uint32_t timeout)
+{
+	memset(event, 0, sizeof(webcfg_event_t));
+	snprintf(event->subdoc_name, sizeof(event->subdoc_name), "%s", (name != NULL) ? name : "");
+	event->trans_id = trans_id;
+	event->version = version;
+	snprintf(event->status, sizeof(event->status), "%s", (status != NULL) ? status : "");
+	event->timeout = timeout;
+	event->type = getEventType(event->status, timeout);
+}
+
+//Producer copies the event record into queue. When the ring is full apply outcomes go to the overflow list, other events are dropped.
+//The queue owns event->failure_reason from here on, also when the event is dropped.
+int addEventToQueue(webcfg_event_t *event)
+{
+	const unsigned long mask = WEBCFG_EVENT_QUEUE_SIZE - 1;
+	unsigned long pos = 0, seq = 0, depth = 0, hwm = 0;
+	event_slot_t *slot = NULL;
+	long diff = 0;
 
 	WebcfgDebug ("Add data to event queue\n");
-        Data = (event_data_t *)malloc(sizeof(event_data_t));
-
-	if(Data)
-        {
-            Data->data =buf;
-            Data->next=NULL;
-            pthread_mutex_lock (&event_mut);
-            if(eventDataQ == NULL)
-            {
-                eventDataQ = Data;
-
-                WebcfgDebug("Producer added Data\n");
-                pthread_cond_signal(&event_con);
-                pthread_mutex_unlock (&event_mut);
-                WebcfgDebug("mutex unlock in producer event thread\n");
-            }
-            else
-            {
-                event_data_t *temp = eventDataQ;
-                while(temp->next)
-                {
-                    temp = temp->next;
-                }
-                temp->next = Data;
-                pthread_mutex_unlock (&event_mut);
-            }
-        }
-        else
-        {
-            WebcfgError("failure in allocation for event data\n");
-        }
+	if(__atomic_load_n(&eventOverflowCount, __ATOMIC_ACQUIRE) > 0)
+	{
+		return addEventToOverflow(event);
+	}
+	pos = __atomic_load_n(&eventQ_tail, __ATOMIC_RELAXED);
+	while(1)
+	{
+		slot = &eventQ[pos & mask];
+		seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		diff = (long)(seq - (pos & ~mask));
+		if(diff == 0)
+		{
+			if(__atomic_compare_exchange_n(&eventQ_tail, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			{
+				break;
+			}
+		}
+		else if(diff < 0)
+		{
+			//losing an apply outcome would leave the subdoc stuck, only restart notices are dropped
+			if(event->type == EVENT_TYPE_ACK || event->type == EVENT_TYPE_NACK || event->type == EVENT_TYPE_EXPIRE || event->type == EVENT_TYPE_TIMEOUT)
+			{
+				return addEventToOverflow(event);
+			}
+			__atomic_add_fetch(&eventQ_dropped, 1, __ATOMIC_RELAXED);
+			WebcfgError("Event queue full, dropping event for %s\n", event->subdoc_name);
+			clearWebcfgEvent(event);
+			return 1;
+		}
+		else
+		{
+			pos = __atomic_load_n(&eventQ_tail, __ATOMIC_RELAXED);
+		}
+	}
+	slot->event = *event;
+	event->failure_reason = NULL;
+	__atomic_store_n(&slot->seq, (pos & ~mask) + 1, __ATOMIC_RELEASE);
+
+	depth = pos + 1 - __atomic_load_n(&eventQ_head, __ATOMIC_RELAXED);
+	hwm = __atomic_load_n(&eventQ_hwm, __ATOMIC_RELAXED);
+	while(depth > hwm && !__atomic_compare_exchange_n(&eventQ_hwm, &hwm, depth, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	pthread_mutex_lock (&event_mut);
+	WebcfgDebug("Producer added Data\n");
+	pthread_cond_signal(&event_con);
+	pthread_mutex_unlock (&event_mut);
+	return 0;
+}
+
+//Consumer copies out the oldest event from queue, the ring first and then the overflow list. Returns 0 when both are empty.
+static int getFromEventQueue(webcfg_event_t *event)
+{
+	const unsigned long mask = WEBCFG_EVENT_QUEUE_SIZE - 1;
+	unsigned long pos = __atomic_load_n(&eventQ_head, __ATOMIC_RELAXED);
+	event_slot_t *slot = &eventQ[pos & mask];
+	event_overflow_t *node = NULL;
+
+	if(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != (pos & ~mask) + 1)
+	{
+		if(__atomic_load_n(&eventOverflowCount, __ATOMIC_ACQUIRE) == 0)
+		{
+			return 0;
+		}
+		pthread_mutex_lock (&event_mut);
+		node = eventOverflowQ;
+		if(node != NULL)
+		{
+			eventOverflowQ = node->next;
+			if(eventOverflowQ == NULL)
+			{
+				eventOverflowTail = NULL;
+			}
+			__atomic_sub_fetch(&eventOverflowCount, 1, __ATOMIC_RELEASE);
+		}
+		pthread_mutex_unlock (&event_mut);
+		if(node == NULL)
+		{
+			return 0;
+		}
+		*event = node->event;
+		WEBCFG_FREE(node);
+		return 1;
+	}
+	*event = slot->event;
+	__atomic_store_n(&slot->seq, (pos & ~mask) + WEBCFG_EVENT_QUEUE_SIZE, __ATOMIC_RELEASE);
+	__atomic_store_n(&eventQ_head, pos + 1, __ATOMIC_RELAXED);
+	return 1;
+}
+
+//Park an event behind the full ring, the list takes ownership of failure_reason. Returns 0 when queued.
+static int addEventToOverflow(webcfg_event_t *event)
+{
+	event_overflow_t *node = (event_overflow_t *)malloc(sizeof(event_overflow_t));
 
+	if(node == NULL)
+	{
+		__atomic_add_fetch(&eventQ_dropped, 1, __ATOMIC_RELAXED);
+		WebcfgError("Failed to allocate overflow event, dropping event for %s\n", event->subdoc_name);
+		clearWebcfgEvent(event);
+		return 1;
+	}
+	node->event = *event;
+	node->next = NULL;
+	event->failure_reason = NULL;
+	pthread_mutex_lock (&event_mut);
+	if(eventOverflowTail != NULL)
+	{
+		eventOverflowTail->next = node;
+	}
+	else
+	{
+		eventOverflowQ = node;
+	}
+	eventOverflowTail = node;
+	__atomic_add_fetch(&eventOverflowCount, 1, __ATOMIC_RELEASE);
+	WebcfgInfo("Event queue full, %s event parked in overflow list\n", node->event.subdoc_name);
+	pthread_cond_signal(&event_con);
+	pthread_mutex_unlock (&event_mut);
 	return 0;
 }
 
+//True when the consumer has an event to take, called under event_mut.
+//The head slot is checked rather than the tail so a claimed but unwritten slot is waited for, not spun on.
+static int isEventReady(void)
+{
+	const unsigned long mask = WEBCFG_EVENT_QUEUE_SIZE - 1;
+	unsigned long pos = __atomic_load_n(&eventQ_head, __ATOMIC_RELAXED);
+
+	return (__atomic_load_n(&eventQ[pos & mask].seq, __ATOMIC_ACQUIRE) == (pos & ~mask) + 1) || (eventOverflowQ != NULL);
+}
+
+//Discard queued events and reset the counters. Only when the consumer thread is not running, returns the number discarded.
+int resetEventQueue(void)
+{
+	webcfg_event_t event;
+	int count = 0;
+
+	while(getFromEventQueue(&event))
+	{
+		clearWebcfgEvent(&event);
+		count++;
+	}
+	__atomic_store_n(&eventQ_hwm, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&eventQ_dropped, 0, __ATOMIC_RELAXED);
+	return count;
+}
+
 
 //Webcfg consumer thread to process the events.
 void processWebcfgEvents()
@@ -261,344 +566,34 @@ void processWebcfgEvents()
 
 }
 
-//Parse and process sub doc event data.
+//Process typed sub doc events.
 void* processSubdocEvents()
 {
-	event_params_t *eventParam = NULL;
-	int rv = WEBCFG_FAILURE;
-	WEBCFG_STATUS rs = WEBCFG_FAILURE;
-	uint32_t docVersion = 0;
-	char err_details[512] = {0};
-	webconfig_tmp_data_t * subdoc_node = NULL;
-	expire_timer_t * doctimer_node = NULL;
-	char * cloud_trans_id = NULL;
-	uint16_t err = 0;
-	char* errmsg = NULL;
+	webcfg_event_t event;
 
 	while(FOREVER())
 	{
-		pthread_mutex_lock (&event_mut);
-		WebcfgDebug("mutex lock in event consumer thread\n");
-		if(eventDataQ != NULL)
+		if(getFromEventQueue(&event))
 		{
-			event_data_t *Data = eventDataQ;
-			eventDataQ = eventDataQ->next;
-			pthread_mutex_unlock (&event_mut);
-			WebcfgDebug("mutex unlock in event consumer thread\n");
-
-			WebcfgDebug("Data->data is %s\n", Data->data);
-			rv = parseEventData(Data->data, &eventParam);
-			if(rv == WEBCFG_SUCCESS)
-			{
-				subdoc_node = getTmpNode(eventParam->subdoc_name);
-				doctimer_node = getTimerNode(eventParam->subdoc_name);
-
-				WebcfgDebug("Event detection\n");
-				if (((eventParam->status !=NULL) && (strcmp(eventParam->status, "ACK")==0 || (strcmp(eventParam->status, "ACK;enabled")==0) || (strcmp(eventParam->status, "ACK;disabled")==0))) && (eventParam->timeout == 0))
-				{
-					//Based on ACK event if mesh/cujo is enabled then connected client notification need to be turned OFF
-					if ((eventParam->subdoc_name !=NULL) &&((strcmp(eventParam->subdoc_name, "mesh") ==0) || (strcmp(eventParam->subdoc_name, "advsecurity") ==0)))
-					{
-						WebcfgInfo("ACK for mesh/cujo received: %s,%lu,%lu,%s,%lu\n", eventParam->subdoc_name,(long)eventParam->trans_id, (long)eventParam->version, eventParam->status, (long)eventParam->timeout);
-						handleConnectedClientNotify(eventParam->status);
-					}
-				
-					WebcfgInfo("ACK EVENT: %s,%lu,%lu,ACK,%lu %s\n", eventParam->subdoc_name,(long)eventParam->trans_id, (long)eventParam->version, (long)eventParam->timeout, "(doc apply success)");
-					WebcfgInfo("doc apply success, proceed to add to DB\n");
-					if( validateEvent(subdoc_node, eventParam->subdoc_name, eventParam->trans_id) == WEBCFG_SUCCESS)
-					{
-						//version in event &tmp are not same indicates latest doc is not yet applied
-						if((getDocVersionFromTmpList(subdoc_node, eventParam->subdoc_name))== eventParam->version)
-						{
-							stopWebcfgTimer(doctimer_node, eventParam->subdoc_name, eventParam->trans_id);
-
-							//add to DB, update tmp list and notification based on success ack.
-							sendSuccessNotification(subdoc_node, eventParam->subdoc_name, eventParam->version, eventParam->trans_id);
-							//No DB update for supplementary sync as version is not required to be stored.
-							if(subdoc_node->isSupplementarySync == 0)
-							{
-								WebcfgDebug("AddToDB subdoc_name %s version %lu\n", eventParam->subdoc_name, (long)eventParam->version);
-								checkDBList(eventParam->subdoc_name,eventParam->version, NULL);
-								WebcfgDebug("checkRootUpdate\n");
-								if(checkRootUpdate() == WEBCFG_SUCCESS)
-								{
-									WebcfgDebug("updateRootVersionToDB\n");
-									updateRootVersionToDB();
-								}
-								addNewDocEntry(get_successDocCount());
-							}
-							else
-							{
-								WebcfgInfo("No DB update for supplementary sync as version is not required to be stored.\n");
-							}
-							//root doc delete from tmp list and mp docs destroy can be done irrespective of primary/supplementary checks as all docs success can be reached during any sync.
-							WebcfgDebug("check for deleteRootAndMultipartDocs\n");
-							deleteRootAndMultipartDocs();
-						}
-						else
-						{
-							WebcfgError("ACK event version and tmp cache version are not same\n");
-						}
-					}
-				}
-				else if (((eventParam->status !=NULL)&&(strcmp(eventParam->status, "NACK")==0)) && (eventParam->timeout == 0))
-				{
-					WebcfgInfo("NACK EVENT: %s,%lu,%lu,NACK,%lu %s\n", eventParam->subdoc_name,(long)eventParam->trans_id, (long)eventParam->version, (long)eventParam->timeout, "(doc apply failed)");
-					WebcfgError("doc apply failed for %s\n", eventParam->subdoc_name);
-					if( validateEvent(subdoc_node, eventParam->subdoc_name, eventParam->trans_id) == WEBCFG_SUCCESS)
-					{
-						if((getDocVersionFromTmpList(subdoc_node, eventParam->subdoc_name))== eventParam->version)
-						{
-							stopWebcfgTimer(doctimer_node, eventParam->subdoc_name, eventParam->trans_id);
-							snprintf(err_details, sizeof(err_details),"NACK:%s,%s",((NULL != eventParam->process_name) ? eventParam->process_name : "unknown"), ((NULL != eventParam->failure_reason) ? eventParam->failure_reason : "unknown"));
-							WebcfgDebug("err_details : %s, err_code : %lu\n", err_details, (long) eventParam->err_code);
-							WebcfgInfo("subdoc_name and err_code : %s %lu\n", eventParam->subdoc_name, (long) eventParam->err_code);
-							WebcfgInfo("failure_reason %s\n", err_details);
-							updateTmpList(subdoc_node, eventParam->subdoc_name, eventParam->version, "failed", err_details, eventParam->err_code, eventParam->trans_id, 0);
-							WebcfgDebug("get_global_transID is %s\n", get_global_transID());
-							if(subdoc_node !=NULL && subdoc_node->cloud_trans_id !=NULL)
-							{
-								cloud_trans_id = subdoc_node->cloud_trans_id;
-							}
-							else
-							{
-								WebcfgInfo("subdoc_node is NULL, cloud_trans_id is unknown\n");
-								cloud_trans_id = "unknown";
-							}
-							WebcfgDebug("cloud_trans_id is %s\n", cloud_trans_id);
-							addWebConfgNotifyMsg(eventParam->subdoc_name, eventParam->version, "failed", err_details, cloud_trans_id, eventParam->timeout, "status", eventParam->err_code, NULL, 200);
-						}
-						else
-						{
-							WebcfgError("NACK event version and tmp cache version are not same\n");
-						}
-					}
-				}
-				else if ((eventParam->status !=NULL)&&(strcmp(eventParam->status, "EXPIRE")==0))
-				{
-					WebcfgInfo("EXPIRE EVENT: %s,%lu,%lu,EXPIRE,%lu\n", eventParam->subdoc_name,(long)eventParam->trans_id, (long)eventParam->version, (long)eventParam->timeout);
-					WebcfgInfo("doc apply timeout expired, need to retry\n");
-					WebcfgDebug("get_global_transID is %s\n", get_global_transID());
-					if(eventParam->version !=0)
-					{
-						docVersion = eventParam->version;
-					}
-					else
-					{
-						docVersion = getDocVersionFromTmpList(subdoc_node, eventParam->subdoc_name);
-					}
-					WebcfgDebug("docVersion %lu\n", (long) docVersion);
-					if(subdoc_node !=NULL && subdoc_node->cloud_trans_id !=NULL)
-					{
-						addWebConfgNotifyMsg(eventParam->subdoc_name, docVersion, "pending", "timer_expired", subdoc_node->cloud_trans_id, eventParam->timeout, "status", 0, NULL, 200);
-					}
-					//To avoid NACK blob re-apply on EXPIRE event after 304
-					if(checkTmpNACKstatus(subdoc_node, eventParam->subdoc_name))
-					{
-						WebcfgInfo("Skip retry for %s as blob apply status is NACK\n", eventParam->subdoc_name);
-					}
-					else
-					{
-					WebcfgDebug("retryMultipartSubdoc for EXPIRE case\n");
-					rs = retryMultipartSubdoc(subdoc_node, eventParam->subdoc_name);
-					if(rs == WEBCFG_SUCCESS)
-					{
-						WebcfgDebug("retryMultipartSubdoc success\n");
-					}
-					else
-					{
-						WebcfgError("retryMultipartSubdoc failed\n");
-						if(subdoc_node !=NULL)
-						{
-							if(subdoc_node->retry_count < 3)
-							{
-								err = getStatusErrorCodeAndMessage(SUBDOC_RETRY_FAILED, &errmsg);
-								WebcfgDebug("The error_details is %s and err_code is %d\n", errmsg, err);
-								updateTmpList(subdoc_node, eventParam->subdoc_name, docVersion, "failed", errmsg, err, subdoc_node->trans_id, subdoc_node->retry_count);
-								if(subdoc_node->cloud_trans_id !=NULL)
-								{
-									addWebConfgNotifyMsg(eventParam->subdoc_name, docVersion, "failed", errmsg, subdoc_node->cloud_trans_id ,0, "status", err, NULL, 200);
-								}
-								WEBCFG_FREE(errmsg);
-							}
-						}
-					}
-					}
-				}
-				else if (eventParam->timeout != 0)
-				{
-					WebcfgInfo("TIMEOUT EVENT: %s,%lu,%lu,ACK,%lu %s\n", eventParam->subdoc_name,(long)eventParam->trans_id, (long)eventParam->version, (long)eventParam->timeout,"(doc apply need time)");
-					WebcfgInfo("doc apply need time, start timer.\n");
-					if( validateEvent(subdoc_node, eventParam->subdoc_name, eventParam->trans_id) == WEBCFG_SUCCESS)
-					{
-						if((getDocVersionFromTmpList(subdoc_node, eventParam->subdoc_name))== eventParam->version)
-						{
-							startWebcfgTimer(doctimer_node, eventParam->subdoc_name, eventParam->trans_id, eventParam->timeout);
-							if(subdoc_node !=NULL && subdoc_node->cloud_trans_id !=NULL)
-							{
-								cloud_trans_id = subdoc_node->cloud_trans_id;
-							}
-							else
-							{
-								WebcfgInfo("subdoc_node is NULL, cloud_trans_id is unknown\n");
-								cloud_trans_id = "unknown";
-							}
-							WebcfgDebug("cloud_trans_id is %s\n", cloud_trans_id);
-							addWebConfgNotifyMsg(eventParam->subdoc_name, eventParam->version, "pending", NULL, cloud_trans_id,eventParam->timeout, "ack", 0, NULL, 200);
-						}
-						else
-						{
-							WebcfgError("Timeout event version and tmp cache version are not same\n");
-						}
-					}
-				}
-				else
-				{
-					if ((eventParam->status !=NULL)&&(strcmp(eventParam->status, "COMP_INIT")==0))
-					{
-						WebcfgInfo("COMP_INIT EVENT: %s,%d,%lu\n", eventParam->subdoc_name,0, (long)eventParam->version);
-						WebcfgInfo("Component initialized, check and re-send blob.\n");
-					}
-					else
-					{
-						WebcfgInfo("Crash EVENT: %s,%d,%lu\n", eventParam->subdoc_name,0, (long)eventParam->version);
-						WebcfgInfo("Component restarted after crash, re-send blob.\n");
-					}
-					uint32_t tmpVersion = 0;
-
-					//If version in event and tmp are not matching, re-send blob to retry.
-					if(checkDBVersion(eventParam->subdoc_name, eventParam->version) !=WEBCFG_SUCCESS)
-					{
-						WebcfgDebug("DB and event version are not same, check tmp list\n");
-						tmpVersion = getDocVersionFromTmpList(subdoc_node, eventParam->subdoc_name);
-						if (tmpVersion == 0)
-						{
-							//tmpVersion=0 indicate already doc is applied & doc is not available in tmp list
-							WebcfgDebug("tmpVersion is 0, DB already in latest version\n");
-						}
-						else if(tmpVersion != eventParam->version)
-						{
-							//To avoid NACK blob re-apply on CRASH event after 304
-							if(checkTmpNACKstatus(subdoc_node, eventParam->subdoc_name))
-							{
-								WebcfgInfo("Skip retry for %s as blob apply status is NACK\n", eventParam->subdoc_name);
-							}
-							else
-							{
-							WebcfgInfo("tmp list has new version %lu for doc %s, retry\n", (long)tmpVersion, eventParam->subdoc_name);
-							rs = retryMultipartSubdoc(subdoc_node, eventParam->subdoc_name);
-							if(rs == WEBCFG_SUCCESS)
-							{
-								WebcfgDebug("retryMultipartSubdoc success\n");
-							}
-							else
-							{
-								WebcfgError("retryMultipartSubdoc failed\n");
-								if(subdoc_node != NULL)
-								{
-									if(subdoc_node->retry_count < 3)
-									{
-										err = getStatusErrorCodeAndMessage(SUBDOC_RETRY_FAILED, &errmsg);
-										WebcfgDebug("The error_details is %s and err_code is %d\n", errmsg, err);
-										updateTmpList(subdoc_node, eventParam->subdoc_name, tmpVersion, "failed", errmsg, err, subdoc_node->trans_id, subdoc_node->retry_count);
-									        if(subdoc_node->cloud_trans_id != NULL)
-										{
-											addWebConfgNotifyMsg(eventParam->subdoc_name, tmpVersion, "failed", errmsg, subdoc_node->cloud_trans_id ,0, "status", err, NULL, 200);
-										}
-										WEBCFG_FREE(errmsg);
-									}
-								}
-							}
-							}
-						}
-						else
-						{
-							//already in tmp latest version,send success notify, updateDB
-							WebcfgInfo("tmp version %lu same as event version %lu\n",(long)tmpVersion, (long)eventParam->version); 
-							sendSuccessNotification(subdoc_node, eventParam->subdoc_name, eventParam->version, eventParam->trans_id);
-							//No DB update for supplementary docs
-							if(subdoc_node->isSupplementarySync == 0)
-							{
-								WebcfgInfo("AddToDB subdoc_name %s version %lu\n", eventParam->subdoc_name, (long)eventParam->version);
-								checkDBList(eventParam->subdoc_name,eventParam->version, NULL);
-								WebcfgDebug("checkRootUpdate\n");
-								if(checkRootUpdate() == WEBCFG_SUCCESS)
-								{
-									WebcfgDebug("updateRootVersionToDB\n");
-									updateRootVersionToDB();
-								}
-								addNewDocEntry(get_successDocCount());
-							}
-							WebcfgDebug("check for deleteRootAndMultipartDocs\n");
-							deleteRootAndMultipartDocs();
-						}
-					}
-					else
-					{
-						WebcfgDebug("DB and event version are same, check tmp list\n");
-						tmpVersion = getDocVersionFromTmpList(subdoc_node, eventParam->subdoc_name);
-						//tmpVersion=0 indicate already doc is applied & deleted frm tmp list
-						if((tmpVersion !=0) && (tmpVersion != eventParam->version))
-						{
-							//To avoid NACK blob re-apply on CRASH event after 304
-							if(checkTmpNACKstatus(subdoc_node, eventParam->subdoc_name))
-							{
-								WebcfgInfo("Skip retry for %s as blob apply status is NACK\n", eventParam->subdoc_name);
-							}
-							else
-							{
-							WebcfgInfo("tmp list has new version %lu for doc %s, retry\n", (long)tmpVersion, eventParam->subdoc_name);
-							//retry with latest tmp version
-							rs = retryMultipartSubdoc(subdoc_node, eventParam->subdoc_name);
-							//wait for ACK to send success notification and Update DB
-							if(rs == WEBCFG_SUCCESS)
-							{
-								WebcfgDebug("retryMultipartSubdoc success\n");
-							}
-							else
-							{
-								WebcfgError("retryMultipartSubdoc failed\n");
-								if(subdoc_node != NULL)
-								{
-									if(subdoc_node->retry_count < 3)
-									{
-										err = getStatusErrorCodeAndMessage(SUBDOC_RETRY_FAILED, &errmsg);
-										WebcfgDebug("The error_details is %s and err_code is %d\n", errmsg, err);
-										updateTmpList(subdoc_node, eventParam->subdoc_name, tmpVersion, "failed", errmsg, err, subdoc_node->trans_id, subdoc_node->retry_count);
-										if(subdoc_node->cloud_trans_id != NULL)
-										{
-											addWebConfgNotifyMsg(eventParam->subdoc_name, tmpVersion, "failed", errmsg, subdoc_node->cloud_trans_id ,0, "status", err, NULL, 200);
-										}
-										WEBCFG_FREE(errmsg);
-									}
-								}
-							}
-							}
-						}
-						else
-						{
-							WebcfgInfo("Already in latest version, no need to retry\n");
-						}
-					}
-				}
-				free_event_params_struct(eventParam);
-			}
-			else
-			{
-				WebcfgError("Failed to parse event Data\n");
-				err = getStatusErrorCodeAndMessage(COMPONENT_EVENT_PARSE_FAILURE, &errmsg);
-				WebcfgDebug("The error_details is %s and err_code is %d\n", errmsg, err);
-				addWebConfgNotifyMsg(NULL, 0, "failed", errmsg, NULL ,0, "status", err, NULL, 200);
-				WEBCFG_FREE(errmsg);
-			}
-			WEBCFG_FREE(Data);
+			WebcfgDebug("event data is %s,%lu,%lu,%s,%lu\n", event.subdoc_name, (long)event.trans_id, (long)event.version, event.status, (long)event.timeout);
+			processSubdocEvent(&event);
+			clearWebcfgEvent(&event);
 		}
 		else
 		{
+			pthread_mutex_lock (&event_mut);
+			WebcfgDebug("mutex lock in event consumer thread\n");
+			//re-check under event_mut so a producer signal after the empty check is not lost
+			if(isEventReady())
+			{
+				pthread_mutex_unlock (&event_mut);
+				continue;
+			}
 			if (get_global_shutdown())
 			{
 				WebcfgDebug("g_shutdown in event consumer thread\n");
 				pthread_mutex_unlock (&event_mut);
+				resetEventQueue();
 				break;
 			}
 			WebcfgDebug("Before pthread cond wait in event consumer thread\n");
@@ -610,105 +605,210 @@ void* processSubdocEvents()
 	return NULL;
 }
 
-//Extract values from comma separated string and add to event_params_t structure.
-int parseEventData(char* str, event_params_t **val)
+//Classify component event from its status and timeout.
+WEBCFG_EVENT_TYPE getEventType(const char *status, uint32_t timeout)
 {
-	event_params_t *param = NULL;
-	char *tmpStr, *token =  NULL;
-	char * trans_id = NULL;
-	char *version = NULL;
-	char * timeout = NULL;
-	char *err_code = NULL;
-	char *subdoc_name = NULL, *status = NULL;
-	char *process_name = NULL, *failure_reason = NULL;
-
-	if(str !=NULL)
-	{
-		param = (event_params_t *)malloc(sizeof(event_params_t));
-		if(param)
-		{
-			memset(param, 0, sizeof(event_params_t));
-		        token = strdup(str);
-				tmpStr = token;
-			WEBCFG_FREE(str);
+	if(status == NULL)
+	{
+		return (timeout != 0) ? EVENT_TYPE_TIMEOUT : EVENT_TYPE_CRASH;
+	}
+	if(strcmp(status, "EXPIRE") == 0)
+	{
+		return EVENT_TYPE_EXPIRE;
+	}
+	if(timeout != 0)
+	{
+		return EVENT_TYPE_TIMEOUT;
+	}
+	if((strcmp(status, "ACK") == 0) || (strcmp(status, "ACK;enabled") == 0) || (strcmp(status, "ACK;disabled") == 0))
+	{
+		return EVENT_TYPE_ACK;
+	}
+	if(strcmp(status, "NACK") == 0)
+	{
+		return EVENT_TYPE_NACK;
+	}
+	if(strcmp(status, "COMP_INIT") == 0)
+	{
+		return EVENT_TYPE_COMP_INIT;
+	}
+	return EVENT_TYPE_CRASH;
+}
 
-		        subdoc_name = strsep(&tmpStr, ",");
-				if(subdoc_name != NULL)
-				{
-					param->subdoc_name = strdup(subdoc_name);
-				}
-		        trans_id = strsep(&tmpStr,",");
-		        version = strsep(&tmpStr,",");
-				status = strsep(&tmpStr,",");
-				if(status != NULL)
-				{
-		        	param->status = strdup(status);
-				}
-		        timeout = strsep(&tmpStr, ",");
+//Forget all subdoc states. Only when the event consumer thread is not running.
+void resetSubdocStates(void)
+{
+	subdoc_state_t *entry = NULL;
 
-			if(tmpStr !=NULL)
-			{
-				WebcfgInfo("For NACK event: tmpStr with error_details is %s\n", tmpStr);
-				process_name = strsep(&tmpStr, ",");
-				if(process_name != NULL)
-				{
-					param->process_name = strdup(process_name);
-				}
-				err_code = strsep(&tmpStr, ",");
-				failure_reason = strsep(&tmpStr, ",");
-				if(failure_reason != NULL)
-				{
-					param->failure_reason = strdup(failure_reason);
-				}
-				WebcfgInfo("process_name %s err_code %s failure_reason %s\n", param->process_name, err_code, param->failure_reason);
-			}
+	memset(subdocStates, 0, sizeof(subdocStates));
+	while(subdocStateOverflow != NULL)
+	{
+		entry = subdocStateOverflow;
+		subdocStateOverflow = entry->next;
+		WEBCFG_FREE(entry);
+	}
+}
 
-			WebcfgDebug("convert string to uint type\n");
-			if(trans_id !=NULL)
-			{
-				param->trans_id = strtoul(trans_id,NULL,0);
-			}
+//Current lifecycle state of a subdoc, pending_apply when no event is seen yet.
+WEBCFG_SUBDOC_STATE getSubdocState(const char *docname)
+{
+	subdoc_state_t *entry = NULL;
 
-			if(version !=NULL)
-			{
-				param->version = strtoul(version,NULL,0);
-			}
+	if(docname == NULL)
+	{
+		return SUBDOC_STATE_PENDING_APPLY;
+	}
+	entry = lookupSubdocState(docname, false);
+	return (entry != NULL) ? entry->state : SUBDOC_STATE_PENDING_APPLY;
+}
 
-			if(timeout !=NULL)
-			{
-				param->timeout = strtoul(timeout,NULL,0);
-			}
+const char * subdocStateToString(WEBCFG_SUBDOC_STATE state)
+{
+	switch(state)
+	{
+		case SUBDOC_STATE_PENDING_APPLY:
+			return "pending_apply";
+		case SUBDOC_STATE_PENDING:
+			return "pending";
+		case SUBDOC_STATE_APPLIED:
+			return "applied";
+		case SUBDOC_STATE_FAILED:
+			return "failed";
+		case SUBDOC_STATE_RETRYING:
+			return "retrying";
+		default:
+			return "unknown";
+	}
+}
 
-			if(err_code !=NULL)
+//Extract values from comma separated string into a typed event record, only a NACK failure_reason is allocated.
+//Fails when the subdoc name is missing, release the record with clearWebcfgEvent.
+int parseEventString(const char *str, webcfg_event_t *event)
+{
+	const char *p = str;
+	const char *end = NULL;
+
+	if(str == NULL || event == NULL)
+	{
+		return WEBCFG_FAILURE;
+	}
+	memset(event, 0, sizeof(webcfg_event_t));
+
+	p = getEventField(p, event->subdoc_name, sizeof(event->subdoc_name));
+	if(event->subdoc_name[0] == '\0')
+	{
+		WebcfgError("Event %s has no subdoc name\n", str);
+		return WEBCFG_FAILURE;
+	}
+	if(p != NULL)
+	{
+		event->trans_id = strtoul(p, NULL, 0);
+		p = getEventField(p, NULL, 0);
+	}
+	if(p != NULL)
+	{
+		event->version = strtoul(p, NULL, 0);
+		p = getEventField(p, NULL, 0);
+	}
+	if(p != NULL)
+	{
+		p = getEventField(p, event->status, sizeof(event->status));
+	}
+	if(p != NULL)
+	{
+		event->timeout = strtoul(p, NULL, 0);
+		p = getEventField(p, NULL, 0);
+	}
+	if(p != NULL)
+	{
+		WebcfgInfo("For NACK event: tmpStr with error_details is %s\n", p);
+		p = getEventField(p, event->process_name, sizeof(event->process_name));
+		if(p != NULL)
+		{
+			event->err_code = strtoul(p, NULL, 0);
+			p = getEventField(p, NULL, 0);
+		}
+		if(p != NULL && *p != '\0')
+		{
+			end = strchr(p, ',');
+			event->failure_reason = strndup(p, (end != NULL) ? (size_t)(end - p) : strlen(p));
+			if(event->failure_reason == NULL)
 			{
-				param->err_code = strtoul(err_code,NULL,0);
-				WebcfgDebug("param->err_code %lu\n", (long)param->err_code);
+				WebcfgError("Failed to allocate failure_reason for %s\n", event->subdoc_name);
+				return WEBCFG_FAILURE;
 			}
-
-			WebcfgDebug("param->subdoc_name %s param->trans_id %lu param->version %lu param->status %s param->timeout %lu\n", param->subdoc_name, (long)param->trans_id, (long)param->version, param->status, (long)param->timeout);
-			*val = param;
-			WEBCFG_FREE(token);
-			return WEBCFG_SUCCESS;
-		}		
+		}
+		WebcfgInfo("process_name %s err_code %lu failure_reason %s\n", event->process_name, (long)event->err_code, (event->failure_reason != NULL) ? event->failure_reason : "");
 	}
 
-	return WEBCFG_FAILURE;
+	event->type = getEventType(event->status, event->timeout);
+	WebcfgDebug("event->subdoc_name %s event->trans_id %lu event->version %lu event->status %s event->timeout %lu\n", event->subdoc_name, (long)event->trans_id, (long)event->version, event->status, (long)event->timeout);
+	return WEBCFG_SUCCESS;
+}
+
+//Compatibility wrapper, extracts values from comma separated string to a heap event_params_t structure. str is freed.
+int parseEventData(char* str, event_params_t **val)
+{
+	event_params_t *param = NULL;
+	webcfg_event_t event;
+	int rv = WEBCFG_FAILURE;
 
+	memset(&event, 0, sizeof(webcfg_event_t));
+	rv = parseEventString(str, &event);
+	if(str != NULL)
+	{
+		WEBCFG_FREE(str);
+	}
+	if(rv != WEBCFG_SUCCESS)
+	{
+		clearWebcfgEvent(&event);
+		return WEBCFG_FAILURE;
+	}
+	param = (event_params_t *)malloc(sizeof(event_params_t));
+	if(param == NULL)
+	{
+		clearWebcfgEvent(&event);
+		return WEBCFG_FAILURE;
+	}
+	memset(param, 0, sizeof(event_params_t));
+
+	param->subdoc_name = strdup(event.subdoc_name);
+	param->trans_id = event.trans_id;
+	param->version = event.version;
+	param->status = strdup(event.status);
+	param->timeout = event.timeout;
+	param->process_name = (event.process_name[0] != '\0') ? strdup(event.process_name) : NULL;
+	param->err_code = event.err_code;
+	//reason moves over as is
+	param->failure_reason = event.failure_reason;
+	if(param->subdoc_name == NULL || param->status == NULL || (event.process_name[0] != '\0' && param->process_name == NULL))
+	{
+		WebcfgError("Failed to allocate event params\n");
+		free_event_params_struct(param);
+		return WEBCFG_FAILURE;
+	}
+	*val = param;
+	return WEBCFG_SUCCESS;
 }
 
+//Free the heap part of an event record, the record itself is reusable afterwards.
+void clearWebcfgEvent(webcfg_event_t *event)
+{
+	if(event != NULL && event->failure_reason != NULL)
+	{
+		WEBCFG_FREE(event->failure_reason);
+	}
+}
 
 //To generate custom timer EXPIRE event for expired doc and add to event queue.
 void createTimerExpiryEvent(char *docName, uint16_t transid)
 {
-	char *expiry_event_data = NULL;
-	char data[128] = {0};
+	webcfg_event_t event;
 
-	snprintf(data,sizeof(data),"%s,%hu,%u,EXPIRE,%u",docName,transid,0,0);
-	expiry_event_data = strdup(data);
-	WebcfgDebug("expiry_event_data formed %s\n", expiry_event_data);
-	if(expiry_event_data)
+	setWebcfgEvent(&event, docName, transid, 0, "EXPIRE", 0);
+	WebcfgDebug("expiry event formed %s,%hu,EXPIRE\n", event.subdoc_name, transid);
+	if(addEventToQueue(&event) == 0)
 	{
-		addToEventQueue(expiry_event_data);
 		WebcfgDebug("Added EXPIRE event queue\n");
 	}
 	else
@@ -751,6 +851,7 @@ WEBCFG_STATUS startWebcfgTimer(expire_timer_t *timer_node, char *name, uint16_t
 			new_node->subdoc_name = strdup(name);
 			new_node->txid = transID;
 			new_node->timeout = timeout;
+			setTimerDeadline(new_node);
 			WebcfgDebug("started webcfg internal timer\n");
 
 			new_node->next=NULL;
@@ -759,6 +860,7 @@ WEBCFG_STATUS startWebcfgTimer(expire_timer_t *timer_node, char *name, uint16_t
 			if (g_timer_head == NULL)
 			{
 				g_timer_head = new_node;
+				pthread_cond_signal(&expire_timer_con);
 				pthread_mutex_unlock (&expire_timer_mut);
 			}
 			else
@@ -771,6 +873,7 @@ WEBCFG_STATUS startWebcfgTimer(expire_timer_t *timer_node, char *name, uint16_t
 					temp=temp->next;
 				}
 				temp->next=new_node;
+				pthread_cond_signal(&expire_timer_con);
 				pthread_mutex_unlock (&expire_timer_mut);
 			}
 
@@ -799,7 +902,10 @@ WEBCFG_STATUS updateTimerList(expire_timer_t *temp, int status, char *docname, u
 			temp->running = status;
 			temp->txid = transid;
 			temp->timeout = timeout;
+			setTimerDeadline(temp);
 			WebcfgInfo("doc timer %s is updated with txid %lu timeout %lu\n", docname, (long)temp->txid, (long)temp->timeout);
+			//wake timer loop to re-arm on the new deadline
+			pthread_cond_signal(&expire_timer_con);
 			pthread_mutex_unlock (&expire_timer_mut);
 			return WEBCFG_SUCCESS;
 		}
@@ -903,33 +1009,35 @@ WEBCFG_STATUS stopWebcfgTimer(expire_timer_t *temp, char *name, uint16_t trans_i
 	return WEBCFG_FAILURE;
 }
 
-//check timer expiry by decrementing timeout by 5 for 5s sleep.
+//check timer expiry by comparing each running doc deadline against CLOCK_MONOTONIC.
 int checkTimerExpired (char **exp_doc)
 {
 	expire_timer_t *temp = NULL;
-	temp = get_global_timer_node();
+	struct timespec now;
 
-	//Traverse through all docs in list, decrement timer and check if any doc expired.
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	pthread_mutex_lock (&expire_timer_mut);
+	temp = g_timer_head;
+
+	//Traverse through all docs in list and check if any doc deadline has passed.
 	while (NULL != temp)
 	{
 		WebcfgDebug("checking expiry for temp->subdoc_name %s\n",temp->subdoc_name);
 		if (temp->running)
 		{
 			WebcfgDebug("timer running for doc %s temp->timeout: %d\n",temp->subdoc_name, (int)temp->timeout);
-			if((int)temp->timeout <= 0)
+			if((temp->deadline.tv_sec < now.tv_sec) || ((temp->deadline.tv_sec == now.tv_sec) && (temp->deadline.tv_nsec <= now.tv_nsec)))
 			{
 				WebcfgInfo("Timer Expired for doc %s, doc apply failed\n", temp->subdoc_name);
 				*exp_doc = strdup(temp->subdoc_name);
 				WebcfgDebug("*exp_doc is %s\n", *exp_doc);
+				pthread_mutex_unlock (&expire_timer_mut);
 				return true;
 			}
-			pthread_mutex_lock (&expire_timer_mut);
-			temp->timeout = temp->timeout - 5;
-			pthread_mutex_unlock (&expire_timer_mut);
-			WebcfgDebug("temp->timeout %d for doc %s\n", temp->timeout, temp->subdoc_name);
 		}
 		temp= temp->next;
 	}
+	pthread_mutex_unlock (&expire_timer_mut);
 	return false;
 }
 
@@ -946,6 +1054,7 @@ WEBCFG_STATUS retryMultipartSubdoc(webconfig_tmp_data_t *docNode, char *docName)
 	int paramCount = 0;
 	uint16_t doc_transId = 0;
 	webcfgparam_t *pm = NULL;
+	mpdoc_params_t *params = NULL;
 	multipartdocs_t *gmp = NULL;
 	uint16_t err = 0;
 	char * errmsg = NULL;
@@ -955,232 +1064,210 @@ WEBCFG_STATUS retryMultipartSubdoc(webconfig_tmp_data_t *docNode, char *docName)
 	void *buff = NULL;
 #endif
 
-	gmp = get_global_mp();
+	gmp = acquireMpDoc(docName);
 
 	if(gmp ==NULL)
 	{
-		WebcfgError("Multipart mp cache is NULL\n");
+		WebcfgError("docName %s not found in mp cache\n", docName);
 		return rv;
 	}
 
 	if(checkAndUpdateTmpRetryCount(docNode, docName) !=WEBCFG_SUCCESS)
 	{
 		WebcfgError("checkAndUpdateTmpRetryCount failed\n");
+		releaseMpDoc(gmp);
 		return rv;
 	}
 
-	while( gmp != NULL)
+	WebcfgDebug("gmp->name_space %s\n", gmp->name_space);
+	WebcfgDebug("gmp->etag %lu\n" , (long)gmp->etag);
+	WebcfgDebug("gmp->data %s\n" , gmp->data);
+	WebcfgDebug("gmp->data_size is %zu\n", gmp->data_size);
+
+	//Decoded params are cached per doc version, so repeated retries skip the msgpack decode.
+	params = acquireMpDocParams(gmp, &err);
+	pm = (params != NULL) ? params->params : NULL;
+	if ( NULL != pm)
 	{
-		multipartdocs_t *temp_mp = NULL;
-		temp_mp = get_global_mp();
+		paramCount = (int)pm->entries_count;
 
-		if(temp_mp == NULL)
-		{
-			WebcfgInfo("mp cache list is empty. Exiting from subdoc retry.\n");
-			break;
-		}
+		reqParam = (param_t *) malloc(sizeof(param_t) * paramCount);
+		memset(reqParam,0,(sizeof(param_t) * paramCount));
 
-		if(strcmp(gmp->name_space, docName) == 0)
+		WebcfgDebug("paramCount is %d\n", paramCount);
+		for (i = 0; i < paramCount; i++)
 		{
-			WebcfgDebug("gmp->name_space %s\n", gmp->name_space);
-			WebcfgDebug("gmp->etag %lu\n" , (long)gmp->etag);
-			WebcfgDebug("gmp->data %s\n" , gmp->data);
-			WebcfgDebug("gmp->data_size is %zu\n", gmp->data_size);
-
-			WebcfgDebug("--------------decode root doc-------------\n");
-			pm = webcfgparam_convert( gmp->data, gmp->data_size+1 );
-			err = errno;
-			if ( NULL != pm)
-			{
-				paramCount = (int)pm->entries_count;
-
-				reqParam = (param_t *) malloc(sizeof(param_t) * paramCount);
-				memset(reqParam,0,(sizeof(param_t) * paramCount));
-
-				WebcfgDebug("paramCount is %d\n", paramCount);
-				for (i = 0; i < paramCount; i++)
+	                if(pm->entries[i].value != NULL)
+	                {
+				if(pm->entries[i].type == WDMP_BLOB)
 				{
-			                if(pm->entries[i].value != NULL)
-			                {
-						if(pm->entries[i].type == WDMP_BLOB)
+					char *appended_doc = NULL;
+					WebcfgDebug("B4 webcfg_appendeddoc\n");
+					appended_doc = webcfg_appendeddoc( gmp->name_space, gmp->etag, pm->entries[i].value, pm->entries[i].value_size, &doc_transId, &sendMsgsize);
+					
+					WebcfgDebug("webcfg_appendeddoc doc_transId is %hu\n", doc_transId);
+					reqParam[i].name = strdup(pm->entries[i].name);
+					#ifdef WEBCONFIG_BIN_SUPPORT
+						if(isRbusEnabled() && isRbusListener(gmp->name_space))
 						{
-							char *appended_doc = NULL;
-							WebcfgDebug("B4 webcfg_appendeddoc\n");
-							appended_doc = webcfg_appendeddoc( gmp->name_space, gmp->etag, pm->entries[i].value, pm->entries[i].value_size, &doc_transId, &sendMsgsize);
-							
-							WebcfgDebug("webcfg_appendeddoc doc_transId is %hu\n", doc_transId);
-							reqParam[i].name = strdup(pm->entries[i].name);
-							#ifdef WEBCONFIG_BIN_SUPPORT
-								if(isRbusEnabled() && isRbusListener(gmp->name_space))
-								{
-								        //Setting reqParam struct to avoid validate_request_param() failure
-									//disable string operation as it is binary data.
-									reqParam[i].value = appended_doc;
-									//setting reqParam type as base64 to indicate blob
-									reqParam[i].type = WDMP_BASE64;
-									buff = reqParam[i].value;
-								}
-								else
-								{
-									reqParam[i].value = strdup(appended_doc);
-									reqParam[i].type = WDMP_BASE64;
-									WEBCFG_FREE(appended_doc);
-								}
-							#else
-								reqParam[i].value = strdup(appended_doc);
-								reqParam[i].type = WDMP_BASE64;
-								WEBCFG_FREE(appended_doc);
-							#endif
-							//update doc_transId only for blob docs, not for scalars.
-							updateTmpList(docNode, gmp->name_space, gmp->etag, "pending", "failed_retrying", ccspStatus, doc_transId, 1);
+						        //Setting reqParam struct to avoid validate_request_param() failure
+							//disable string operation as it is binary data.
+							reqParam[i].value = appended_doc;
+							//setting reqParam type as base64 to indicate blob
+							reqParam[i].type = WDMP_BASE64;
+							buff = reqParam[i].value;
 						}
 						else
 						{
-							if(pm->entries[i].name !=NULL)
-							{
-								reqParam[i].name = strdup(pm->entries[i].name);
-							}
-							if(pm->entries[i].value !=NULL)
-							{
-								reqParam[i].value = strdup(pm->entries[i].value);
-							}
-							reqParam[i].type = pm->entries[i].type;
+							reqParam[i].value = strdup(appended_doc);
+							reqParam[i].type = WDMP_BASE64;
+							WEBCFG_FREE(appended_doc);
 						}
-			                }
-					WebcfgInfo("Request:> param[%d].name = %s, type = %d\n",i,reqParam[i].name,reqParam[i].type);
-					WebcfgDebug("Request:> param[%d].value = %s\n",i,reqParam[i].value);
+					#else
+						reqParam[i].value = strdup(appended_doc);
+						reqParam[i].type = WDMP_BASE64;
+						WEBCFG_FREE(appended_doc);
+					#endif
+					//update doc_transId only for blob docs, not for scalars.
+					updateTmpList(docNode, gmp->name_space, gmp->etag, "pending", "failed_retrying", ccspStatus, doc_transId, 1);
+				}
+				else
+				{
+					if(pm->entries[i].name !=NULL)
+					{
+						reqParam[i].name = strdup(pm->entries[i].name);
+					}
+					if(pm->entries[i].value !=NULL)
+					{
+						reqParam[i].value = strdup(pm->entries[i].value);
+					}
+					reqParam[i].type = pm->entries[i].type;
+				}
+	                }
+			WebcfgInfo("Request:> param[%d].name = %s, type = %d\n",i,reqParam[i].name,reqParam[i].type);
+			WebcfgDebug("Request:> param[%d].value = %s\n",i,reqParam[i].value);
+		}
+
+		if(reqParam !=NULL && validate_request_param(reqParam, paramCount) == WEBCFG_SUCCESS)
+		{
+			WebcfgDebug("Proceed to setValues..\n");
+			WebcfgDebug("retryMultipartSubdoc WebConfig SET Request\n");
+			#ifdef WEBCONFIG_BIN_SUPPORT
+				SubDocMeta_t meta;
+				// rbus_enabled and rbus_listener_supported, rbus_set direct API used to send binary data to component.
+				if(isRbusEnabled() && getSubDocMeta(gmp->name_space, &meta) == WEBCFG_SUCCESS && meta.rbus_listener)
+				{
+					blobSet_rbus(meta.dest, buff, sendMsgsize, &ret, &ccspStatus);
+				}
+				//rbus_enabled and rbus_listener_not_supported, rbus_set api used to send b64 encoded data to component.
+				else 
+				{
+					setValues_rbus(reqParam, paramCount, ATOMIC_SET_WEBCONFIG, NULL, NULL, &ret, &ccspStatus);
 				}
-
-				if(reqParam !=NULL && validate_request_param(reqParam, paramCount) == WEBCFG_SUCCESS)
+			#else
+			        //dbus_enabled, ccsp common library set api used to send data to component.
+				setValues(reqParam, paramCount, ATOMIC_SET_WEBCONFIG, NULL, NULL, &ret, &ccspStatus);
+			#endif
+			//setValues(reqParam, paramCount, ATOMIC_SET_WEBCONFIG, NULL, NULL, &ret, &ccspStatus);
+			if(ret == WDMP_SUCCESS)
+			{
+				WebcfgInfo("retryMultipartSubdoc setValues success. ccspStatus : %d\n", ccspStatus);
+				if(reqParam[0].type  != WDMP_BASE64)
 				{
-					WebcfgDebug("Proceed to setValues..\n");
-					WebcfgDebug("retryMultipartSubdoc WebConfig SET Request\n");
-					#ifdef WEBCONFIG_BIN_SUPPORT
-						// rbus_enabled and rbus_listener_supported, rbus_set direct API used to send binary data to component.
-						if(isRbusEnabled() && isRbusListener(gmp->name_space))
-						{
-							char topic[64] = {0};
-					        	get_destination(gmp->name_space, topic);
-							blobSet_rbus(topic, buff, sendMsgsize, &ret, &ccspStatus);
-						}
-						//rbus_enabled and rbus_listener_not_supported, rbus_set api used to send b64 encoded data to component.
-						else 
-						{
-							setValues_rbus(reqParam, paramCount, ATOMIC_SET_WEBCONFIG, NULL, NULL, &ret, &ccspStatus);
-						}
-					#else
-					        //dbus_enabled, ccsp common library set api used to send data to component.
-						setValues(reqParam, paramCount, ATOMIC_SET_WEBCONFIG, NULL, NULL, &ret, &ccspStatus);
-					#endif
-					//setValues(reqParam, paramCount, ATOMIC_SET_WEBCONFIG, NULL, NULL, &ret, &ccspStatus);
-					if(ret == WDMP_SUCCESS)
+					WebcfgDebug("For scalar docs, update trans_id as 0\n");
+					updateTmpList(docNode, gmp->name_space, gmp->etag, "success", "none", 0, 0, 0);
+					//send scalar success notification, delete tmp, updateDB
+					if(docNode !=NULL && docNode->cloud_trans_id !=NULL)
+					{
+						addWebConfgNotifyMsg(gmp->name_space, gmp->etag, "success", "none", docNode->cloud_trans_id, 0, "status", 0, NULL, 200);
+					}
+					WebcfgDebug("deleteFromTmpList as scalar doc is applied\n");
+					WebcfgDebug("docNode->isSupplementarySync is %d\n", docNode->isSupplementarySync);
+					if(docNode->isSupplementarySync == 0)
 					{
-						WebcfgInfo("retryMultipartSubdoc setValues success. ccspStatus : %d\n", ccspStatus);
-						if(reqParam[0].type  != WDMP_BASE64)
+						checkDBList(gmp->name_space,gmp->etag, NULL);
+						WebcfgInfo("checkRootUpdate scalar doc case\n");
+						if(checkRootUpdate() == WEBCFG_SUCCESS)
 						{
-							WebcfgDebug("For scalar docs, update trans_id as 0\n");
-							updateTmpList(docNode, gmp->name_space, gmp->etag, "success", "none", 0, 0, 0);
-							//send scalar success notification, delete tmp, updateDB
-							if(docNode !=NULL && docNode->cloud_trans_id !=NULL)
-							{
-								addWebConfgNotifyMsg(gmp->name_space, gmp->etag, "success", "none", docNode->cloud_trans_id, 0, "status", 0, NULL, 200);
-							}
-							WebcfgDebug("deleteFromTmpList as scalar doc is applied\n");
-							WebcfgDebug("docNode->isSupplementarySync is %d\n", docNode->isSupplementarySync);
-							if(docNode->isSupplementarySync == 0)
-							{
-								checkDBList(gmp->name_space,gmp->etag, NULL);
-								WebcfgInfo("checkRootUpdate scalar doc case\n");
-								if(checkRootUpdate() == WEBCFG_SUCCESS)
-								{
-									WebcfgDebug("updateRootVersionToDB\n");
-									updateRootVersionToDB();
-								}
-								addNewDocEntry(get_successDocCount());
-							}
-							else
-							{
-								WebcfgInfo("retryMultipartSubdoc. No DB update is required for supplementary sync\n");
-							}
-							WebcfgDebug("check for deleteRootAndMultipartDocs\n");
-							deleteRootAndMultipartDocs();
+							WebcfgDebug("updateRootVersionToDB\n");
+							updateRootVersionToDB();
 						}
-						rv = WEBCFG_SUCCESS;
+						addNewDocEntry(get_successDocCount());
 					}
 					else
 					{
-
-						WebcfgError("retryMultipartSubdoc setValues Failed. ccspStatus : %d\n", ccspStatus);
-						errd = mapStatus(ccspStatus);
-						WebcfgDebug("The errd value is %d\n",errd);
-
-						mapWdmpStatusToStatusMessage(errd, errDetails);
-						WebcfgDebug("The errDetails value is %s\n",errDetails);
-
-						if((ccspStatus == 192) || (ccspStatus == 204) || (ccspStatus == 191) || (ccspStatus == 193) || (ccspStatus == 190))
-						{
-							long long expiry_time = 0;
-							WebcfgDebug("ccspStatus is crash %d\n", ccspStatus);
-							snprintf(result,MAX_VALUE_LEN,"failed_retrying:%s", errDetails);
-							WebcfgDebug("The result is %s\n",result);
-							updateTmpList(docNode, gmp->name_space, gmp->etag, "pending", result, ccspStatus, 0, 1);
-							if(docNode !=NULL && docNode->cloud_trans_id !=NULL)
-							{
-								addWebConfgNotifyMsg(gmp->name_space, gmp->etag, "pending", result, docNode->cloud_trans_id, 0,"status",ccspStatus, NULL, 200);
-							}
-							expiry_time = getRetryExpiryTimeout();
-							set_doc_fail(1);
-							updateFailureTimeStamp(docNode, gmp->name_space, expiry_time);
-
-							//To get the exact time diff for retry from present time do the below
-							updateRetryTimeDiff(expiry_time);
-
-							WebcfgDebug("the retry flag value is %d\n", get_doc_fail());
-						}
-						else
-						{
-							snprintf(result,MAX_VALUE_LEN,"doc_rejected:%s", errDetails);
-							WebcfgDebug("The result is %s\n",result);
-							updateTmpList(docNode, gmp->name_space, gmp->etag, "failed", result, ccspStatus, 0, 0);
-							if(docNode !=NULL && docNode->cloud_trans_id !=NULL)
-							{
-								addWebConfgNotifyMsg(gmp->name_space, gmp->etag, "failed", result, docNode->cloud_trans_id, 0, "status", ccspStatus, NULL, 200);
-							}
-						}
+						WebcfgInfo("retryMultipartSubdoc. No DB update is required for supplementary sync\n");
 					}
-					reqParam_destroy(paramCount, reqParam);
+					WebcfgDebug("check for deleteRootAndMultipartDocs\n");
+					deleteRootAndMultipartDocs();
 				}
-				webcfgparam_destroy( pm );
+				rv = WEBCFG_SUCCESS;
 			}
 			else
 			{
-				WebcfgError("--------------decode root doc failed-------------\n");
-				char * msg = NULL;
-				msg = (char *)webcfgparam_strerror(err);
-				err = getStatusErrorCodeAndMessage(DECODE_ROOT_FAILURE, &errmsg);
-				snprintf(result,MAX_VALUE_LEN,"%s:%s", errmsg, msg);
-				updateTmpList(docNode, gmp->name_space, gmp->etag, "failed", result, err, 0, 0);
-				if(docNode !=NULL && docNode->cloud_trans_id !=NULL)
+
+				WebcfgError("retryMultipartSubdoc setValues Failed. ccspStatus : %d\n", ccspStatus);
+				errd = mapStatus(ccspStatus);
+				WebcfgDebug("The errd value is %d\n",errd);
+
+				mapWdmpStatusToStatusMessage(errd, errDetails);
+				WebcfgDebug("The errDetails value is %s\n",errDetails);
+
+				if((ccspStatus == 192) || (ccspStatus == 204) || (ccspStatus == 191) || (ccspStatus == 193) || (ccspStatus == 190))
 				{
-					addWebConfgNotifyMsg(gmp->name_space, gmp->etag, "failed", result, docNode->cloud_trans_id,0, "status", err, NULL, 200);
+					long long expiry_time = 0;
+					WebcfgDebug("ccspStatus is crash %d\n", ccspStatus);
+					snprintf(result,MAX_VALUE_LEN,"failed_retrying:%s", errDetails);
+					WebcfgDebug("The result is %s\n",result);
+					updateTmpList(docNode, gmp->name_space, gmp->etag, "pending", result, ccspStatus, 0, 1);
+					if(docNode !=NULL && docNode->cloud_trans_id !=NULL)
+					{
+						addWebConfgNotifyMsg(gmp->name_space, gmp->etag, "pending", result, docNode->cloud_trans_id, 0,"status",ccspStatus, NULL, 200);
+					}
+					expiry_time = getRetryExpiryTimeout();
+					set_doc_fail(1);
+					updateFailureTimeStamp(docNode, gmp->name_space, expiry_time);
+
+					WebcfgDebug("the retry flag value is %d\n", get_doc_fail());
+				}
+				else
+				{
+					snprintf(result,MAX_VALUE_LEN,"doc_rejected:%s", errDetails);
+					WebcfgDebug("The result is %s\n",result);
+					updateTmpList(docNode, gmp->name_space, gmp->etag, "failed", result, ccspStatus, 0, 0);
+					if(docNode !=NULL && docNode->cloud_trans_id !=NULL)
+					{
+						addWebConfgNotifyMsg(gmp->name_space, gmp->etag, "failed", result, docNode->cloud_trans_id, 0, "status", ccspStatus, NULL, 200);
+					}
 				}
-				WEBCFG_FREE(errmsg);
 			}
-			break;
+			reqParam_destroy(paramCount, reqParam);
 		}
-		else
+		releaseMpDocParams(params);
+	}
+	else
+	{
+		WebcfgError("--------------decode root doc failed-------------\n");
+		char * msg = NULL;
+		msg = (char *)webcfgparam_strerror(err);
+		err = getStatusErrorCodeAndMessage(DECODE_ROOT_FAILURE, &errmsg);
+		snprintf(result,MAX_VALUE_LEN,"%s:%s", errmsg, msg);
+		updateTmpList(docNode, gmp->name_space, gmp->etag, "failed", result, err, 0, 0);
+		if(docNode !=NULL && docNode->cloud_trans_id !=NULL)
 		{
-			WebcfgDebug("docName %s not found in mp list\n", docName);
-			gmp = gmp->next;
+			addWebConfgNotifyMsg(gmp->name_space, gmp->etag, "failed", result, docNode->cloud_trans_id,0, "status", err, NULL, 200);
 		}
+		WEBCFG_FREE(errmsg);
 	}
+	releaseMpDoc(gmp);
 	return rv;
 }
 
 WEBCFG_STATUS checkDBVersion(char *docname, uint32_t version)
 {
 	webconfig_db_data_t *webcfgdb = NULL;
-	webcfgdb = get_global_db_node();
+	webcfg_db_snapshot_t *snap = acquireDBSnapshot();
+	webcfgdb = (snap != NULL) ? snap->db_list : NULL;
 
 	//Traverse through doc list & check version for required doc
 	while (NULL != webcfgdb)
@@ -1191,11 +1278,13 @@ WEBCFG_STATUS checkDBVersion(char *docname, uint32_t version)
 			if(webcfgdb->version == version)
 			{
 				WebcfgInfo("webcfgdb version %lu is same for doc %s\n", (long)webcfgdb->version, docname);
+				releaseDBSnapshot(snap);
 				return WEBCFG_SUCCESS;
 			}
 		}
 		webcfgdb= webcfgdb->next;
 	}
+	releaseDBSnapshot(snap);
 	return WEBCFG_FAILURE;
 }
 
@@ -1218,8 +1307,8 @@ WEBCFG_STATUS checkAndUpdateTmpRetryCount(webconfig_tmp_data_t *temp, char *docn
 				}
 				return WEBCFG_FAILURE;
 			}
-			temp->retry_count++;
-			WebcfgDebug("temp->retry_count updated to %d for docname %s\n",temp->retry_count, docname);
+			int retry_count = incrementTmpRetryCount(temp);
+			WebcfgDebug("temp->retry_count updated to %d for docname %s\n", retry_count, docname);
 			return WEBCFG_SUCCESS;
 		}
 	}
@@ -1381,3 +1470,521 @@ int checkTmpNACKstatus(webconfig_tmp_data_t *temp, char *docname)
 	WebcfgDebug("Tmp list is empty or error_details is not NACK\n");
 	return 0;
 }
+
+/*----------------------------------------------------------------------------*/
+/*                             Internal functions                             */
+/*----------------------------------------------------------------------------*/
+
+//Arm node deadline at now + timeout seconds. Stopped timers keep a zero deadline.
+static void setTimerDeadline(expire_timer_t *node)
+{
+	if(node->running)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &node->deadline);
+		node->deadline.tv_sec += node->timeout;
+	}
+	else
+	{
+		memset(&node->deadline, 0, sizeof(struct timespec));
+	}
+}
+
+//Find the nearest deadline among running doc timers. Caller must hold expire_timer_mut.
+static int getNextTimerDeadline(struct timespec *deadline)
+{
+	expire_timer_t *temp = g_timer_head;
+	int found = false;
+
+	while (NULL != temp)
+	{
+		if (temp->running)
+		{
+			if(!found || (temp->deadline.tv_sec < deadline->tv_sec) || ((temp->deadline.tv_sec == deadline->tv_sec) && (temp->deadline.tv_nsec < deadline->tv_nsec)))
+			{
+				*deadline = temp->deadline;
+				found = true;
+			}
+		}
+		temp= temp->next;
+	}
+	return found;
+}
+
+//Copy one comma separated field into dst, truncated to len. Returns the start of the next field, NULL at end of string.
+static const char *getEventField(const char *str, char *dst, size_t len)
+{
+	const char *end = strchr(str, ',');
+	size_t n = (end != NULL) ? (size_t)(end - str) : strlen(str);
+
+	if(dst != NULL && len > 0)
+	{
+		if(n >= len)
+		{
+			n = len - 1;
+		}
+		memcpy(dst, str, n);
+		dst[n] = '\0';
+	}
+	return (end != NULL) ? end + 1 : NULL;
+}
+
+//Dispatch one event to its handler and move the subdoc to the next lifecycle state.
+//The state entry is a hash lookup, the tmp node is still a list walk in getTmpNode.
+static void processSubdocEvent(webcfg_event_t *event)
+{
+	webconfig_tmp_data_t * subdoc_node = NULL;
+	subdoc_state_t *entry = NULL;
+	WEBCFG_EVENT_TYPE outcome = EVENT_TYPE_NONE;
+	WEBCFG_SUBDOC_STATE prev = SUBDOC_STATE_PENDING_APPLY;
+
+	if(event->type <= EVENT_TYPE_NONE || event->type >= EVENT_TYPE_MAX)
+	{
+		WebcfgError("Invalid event type %d for %s\n", event->type, event->subdoc_name);
+		return;
+	}
+	entry = lookupSubdocState(event->subdoc_name, true);
+	if(isSuppressedEvent(event, entry))
+	{
+		__atomic_add_fetch(&event_suppressed, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	subdoc_node = getTmpNode(event->subdoc_name);
+	if(isGatedEvent(event, subdoc_node, entry))
+	{
+		return;
+	}
+
+	WebcfgDebug("Event detection\n");
+	outcome = eventHandlers[event->type](event, subdoc_node, entry);
+	if(outcome != EVENT_TYPE_NONE)
+	{
+		recordAcceptedEvent(event, entry);
+		prev = entry->state;
+		entry->state = subdocTransitions[prev][outcome];
+		//A failed retry also lands in failed, only a component NACK gates restarts and expiries.
+		entry->nack_failed = (entry->state == SUBDOC_STATE_FAILED) && (event->type == EVENT_TYPE_NACK);
+		if(entry->nack_failed)
+		{
+			entry->failed_version = (subdoc_node != NULL) ? subdoc_node->version : event->version;
+		}
+		WebcfgDebug("subdoc %s state %s -> %s\n", event->subdoc_name, subdocStateToString(prev), subdocStateToString(entry->state));
+	}
+}
+
+//Find the interned state entry of a subdoc, adding it when create is set. Never NULL when create is set.
+//Names that do not fit in the table are chained in subdocStateOverflow, each keeps its own state.
+static subdoc_state_t *lookupSubdocState(const char *docname, int create)
+{
+	const uint32_t mask = SUBDOC_STATE_TABLE_SIZE - 1;
+	uint32_t hash = 2166136261u;
+	uint32_t i = 0, idx = 0;
+	const char *p = NULL;
+	subdoc_state_t *entry = NULL;
+
+	//FNV-1a
+	for(p = docname; *p != '\0'; p++)
+	{
+		hash = (hash ^ (unsigned char)*p) * 16777619u;
+	}
+	for(i = 0; i < SUBDOC_STATE_TABLE_SIZE; i++)
+	{
+		idx = (hash + i) & mask;
+		if(subdocStates[idx].name[0] == '\0')
+		{
+			if(!create)
+			{
+				return NULL;
+			}
+			initSubdocState(&subdocStates[idx], docname, hash);
+			return &subdocStates[idx];
+		}
+		if((subdocStates[idx].hash == hash) && (strcmp(subdocStates[idx].name, docname) == 0))
+		{
+			return &subdocStates[idx];
+		}
+	}
+	for(entry = subdocStateOverflow; entry != NULL; entry = entry->next)
+	{
+		if((entry->hash == hash) && (strcmp(entry->name, docname) == 0))
+		{
+			return entry;
+		}
+	}
+	if(!create)
+	{
+		return NULL;
+	}
+	entry = (subdoc_state_t *)malloc(sizeof(subdoc_state_t));
+	if(entry == NULL)
+	{
+		//out of memory, the event is still processed but its state is not kept
+		WebcfgError("Failed to allocate state for %s, it is not tracked\n", docname);
+		initSubdocState(&subdocStateScratch, docname, hash);
+		return &subdocStateScratch;
+	}
+	WebcfgInfo("Subdoc state table full, %s is chained\n", docname);
+	initSubdocState(entry, docname, hash);
+	entry->next = subdocStateOverflow;
+	subdocStateOverflow = entry;
+	return entry;
+}
+
+static void initSubdocState(subdoc_state_t *entry, const char *docname, uint32_t hash)
+{
+	memset(entry, 0, sizeof(subdoc_state_t));
+	snprintf(entry->name, sizeof(entry->name), "%s", docname);
+	entry->hash = hash;
+	entry->state = SUBDOC_STATE_PENDING_APPLY;
+	entry->flags = ((strcmp(docname, "mesh") == 0) || (strcmp(docname, "advsecurity") == 0)) ? SUBDOC_FLAG_CLIENT_NOTIFY : 0;
+}
+
+//EXPIRE and restart events must not re-apply the version that failed with NACK, and a timer expiry is stale once the doc is applied.
+static int isGatedEvent(webcfg_event_t *event, webconfig_tmp_data_t *subdoc_node, subdoc_state_t *entry)
+{
+	if((entry->state == SUBDOC_STATE_APPLIED) && (event->type == EVENT_TYPE_EXPIRE))
+	{
+		WebcfgInfo("Skip stale EXPIRE event for applied doc %s\n", event->subdoc_name);
+		return true;
+	}
+	if((entry->state == SUBDOC_STATE_FAILED) && entry->nack_failed && ((event->type == EVENT_TYPE_EXPIRE) || (event->type == EVENT_TYPE_COMP_INIT) || (event->type == EVENT_TYPE_CRASH)))
+	{
+		if((subdoc_node != NULL) && (subdoc_node->version == entry->failed_version))
+		{
+			WebcfgInfo("Skip %s event for %s, version %lu failed with NACK\n", (event->status[0] != '\0') ? event->status : "crash", event->subdoc_name, (long)entry->failed_version);
+			return true;
+		}
+	}
+	return false;
+}
+
+//Component responses repeating the last accepted one, or carrying a superseded trans_id, are dropped before the handlers run.
+static int isSuppressedEvent(webcfg_event_t *event, subdoc_state_t *entry)
+{
+	webcfg_db_snapshot_t *snap = NULL;
+	webconfig_tmp_data_t *node = NULL;
+	int reused = 0;
+	int i = 0;
+
+	if((event->type != EVENT_TYPE_ACK) && (event->type != EVENT_TYPE_NACK) && (event->type != EVENT_TYPE_TIMEOUT))
+	{
+		return false;
+	}
+	if(entry->has_last && (entry->last_type == event->type) && (entry->last_trans_id == event->trans_id) && (entry->last_version == event->version) && (entry->last_timeout == event->timeout) && (strcmp(entry->last_status, event->status) == 0))
+	{
+		WebcfgInfo("Suppress duplicate %s event for %s trans_id %lu\n", event->status, event->subdoc_name, (long)event->trans_id);
+		return true;
+	}
+	for(i = 0; i < entry->stale_count; i++)
+	{
+		if(entry->stale_txids[i] == event->trans_id)
+		{
+			//trans_id is random, a new blob may reuse an old one
+			snap = acquireDBSnapshot();
+			node = getSnapshotTmpNode(snap, event->subdoc_name);
+			reused = (node != NULL) && (node->trans_id == event->trans_id);
+			releaseDBSnapshot(snap);
+			if(reused)
+			{
+				entry->stale_txids[i] = entry->stale_txids[--entry->stale_count];
+				return false;
+			}
+			WebcfgInfo("Suppress stale %s event for %s, trans_id %lu is superseded by %lu\n", event->status, event->subdoc_name, (long)event->trans_id, (long)entry->last_trans_id);
+			return true;
+		}
+	}
+	return false;
+}
+
+//Remember the accepted component response, an earlier trans_id of the doc becomes stale.
+static void recordAcceptedEvent(webcfg_event_t *event, subdoc_state_t *entry)
+{
+	int i = 0;
+
+	if((event->type != EVENT_TYPE_ACK) && (event->type != EVENT_TYPE_NACK) && (event->type != EVENT_TYPE_TIMEOUT))
+	{
+		return;
+	}
+	if(entry->has_last && (entry->last_trans_id != event->trans_id))
+	{
+		if(entry->stale_count < SUBDOC_STALE_TXID_MAX)
+		{
+			entry->stale_count++;
+		}
+		for(i = entry->stale_count - 1; i > 0; i--)
+		{
+			entry->stale_txids[i] = entry->stale_txids[i - 1];
+		}
+		entry->stale_txids[0] = entry->last_trans_id;
+	}
+	entry->has_last = true;
+	entry->last_type = event->type;
+	entry->last_trans_id = event->trans_id;
+	entry->last_version = event->version;
+	entry->last_timeout = event->timeout;
+	memcpy(entry->last_status, event->status, sizeof(entry->last_status));
+}
+
+//ACK without timeout, doc apply success. Add to DB, update tmp list and send success notification.
+static WEBCFG_EVENT_TYPE handleAckEvent(webcfg_event_t *event, webconfig_tmp_data_t *subdoc_node, subdoc_state_t *entry)
+{
+	//Based on ACK event if mesh/cujo is enabled then connected client notification need to be turned OFF
+	if(entry->flags & SUBDOC_FLAG_CLIENT_NOTIFY)
+	{
+		WebcfgInfo("ACK for mesh/cujo received: %s,%lu,%lu,%s,%lu\n", event->subdoc_name,(long)event->trans_id, (long)event->version, event->status, (long)event->timeout);
+		handleConnectedClientNotify(event->status);
+	}
+
+	WebcfgInfo("ACK EVENT: %s,%lu,%lu,ACK,%lu %s\n", event->subdoc_name,(long)event->trans_id, (long)event->version, (long)event->timeout, "(doc apply success)");
+	WebcfgInfo("doc apply success, proceed to add to DB\n");
+	if(validateEvent(subdoc_node, event->subdoc_name, event->trans_id) != WEBCFG_SUCCESS)
+	{
+		return EVENT_TYPE_NONE;
+	}
+	//version in event &tmp are not same indicates latest doc is not yet applied
+	if(getDocVersionFromTmpList(subdoc_node, event->subdoc_name) != event->version)
+	{
+		WebcfgError("ACK event version and tmp cache version are not same\n");
+		return EVENT_TYPE_NONE;
+	}
+	stopWebcfgTimer(getTimerNode(event->subdoc_name), event->subdoc_name, event->trans_id);
+	applySubdocSuccess(subdoc_node, event);
+	return EVENT_TYPE_ACK;
+}
+
+//NACK without timeout, doc apply failed. Update tmp list and send failure notification.
+static WEBCFG_EVENT_TYPE handleNackEvent(webcfg_event_t *event, webconfig_tmp_data_t *subdoc_node, subdoc_state_t *entry)
+{
+	char *err_details = NULL;
+	int len = 0;
+	const char *process_name = NULL;
+	const char *failure_reason = NULL;
+	char * cloud_trans_id = NULL;
+
+	(void) entry;
+	WebcfgInfo("NACK EVENT: %s,%lu,%lu,NACK,%lu %s\n", event->subdoc_name,(long)event->trans_id, (long)event->version, (long)event->timeout, "(doc apply failed)");
+	WebcfgError("doc apply failed for %s\n", event->subdoc_name);
+	if(validateEvent(subdoc_node, event->subdoc_name, event->trans_id) != WEBCFG_SUCCESS)
+	{
+		return EVENT_TYPE_NONE;
+	}
+	if(getDocVersionFromTmpList(subdoc_node, event->subdoc_name) != event->version)
+	{
+		WebcfgError("NACK event version and tmp cache version are not same\n");
+		return EVENT_TYPE_NONE;
+	}
+	stopWebcfgTimer(getTimerNode(event->subdoc_name), event->subdoc_name, event->trans_id);
+	process_name = (event->process_name[0] != '\0') ? event->process_name : "unknown";
+	failure_reason = (event->failure_reason != NULL) ? event->failure_reason : "unknown";
+	//sized to the reason so the tmp list keeps it whole
+	len = snprintf(NULL, 0, "NACK:%s,%s", process_name, failure_reason);
+	err_details = (char *)malloc(len + 1);
+	if(err_details == NULL)
+	{
+		WebcfgError("Failed to allocate err_details for %s\n", event->subdoc_name);
+		return EVENT_TYPE_NONE;
+	}
+	snprintf(err_details, len + 1, "NACK:%s,%s", process_name, failure_reason);
+	WebcfgDebug("err_details : %s, err_code : %lu\n", err_details, (long) event->err_code);
+	WebcfgInfo("subdoc_name and err_code : %s %lu\n", event->subdoc_name, (long) event->err_code);
+	WebcfgInfo("failure_reason %s\n", err_details);
+	updateTmpList(subdoc_node, event->subdoc_name, event->version, "failed", err_details, event->err_code, event->trans_id, 0);
+	WebcfgDebug("get_global_transID is %s\n", get_global_transID());
+	if(subdoc_node !=NULL && subdoc_node->cloud_trans_id !=NULL)
+	{
+		cloud_trans_id = subdoc_node->cloud_trans_id;
+	}
+	else
+	{
+		WebcfgInfo("subdoc_node is NULL, cloud_trans_id is unknown\n");
+		cloud_trans_id = "unknown";
+	}
+	WebcfgDebug("cloud_trans_id is %s\n", cloud_trans_id);
+	addWebConfgNotifyMsg(event->subdoc_name, event->version, "failed", err_details, cloud_trans_id, event->timeout, "status", event->err_code, NULL, 200);
+	WEBCFG_FREE(err_details);
+	return EVENT_TYPE_NACK;
+}
+
+//Internal EXPIRE event, doc apply timer expired. Notify pending and retry the doc.
+static WEBCFG_EVENT_TYPE handleExpireEvent(webcfg_event_t *event, webconfig_tmp_data_t *subdoc_node, subdoc_state_t *entry)
+{
+	uint32_t docVersion = 0;
+
+	(void) entry;
+	WebcfgInfo("EXPIRE EVENT: %s,%lu,%lu,EXPIRE,%lu\n", event->subdoc_name,(long)event->trans_id, (long)event->version, (long)event->timeout);
+	WebcfgInfo("doc apply timeout expired, need to retry\n");
+	WebcfgDebug("get_global_transID is %s\n", get_global_transID());
+	if(event->version !=0)
+	{
+		docVersion = event->version;
+	}
+	else
+	{
+		docVersion = getDocVersionFromTmpList(subdoc_node, event->subdoc_name);
+	}
+	WebcfgDebug("docVersion %lu\n", (long) docVersion);
+	if(subdoc_node !=NULL && subdoc_node->cloud_trans_id !=NULL)
+	{
+		addWebConfgNotifyMsg(event->subdoc_name, docVersion, "pending", "timer_expired", subdoc_node->cloud_trans_id, event->timeout, "status", 0, NULL, 200);
+	}
+	//To avoid NACK blob re-apply on EXPIRE event after 304
+	if(checkTmpNACKstatus(subdoc_node, event->subdoc_name))
+	{
+		WebcfgInfo("Skip retry for %s as blob apply status is NACK\n", event->subdoc_name);
+		return EVENT_TYPE_NACK;
+	}
+	WebcfgDebug("retryMultipartSubdoc for EXPIRE case\n");
+	if(retryMultipartSubdoc(subdoc_node, event->subdoc_name) == WEBCFG_SUCCESS)
+	{
+		WebcfgDebug("retryMultipartSubdoc success\n");
+		return EVENT_TYPE_EXPIRE;
+	}
+	handleRetryFailure(subdoc_node, event->subdoc_name, docVersion);
+	return EVENT_TYPE_NACK;
+}
+
+//ACK with timeout, doc apply needs more time. Start the doc timer and notify pending.
+static WEBCFG_EVENT_TYPE handleTimeoutEvent(webcfg_event_t *event, webconfig_tmp_data_t *subdoc_node, subdoc_state_t *entry)
+{
+	char * cloud_trans_id = NULL;
+
+	(void) entry;
+	WebcfgInfo("TIMEOUT EVENT: %s,%lu,%lu,ACK,%lu %s\n", event->subdoc_name,(long)event->trans_id, (long)event->version, (long)event->timeout,"(doc apply need time)");
+	WebcfgInfo("doc apply need time, start timer.\n");
+	if(validateEvent(subdoc_node, event->subdoc_name, event->trans_id) != WEBCFG_SUCCESS)
+	{
+		return EVENT_TYPE_NONE;
+	}
+	if(getDocVersionFromTmpList(subdoc_node, event->subdoc_name) != event->version)
+	{
+		WebcfgError("Timeout event version and tmp cache version are not same\n");
+		return EVENT_TYPE_NONE;
+	}
+	startWebcfgTimer(getTimerNode(event->subdoc_name), event->subdoc_name, event->trans_id, event->timeout);
+	if(subdoc_node !=NULL && subdoc_node->cloud_trans_id !=NULL)
+	{
+		cloud_trans_id = subdoc_node->cloud_trans_id;
+	}
+	else
+	{
+		WebcfgInfo("subdoc_node is NULL, cloud_trans_id is unknown\n");
+		cloud_trans_id = "unknown";
+	}
+	WebcfgDebug("cloud_trans_id is %s\n", cloud_trans_id);
+	addWebConfgNotifyMsg(event->subdoc_name, event->version, "pending", NULL, cloud_trans_id,event->timeout, "ack", 0, NULL, 200);
+	return EVENT_TYPE_TIMEOUT;
+}
+
+//COMP_INIT or crash event, component (re)started. Re-send blob when tmp list has a newer version.
+static WEBCFG_EVENT_TYPE handleRestartEvent(webcfg_event_t *event, webconfig_tmp_data_t *subdoc_node, subdoc_state_t *entry)
+{
+	uint32_t tmpVersion = 0;
+
+	(void) entry;
+	if (event->type == EVENT_TYPE_COMP_INIT)
+	{
+		WebcfgInfo("COMP_INIT EVENT: %s,%d,%lu\n", event->subdoc_name,0, (long)event->version);
+		WebcfgInfo("Component initialized, check and re-send blob.\n");
+	}
+	else
+	{
+		WebcfgInfo("Crash EVENT: %s,%d,%lu\n", event->subdoc_name,0, (long)event->version);
+		WebcfgInfo("Component restarted after crash, re-send blob.\n");
+	}
+
+	//If version in event and tmp are not matching, re-send blob to retry.
+	if(checkDBVersion(event->subdoc_name, event->version) !=WEBCFG_SUCCESS)
+	{
+		WebcfgDebug("DB and event version are not same, check tmp list\n");
+		tmpVersion = getDocVersionFromTmpList(subdoc_node, event->subdoc_name);
+		if (tmpVersion == 0)
+		{
+			//tmpVersion=0 indicate already doc is applied & doc is not available in tmp list
+			WebcfgDebug("tmpVersion is 0, DB already in latest version\n");
+			return EVENT_TYPE_NONE;
+		}
+		if(tmpVersion != event->version)
+		{
+			return retrySubdocFromTmp(subdoc_node, event, tmpVersion);
+		}
+		//already in tmp latest version,send success notify, updateDB
+		WebcfgInfo("tmp version %lu same as event version %lu\n",(long)tmpVersion, (long)event->version);
+		applySubdocSuccess(subdoc_node, event);
+		return EVENT_TYPE_ACK;
+	}
+
+	WebcfgDebug("DB and event version are same, check tmp list\n");
+	tmpVersion = getDocVersionFromTmpList(subdoc_node, event->subdoc_name);
+	//tmpVersion=0 indicate already doc is applied & deleted frm tmp list
+	if((tmpVersion !=0) && (tmpVersion != event->version))
+	{
+		return retrySubdocFromTmp(subdoc_node, event, tmpVersion);
+	}
+	WebcfgInfo("Already in latest version, no need to retry\n");
+	return EVENT_TYPE_NONE;
+}
+
+//Send success notification, add to DB and clean up tmp list once all docs are applied.
+static void applySubdocSuccess(webconfig_tmp_data_t *subdoc_node, webcfg_event_t *event)
+{
+	sendSuccessNotification(subdoc_node, event->subdoc_name, event->version, event->trans_id);
+	//No DB update for supplementary sync as version is not required to be stored.
+	if(subdoc_node->isSupplementarySync == 0)
+	{
+		WebcfgDebug("AddToDB subdoc_name %s version %lu\n", event->subdoc_name, (long)event->version);
+		checkDBList(event->subdoc_name,event->version, NULL);
+		WebcfgDebug("checkRootUpdate\n");
+		if(checkRootUpdate() == WEBCFG_SUCCESS)
+		{
+			WebcfgDebug("updateRootVersionToDB\n");
+			updateRootVersionToDB();
+		}
+		addNewDocEntry(get_successDocCount());
+	}
+	else
+	{
+		WebcfgInfo("No DB update for supplementary sync as version is not required to be stored.\n");
+	}
+	//root doc delete from tmp list and mp docs destroy can be done irrespective of primary/supplementary checks as all docs success can be reached during any sync.
+	WebcfgDebug("check for deleteRootAndMultipartDocs\n");
+	deleteRootAndMultipartDocs();
+}
+
+//Retry tmp list version of a doc after component restart, NACK docs are not re-applied.
+static WEBCFG_EVENT_TYPE retrySubdocFromTmp(webconfig_tmp_data_t *subdoc_node, webcfg_event_t *event, uint32_t version)
+{
+	//To avoid NACK blob re-apply on CRASH event after 304
+	if(checkTmpNACKstatus(subdoc_node, event->subdoc_name))
+	{
+		WebcfgInfo("Skip retry for %s as blob apply status is NACK\n", event->subdoc_name);
+		return EVENT_TYPE_NACK;
+	}
+	WebcfgInfo("tmp list has new version %lu for doc %s, retry\n", (long)version, event->subdoc_name);
+	//retry with latest tmp version, wait for ACK to send success notification and Update DB
+	if(retryMultipartSubdoc(subdoc_node, event->subdoc_name) == WEBCFG_SUCCESS)
+	{
+		WebcfgDebug("retryMultipartSubdoc success\n");
+		return event->type;
+	}
+	handleRetryFailure(subdoc_node, event->subdoc_name, version);
+	return EVENT_TYPE_NACK;
+}
+
+//Mark doc failed and notify when retry could not be sent and retries are left.
+static void handleRetryFailure(webconfig_tmp_data_t *subdoc_node, char *docname, uint32_t version)
+{
+	uint16_t err = 0;
+	char* errmsg = NULL;
+
+	WebcfgError("retryMultipartSubdoc failed\n");
+	if((subdoc_node != NULL) && (subdoc_node->retry_count < 3))
+	{
+		err = getStatusErrorCodeAndMessage(SUBDOC_RETRY_FAILED, &errmsg);
+		WebcfgDebug("The error_details is %s and err_code is %d\n", errmsg, err);
+		updateTmpList(subdoc_node, docname, version, "failed", errmsg, err, subdoc_node->trans_id, subdoc_node->retry_count);
+		if(subdoc_node->cloud_trans_id != NULL)
+		{
+			addWebConfgNotifyMsg(docname, version, "failed", errmsg, subdoc_node->cloud_trans_id ,0, "status", err, NULL, 200);
+		}
+		WEBCFG_FREE(errmsg);
+	}
+}
@@ -17,16 +17,66 @@
 #define ERRHANDLE_H
 
 #include <stdint.h>
+#include <time.h>
 #include "webcfg.h"
 #include "webcfg_db.h"
 
 #define MAX_APPLY_RETRY_COUNT 3
 
-typedef struct _event_data
+/* Component event queue capacity, must be a power of 2. */
+#define WEBCFG_EVENT_QUEUE_SIZE 128
+
+#define EVENT_NAME_LEN		64
+#define EVENT_STATUS_LEN	32
+#define EVENT_PROCESS_LEN	64
+
+/* Event kinds, classified once from the status string and timeout when the
+ * record is built. */
+typedef enum
+{
+	EVENT_TYPE_NONE = 0,
+	EVENT_TYPE_ACK,
+	EVENT_TYPE_NACK,
+	EVENT_TYPE_EXPIRE,
+	EVENT_TYPE_TIMEOUT,
+	EVENT_TYPE_COMP_INIT,
+	EVENT_TYPE_CRASH,
+	EVENT_TYPE_MAX
+} WEBCFG_EVENT_TYPE;
+
+/* Per subdoc apply lifecycle driven by component events. */
+typedef enum
+{
+	SUBDOC_STATE_PENDING_APPLY = 0,
+	SUBDOC_STATE_PENDING,
+	SUBDOC_STATE_APPLIED,
+	SUBDOC_STATE_FAILED,
+	SUBDOC_STATE_RETRYING,
+	SUBDOC_STATE_MAX
+} WEBCFG_SUBDOC_STATE;
+
+/* Typed component event record. Fields are inline so events are queued and
+ * processed without heap allocation, an empty string means not set. The
+ * free-form NACK failure_reason is the exception, it is kept whole on the
+ * heap and owned by the record, see clearWebcfgEvent. */
+typedef struct _webcfg_event
+{
+	char subdoc_name[EVENT_NAME_LEN];
+	uint16_t trans_id;
+	uint32_t version;
+	char status[EVENT_STATUS_LEN];
+	uint32_t timeout;
+	char process_name[EVENT_PROCESS_LEN];
+	uint16_t err_code;
+	char *failure_reason;
+	WEBCFG_EVENT_TYPE type;
+} webcfg_event_t;
+
+typedef struct _event_slot
 {
-	char * data;
-	struct _event_data *next;
-} event_data_t;
+	unsigned long seq;
+	webcfg_event_t event;
+} event_slot_t;
 
 typedef struct _event_params
 {
@@ -45,6 +95,7 @@ typedef struct expire_timer_list
 {
 	int running;
 	uint32_t timeout;
+	struct timespec deadline;
 	char *subdoc_name;
 	uint16_t txid;
 	struct expire_timer_list *next;
@@ -54,6 +105,19 @@ void initEventHandlingTask();
 void processWebcfgEvents();
 
 void webcfgCallback(char *Info, void* user_data);
+int addToEventQueue(char *buf);
+int addEventToQueue(webcfg_event_t *event);
+void clearWebcfgEvent(webcfg_event_t *event);
+void setWebcfgEvent(webcfg_event_t *event, const char *name, uint16_t trans_id, uint32_t version, const char *status, uint32_t timeout);
+int parseEventString(const char *str, webcfg_event_t *event);
+WEBCFG_EVENT_TYPE getEventType(const char *status, uint32_t timeout);
+WEBCFG_SUBDOC_STATE getSubdocState(const char *docname);
+void resetSubdocStates(void);
+const char * subdocStateToString(WEBCFG_SUBDOC_STATE state);
+unsigned long get_global_event_queue_hwm(void);
+unsigned long get_global_event_queue_dropped(void);
+int resetEventQueue(void);
+unsigned long get_global_event_suppressed(void);
 WEBCFG_STATUS retryMultipartSubdoc(webconfig_tmp_data_t *docNode, char *docName);
 WEBCFG_STATUS checkAndUpdateTmpRetryCount(webconfig_tmp_data_t *temp, char *docname);
 uint32_t getDocVersionFromTmpList(webconfig_tmp_data_t *temp, char *docname);
@@ -64,6 +128,8 @@ pthread_t get_global_event_threadid();
 pthread_t get_global_process_threadid();
 pthread_cond_t *get_global_event_con(void);
 pthread_mutex_t *get_global_event_mut(void);
+pthread_cond_t *get_global_expire_timer_con(void);
+pthread_mutex_t *get_global_expire_timer_mut(void);
 int checkTmpNACKstatus(webconfig_tmp_data_t *temp, char *docname);
 WEBCFG_STATUS checkDBVersion(char *docname, uint32_t version);
 WEBCFG_STATUS updateTimerList(expire_timer_t *temp, int status, char *docname, uint16_t transid, uint32_t timeout);
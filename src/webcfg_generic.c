@@ -64,6 +64,7 @@ int __attribute__((weak)) Set_Supplementary_URL( char *name, char *pString);
 #endif
 void __attribute__((weak)) setValues(const param_t paramVal[], const unsigned int paramCount, const int setType, char *transactionId, money_trace_spans *timeSpan, WDMP_STATUS *retStatus, int *ccspStatus);
 void __attribute__((weak)) sendNotification(char *payload, char *source, char *destination);
+int __attribute__((weak)) sendNotificationWithStatus(char *payload, char *source, char *destination);
 int __attribute__((weak)) registerWebcfgEvent(WebConfigEventCallback webcfgEventCB);
 int __attribute__((weak)) unregisterWebcfgEvent();
 WDMP_STATUS __attribute__((weak)) mapStatus(int ret);
@@ -320,6 +321,21 @@ void sendNotification(char *payload, char *source, char *destination)
 	return;
 }
 
+int sendNotificationWithStatus(char *payload, char *source, char *destination)
+{
+#ifdef WEBCONFIG_BIN_SUPPORT
+	WebcfgDebug("Inside sendNotificationWithStatus weak impl\n");
+	if(isRbusEnabled())
+	{
+		WebcfgDebug("B4 sendNotification_rbus\n");
+		return sendNotification_rbus(payload, source, destination);
+	}
+#endif
+	//sendNotification reports no status, so a hand-off to it counts as delivered.
+	sendNotification(payload, source, destination);
+	return 1;
+}
+
 int registerWebcfgEvent(WebConfigEventCallback webcfgEventCB)
 {
 	int ret = 0;
@@ -92,6 +92,16 @@ void setValues(const param_t paramVal[], const unsigned int paramCount, const in
  */
 void sendNotification(char *payload, char *source, char *destination);
 
+/**
+ * @brief sendNotificationWithStatus sends event notification and reports delivery.
+ *
+ * @param[in] payload Notify payload to be send to cloud.
+ * @param[in] source The source end from which notify event is triggered.
+ * @param[in] destination The destination at which notification has to be reached.
+ * @return 1 if the notification was handed to the upstream transport, 0 otherwise.
+ */
+int sendNotificationWithStatus(char *payload, char *source, char *destination);
+
 typedef void (*WebConfigEventCallback)(char* Info, void *user_data);
 int registerWebcfgEvent(WebConfigEventCallback webcfgEventCB);
 int unregisterWebcfgEvent();
@@ -17,9 +17,19 @@
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/inotify.h>
 #include "webcfg_log.h"
 #include "webcfg_metadata.h"
 #include "webcfg_multipart.h"
+#include "webcfg_notify.h"
+#ifdef FEATURE_SUPPORT_MQTTCM
+#include "webcfg_mqtt.h"
+#endif
+#ifdef WEBCONFIG_BIN_SUPPORT
+#include "webcfg_rbus.h"
+#endif
 
 /*----------------------------------------------------------------------------*/
 /*                                   Macros                                   */
@@ -28,6 +38,36 @@
 /*----------------------------------------------------------------------------*/
 /*                               Data Structures                              */
 /*----------------------------------------------------------------------------*/
+//Open addressing slot of a metadata index, an empty slot has name NULL.
+typedef struct
+{
+	const char *name;
+	uint32_t hash;
+	SubDocMeta_t meta;
+} metaIndexSlot_t;
+
+//One generation of the parsed properties file.
+typedef struct
+{
+	char *supported_bits;
+	char *supported_version;
+	char *supplementary_docs;
+	SubDocSupportMap_t *sdHead;
+	SubDocSupportMap_t *sdTail;
+	SupplementaryDocs_t *spHead;
+	SupplementaryDocs_t *spTail;
+	//Tunables found in the file, applied only once the whole file parsed.
+	int has_notify_batch_window;
+	unsigned int notify_batch_window;
+#ifdef WEBCONFIG_BIN_SUPPORT
+	int has_set_batch_size;
+	unsigned int set_batch_size;
+#endif
+#ifdef FEATURE_SUPPORT_MQTTCM
+	int has_mqtt_publish_async;
+	int mqtt_publish_async;
+#endif
+} webcfgProperties_t;
 
 /*----------------------------------------------------------------------------*/
 /*                            File Scoped Variables                           */
@@ -39,10 +79,36 @@ SubDocSupportMap_t *g_sdInfoHead = NULL;
 SubDocSupportMap_t *g_sdInfoTail = NULL;
 SupplementaryDocs_t *g_spInfoHead = NULL;
 SupplementaryDocs_t *g_spInfoTail = NULL;
+//Indexes are rebuilt from the lists on the first lookup after a list changes.
+//The mutex also guards the properties swap, readers outside this file take copies under it.
+static pthread_mutex_t metadata_index_mut = PTHREAD_MUTEX_INITIALIZER;
+static metaIndexSlot_t *sdIndex = NULL;
+static uint32_t sdIndexMask = 0;
+static int sdIndexDirty = 1;
+static metaIndexSlot_t *spIndex = NULL;
+static uint32_t spIndexMask = 0;
+static int spIndexDirty = 1;
+static pthread_mutex_t properties_watcher_mut = PTHREAD_MUTEX_INITIALIZER;
+static int propertiesWatcherStarted = 0;
+static char propertiesFile[256] = {'\0'};
 /*----------------------------------------------------------------------------*/
 /*                             Function Prototypes                            */
 /*----------------------------------------------------------------------------*/
 void displaystruct();
+static void markMetaIndexDirty(int sd, int sp);
+static uint32_t metaIndexHash(const char *name);
+static metaIndexSlot_t *allocMetaIndex(int count, uint32_t *mask);
+static metaIndexSlot_t *insertMetaIndex(metaIndexSlot_t *index, uint32_t mask, const char *name);
+static metaIndexSlot_t *findMetaIndex(metaIndexSlot_t *index, uint32_t mask, const char *name);
+static void rebuildSubDocIndex(void);
+static void rebuildSupplementaryIndex(void);
+static WEBCFG_STATUS buildSupplementaryList(char *docs, SupplementaryDocs_t **head, SupplementaryDocs_t **tail);
+static WEBCFG_STATUS parseWebcfgProperties(char * filename, webcfgProperties_t *props);
+static void installWebcfgProperties(webcfgProperties_t *props);
+static void freeWebcfgProperties(webcfgProperties_t *props);
+static void applyWebcfgTunables(webcfgProperties_t *props);
+static char *copyProperty(char **value);
+static void *webcfgPropertiesWatcherTask(void *arg);
 /*----------------------------------------------------------------------------*/
 /*                             External Functions                             */
 /*----------------------------------------------------------------------------*/
@@ -50,136 +116,64 @@ void displaystruct();
 
 void initWebcfgProperties(char * filename)
 {
-	FILE *fp = NULL;
-	char str[MAXCHAR] = {'\0'};
-	//For WEBCONFIG_SUBDOC_MAP parsing
-	char *p;
-	char *token;
+	webcfgProperties_t props;
 
-	WebcfgDebug("webcfg properties file path is %s\n", filename);
-	fp = fopen(filename,"r");
-
-	if (fp == NULL)
+	if(parseWebcfgProperties(filename, &props) != WEBCFG_SUCCESS)
 	{
-		WebcfgError("Failed to open file %s\n", filename);
 		return;
 	}
+	installWebcfgProperties(&props);
 
-	while (fgets(str, MAXCHAR, fp) != NULL)
+	if(g_sdInfoHead != NULL)
 	{
-		char * value = NULL;
-
-		if(NULL != (value = strstr(str,"WEBCONFIG_SUPPORTED_DOCS_BIT=")))
-		{
-			WebcfgDebug("The value stored is %s\n", str);
-			value = value + strlen("WEBCONFIG_SUPPORTED_DOCS_BIT=");
-			value[strlen(value)-1] = '\0';
-			setsupportedDocs(value);
-                        value = NULL;
-		}
-
-		if(NULL != (value =strstr(str,"WEBCONFIG_DOC_SCHEMA_VERSION")))
-		{
-			WebcfgDebug("The value stored is %s\n", str);
-			value = value + strlen("WEBCONFIG_DOC_SCHEMA_VERSION=");
-			value[strlen(value)-1] = '\0';
-			setsupportedVersion(value);
-			value = NULL;
-		}
-
-		if(strncmp(str,"WEBCONFIG_SUBDOC_MAP",strlen("WEBCONFIG_SUBDOC_MAP")) ==0)
-		{
-			
-			p = str;
-			char *tok = NULL;
-			WebcfgDebug("The value of tok is %s\n", tok);
-			tok = strtok_r(p, " =",&p);
-			token = strtok_r(p,",",&p);
-			while(token!= NULL)
-			{
-
-				char subdoc[100];
-				char *subtoken;
-				SubDocSupportMap_t *sdInfo = NULL;
-				strncpy(subdoc,token,(sizeof(subdoc)-1));
-				puts(subdoc);
-				sdInfo = (SubDocSupportMap_t *)malloc(sizeof(SubDocSupportMap_t));
-				if( sdInfo==NULL )
-				{
-					fclose(fp);
-					WebcfgError("Unable to allocate memory\n");
-					return;
-				}
-				memset(sdInfo, 0, sizeof(SubDocSupportMap_t));
-
-				subtoken = strtok(subdoc,":");//portforwarding or lan
+		displaystruct();
+	}
+}
 
-				if(subtoken == NULL)
-				{
-					fclose(fp);
-					WEBCFG_FREE(sdInfo);
-					return;
-				}
-				
-				strncpy(sdInfo->name,subtoken,(sizeof(sdInfo->name)-1));
-				subtoken = strtok(NULL,":");//skip bitposition
-				subtoken = strtok(NULL,":");//skip support
-				if(subtoken != NULL)
-				{
-				webcfgStrncpy(sdInfo->support, subtoken, sizeof(sdInfo->support));//To handle subtoken null case
-				}
-				#ifdef WEBCONFIG_BIN_SUPPORT				
-				subtoken = strtok(NULL,":");//skip rbus_listner
-				if(subtoken != NULL)
-				{
-					webcfgStrncpy(sdInfo->rbus_listener, subtoken, sizeof(sdInfo->rbus_listener));
-				}
-				
-				if(sdInfo->rbus_listener[0] != '\0')
-				{
-					if(strncmp(sdInfo->rbus_listener, "true", strlen("true")) == 0)
-					{
-						subtoken = strtok(NULL,":");//skip destination
-						webcfgStrncpy(sdInfo->dest, subtoken,  sizeof(sdInfo->dest));
-					}
-				}
-				#endif
-				token =strtok_r(p,",",&p);
-				sdInfo->next = NULL;
+//Parses the file into a new table and swaps it in, the current table is kept when parsing fails.
+WEBCFG_STATUS reloadWebcfgProperties(char * filename)
+{
+	webcfgProperties_t props;
 
-				if(g_sdInfoTail == NULL)
-				{
-					g_sdInfoHead = sdInfo;
-					g_sdInfoTail = sdInfo;
-				}
-				else
-				{
-					SubDocSupportMap_t *temp =NULL;
-					temp = get_global_sdInfoTail();
-					temp->next = sdInfo;
-					g_sdInfoTail = sdInfo;
-				}
+	if(parseWebcfgProperties(filename, &props) != WEBCFG_SUCCESS)
+	{
+		WebcfgError("Reload of %s failed, keeping current properties\n", filename);
+		return WEBCFG_FAILURE;
+	}
+	installWebcfgProperties(&props);
+	resetSupportedHeaders();
+#ifdef FEATURE_SUPPORT_MQTTCM
+	resetMqttSupportedHeaders();
+#endif
+	WebcfgInfo("Reloaded webcfg properties from %s\n", filename);
+	displaystruct();
+	return WEBCFG_SUCCESS;
+}
 
-			}
+//Watches the directory of filename so that both in place writes and renames over the file trigger a reload.
+void initWebcfgPropertiesWatcher(char * filename)
+{
+	int err = 0;
+	pthread_t watcherThreadId;
 
-		}
-		if(NULL != (value =strstr(str,"WEBCONFIG_SUPPLEMENTARY_DOCS")))
-		{
-			WebcfgDebug("The value stored is %s\n", str);
-			value = value + strlen("WEBCONFIG_SUPPLEMENTARY_DOCS=");
-			value[strlen(value)-1] = '\0';
-			setsupplementaryDocs(value);
-			value = NULL;
-			supplementaryDocs();
-		}
-		
+	pthread_mutex_lock(&properties_watcher_mut);
+	if(propertiesWatcherStarted)
+	{
+		pthread_mutex_unlock(&properties_watcher_mut);
+		return;
 	}
-	fclose(fp);
-
-	if(g_sdInfoHead != NULL)
+	webcfgStrncpy(propertiesFile, filename, sizeof(propertiesFile));
+	err = pthread_create(&watcherThreadId, NULL, webcfgPropertiesWatcherTask, NULL);
+	if (err != 0)
 	{
-		displaystruct();
+		WebcfgError("Error creating webcfg properties watcher thread :[%s]\n", strerror(err));
+	}
+	else
+	{
+		propertiesWatcherStarted = 1;
+		WebcfgInfo("webcfg properties watcher thread created Successfully\n");
 	}
+	pthread_mutex_unlock(&properties_watcher_mut);
 }
 
 void setsupplementaryDocs( char * value)
@@ -236,85 +230,141 @@ char * getsupplementaryDocs()
       return supplementary_docs;
 }
 
-WEBCFG_STATUS isSubDocSupported(char *subDoc)
+//Copies stay valid across a properties reload, caller frees them.
+char * copysupportedDocs()
 {
+	return copyProperty(&supported_bits);
+}
 
-	SubDocSupportMap_t *sd = NULL;
-	
-	sd = get_global_sdInfoHead();
+char * copysupportedVersion()
+{
+	return copyProperty(&supported_version);
+}
 
-	while(sd != NULL)
+char * copysupplementaryDocs()
+{
+	return copyProperty(&supplementary_docs);
+}
+
+//Snapshot of the supplementary list for walking across syncs, release with freeSupplementaryDocsList().
+SupplementaryDocs_t * copySupplementaryDocsList()
+{
+	SupplementaryDocs_t *sp = NULL;
+	SupplementaryDocs_t *node = NULL;
+	SupplementaryDocs_t *head = NULL;
+	SupplementaryDocs_t *tail = NULL;
+
+	pthread_mutex_lock(&metadata_index_mut);
+	for(sp = g_spInfoHead; sp != NULL; sp = sp->next)
 	{
-		if(strncmp(sd->name, subDoc, strlen(subDoc)) == 0)
+		node = (SupplementaryDocs_t *)malloc(sizeof(SupplementaryDocs_t));
+		if(node == NULL)
 		{
-			WebcfgDebug("The subdoc %s is present\n",sd->name);
-			if(strncmp(sd->support, "true", strlen("true")) == 0)
-			{
-				WebcfgInfo("%s is supported\n",subDoc);
-				return WEBCFG_SUCCESS;
-				
-			}
-			else
-			{
-				WebcfgInfo("%s is not supported\n",subDoc);
-				return WEBCFG_FAILURE;
-			}
+			WebcfgError("Unable to allocate memory for supplementary docs\n");
+			break;
+		}
+		memset(node, 0, sizeof(SupplementaryDocs_t));
+		if(sp->name != NULL)
+		{
+			node->name = strdup(sp->name);
+		}
+		if(tail == NULL)
+		{
+			head = node;
 		}
-		sd = sd->next;
-		
+		else
+		{
+			tail->next = node;
+		}
+		tail = node;
 	}
-	WebcfgError("Supported doc bit not found for %s\n",subDoc);
-	return WEBCFG_FAILURE;
+	pthread_mutex_unlock(&metadata_index_mut);
+	return head;
 }
-#ifdef WEBCONFIG_BIN_SUPPORT
-//To find the given subdoc is rbus_listener supported or not
-bool isRbusListener(char *subDoc)
+
+void freeSupplementaryDocsList(SupplementaryDocs_t *head)
 {
+	SupplementaryDocs_t *sp = NULL;
 
-	SubDocSupportMap_t *sd = NULL;
+	while(head != NULL)
+	{
+		sp = head;
+		head = sp->next;
+		if(sp->name != NULL)
+		{
+			WEBCFG_FREE(sp->name);
+		}
+		WEBCFG_FREE(sp);
+	}
+}
 
-	sd = get_global_sdInfoHead();
+//Returns every attribute of subDoc from one lookup in the hashed subdoc map.
+WEBCFG_STATUS getSubDocMeta(char *subDoc, SubDocMeta_t *meta)
+{
+	metaIndexSlot_t *slot = NULL;
+	WEBCFG_STATUS rv = WEBCFG_FAILURE;
 
-	while(sd != NULL)
+	if(subDoc == NULL || meta == NULL)
 	{
-		if(strncmp(sd->name, subDoc, strlen(subDoc)) == 0)
-		{
-			WebcfgDebug("The subdoc %s is present\n",sd->name);
-			if(strncmp(sd->rbus_listener, "true", strlen("true")) == 0)
-			{
-				WebcfgDebug("%s is rbus_listener supported\n",subDoc);
-				return true;
+		return WEBCFG_FAILURE;
+	}
+	pthread_mutex_lock(&metadata_index_mut);
+	if(sdIndexDirty)
+	{
+		rebuildSubDocIndex();
+	}
+	slot = findMetaIndex(sdIndex, sdIndexMask, subDoc);
+	if(slot != NULL)
+	{
+		*meta = slot->meta;
+		rv = WEBCFG_SUCCESS;
+	}
+	pthread_mutex_unlock(&metadata_index_mut);
+	return rv;
+}
 
-			}
-			else
-			{
-				WebcfgDebug("%s is not rbus_listener supported\n",subDoc);
-				return false;
-			}
-		}
-		sd = sd->next;
+WEBCFG_STATUS isSubDocSupported(char *subDoc)
+{
+	SubDocMeta_t meta;
+
+	if(getSubDocMeta(subDoc, &meta) != WEBCFG_SUCCESS)
+	{
+		WebcfgError("Supported doc bit not found for %s\n",subDoc);
+		return WEBCFG_FAILURE;
+	}
+	WebcfgDebug("The subdoc %s is present\n",subDoc);
+	if(meta.supported)
+	{
+		WebcfgInfo("%s is supported\n",subDoc);
+		return WEBCFG_SUCCESS;
+	}
+	WebcfgInfo("%s is not supported\n",subDoc);
+	return WEBCFG_FAILURE;
+}
+#ifdef WEBCONFIG_BIN_SUPPORT
+//To find the given subdoc is rbus_listener supported or not
+bool isRbusListener(char *subDoc)
+{
+	SubDocMeta_t meta;
 
+	if(getSubDocMeta(subDoc, &meta) == WEBCFG_SUCCESS && meta.rbus_listener)
+	{
+		WebcfgDebug("%s is rbus_listener supported\n",subDoc);
+		return true;
 	}
+	WebcfgDebug("%s is not rbus_listener supported\n",subDoc);
 	return false;
 }
 
 //To get dest field from SubDocSupportMap struct 
 WEBCFG_STATUS get_destination(char* subDoc, char* destination)
 {
-	SubDocSupportMap_t *sd = NULL;
-	sd = get_global_sdInfoHead();
+	SubDocMeta_t meta;
 
-	while(sd != NULL)
+	if(getSubDocMeta(subDoc, &meta) == WEBCFG_SUCCESS && strlen(meta.dest) > 0)
 	{
-		if(strncmp(sd->name, subDoc, strlen(subDoc)) == 0)
-		{
-			if(strlen(sd->dest) > 0)
-			{
-				webcfgStrncpy(destination, sd->dest, strlen(sd->dest)+1);
-				return WEBCFG_SUCCESS;
-			}
-		}
-		sd = sd->next;	
+		webcfgStrncpy(destination, meta.dest, strlen(meta.dest)+1);
+		return WEBCFG_SUCCESS;
 	}
 	return WEBCFG_FAILURE;	
 }
@@ -323,30 +373,24 @@ WEBCFG_STATUS get_destination(char* subDoc, char* destination)
 //To check if the doc received during poke is supplementary or not.
 WEBCFG_STATUS isSupplementaryDoc(char *subDoc)
 {
-	SupplementaryDocs_t *sp = NULL;
-	sp = get_global_spInfoHead();
+	WEBCFG_STATUS rv = WEBCFG_FAILURE;
 
-	while(sp != NULL)
+	if(subDoc == NULL)
 	{
-		WebcfgDebug("Supplementary check for docname %s, subDoc received is %s\n", sp->name, subDoc);
-		if(strlen(sp->name) == strlen(subDoc))
-		{
-			if(strncmp(sp->name, subDoc, strlen(subDoc)) == 0)
-			{
-				WebcfgDebug("subDoc %s is supplementary\n",subDoc);
-				return WEBCFG_SUCCESS;
-
-			}
-			else
-			{
-				WebcfgDebug("subDoc %s is not supplementary\n",subDoc);
-				return WEBCFG_FAILURE;
-			}
-		}
-		sp = sp->next;
-
+		return WEBCFG_FAILURE;
 	}
-	return WEBCFG_FAILURE;
+	pthread_mutex_lock(&metadata_index_mut);
+	if(spIndexDirty)
+	{
+		rebuildSupplementaryIndex();
+	}
+	if(findMetaIndex(spIndex, spIndexMask, subDoc) != NULL)
+	{
+		rv = WEBCFG_SUCCESS;
+	}
+	pthread_mutex_unlock(&metadata_index_mut);
+	WebcfgDebug("subDoc %s is %ssupplementary\n", subDoc, (rv == WEBCFG_SUCCESS) ? "" : "not ");
+	return rv;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -354,18 +398,22 @@ WEBCFG_STATUS isSupplementaryDoc(char *subDoc)
 /*----------------------------------------------------------------------------*/
 void set_global_sdInfoHead(SubDocSupportMap_t *new_head) {
 	g_sdInfoHead = new_head;
+	markMetaIndexDirty(1, 0);
 }
 
 void set_global_sdInfoTail(SubDocSupportMap_t *new_tail) {
     g_sdInfoTail = new_tail;
+    markMetaIndexDirty(1, 0);
 }
 
 void set_global_spInfoHead(SupplementaryDocs_t *new_head) {
     g_spInfoHead = new_head;
+    markMetaIndexDirty(0, 1);
 }
 
 void set_global_spInfoTail(SupplementaryDocs_t *new_head) {
     g_spInfoTail = new_head;
+    markMetaIndexDirty(0, 1);
 }
 
 SubDocSupportMap_t * get_global_sdInfoHead(void)
@@ -398,51 +446,27 @@ SupplementaryDocs_t * get_global_spInfoTail(void)
 
 void supplementaryDocs()
 {
-	int count = 0;
 	char* docs = NULL;
-	char* docs_var = NULL;
+	SupplementaryDocs_t *head = NULL;
+	SupplementaryDocs_t *tail = NULL;
+
 	docs = getsupplementaryDocs();
 	if (docs !=NULL)
 	{
-		docs_var = strndup(docs,strlen(docs));
-		char* token = strtok(docs_var, ",");
-
-		while(token != NULL)
+		buildSupplementaryList(docs, &head, &tail);
+		if(head != NULL)
 		{
-			SupplementaryDocs_t *spInfo = NULL;
-			spInfo = (SupplementaryDocs_t *)malloc(sizeof(SupplementaryDocs_t));
-
-			if(spInfo == NULL)
-			{
-				WebcfgError("Unable to allocate memory for supplementary docs\n");
-				WEBCFG_FREE(docs_var);
-				return;
-			}
-
-			memset(spInfo, 0, sizeof(SupplementaryDocs_t));
-
-			WebcfgDebug("The value is %s\n",token);
-			spInfo->name = strdup(token);
-			spInfo->next = NULL;
-
 			if(g_spInfoTail == NULL)
 			{
-				g_spInfoHead = spInfo;
-				g_spInfoTail = spInfo;
+				g_spInfoHead = head;
 			}
 			else
 			{
-				SupplementaryDocs_t *temp = NULL;
-				temp = get_global_spInfoTail();
-				temp->next = spInfo;
-				g_spInfoTail = spInfo;
+				g_spInfoTail->next = head;
 			}
-
-			WebcfgDebug("The supplementary_doc[%d] is %s\n", count, spInfo->name);
-			count++;
-			token = strtok(NULL, ",");
+			g_spInfoTail = tail;
 		}
-		WEBCFG_FREE(docs_var);
+		markMetaIndexDirty(0, 1);
 	}
 }
 
@@ -473,4 +497,557 @@ void delete_supplementary_list()
 	}
 	g_spInfoHead = NULL;
 	g_spInfoTail = NULL;
+	markMetaIndexDirty(0, 1);
+}
+
+static void markMetaIndexDirty(int sd, int sp)
+{
+	pthread_mutex_lock(&metadata_index_mut);
+	if(sd)
+	{
+		sdIndexDirty = 1;
+	}
+	if(sp)
+	{
+		spIndexDirty = 1;
+	}
+	pthread_mutex_unlock(&metadata_index_mut);
+}
+
+//FNV-1a over the subdoc name.
+static uint32_t metaIndexHash(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while(*name != '\0')
+	{
+		hash ^= (unsigned char)*name++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+//Table is a power of two at least twice the entry count, so probes stay short.
+static metaIndexSlot_t *allocMetaIndex(int count, uint32_t *mask)
+{
+	uint32_t size = 8;
+	metaIndexSlot_t *index = NULL;
+
+	*mask = 0;
+	if(count <= 0)
+	{
+		return NULL;
+	}
+	while(size < (uint32_t)count * 2)
+	{
+		size <<= 1;
+	}
+	index = (metaIndexSlot_t *)calloc(size, sizeof(metaIndexSlot_t));
+	if(index == NULL)
+	{
+		WebcfgError("Unable to allocate metadata index\n");
+		return NULL;
+	}
+	*mask = size - 1;
+	return index;
+}
+
+//Returns the slot for a new name, NULL when the name is already indexed so the first entry wins.
+static metaIndexSlot_t *insertMetaIndex(metaIndexSlot_t *index, uint32_t mask, const char *name)
+{
+	uint32_t hash = metaIndexHash(name);
+	uint32_t i = hash & mask;
+
+	while(index[i].name != NULL)
+	{
+		if(index[i].hash == hash && strcmp(index[i].name, name) == 0)
+		{
+			return NULL;
+		}
+		i = (i + 1) & mask;
+	}
+	index[i].name = name;
+	index[i].hash = hash;
+	return &index[i];
+}
+
+static metaIndexSlot_t *findMetaIndex(metaIndexSlot_t *index, uint32_t mask, const char *name)
+{
+	uint32_t hash = 0;
+	uint32_t i = 0;
+
+	if(index == NULL)
+	{
+		return NULL;
+	}
+	hash = metaIndexHash(name);
+	i = hash & mask;
+	while(index[i].name != NULL)
+	{
+		if(index[i].hash == hash && strcmp(index[i].name, name) == 0)
+		{
+			return &index[i];
+		}
+		i = (i + 1) & mask;
+	}
+	return NULL;
+}
+
+//Caller holds metadata_index_mut.
+static void rebuildSubDocIndex(void)
+{
+	SubDocSupportMap_t *sd = NULL;
+	metaIndexSlot_t *slot = NULL;
+	int count = 0;
+
+	if(sdIndex != NULL)
+	{
+		WEBCFG_FREE(sdIndex);
+	}
+	for(sd = g_sdInfoHead; sd != NULL; sd = sd->next)
+	{
+		count++;
+	}
+	sdIndex = allocMetaIndex(count, &sdIndexMask);
+	if(sdIndex != NULL)
+	{
+		for(sd = g_sdInfoHead; sd != NULL; sd = sd->next)
+		{
+			slot = insertMetaIndex(sdIndex, sdIndexMask, sd->name);
+			if(slot == NULL)
+			{
+				continue;
+			}
+			slot->meta.supported = (strncmp(sd->support, "true", strlen("true")) == 0);
+			#ifdef WEBCONFIG_BIN_SUPPORT
+			slot->meta.rbus_listener = (strncmp(sd->rbus_listener, "true", strlen("true")) == 0);
+			webcfgStrncpy(slot->meta.dest, sd->dest, sizeof(slot->meta.dest));
+			#endif
+		}
+	}
+	sdIndexDirty = 0;
+	WebcfgDebug("Subdoc metadata index built with %d entries\n", count);
+}
+
+//Caller holds metadata_index_mut.
+static void rebuildSupplementaryIndex(void)
+{
+	SupplementaryDocs_t *sp = NULL;
+	int count = 0;
+
+	if(spIndex != NULL)
+	{
+		WEBCFG_FREE(spIndex);
+	}
+	for(sp = g_spInfoHead; sp != NULL; sp = sp->next)
+	{
+		count++;
+	}
+	spIndex = allocMetaIndex(count, &spIndexMask);
+	if(spIndex != NULL)
+	{
+		for(sp = g_spInfoHead; sp != NULL; sp = sp->next)
+		{
+			if(sp->name != NULL)
+			{
+				insertMetaIndex(spIndex, spIndexMask, sp->name);
+			}
+		}
+	}
+	spIndexDirty = 0;
+}
+
+//Builds a supplementary list from a comma separated docs string into head/tail.
+static WEBCFG_STATUS buildSupplementaryList(char *docs, SupplementaryDocs_t **head, SupplementaryDocs_t **tail)
+{
+	int count = 0;
+	char *docs_var = NULL;
+	char *token = NULL;
+	char *saveptr = NULL;
+
+	docs_var = strndup(docs,strlen(docs));
+	if(docs_var == NULL)
+	{
+		WebcfgError("Unable to allocate memory for supplementary docs\n");
+		return WEBCFG_FAILURE;
+	}
+	token = strtok_r(docs_var, ",", &saveptr);
+
+	while(token != NULL)
+	{
+		SupplementaryDocs_t *spInfo = NULL;
+		spInfo = (SupplementaryDocs_t *)malloc(sizeof(SupplementaryDocs_t));
+
+		if(spInfo == NULL)
+		{
+			WebcfgError("Unable to allocate memory for supplementary docs\n");
+			WEBCFG_FREE(docs_var);
+			return WEBCFG_FAILURE;
+		}
+
+		memset(spInfo, 0, sizeof(SupplementaryDocs_t));
+
+		WebcfgDebug("The value is %s\n",token);
+		spInfo->name = strdup(token);
+		spInfo->next = NULL;
+
+		if(*tail == NULL)
+		{
+			*head = spInfo;
+			*tail = spInfo;
+		}
+		else
+		{
+			(*tail)->next = spInfo;
+			*tail = spInfo;
+		}
+
+		WebcfgDebug("The supplementary_doc[%d] is %s\n", count, spInfo->name);
+		count++;
+		token = strtok_r(NULL, ",", &saveptr);
+	}
+	WEBCFG_FREE(docs_var);
+	return WEBCFG_SUCCESS;
+}
+
+//Parses filename into props without touching the active table or any tunable.
+static WEBCFG_STATUS parseWebcfgProperties(char * filename, webcfgProperties_t *props)
+{
+	FILE *fp = NULL;
+	char str[MAXCHAR] = {'\0'};
+	//For WEBCONFIG_SUBDOC_MAP parsing
+	char *p;
+	char *token;
+
+	memset(props, 0, sizeof(webcfgProperties_t));
+	WebcfgDebug("webcfg properties file path is %s\n", filename);
+	fp = fopen(filename,"r");
+
+	if (fp == NULL)
+	{
+		WebcfgError("Failed to open file %s\n", filename);
+		return WEBCFG_FAILURE;
+	}
+
+	while (fgets(str, MAXCHAR, fp) != NULL)
+	{
+		char * value = NULL;
+
+		if(NULL != (value = strstr(str,"WEBCONFIG_SUPPORTED_DOCS_BIT=")))
+		{
+			WebcfgDebug("The value stored is %s\n", str);
+			value = value + strlen("WEBCONFIG_SUPPORTED_DOCS_BIT=");
+			value[strlen(value)-1] = '\0';
+			if(props->supported_bits != NULL)
+			{
+				WEBCFG_FREE(props->supported_bits);
+			}
+			props->supported_bits = strdup(value);
+			value = NULL;
+		}
+
+		if(NULL != (value =strstr(str,"WEBCONFIG_DOC_SCHEMA_VERSION")))
+		{
+			WebcfgDebug("The value stored is %s\n", str);
+			value = value + strlen("WEBCONFIG_DOC_SCHEMA_VERSION=");
+			value[strlen(value)-1] = '\0';
+			if(props->supported_version != NULL)
+			{
+				WEBCFG_FREE(props->supported_version);
+			}
+			props->supported_version = strdup(value);
+			value = NULL;
+		}
+
+		if(strncmp(str,"WEBCONFIG_SUBDOC_MAP",strlen("WEBCONFIG_SUBDOC_MAP")) ==0)
+		{
+			p = str;
+			strtok_r(p, " =",&p);
+			token = strtok_r(p,",",&p);
+			while(token!= NULL)
+			{
+				char subdoc[100] = {'\0'};
+				char *subtoken;
+				char *saveptr = NULL;
+				SubDocSupportMap_t *sdInfo = NULL;
+				strncpy(subdoc,token,(sizeof(subdoc)-1));
+				token =strtok_r(p,",",&p);
+
+				subtoken = strtok_r(subdoc,":",&saveptr);//portforwarding or lan
+				if(subtoken == NULL)
+				{
+					continue;
+				}
+
+				sdInfo = (SubDocSupportMap_t *)malloc(sizeof(SubDocSupportMap_t));
+				if( sdInfo==NULL )
+				{
+					fclose(fp);
+					WebcfgError("Unable to allocate memory\n");
+					freeWebcfgProperties(props);
+					return WEBCFG_FAILURE;
+				}
+				memset(sdInfo, 0, sizeof(SubDocSupportMap_t));
+
+				strncpy(sdInfo->name,subtoken,(sizeof(sdInfo->name)-1));
+				subtoken = strtok_r(NULL,":",&saveptr);//skip bitposition
+				subtoken = strtok_r(NULL,":",&saveptr);//skip support
+				if(subtoken != NULL)
+				{
+					webcfgStrncpy(sdInfo->support, subtoken, sizeof(sdInfo->support));//To handle subtoken null case
+				}
+				#ifdef WEBCONFIG_BIN_SUPPORT
+				subtoken = strtok_r(NULL,":",&saveptr);//skip rbus_listner
+				if(subtoken != NULL)
+				{
+					webcfgStrncpy(sdInfo->rbus_listener, subtoken, sizeof(sdInfo->rbus_listener));
+				}
+
+				if(strncmp(sdInfo->rbus_listener, "true", strlen("true")) == 0)
+				{
+					subtoken = strtok_r(NULL,":",&saveptr);//skip destination
+					if(subtoken != NULL)
+					{
+						webcfgStrncpy(sdInfo->dest, subtoken,  sizeof(sdInfo->dest));
+					}
+				}
+				#endif
+				sdInfo->next = NULL;
+
+				if(props->sdTail == NULL)
+				{
+					props->sdHead = sdInfo;
+					props->sdTail = sdInfo;
+				}
+				else
+				{
+					props->sdTail->next = sdInfo;
+					props->sdTail = sdInfo;
+				}
+			}
+		}
+
+		if(NULL != (value =strstr(str,"WEBCONFIG_SUPPLEMENTARY_DOCS")))
+		{
+			WebcfgDebug("The value stored is %s\n", str);
+			value = value + strlen("WEBCONFIG_SUPPLEMENTARY_DOCS=");
+			value[strlen(value)-1] = '\0';
+			if(props->supplementary_docs != NULL)
+			{
+				WEBCFG_FREE(props->supplementary_docs);
+			}
+			props->supplementary_docs = strdup(value);
+			value = NULL;
+			if(props->supplementary_docs != NULL && buildSupplementaryList(props->supplementary_docs, &props->spHead, &props->spTail) != WEBCFG_SUCCESS)
+			{
+				fclose(fp);
+				freeWebcfgProperties(props);
+				return WEBCFG_FAILURE;
+			}
+		}
+
+		if(NULL != (value =strstr(str,"WEBCONFIG_NOTIFY_BATCH_WINDOW_MS=")))
+		{
+			WebcfgDebug("The value stored is %s\n", str);
+			value = value + strlen("WEBCONFIG_NOTIFY_BATCH_WINDOW_MS=");
+			props->notify_batch_window = (unsigned int)strtoul(value, NULL, 10);
+			props->has_notify_batch_window = 1;
+			value = NULL;
+		}
+#ifdef WEBCONFIG_BIN_SUPPORT
+		if(NULL != (value =strstr(str,"WEBCONFIG_SET_BATCH_SIZE=")))
+		{
+			WebcfgDebug("The value stored is %s\n", str);
+			value = value + strlen("WEBCONFIG_SET_BATCH_SIZE=");
+			props->set_batch_size = (unsigned int)strtoul(value, NULL, 10);
+			props->has_set_batch_size = 1;
+			value = NULL;
+		}
+#endif
+#ifdef FEATURE_SUPPORT_MQTTCM
+		if(NULL != (value =strstr(str,"WEBCONFIG_MQTT_PUBLISH_ASYNC=")))
+		{
+			WebcfgDebug("The value stored is %s\n", str);
+			value = value + strlen("WEBCONFIG_MQTT_PUBLISH_ASYNC=");
+			props->mqtt_publish_async = (strncmp(value, "true", strlen("true")) == 0) ? 1 : 0;
+			props->has_mqtt_publish_async = 1;
+			value = NULL;
+		}
+#endif
+	}
+	fclose(fp);
+	return WEBCFG_SUCCESS;
+}
+
+//Swaps props in as the active table and frees the replaced one. Readers outside this
+//file only hold copies taken under metadata_index_mut, so nothing points into it anymore.
+static void installWebcfgProperties(webcfgProperties_t *props)
+{
+	webcfgProperties_t old;
+
+	memset(&old, 0, sizeof(webcfgProperties_t));
+	pthread_mutex_lock(&metadata_index_mut);
+	old.supported_bits = supported_bits;
+	old.supported_version = supported_version;
+	old.supplementary_docs = supplementary_docs;
+	old.sdHead = g_sdInfoHead;
+	old.spHead = g_spInfoHead;
+
+	supported_bits = props->supported_bits;
+	supported_version = props->supported_version;
+	supplementary_docs = props->supplementary_docs;
+	g_sdInfoHead = props->sdHead;
+	g_sdInfoTail = props->sdTail;
+	g_spInfoHead = props->spHead;
+	g_spInfoTail = props->spTail;
+	sdIndexDirty = 1;
+	spIndexDirty = 1;
+	pthread_mutex_unlock(&metadata_index_mut);
+
+	applyWebcfgTunables(props);
+	freeWebcfgProperties(&old);
+}
+
+static void freeWebcfgProperties(webcfgProperties_t *props)
+{
+	SubDocSupportMap_t *sd = NULL;
+
+	while(props->sdHead != NULL)
+	{
+		sd = props->sdHead;
+		props->sdHead = sd->next;
+		WEBCFG_FREE(sd);
+	}
+	freeSupplementaryDocsList(props->spHead);
+	if(props->supported_bits != NULL)
+	{
+		WEBCFG_FREE(props->supported_bits);
+	}
+	if(props->supported_version != NULL)
+	{
+		WEBCFG_FREE(props->supported_version);
+	}
+	if(props->supplementary_docs != NULL)
+	{
+		WEBCFG_FREE(props->supplementary_docs);
+	}
+	memset(props, 0, sizeof(webcfgProperties_t));
+}
+
+static void applyWebcfgTunables(webcfgProperties_t *props)
+{
+	if(props->has_notify_batch_window)
+	{
+		set_global_notify_batch_window(props->notify_batch_window);
+	}
+#ifdef WEBCONFIG_BIN_SUPPORT
+	if(props->has_set_batch_size)
+	{
+		set_global_set_batch_size(props->set_batch_size);
+	}
+#endif
+#ifdef FEATURE_SUPPORT_MQTTCM
+	if(props->has_mqtt_publish_async)
+	{
+		set_global_mqtt_publish_async(props->mqtt_publish_async);
+	}
+#endif
+}
+
+static char *copyProperty(char **value)
+{
+	char *copy = NULL;
+
+	pthread_mutex_lock(&metadata_index_mut);
+	if(*value != NULL)
+	{
+		copy = strdup(*value);
+	}
+	pthread_mutex_unlock(&metadata_index_mut);
+	return copy;
+}
+
+static void *webcfgPropertiesWatcherTask(void *arg)
+{
+	char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	char dir[256] = {'\0'};
+	const char *base = NULL;
+	char *slash = NULL;
+	ssize_t len = 0;
+	int fd = -1;
+	int wd = -1;
+	int reload = 0;
+	(void) arg;
+
+	pthread_detach(pthread_self());
+	webcfgStrncpy(dir, propertiesFile, sizeof(dir));
+	slash = strrchr(dir, '/');
+	if(slash == NULL)
+	{
+		base = propertiesFile;
+		webcfgStrncpy(dir, ".", sizeof(dir));
+	}
+	else
+	{
+		base = propertiesFile + (slash - dir) + 1;
+		if(slash == dir)
+		{
+			slash[1] = '\0';
+		}
+		else
+		{
+			*slash = '\0';
+		}
+	}
+
+	fd = inotify_init1(IN_CLOEXEC);
+	if(fd < 0)
+	{
+		WebcfgError("inotify_init1 failed :[%s], properties reload disabled\n", strerror(errno));
+		return NULL;
+	}
+	wd = inotify_add_watch(fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+	if(wd < 0)
+	{
+		WebcfgError("inotify_add_watch on %s failed :[%s], properties reload disabled\n", dir, strerror(errno));
+		close(fd);
+		return NULL;
+	}
+	WebcfgInfo("Watching %s for changes to %s\n", dir, base);
+
+	while(1)
+	{
+		char *ptr = NULL;
+		const struct inotify_event *event = NULL;
+
+		len = read(fd, buf, sizeof(buf));
+		if(len <= 0)
+		{
+			if(len < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			WebcfgError("inotify read failed :[%s], properties reload disabled\n", strerror(errno));
+			break;
+		}
+
+		//Several events for the file may arrive together, reload once per read.
+		reload = 0;
+		for(ptr = buf; ptr < buf + len; ptr += sizeof(struct inotify_event) + event->len)
+		{
+			event = (const struct inotify_event *) ptr;
+			if(event->len > 0 && strcmp(event->name, base) == 0)
+			{
+				reload = 1;
+			}
+		}
+		if(reload)
+		{
+			WebcfgInfo("%s changed, reloading\n", propertiesFile);
+			reloadWebcfgProperties(propertiesFile);
+		}
+	}
+	inotify_rm_watch(fd, wd);
+	close(fd);
+	return NULL;
 }
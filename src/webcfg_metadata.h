@@ -48,6 +48,16 @@ typedef struct SubDocSupportMap
     struct SubDocSupportMap *next;
 }SubDocSupportMap_t;
 
+//All attributes of one subdoc, returned by a single hashed lookup.
+typedef struct SubDocMeta
+{
+    bool supported;
+    #ifdef WEBCONFIG_BIN_SUPPORT
+    bool rbus_listener;
+    char dest[64];
+    #endif
+}SubDocMeta_t;
+
 void set_global_sdInfoHead(SubDocSupportMap_t *new_head);
 void set_global_sdInfoTail(SubDocSupportMap_t *new_tail);
 void set_global_spInfoHead(SupplementaryDocs_t *new_head);
@@ -60,18 +70,26 @@ SupplementaryDocs_t * get_global_spInfoTail(void);
 /*----------------------------------------------------------------------------*/
 /*                             External Functions                             */
 /*----------------------------------------------------------------------------*/
+WEBCFG_STATUS getSubDocMeta(char *subDoc, SubDocMeta_t *meta);
 WEBCFG_STATUS isSubDocSupported(char *subDoc);
 #ifdef WEBCONFIG_BIN_SUPPORT
 bool isRbusListener(char *subDoc);
 WEBCFG_STATUS get_destination(char *subDoc, char *topic);
 #endif
 void initWebcfgProperties(char * filename);
+WEBCFG_STATUS reloadWebcfgProperties(char * filename);
+void initWebcfgPropertiesWatcher(char * filename);
 void setsupportedDocs( char * value);
 void setsupportedVersion( char * value);
 void setsupplementaryDocs( char * value);
 char * getsupportedDocs();
 char * getsupportedVersion();
 char * getsupplementaryDocs();
+char * copysupportedDocs();
+char * copysupportedVersion();
+char * copysupplementaryDocs();
+SupplementaryDocs_t * copySupplementaryDocsList();
+void freeSupplementaryDocsList(SupplementaryDocs_t *head);
 void supplementaryDocs();
 void delete_supplementary_list();
 void displaystruct();
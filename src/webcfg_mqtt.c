@@ -19,17 +19,61 @@
 
 #include <unistd.h>
 #include <string.h>
+#include <strings.h>
 #include <stdlib.h>
 #include <sys/types.h>
 #include <ctype.h>
 #include <pthread.h>
 #include <errno.h>
+#include <time.h>
 #include "webcfg_generic.h"
 #include "webcfg_multipart.h"
 #include "webcfg_mqtt.h"
 #include "webcfg_rbus.h"
 #include "webcfg_notify.h"
 
+//Incoming messages are processed in arrival order by one worker, processPayload works on the shared sync state.
+#define MQTT_WORKER_QUEUE_MAX		8
+//Notifications published to mqttConnManager without waiting for each reply, in async mode.
+//One reply handler per slot is generated below, keep them in sync.
+#define MQTT_PUBLISH_INFLIGHT_MAX	8
+#define MQTT_PUBLISH_TIMEOUT_SEC	10
+
+//Notification behind an async publish, requeued to the notify outbox when the reply is a failure.
+typedef struct
+{
+	int used;
+	char *dest;
+	char *payload;
+} mqtt_publish_slot_t;
+
+typedef struct
+{
+	pthread_t threadId;
+	pthread_mutex_t mut;
+	pthread_cond_t con;
+	msg_t *head;
+	msg_t *tail;
+	int count;
+} mqtt_worker_t;
+
+//Slice of the received message buffer, not NUL terminated.
+typedef struct
+{
+	const char *ptr;
+	size_t len;
+} mqtt_slice_t;
+
+//HTTP style envelope of an MQTT config message, slices point into the message buffer.
+typedef struct
+{
+	int response_code;
+	mqtt_slice_t content_type;
+	mqtt_slice_t etag;
+	mqtt_slice_t content_length;
+	mqtt_slice_t body;
+} mqtt_envelope_t;
+
 pthread_cond_t mqtt_sync_condition=PTHREAD_COND_INITIALIZER;
 pthread_mutex_t mqtt_sync_mutex=PTHREAD_MUTEX_INITIALIZER;
 static pthread_t mqttThreadId = 0;
@@ -51,6 +95,22 @@ static char g_deviceWanMac[64]={'\0'};
 static char *supportedVersion_header=NULL;
 static char *supportedDocs_header=NULL;
 static char *supplementaryDocs_header=NULL;
+//Set when webconfig.properties is reloaded, the cached headers are dropped on the next createMqttHeader.
+static int supported_headers_stale = 0;
+static pthread_mutex_t supported_headers_mut = PTHREAD_MUTEX_INITIALIZER;
+static mqtt_worker_t mqttWorker;
+static pthread_mutex_t mqttWorkersMut = PTHREAD_MUTEX_INITIALIZER;
+static int mqttWorkersStarted = 0;
+//Messages dropped because the worker queue was full.
+static unsigned int mqttDroppedCount = 0;
+static int mqtt_publish_async = 0;
+static mqtt_publish_slot_t mqttPublishSlots[MQTT_PUBLISH_INFLIGHT_MAX];
+static pthread_mutex_t mqtt_publish_mut = PTHREAD_MUTEX_INITIALIZER;
+//Connection status events from mqttConnManager wake up checkMqttConnStatus, polling is the fallback.
+static pthread_mutex_t mqtt_conn_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t mqtt_conn_condition = PTHREAD_COND_INITIALIZER;
+static pthread_once_t mqttConnEventOnce = PTHREAD_ONCE_INIT;
+static unsigned int mqtt_conn_event_gen = 0;
 
 static void webcfgSubscribeCallbackHandler(
     rbusHandle_t handle,
@@ -64,7 +124,46 @@ static void webcfgOnPublishCallbackHandler(
     rbusHandle_t handle,
     rbusEvent_t const* event,
     rbusEventSubscription_t* subscription);
-void * processPayloadTask(void *tmp);
+static void initMqttWorkers(void);
+static void * mqttWorkerTask(void *arg);
+static int addToMqttWorker(msg_t *msg);
+static void parseMqttEnvelope(const char *data, size_t len, mqtt_envelope_t *env);
+static int matchMqttHeader(const char *line, size_t line_len, const char *name, mqtt_slice_t *value);
+static int reservePublishSlot(const char *dest, const char *payload);
+static void releasePublishSlot(int slot, rbusError_t error);
+static void publishAsyncRespHandler(int slot, char const* methodName, rbusError_t error);
+static void subscribeMqttConnStatusEvent(void);
+static void dropStaleSupportedHeaders(void);
+static void mqttConnStatusEventHandler(
+    rbusHandle_t handle,
+    rbusEvent_t const* event,
+    rbusEventSubscription_t* subscription);
+static void mqttConnStatusSubscribeHandler(
+    rbusHandle_t handle,
+    rbusEventSubscription_t* subscription,
+    rbusError_t error);
+
+//rbus async replies carry no user data, each in-flight slot gets its own handler.
+#define MQTT_PUBLISH_SLOT_HANDLER(n) \
+static void publishAsyncRespHandler##n(rbusHandle_t handle, char const* methodName, rbusError_t error, rbusObject_t params) \
+{ \
+	(void) handle; \
+	(void) params; \
+	publishAsyncRespHandler(n, methodName, error); \
+}
+MQTT_PUBLISH_SLOT_HANDLER(0)
+MQTT_PUBLISH_SLOT_HANDLER(1)
+MQTT_PUBLISH_SLOT_HANDLER(2)
+MQTT_PUBLISH_SLOT_HANDLER(3)
+MQTT_PUBLISH_SLOT_HANDLER(4)
+MQTT_PUBLISH_SLOT_HANDLER(5)
+MQTT_PUBLISH_SLOT_HANDLER(6)
+MQTT_PUBLISH_SLOT_HANDLER(7)
+
+static rbusMethodAsyncRespHandler_t mqttPublishSlotHandlers[MQTT_PUBLISH_INFLIGHT_MAX] = {
+	publishAsyncRespHandler0, publishAsyncRespHandler1, publishAsyncRespHandler2, publishAsyncRespHandler3,
+	publishAsyncRespHandler4, publishAsyncRespHandler5, publishAsyncRespHandler6, publishAsyncRespHandler7
+};
 
 void initWebconfigMqttTask(unsigned long status)
 {
@@ -191,10 +290,12 @@ int getMqttCMConnStatus()
         return ret;
 }
 
-//This function checks the mqtt connection status and if it is "down" it will wait in back off retry
+//This function checks the mqtt connection status and if it is "down" it waits for the status event, with back off polling as fallback
 void checkMqttConnStatus()
 {
 	int connStatus = 0;
+	unsigned int event_gen = 0;
+	struct timespec ts;
 	int backoffRetryTime = 0;
 	int backoff_max_time = 5;
 	int max_retry_sleep;
@@ -203,6 +304,7 @@ void checkMqttConnStatus()
         max_retry_sleep = (int) pow(2, backoff_max_time) -1;
         WebcfgInfo("max_retry_sleep is %d\n", max_retry_sleep );
 
+	pthread_once(&mqttConnEventOnce, subscribeMqttConnStatusEvent);
 	while(1)
 	{
 		if(backoffRetryTime < max_retry_sleep)
@@ -211,6 +313,7 @@ void checkMqttConnStatus()
 		}
 
 		WebcfgInfo("New backoffRetryTime value calculated as %d seconds\n", backoffRetryTime);
+		event_gen = __atomic_load_n(&mqtt_conn_event_gen, __ATOMIC_ACQUIRE);
 		connStatus = getMqttCMConnStatus();
 		if(connStatus)
 		{
@@ -220,7 +323,24 @@ void checkMqttConnStatus()
 		else
 		{
 			WebcfgError("MQTTCM broker is not connected, waiting..\n");
-			sleep(backoffRetryTime);
+			clock_gettime(CLOCK_MONOTONIC, &ts);
+			ts.tv_sec += backoffRetryTime;
+			pthread_mutex_lock(&mqtt_conn_mutex);
+			while(event_gen == mqtt_conn_event_gen)
+			{
+				if(pthread_cond_timedwait(&mqtt_conn_condition, &mqtt_conn_mutex, &ts) == ETIMEDOUT)
+				{
+					break;
+				}
+			}
+			if(event_gen != mqtt_conn_event_gen)
+			{
+				//Status changed to Up, poll right away without further back off.
+				WebcfgInfo("MQTTCM connection status event received, checking status\n");
+				c = 1;
+				backoffRetryTime = 0;
+			}
+			pthread_mutex_unlock(&mqtt_conn_mutex);
 			c++;
 
 			if(backoffRetryTime == max_retry_sleep)
@@ -552,11 +672,13 @@ int createMqttHeader(char **header_list)
 		WebcfgError("Failed in memory allocation for schema_header\n");	
 	}
 
+	dropStaleSupportedHeaders();
+
 	if(!get_global_supplementarySync())
 	{
 		if(supportedVersion_header == NULL)
 		{
-			supportedVersion = getsupportedVersion();
+			supportedVersion = copysupportedVersion();
 
 			if(supportedVersion !=NULL)
 			{
@@ -573,6 +695,7 @@ int createMqttHeader(char **header_list)
 				{
 					WebcfgError("Failed in memory allocation for supportedVersion_header\n");	
 				}
+				WEBCFG_FREE(supportedVersion);
 			}
 			else
 			{
@@ -586,7 +709,7 @@ int createMqttHeader(char **header_list)
 
 		if(supportedDocs_header == NULL)
 		{
-			supportedDocs = getsupportedDocs();
+			supportedDocs = copysupportedDocs();
 
 			if(supportedDocs !=NULL)
 			{
@@ -603,6 +726,7 @@ int createMqttHeader(char **header_list)
 				{
 					WebcfgError("Failed in memory allocation for supportedDocs_header\n");	
 				}
+				WEBCFG_FREE(supportedDocs);
 			}
 			else
 			{
@@ -618,7 +742,7 @@ int createMqttHeader(char **header_list)
 	{
 		if(supplementaryDocs_header == NULL)
 		{
-			supplementaryDocs = getsupplementaryDocs();
+			supplementaryDocs = copysupplementaryDocs();
 
 			if(supplementaryDocs !=NULL)
 			{
@@ -635,6 +759,7 @@ int createMqttHeader(char **header_list)
 				{
 					WebcfgError("Failed in memory allocation for supplementaryDocs_header\n");	
 				}	
+				WEBCFG_FREE(supplementaryDocs);
 			}
 			else
 			{
@@ -1008,30 +1133,6 @@ void freeMqttHeaders(char *contentlen_header, char *contenttype_header, char *Pa
 	WEBCFG_FREE(transaction_uuid);
 }
 
-//new thread created for processPayload 
-void * processPayloadTask(void *tmp)
-{
-	pthread_detach(pthread_self());
-	if(tmp != NULL)
-	{
-		msg_t *msg = NULL;
-		msg = (msg_t *) tmp;
-		int len=0;
-		void * data = NULL;
-		data = msg->data;
-		len = msg->len;
-
-		processPayload((char *)data, len);
-		WEBCFG_FREE(tmp);
-	}
-	else
-	{
-		WebcfgError("tmp data is NULL\n");
-	}
-
-	return NULL;
-}
-
 static void webcfgOnMessageCallbackHandler(
     rbusHandle_t handle,
     rbusEvent_t const* event,
@@ -1045,25 +1146,27 @@ static void webcfgOnMessageCallbackHandler(
     WebcfgInfo("Received on message callback event %s\n", event->name);
 
     if(incoming_value != NULL)
-    {	
-	int err = 0;
-	pthread_t threadId;
-	char *data = NULL;
+    {
+	char const *data = NULL;
 	int len = 0;
 	char *temp_data = NULL;
-	
-	WebcfgDebug("on message incoming_value: %s\n", rbusValue_GetBytes(incoming_value, NULL));
 
-	data = (char *)rbusValue_GetBytes(incoming_value, &len);
-	temp_data = malloc(sizeof(char) * len + 1);
-	if(temp_data != NULL)
+	//rbus owns the event bytes, copy once and hand the copy over to a worker.
+	data = (char const *)rbusValue_GetBytes(incoming_value, &len);
+	if(data == NULL || len <= 0)
 	{
-		temp_data = memcpy(temp_data, data, len + 1);
+		WebcfgError("on message incoming_value is empty\n");
+		return;
 	}
-	else
+	temp_data = malloc(sizeof(char) * len + 1);
+	if(temp_data == NULL)
 	{
-		WebcfgError("Failed in memory allocation for temp_data\n");	
+		WebcfgError("Failed in memory allocation for temp_data\n");
+		return;
 	}
+	memcpy(temp_data, data, len);
+	temp_data[len] = '\0';
+
 	msg = (msg_t *)malloc(sizeof(msg_t));
 	if(msg != NULL)
 	{
@@ -1074,23 +1177,21 @@ static void webcfgOnMessageCallbackHandler(
 		WebcfgDebug("data is %s\n", temp_data);
 		WebcfgDebug("Received msg len is %d\n", len);
 
-		err = pthread_create(&threadId, NULL, processPayloadTask, (void *) msg);
-		if (err != 0) 
-		{
-			WebcfgError("Error creating WebConfig processPayload thread :[%s]\n", strerror(err));
-		}
-		else
+		if(addToMqttWorker(msg) != 0)
 		{
-			WebcfgInfo("WebConfig processPayload Thread created Successfully.\n");
+			WEBCFG_FREE(msg->data);
+			WEBCFG_FREE(msg);
 		}
 	}
 	else
 	{
 		WebcfgError("Failed in memory allocation for msg\n");
+		WEBCFG_FREE(temp_data);
 	}
 
     }
     (void)handle;
+    (void)subscription;
 }
 
 static void webcfgOnPublishCallbackHandler(
@@ -1216,255 +1317,166 @@ int handleMqttResponse(int response_code, char *contentLength, char* transaction
 int processPayload(char * data, int dataSize)
 {
 	int mstatus = 0;
-
 	char *transaction_uuid =NULL;
 	char ct[256] = {0};
-	char * data_body = malloc(sizeof(char) * dataSize+1);
+	char version[64] = {0};
+	char contentLength[32] = {0};
+	char *contentLengthString = NULL;
+	mqtt_envelope_t env;
 
-	if(data_body == NULL)
+	if(data == NULL || dataSize <= 0)
 	{
-		WebcfgError("Failed in memory allocation for data_body\n");
+		WebcfgError("webConfigData is empty\n");
+		WEBCFG_FREE(data);
 		return 1;
 	}
 
-	memset(data_body, 0, sizeof(char) * dataSize+1);
-	data_body = memcpy(data_body, data, dataSize+1);
-	data_body[dataSize] = '\0';
-	char *ptr_count = data_body;
-	char *ptr1_count = data_body;
-	char *temp = NULL;
-	char *etag_header = NULL;
-	char* version = NULL;
-	char* res_header = NULL;
-	char* res_code = NULL;
-	char* contentLengthString = NULL;
-	char* contentlength_header = NULL;
-	int response_code = 0;
-	WebcfgDebug("ptr_count is %s\n", ptr_count);
-
-	while((ptr_count - data_body) < dataSize )
+	//Headers are sliced from the received buffer in one pass, only the small values are copied out.
+	parseMqttEnvelope(data, (size_t)dataSize, &env);
+	if(env.response_code == 0)
 	{
-		ptr_count = memchr(ptr_count, 'H', dataSize - (ptr_count - data_body));
-		if(ptr_count == NULL)
-		{
-			WebcfgError("HTTP response code not found\n");
-			break;
-		}
-		if(0 == memcmp(ptr_count, "HTTP", strlen("HTTP")))
-		{
-			ptr1_count = memchr(ptr_count+1, '\r', dataSize - (ptr_count - data_body));
-			res_header = strndup(ptr_count, (ptr1_count-ptr_count));
-			if(res_header != NULL)
-			{
-				//Extract HTTP response code using space as delimiter
-				res_code = strtok(res_header, " ");
-				if(res_code !=NULL)
-				{
-					res_code = strtok(NULL, " ");
-					WebcfgInfo("response code extracted is %s\n", res_code);
-					if(res_code != NULL)
-					{
-						response_code = atoi(res_code);
-					}
-					res_code++;
-					break;
-				}
-			}
-		}
-		ptr_count++;
+		WebcfgError("HTTP response code not found\n");
+	}
+	else
+	{
+		WebcfgInfo("response code extracted is %d\n", env.response_code);
 	}
 
-	ptr_count = data_body;
-	ptr1_count = data_body;
-	while((ptr_count - data_body) < dataSize )
+	if(env.content_type.ptr != NULL)
 	{
-		ptr_count = memchr(ptr_count, 'C', dataSize - (ptr_count - data_body));
-		if(ptr_count == NULL)
-		{
-			WebcfgError("Content-type header not found\n");
-			break;
-		}
-/*since key name is Content-type in test blob using this for original code base use Content-Type*/
-		if(0 == memcmp(ptr_count, "Content-Type:", strlen("Content-Type:")))
-		{
-			ptr1_count = memchr(ptr_count+1, '\r', dataSize - (ptr_count - data_body));
-			temp = strndup(ptr_count, (ptr1_count-ptr_count));
-			strncpy(ct,temp,(sizeof(ct)-1));
-			break;
-		}
-		ptr_count++;
+		snprintf(ct, sizeof(ct), "%.*s", (int)env.content_type.len, env.content_type.ptr);
+	}
+	else
+	{
+		WebcfgError("Content-type header not found\n");
 	}
 
-	ptr_count = data_body;
-	ptr1_count = data_body;
-	while((ptr_count - data_body) < dataSize )
+	if(env.etag.ptr != NULL)
 	{
-		ptr_count = memchr(ptr_count, 'E', dataSize - (ptr_count - data_body));
-		if(ptr_count == NULL)
+		//Extract root version from Etag: <value> header.
+		snprintf(version, sizeof(version), "%.*s", (int)env.etag.len, env.etag.ptr);
+		WebcfgInfo("etag header extracted is %s\n", version);
+		//g_ETAG should be updated only for primary sync.
+		if(!get_global_supplementarySync())
 		{
-			WebcfgError("etag_header not found\n");
-			break;
-		}
-		if(0 == memcmp(ptr_count, "Etag:", strlen("Etag:")))
-		{
-			ptr1_count = memchr(ptr_count+1, '\r', dataSize - (ptr_count - data_body));
-			etag_header = strndup(ptr_count, (ptr1_count-ptr_count));
-			if(etag_header !=NULL)
-			{
-				WebcfgInfo("etag header extracted is %s\n", etag_header);
-				//Extract root version from Etag: <value> header.
-				version = strtok(etag_header, ":");
-				if(version !=NULL)
-				{
-					version = strtok(NULL, ":");
-					version++;
-					//g_ETAG should be updated only for primary sync.
-					if(!get_global_supplementarySync())
-					{
-						set_global_ETAG(version);
-						WebcfgInfo("g_ETAG updated in processPayload %s\n", get_global_ETAG());
-					}
-					break;
-				}
-			}
+			set_global_ETAG(version);
+			WebcfgInfo("g_ETAG updated in processPayload %s\n", get_global_ETAG());
 		}
-		ptr_count++;
+	}
+	else
+	{
+		WebcfgError("etag_header not found\n");
 	}
 
-	ptr_count = data_body;
-	ptr1_count = data_body;
-	while((ptr_count - data_body) < dataSize )
+	if(env.content_length.ptr != NULL)
 	{
-		ptr_count = memchr(ptr_count, 'C', dataSize - (ptr_count - data_body));
-		if(ptr_count == NULL)
-		{
-			WebcfgError("Content-Length not found\n");
-			break;
-		}
-		if(0 == memcmp(ptr_count, "Content-Length:", strlen("Content-Length:")))
-		{
-			ptr1_count = memchr(ptr_count+1, '\r', dataSize - (ptr_count - data_body));
-			contentlength_header = strndup(ptr_count, (ptr1_count-ptr_count));
-			if(contentlength_header !=NULL)
-			{
-				//Extract content length from Content-Length: <value> header.
-				contentLengthString = strtok(contentlength_header, ":");
-				if(contentLengthString !=NULL)
-				{
-					contentLengthString = strtok(NULL, ":");
-					contentLengthString++;
-					WebcfgInfo("contentlength extracted is %s\n", contentLengthString);
-					break;
-				}
-			}
-		}
-		ptr_count++;
+		snprintf(contentLength, sizeof(contentLength), "%.*s", (int)env.content_length.len, env.content_length.ptr);
+		contentLengthString = contentLength;
+	}
+	else
+	{
+		WebcfgError("Content-Length not found\n");
 	}
 
-	WEBCFG_FREE(data_body);
-	WEBCFG_FREE(temp);
-	WEBCFG_FREE(etag_header);
 	transaction_uuid = generate_trans_uuid();
 
 	WebcfgInfo("contentlength extracted is %s\n", contentLengthString);
-	if(handleMqttResponse(response_code, contentLengthString, transaction_uuid) == 1)
+	if(handleMqttResponse(env.response_code, contentLengthString, transaction_uuid) == 1)
 	{
 		WEBCFG_FREE(data);
 		return 1;
 	}
 
-	if(data !=NULL)
+	WebcfgInfo("webConfigData fetched successfully\n");
+	WebcfgInfo("webConfig is not in sync with cloud. response_code:%d\n", env.response_code);
+	if(env.body.ptr == NULL)
 	{
-		WebcfgInfo("webConfigData fetched successfully\n");
-		WebcfgInfo("webConfig is not in sync with cloud. response_code:%d\n", response_code);
-		WebcfgDebug("parseMultipartDocument\n");
-		mstatus = parseMultipartDocument(data, ct, (size_t)dataSize, transaction_uuid);
+		//no blank line or boundary after the headers, let the parser scan the whole message
+		env.body.ptr = data;
+		env.body.len = (size_t)dataSize;
+	}
+	WebcfgDebug("parseMultipartBody body len %zu\n", env.body.len);
+	//Only the body is scanned for boundaries, the parser takes ownership of data.
+	mstatus = parseMultipartBody(data, (char *)env.body.ptr, env.body.len, ct, transaction_uuid);
 
-		if(mstatus == WEBCFG_SUCCESS)
-		{
-			WebcfgInfo("webConfigData applied successfully\n");
-		}
-		else
-		{
-			WebcfgDebug("Failed to apply root webConfigData received from server\n");
-		}
+	if(mstatus == WEBCFG_SUCCESS)
+	{
+		WebcfgInfo("webConfigData applied successfully\n");
 	}
 	else
 	{
-		WEBCFG_FREE(transaction_uuid);
-		WebcfgError("webConfigData is empty, need to retry\n");
+		WebcfgDebug("Failed to apply root webConfigData received from server\n");
 	}
 	return 1;
 }
 
+//Frame "Destination: <dest>\r\nContent-type: ...\r\nContent-length: <n>\r\n\r\n<payload>\r\n", buffer is sized exactly.
 char * createMqttPubHeader(char * payload, char * dest, ssize_t * payload_len)
 {
-	char * destination = NULL;
-	char * content_type = NULL;
-	char * content_length = NULL;
+	static const char dest_prefix[] = "Destination: ";
+	static const char content_type[] = "\r\nContent-type: application/json";
+	char content_length[48] = {'\0'};
+	size_t plen = 0, dlen = 0, clen = 0, total = 0;
 	char *pub_headerlist = NULL;
+	char *p = NULL;
 
-	pub_headerlist = (char *) malloc(sizeof(char) * 1024);
-
-	if(pub_headerlist != NULL)
+	if(payload == NULL)
 	{
-		if(payload != NULL)
-		{
-			if(dest != NULL)
-			{
-				destination = (char *) malloc(sizeof(char)*MAX_BUF_SIZE);
-				if(destination !=NULL)
-				{
-					snprintf(destination, MAX_BUF_SIZE, "Destination: %s", dest);
-					WebcfgInfo("destination formed %s\n", destination);
-				}
-				else
-				{
-					WebcfgError("Failed in memory allocation for destination\n");					
-				}
-			}
-
-			content_type = (char *) malloc(sizeof(char)*MAX_BUF_SIZE);
-			if(content_type !=NULL)
-			{
-				snprintf(content_type, MAX_BUF_SIZE, "\r\nContent-type: application/json");
-				WebcfgInfo("content_type formed %s\n", content_type);
-			}
-			else
-			{
-				WebcfgError("Failed in memory allocation for content_type\n");				
-			}
-
-			content_length = (char *) malloc(sizeof(char)*MAX_BUF_SIZE);
-			if(content_length !=NULL)
-			{
-				snprintf(content_length, MAX_BUF_SIZE, "\r\nContent-length: %zu", strlen(payload));
-				WebcfgInfo("content_length formed %s\n", content_length);
-			}
-			else
-			{
-				WebcfgError("Failed in memory allocation for content_length\n");
-			}
-
-			WebcfgInfo("Framing publish notification header\n");
-			snprintf(pub_headerlist, 1024, "%s%s%s\r\n\r\n%s\r\n", (destination!=NULL)?destination:"", (content_type!=NULL)?content_type:"", (content_length!=NULL)?content_length:"",(payload!=NULL)?payload:"");
-	    }
-		WebcfgInfo("mqtt pub_headerlist is \n%s", pub_headerlist);
-		*payload_len = strlen(pub_headerlist);
-		WEBCFG_FREE(content_length);
-		WEBCFG_FREE(content_type);
-		WEBCFG_FREE(destination);
+		WebcfgError("payload is NULL, skip framing publish notification\n");
+		return NULL;
 	}
-	else
+	plen = strlen(payload);
+	dlen = (dest != NULL) ? strlen(dest) : 0;
+	clen = snprintf(content_length, sizeof(content_length), "\r\nContent-length: %zu", plen);
+	total = ((dest != NULL) ? (sizeof(dest_prefix) - 1 + dlen) : 0) + (sizeof(content_type) - 1) + clen + 4 + plen + 2;
+
+	pub_headerlist = (char *) malloc(total + 1);
+	if(pub_headerlist == NULL)
 	{
 		WebcfgError("Failed in memory allocation for pub_headerlist\n");
-	}	
+		return NULL;
+	}
+
+	WebcfgInfo("Framing publish notification header\n");
+	p = pub_headerlist;
+	if(dest != NULL)
+	{
+		memcpy(p, dest_prefix, sizeof(dest_prefix) - 1);
+		p += sizeof(dest_prefix) - 1;
+		memcpy(p, dest, dlen);
+		p += dlen;
+	}
+	memcpy(p, content_type, sizeof(content_type) - 1);
+	p += sizeof(content_type) - 1;
+	memcpy(p, content_length, clen);
+	p += clen;
+	memcpy(p, "\r\n\r\n", 4);
+	p += 4;
+	memcpy(p, payload, plen);
+	p += plen;
+	memcpy(p, "\r\n", 3);
+
+	WebcfgInfo("mqtt pub_headerlist is \n%s", pub_headerlist);
+	*payload_len = total;
 	return pub_headerlist;
 }
 
-rbusError_t setPublishNotification(char *publishNotifyVal)
+void set_global_mqtt_publish_async(int enable)
+{
+	mqtt_publish_async = enable;
+	WebcfgInfo("mqtt publish async mode is %d\n", mqtt_publish_async);
+}
+
+int get_global_mqtt_publish_async(void)
+{
+	return mqtt_publish_async;
+}
+
+//notify_payload and dest identify the notification, an async publish that fails is requeued with them.
+rbusError_t setPublishNotification(char *publishNotifyVal, const char *notify_payload, const char *dest)
 {
 	rbusError_t ret = RBUS_ERROR_BUS_ERROR;
+	int slot = -1;
 	rbusValue_t value;
 	rbusObject_t inParams;
 	rbusObject_t outParams;
@@ -1506,6 +1518,28 @@ rbusError_t setPublishNotification(char *publishNotifyVal)
 	rbusObject_SetValue(inParams, "qos", value);
 	rbusValue_Release(value);
 
+	//In async mode publishes are pipelined up to a bounded window, the reply is checked in publishAsyncRespHandler.
+	if(mqtt_publish_async)
+	{
+		slot = reservePublishSlot(dest, notify_payload);
+	}
+	if(slot >= 0)
+	{
+		ret = rbusMethod_InvokeAsync(rbus_handle, WEBCFG_MQTT_PUBLISH_PARAM, inParams, mqttPublishSlotHandlers[slot], MQTT_PUBLISH_TIMEOUT_SEC);
+		rbusObject_Release(inParams);
+		if (ret)
+		{
+			//caller sees the failure and spills the notification itself
+			releasePublishSlot(slot, RBUS_ERROR_SUCCESS);
+			WebcfgError("rbusMethod_InvokeAsync for setPublishNotification failed:%s\n", rbusError_ToString(ret));
+		}
+		else
+		{
+			WebcfgInfo("rbusMethod_InvokeAsync for setPublishNotification queued\n");
+		}
+		return ret;
+	}
+
 	ret = rbusMethod_Invoke(rbus_handle, WEBCFG_MQTT_PUBLISH_PARAM, inParams, &outParams);
 	rbusObject_Release(inParams);
 
@@ -1521,16 +1555,19 @@ rbusError_t setPublishNotification(char *publishNotifyVal)
 	return ret;
 }
 
-void publish_notify_mqtt(void *payload, ssize_t len, char * dest)
+//Returns 0 when the notification is handed to mqttConnManager.
+int publish_notify_mqtt(void *payload, ssize_t len, char * dest)
 {
-    int rc;
+	int rc = RBUS_ERROR_BUS_ERROR;
+
+	(void) len;
 	if(dest != NULL)
 	{
 		ssize_t payload_len = 0;
 		char * pub_payload = createMqttPubHeader(payload, dest, &payload_len);
 		if(pub_payload != NULL)
 		{
-			rc = setPublishNotification(pub_payload);
+			rc = setPublishNotification(pub_payload, (const char *)payload, dest);
 			if(rc != 0)
 			{
 					WebcfgError("setPublishNotification failed, rc %d\n", rc);
@@ -1542,6 +1579,7 @@ void publish_notify_mqtt(void *payload, ssize_t len, char * dest)
 			WEBCFG_FREE(pub_payload);
 		}
 	}
+	return rc;
 }
 
 int sendNotification_mqtt(char *payload, char *destination, wrp_msg_t *notif_wrp_msg, void *msg_bytes)
@@ -1549,10 +1587,11 @@ int sendNotification_mqtt(char *payload, char *destination, wrp_msg_t *notif_wrp
 	if(webcfg_onconnect_flag)
 	{
 		WebcfgInfo("publish_notify_mqtt with json string payload\n");
-		char *payload_str = strdup(payload);
-		WebcfgInfo("payload_str %s len %zu\n", payload_str, strlen(payload_str));
-		publish_notify_mqtt(payload_str, strlen(payload_str), destination);
-		WEBCFG_FREE(payload_str);
+		WebcfgInfo("payload_str %s len %zu\n", payload, strlen(payload));
+		if(publish_notify_mqtt(payload, strlen(payload), destination) != 0)
+		{
+			return 0;
+		}
 		WebcfgInfo("publish_notify_mqtt done\n");
 		return 1;
 	}
@@ -1562,7 +1601,382 @@ int sendNotification_mqtt(char *payload, char *destination, wrp_msg_t *notif_wrp
 	}
 	return 0;
 }
+void resetMqttSupportedHeaders(void)
+{
+	pthread_mutex_lock(&supported_headers_mut);
+	supported_headers_stale = 1;
+	pthread_mutex_unlock(&supported_headers_mut);
+}
+
 pthread_cond_t *get_global_mqtt_sync_condition(void)
 {
     return &mqtt_sync_condition;
 }
+
+//Start the MQTT message worker, once per run, stopMqttWorkers() allows a restart.
+static void initMqttWorkers(void)
+{
+	int err = 0;
+
+	pthread_mutex_lock(&mqttWorkersMut);
+	if(mqttWorkersStarted)
+	{
+		pthread_mutex_unlock(&mqttWorkersMut);
+		return;
+	}
+	memset(&mqttWorker, 0, sizeof(mqtt_worker_t));
+	pthread_mutex_init(&mqttWorker.mut, NULL);
+	pthread_cond_init(&mqttWorker.con, NULL);
+	err = pthread_create(&mqttWorker.threadId, NULL, mqttWorkerTask, (void *) &mqttWorker);
+	if (err != 0)
+	{
+		WebcfgError("Error creating MQTT worker :[%s]\n", strerror(err));
+		mqttWorker.threadId = 0;
+	}
+	else
+	{
+		WebcfgInfo("MQTT worker created Successfully\n");
+	}
+	mqttWorkersStarted = 1;
+	pthread_mutex_unlock(&mqttWorkersMut);
+}
+
+//Wake the worker for shutdown and join it, queued messages are freed.
+void stopMqttWorkers(void)
+{
+	msg_t *msg = NULL;
+
+	pthread_mutex_lock(&mqttWorkersMut);
+	if(!mqttWorkersStarted)
+	{
+		pthread_mutex_unlock(&mqttWorkersMut);
+		return;
+	}
+	pthread_mutex_lock(&mqttWorker.mut);
+	pthread_cond_broadcast(&mqttWorker.con);
+	pthread_mutex_unlock(&mqttWorker.mut);
+	if(mqttWorker.threadId != 0)
+	{
+		JoinThread(mqttWorker.threadId);
+		mqttWorker.threadId = 0;
+	}
+	while(mqttWorker.head != NULL)
+	{
+		msg = mqttWorker.head;
+		mqttWorker.head = msg->next;
+		WebcfgError("Dropping queued MQTT message of len %d at shutdown\n", msg->len);
+		WEBCFG_FREE(msg->data);
+		WEBCFG_FREE(msg);
+	}
+	mqttWorker.tail = NULL;
+	mqttWorker.count = 0;
+	mqttWorkersStarted = 0;
+	pthread_mutex_unlock(&mqttWorkersMut);
+	WebcfgInfo("MQTT worker stopped, %u messages dropped on a full queue\n", __atomic_load_n(&mqttDroppedCount, __ATOMIC_RELAXED));
+}
+
+//Queue msg to the worker without blocking the rbus callback thread.
+//Returns 0 when the worker took ownership of msg, 1 when it was dropped (queue full or shutdown).
+static int addToMqttWorker(msg_t *msg)
+{
+	initMqttWorkers();
+	if(mqttWorker.threadId == 0)
+	{
+		//no worker thread, process in the caller rather than dropping the config push
+		WebcfgError("MQTT worker not running, processing payload inline\n");
+		processPayload((char *)msg->data, msg->len);
+		WEBCFG_FREE(msg);
+		return 0;
+	}
+
+	pthread_mutex_lock(&mqttWorker.mut);
+	if(get_global_shutdown())
+	{
+		pthread_mutex_unlock(&mqttWorker.mut);
+		WebcfgError("Shutdown in progress, MQTT message of len %d not processed\n", msg->len);
+		return 1;
+	}
+	if(mqttWorker.count >= MQTT_WORKER_QUEUE_MAX)
+	{
+		pthread_mutex_unlock(&mqttWorker.mut);
+		WebcfgError("MQTT worker queue full, dropped message of len %d, %u dropped so far\n", msg->len, __atomic_add_fetch(&mqttDroppedCount, 1, __ATOMIC_RELAXED));
+		return 1;
+	}
+	msg->next = NULL;
+	if(mqttWorker.tail == NULL)
+	{
+		mqttWorker.head = msg;
+	}
+	else
+	{
+		mqttWorker.tail->next = msg;
+	}
+	mqttWorker.tail = msg;
+	mqttWorker.count++;
+	pthread_cond_signal(&mqttWorker.con);
+	pthread_mutex_unlock(&mqttWorker.mut);
+	return 0;
+}
+
+//Worker processes queued messages in order, processPayload owns the message data.
+static void * mqttWorkerTask(void *arg)
+{
+	mqtt_worker_t *worker = (mqtt_worker_t *) arg;
+	msg_t *msg = NULL;
+
+	while(FOREVER())
+	{
+		pthread_mutex_lock(&worker->mut);
+		while(worker->head == NULL && !get_global_shutdown())
+		{
+			pthread_cond_wait(&worker->con, &worker->mut);
+		}
+		if(get_global_shutdown())
+		{
+			pthread_mutex_unlock(&worker->mut);
+			WebcfgDebug("g_shutdown in MQTT worker\n");
+			break;
+		}
+		msg = worker->head;
+		worker->head = msg->next;
+		if(worker->head == NULL)
+		{
+			worker->tail = NULL;
+		}
+		worker->count--;
+		pthread_mutex_unlock(&worker->mut);
+
+		processPayload((char *)msg->data, msg->len);
+		WEBCFG_FREE(msg);
+	}
+	return NULL;
+}
+
+//Single pass over the envelope lines: status line and headers up to the blank line or first multipart boundary.
+static void parseMqttEnvelope(const char *data, size_t len, mqtt_envelope_t *env)
+{
+	const char *p = data, *end = data + len, *eol = NULL, *sp = NULL;
+	size_t line_len = 0;
+
+	memset(env, 0, sizeof(mqtt_envelope_t));
+	while(p < end)
+	{
+		eol = memchr(p, '\n', end - p);
+		line_len = (eol != NULL) ? (size_t)(eol - p) : (size_t)(end - p);
+		if(line_len > 0 && p[line_len - 1] == '\r')
+		{
+			line_len--;
+		}
+		if((line_len == 0 && env->response_code != 0) || (line_len >= 2 && p[0] == '-' && p[1] == '-'))
+		{
+			env->body.ptr = (line_len == 0) ? ((eol != NULL) ? eol + 1 : end) : p;
+			env->body.len = end - env->body.ptr;
+			return;
+		}
+		if(env->response_code == 0 && line_len > 5 && memcmp(p, "HTTP/", 5) == 0)
+		{
+			//HTTP/1.1 <code> <reason>
+			sp = memchr(p, ' ', line_len);
+			if(sp != NULL)
+			{
+				env->response_code = atoi(sp + 1);
+			}
+		}
+		else if(matchMqttHeader(p, line_len, "Content-Type:", NULL))
+		{
+			//whole line is kept, boundary is extracted by the multipart parser
+			env->content_type.ptr = p;
+			env->content_type.len = line_len;
+		}
+		else if(!matchMqttHeader(p, line_len, "Etag:", &env->etag))
+		{
+			matchMqttHeader(p, line_len, "Content-Length:", &env->content_length);
+		}
+		p = (eol != NULL) ? eol + 1 : end;
+	}
+	env->body.ptr = end;
+	env->body.len = 0;
+}
+
+//Case insensitive header name match, value is the trimmed slice after the name.
+static int matchMqttHeader(const char *line, size_t line_len, const char *name, mqtt_slice_t *value)
+{
+	size_t name_len = strlen(name);
+	const char *v = NULL, *e = line + line_len;
+
+	if(line_len < name_len || strncasecmp(line, name, name_len) != 0)
+	{
+		return 0;
+	}
+	if(value != NULL)
+	{
+		for(v = line + name_len; v < e && (*v == ' ' || *v == '\t'); v++);
+		while(e > v && (e[-1] == ' ' || e[-1] == '\t'))
+		{
+			e--;
+		}
+		value->ptr = v;
+		value->len = e - v;
+	}
+	return 1;
+}
+
+//Take a free in-flight slot for an async publish, -1 when the window is full or out of memory.
+static int reservePublishSlot(const char *dest, const char *payload)
+{
+	int i = 0;
+	int slot = -1;
+
+	pthread_mutex_lock(&mqtt_publish_mut);
+	for(i = 0; i < MQTT_PUBLISH_INFLIGHT_MAX; i++)
+	{
+		if(!mqttPublishSlots[i].used)
+		{
+			mqttPublishSlots[i].dest = (dest != NULL) ? strdup(dest) : NULL;
+			mqttPublishSlots[i].payload = (payload != NULL) ? strdup(payload) : NULL;
+			if(mqttPublishSlots[i].dest == NULL || mqttPublishSlots[i].payload == NULL)
+			{
+				WebcfgError("Failed to reserve async publish slot, publish synchronously\n");
+				if(mqttPublishSlots[i].dest != NULL)
+				{
+					WEBCFG_FREE(mqttPublishSlots[i].dest);
+				}
+				if(mqttPublishSlots[i].payload != NULL)
+				{
+					WEBCFG_FREE(mqttPublishSlots[i].payload);
+				}
+				break;
+			}
+			mqttPublishSlots[i].used = 1;
+			slot = i;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&mqtt_publish_mut);
+	return slot;
+}
+
+//Free the slot, a failed reply puts its notification back in the notify outbox.
+static void releasePublishSlot(int slot, rbusError_t error)
+{
+	char *dest = NULL;
+	char *payload = NULL;
+
+	pthread_mutex_lock(&mqtt_publish_mut);
+	dest = mqttPublishSlots[slot].dest;
+	payload = mqttPublishSlots[slot].payload;
+	mqttPublishSlots[slot].dest = NULL;
+	mqttPublishSlots[slot].payload = NULL;
+	mqttPublishSlots[slot].used = 0;
+	pthread_mutex_unlock(&mqtt_publish_mut);
+
+	if(error != RBUS_ERROR_SUCCESS)
+	{
+		requeueNotification(dest, payload);
+	}
+	if(dest != NULL)
+	{
+		WEBCFG_FREE(dest);
+	}
+	if(payload != NULL)
+	{
+		WEBCFG_FREE(payload);
+	}
+}
+
+//Reply of an async publish, failed notifications are requeued for redelivery.
+static void publishAsyncRespHandler(int slot, char const* methodName, rbusError_t error)
+{
+	if(error != RBUS_ERROR_SUCCESS)
+	{
+		WebcfgError("Async %s failed:%s\n", methodName, rbusError_ToString(error));
+	}
+	else
+	{
+		WebcfgDebug("Async %s success\n", methodName);
+	}
+	releasePublishSlot(slot, error);
+}
+
+//Subscribe once for the broker status, rbus retries until mqttConnManager registers the parameter.
+static void subscribeMqttConnStatusEvent(void)
+{
+	int rc = RBUS_ERROR_SUCCESS;
+	rbusHandle_t rbus_handle = get_global_rbus_handle();
+	pthread_condattr_t attr;
+
+	//Back off deadlines are on CLOCK_MONOTONIC so wall clock changes do not shift them, set up before any event can signal.
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&mqtt_conn_condition, &attr);
+	pthread_condattr_destroy(&attr);
+
+	if(!rbus_handle)
+	{
+		WebcfgError("subscribeMqttConnStatusEvent failed as rbus_handle is empty\n");
+		return;
+	}
+	WebcfgInfo("Subscribing to %s Event\n", MQTT_CONNSTATUS_PARAM);
+	rc = rbusEvent_SubscribeAsync(rbus_handle, MQTT_CONNSTATUS_PARAM, mqttConnStatusEventHandler, mqttConnStatusSubscribeHandler, "Webcfg_MqttConnStatus", -1);
+	if(rc != RBUS_ERROR_SUCCESS)
+	{
+		WebcfgError("%s subscribe failed : %d - %s\n", MQTT_CONNSTATUS_PARAM, rc, rbusError_ToString(rc));
+	}
+}
+
+static void mqttConnStatusEventHandler(
+    rbusHandle_t handle,
+    rbusEvent_t const* event,
+    rbusEventSubscription_t* subscription)
+{
+	const char *status = NULL;
+	rbusValue_t value = NULL;
+
+	(void) handle;
+	(void) subscription;
+	value = rbusObject_GetValue(event->data, "value");
+	if(value != NULL)
+	{
+		status = rbusValue_GetString(value, NULL);
+	}
+	WebcfgInfo("Received %s event, status %s\n", event->name, (status != NULL) ? status : "NULL");
+	if(status != NULL && strncmp(status, "Up", 2) == 0)
+	{
+		pthread_mutex_lock(&mqtt_conn_mutex);
+		__atomic_add_fetch(&mqtt_conn_event_gen, 1, __ATOMIC_RELEASE);
+		pthread_cond_broadcast(&mqtt_conn_condition);
+		pthread_mutex_unlock(&mqtt_conn_mutex);
+	}
+}
+
+static void mqttConnStatusSubscribeHandler(
+    rbusHandle_t handle,
+    rbusEventSubscription_t* subscription,
+    rbusError_t error)
+{
+	(void) handle;
+	WebcfgInfo("mqttConnStatusSubscribeHandler event %s, error %d - %s\n", subscription->eventName, error, rbusError_ToString(error));
+}
+
+static void dropStaleSupportedHeaders(void)
+{
+	pthread_mutex_lock(&supported_headers_mut);
+	if(supported_headers_stale)
+	{
+		if(supportedVersion_header != NULL)
+		{
+			WEBCFG_FREE(supportedVersion_header);
+		}
+		if(supportedDocs_header != NULL)
+		{
+			WEBCFG_FREE(supportedDocs_header);
+		}
+		if(supplementaryDocs_header != NULL)
+		{
+			WEBCFG_FREE(supplementaryDocs_header);
+		}
+		supported_headers_stale = 0;
+		WebcfgInfo("Supported docs headers reset after properties reload\n");
+	}
+	pthread_mutex_unlock(&supported_headers_mut);
+}
@@ -54,13 +54,15 @@
 #define WEBCFG_ONMESSAGE_CALLBACK    "Device.X_RDK_MQTT.Webconfig.OnMessageCallback"
 #define WEBCFG_ONPUBLISH_CALLBACK    "Device.X_RDK_MQTT.Webconfig.OnPublishCallback"
 
-typedef struct
+//Incoming MQTT message, data is owned by the message until handed to processPayload.
+typedef struct mqtt_msg
 {
 	void *data;
 	int len;
+	struct mqtt_msg *next;
 }msg_t;
 
-void publish_notify_mqtt(void *payload, ssize_t len, char * dest);
+int publish_notify_mqtt(void *payload, ssize_t len, char * dest);
 char * createMqttPubHeader(char * payload, char * dest, ssize_t * payload_len);
 int createMqttHeader(char **header_list);
 int triggerMqttSync();
@@ -74,4 +76,8 @@ rbusError_t mqttSubscribeInit();
 int getMqttCMConnStatus();
 void freeMqttHeaders(char *contentlen_header, char *contenttype_header, char *PartnerID_header, char *ModelName_header, char *productClass_header, char *uuid_header, char *systemReadyTime_header, char *currentTime_header, char *status_header, char *FwVersion_header, char *bootTime_header, char *schema_header, char *accept_header, char *version_header, char *doc_header, char *deviceId_header, char *transaction_uuid);
 pthread_cond_t *get_global_mqtt_sync_condition(void);
+void set_global_mqtt_publish_async(int enable);
+int get_global_mqtt_publish_async(void);
+void resetMqttSupportedHeaders(void);
+void stopMqttWorkers(void);
 #endif
@@ -48,6 +48,8 @@
 #define MAX_HEADER_LEN			4096
 #define ETAG_HEADER 		       "Etag:"
 #define CONTENT_LENGTH_HEADER 	       "Content-Length:"
+#define RETRY_AFTER_HEADER 	       "Retry-After:"
+#define SYNC_WINDOW_HEADER 	       "X-Sync-Window:"
 #define CURL_TIMEOUT_SEC	   25L
 #if ! defined(DEVICE_EXTENDER)
 #define CA_CERT_PATH 		   "/etc/ssl/certs/ca-certificates.crt"
@@ -86,6 +88,9 @@ static char g_deviceWanMac[64]={'\0'};
 static char *supportedVersion_header=NULL;
 static char *supportedDocs_header=NULL;
 static char *supplementaryDocs_header=NULL;
+//Set when webconfig.properties is reloaded, the sync thread drops the cached headers on its next request.
+static int supported_headers_stale = 0;
+static pthread_mutex_t supported_headers_mut = PTHREAD_MUTEX_INITIALIZER;
 #endif
 static char g_ForceSyncTransID[128]={'\0'};
 char g_RebootReason[64]={'\0'};
@@ -93,6 +98,9 @@ static char g_transID[64]={'\0'};
 static char * g_contentLen = NULL;
 static multipartdocs_t *g_mp_head = NULL;
 pthread_mutex_t multipart_t_mut =PTHREAD_MUTEX_INITIALIZER;
+//Decoded params of retried docs, at most one entry per doc name.
+static mpdoc_params_t *g_mp_params_head = NULL;
+static pthread_mutex_t mp_params_mut = PTHREAD_MUTEX_INITIALIZER;
 static int eventFlag = 0;
 
 char * get_global_transID(void)
@@ -177,6 +185,12 @@ void loadInitURLFromFile(char **url);
 #ifdef FEATURE_SUPPORT_AKER
 WEBCFG_STATUS checkAkerDoc();
 #endif
+#if !defined (FEATURE_SUPPORT_MQTTCM)
+static void dropStaleSupportedHeaders(void);
+#endif
+static void getHeaderValue(const char *buffer, size_t nitems, size_t name_len, char *value, size_t value_size);
+static void dropMpDocParams(const char *doc_name);
+static void freeMpDocParams(mpdoc_params_t *params);
 
 /*----------------------------------------------------------------------------*/
 /*                             External Functions                             */
@@ -455,6 +469,11 @@ WEBCFG_STATUS webcfg_http_request(char **configData, int r_count, int status, lo
 }
 
 WEBCFG_STATUS parseMultipartDocument(void *config_data, char *ct , size_t data_size, char* trans_uuid)
+{
+	return parseMultipartBody(config_data, (char *) config_data, data_size, ct, trans_uuid);
+}
+
+WEBCFG_STATUS parseMultipartBody(void *config_data, char *body, size_t data_size, char *ct, char* trans_uuid)
 {
 	char *boundary = NULL;
 	char *str=NULL;
@@ -485,10 +504,8 @@ WEBCFG_STATUS parseMultipartDocument(void *config_data, char *ct , size_t data_s
 		last_line_boundary  = (char *)malloc(sizeof(char) * (boundary_len + 5));
 		snprintf(last_line_boundary,boundary_len+5,"--%s--",boundary);
 		WebcfgDebug( "last_line_boundary %s, len %zu\n", last_line_boundary, strlen(last_line_boundary) );
-		// Use --boundary to split
-		str_body = malloc(sizeof(char) * data_size + 1);
-		str_body = memcpy(str_body, config_data, data_size + 1);
-		WEBCFG_FREE(config_data);
+		// Use --boundary to split, body points into config_data which is owned here and parsed in place
+		str_body = body;
 		int num_of_parts = 0;
 		char *ptr_lb=str_body;
 		char *ptr_lb1=str_body;
@@ -552,7 +569,7 @@ WEBCFG_STATUS parseMultipartDocument(void *config_data, char *ct , size_t data_s
 			ptr_lb = memchr(ptr_lb, '\n', data_size - (ptr_lb - str_body));
 			ptr_lb++;
 		}
-		WEBCFG_FREE(str_body);
+		WEBCFG_FREE(config_data);
 		WEBCFG_FREE(line_boundary);
 		WEBCFG_FREE(last_line_boundary);
 
@@ -678,7 +695,7 @@ WEBCFG_STATUS processMsgpackSubdoc(char *transaction_id)
 
 		WebcfgDebug("check for current docs\n");
 		//Process subdocs with status "pending_apply" which indicates docs from current sync, skip all others.
-		if(strcmp(subdoc_node->status, "pending_apply") != 0)
+		if(subdoc_node->status != TMP_STATUS_PENDING_APPLY)
 		{
 			WebcfgDebug("skipped setValues for doc %s as it is already processed\n", mp->name_space);
 			mp = mp->next;
@@ -787,12 +804,11 @@ WEBCFG_STATUS processMsgpackSubdoc(char *transaction_id)
 				{
 					WebcfgDebug("WebConfig SET Request\n");
 					#ifdef WEBCONFIG_BIN_SUPPORT
+						SubDocMeta_t meta;
 						// rbus_enabled and rbus_listener_supported, rbus_set direct API used to send binary data to component.
-						if(isRbusEnabled() && isRbusListener(mp->name_space))
+						if(isRbusEnabled() && getSubDocMeta(mp->name_space, &meta) == WEBCFG_SUCCESS && meta.rbus_listener)
 						{
-							char topic[64] = {0};
-					        	get_destination(mp->name_space, topic);
-							blobSet_rbus(topic, buff, sendMsgSize, &ret, &ccspStatus);
+							blobSet_rbus(meta.dest, buff, sendMsgSize, &ret, &ccspStatus);
 						}
 						//rbus_enabled and rbus_listener_not_supported, rbus_set api used to send b64 encoded data to component.
 						else 
@@ -901,9 +917,7 @@ WEBCFG_STATUS processMsgpackSubdoc(char *transaction_id)
 								set_doc_fail(1);
 
 								updateFailureTimeStamp(subdoc_node, mp->name_space, expiry_time);
-								WebcfgDebug("The retry_timer is %d and timeout generated is %lld\n", get_retry_timer(), expiry_time);
-								//To get the exact time diff for retry from present time.
-								updateRetryTimeDiff(expiry_time);
+								WebcfgDebug("The retry timeout generated is %lld\n", expiry_time);
 								snprintf(result,MAX_VALUE_LEN,"failed_retrying:%s", errDetails);
 							}
 							WebcfgDebug("The result is %s\n",result);
@@ -1044,13 +1058,15 @@ WEBCFG_STATUS processMsgpackSubdoc(char *transaction_id)
 	{
 
 		webconfig_db_data_t* temp1 = NULL;
-		temp1 = get_global_db_node();
+		webcfg_db_snapshot_t *snap = acquireDBSnapshot();
+		temp1 = (snap != NULL) ? snap->db_list : NULL;
 
 		while(temp1 )
 		{
 			WebcfgInfo("DB wd->name: %s, version: %lu\n",  temp1->name, (long)temp1->version);
 			temp1 = temp1->next;
 		}
+		releaseDBSnapshot(snap);
 		WebcfgDebug("addNewDocEntry\n");
 		addNewDocEntry(get_successDocCount());
 	}
@@ -1167,6 +1183,50 @@ size_t headr_callback(char *buffer, size_t size, size_t nitems, void* data)
 			WebcfgDebug("g_contentLen is %s\n", g_contentLen);
 		}
 	}
+
+	//Retry-After is either delta seconds or an HTTP date
+	if( nitems > strlen(RETRY_AFTER_HEADER) && strncasecmp(RETRY_AFTER_HEADER, buffer, strlen(RETRY_AFTER_HEADER)) == 0 )
+	{
+		long retry_after = 0;
+#if !defined (FEATURE_SUPPORT_MQTTCM)
+		time_t retry_date = 0;
+#endif
+
+		getHeaderValue(buffer, nitems, strlen(RETRY_AFTER_HEADER), header_str, sizeof(header_str));
+		if(header_str[0] != '\0' && strspn(header_str, "0123456789") == strlen(header_str))
+		{
+			retry_after = strtol(header_str, NULL, 10);
+		}
+#if !defined (FEATURE_SUPPORT_MQTTCM)
+		else
+		{
+			retry_date = curl_getdate(header_str, NULL);
+			if(retry_date > 0)
+			{
+				retry_after = (long)(retry_date - time(NULL));
+			}
+		}
+#endif
+		set_global_retry_after((retry_after > 0) ? retry_after : 0);
+		WebcfgInfo("Retry-After from server is %ld seconds\n", get_global_retry_after());
+	}
+
+	//Sync window is "start-end" in seconds from local midnight
+	if( nitems > strlen(SYNC_WINDOW_HEADER) && strncasecmp(SYNC_WINDOW_HEADER, buffer, strlen(SYNC_WINDOW_HEADER)) == 0 )
+	{
+		long window_start = 0;
+		long window_end = 0;
+
+		getHeaderValue(buffer, nitems, strlen(SYNC_WINDOW_HEADER), header_str, sizeof(header_str));
+		if(sscanf(header_str, "%ld-%ld", &window_start, &window_end) == 2)
+		{
+			set_global_sync_window(window_start, window_end);
+		}
+		else
+		{
+			WebcfgError("Invalid sync window header %s\n", header_str);
+		}
+	}
 	WebcfgDebug("header_callback size %zu\n", size);
 	WebcfgDebug("data %s\n", (char*)data);
 	return nitems;
@@ -1327,7 +1387,8 @@ int readFromFile(char *filename, char **data, int *len)
 void getRootDocVersionFromDBCache(uint32_t *rt_version, char **rt_string, int *subdoclist)
 {
 	webconfig_db_data_t *temp = NULL;
-	temp = get_global_db_node();
+	webcfg_db_snapshot_t *snap = acquireDBSnapshot();
+	temp = (snap != NULL) ? snap->db_list : NULL;
 
 	while (NULL != temp)
 	{
@@ -1343,6 +1404,7 @@ void getRootDocVersionFromDBCache(uint32_t *rt_version, char **rt_string, int *s
 		temp= temp->next;
 		*subdoclist = *subdoclist+1;
 	}
+	releaseDBSnapshot(snap);
 	WebcfgDebug("*subdoclist is %d\n", *subdoclist);
 }
 
@@ -1469,7 +1531,8 @@ void refreshConfigVersionList(char *versionsList, int http_status, char *docsLis
 		addNewDocEntry(get_successDocCount());
 	}
 	webconfig_db_data_t *temp = NULL;
-	temp = get_global_db_node();
+	webcfg_db_snapshot_t *snap = acquireDBSnapshot();
+	temp = (snap != NULL) ? snap->db_list : NULL;
 
 	if(NULL != temp)
 	{
@@ -1509,6 +1572,7 @@ void refreshConfigVersionList(char *versionsList, int http_status, char *docsLis
 		WebcfgDebug("Final versionsList is %s len %zu\n", versionsList, strlen(versionsList));
 		WebcfgDebug("Final docsList is %s len %zu\n", docsList, strlen(docsList));
 	}
+	releaseDBSnapshot(snap);
 }
 
 /* @brief Function to create curl header options
@@ -1599,9 +1663,11 @@ void createCurlHeader( struct curl_slist *list, struct curl_slist **header_list,
 		WEBCFG_FREE(schema_header);
 	}
 
+	dropStaleSupportedHeaders();
+
 	if(supportedVersion_header == NULL)
 	{
-		supportedVersion = getsupportedVersion();
+		supportedVersion = copysupportedVersion();
 
 		if(supportedVersion !=NULL)
 		{
@@ -1612,6 +1678,7 @@ void createCurlHeader( struct curl_slist *list, struct curl_slist **header_list,
 			snprintf(supportedVersion_header, supported_version_size+1, "X-System-Schema-Version: %s", supportedVersion);
 			WebcfgInfo("supportedVersion_header formed %s\n", supportedVersion_header);
 			list = curl_slist_append(list, supportedVersion_header);
+			WEBCFG_FREE(supportedVersion);
 		}
 		else
 		{
@@ -1626,7 +1693,7 @@ void createCurlHeader( struct curl_slist *list, struct curl_slist **header_list,
 
 	if(supportedDocs_header == NULL)
        	{
-		supportedDocs = getsupportedDocs();
+		supportedDocs = copysupportedDocs();
 
       		if(supportedDocs !=NULL)
 		{
@@ -1640,6 +1707,7 @@ void createCurlHeader( struct curl_slist *list, struct curl_slist **header_list,
 				WebcfgInfo("supportedDocs_header formed %s\n", supportedDocs_header);
 				list = curl_slist_append(list, supportedDocs_header);
 			}
+			WEBCFG_FREE(supportedDocs);
 		}
 		else
 		{
@@ -1656,7 +1724,7 @@ void createCurlHeader( struct curl_slist *list, struct curl_slist **header_list,
 	{
 		if(supplementaryDocs_header == NULL)
 		{
-			supplementaryDocs = getsupplementaryDocs();
+			supplementaryDocs = copysupplementaryDocs();
 
 			if(supplementaryDocs !=NULL)
 			{
@@ -1667,6 +1735,7 @@ void createCurlHeader( struct curl_slist *list, struct curl_slist **header_list,
 				snprintf(supplementaryDocs_header, supplementary_docs_size+1, "X-System-SupplementaryService-Sync: %s", supplementaryDocs);
 				WebcfgInfo("supplementaryDocs_header formed %s\n", supplementaryDocs_header);
 				list = curl_slist_append(list, supplementaryDocs_header);
+				WEBCFG_FREE(supplementaryDocs);
 			}
 			else
 			{
@@ -1990,21 +2059,158 @@ void delete_multipart()
 {
 	multipartdocs_t *temp = NULL;
 	multipartdocs_t *head = NULL;
-	head = get_global_mp();
+
+	//Detach the whole list first, borrowed nodes are freed by their last reader.
+	pthread_mutex_lock (&multipart_t_mut);
+	head = g_mp_head;
+	g_mp_head = NULL;
+	pthread_mutex_unlock (&multipart_t_mut);
 
 	while(head != NULL)
 	{
 		temp = head;
 		head = head->next;
 		WebcfgDebug("Deleted mp node: temp->name_space:%s\n", temp->name_space);
-		WEBCFG_FREE(temp->name_space);
-		WEBCFG_FREE(temp->data);
-		free(temp);
+		releaseMpDoc(temp);
 		temp = NULL;
 	}
+	dropMpDocParams(NULL);
+}
+
+//Borrow a subdoc from the multipart list, release it with releaseMpDoc().
+multipartdocs_t * acquireMpDoc(const char *doc_name)
+{
+	multipartdocs_t *temp = NULL;
+
+	if(doc_name == NULL)
+	{
+		return NULL;
+	}
 	pthread_mutex_lock (&multipart_t_mut);
-	g_mp_head = NULL;
+	for(temp = g_mp_head; temp != NULL; temp = temp->next)
+	{
+		if(strcmp(temp->name_space, doc_name) == 0)
+		{
+			__atomic_add_fetch(&temp->refcount, 1, __ATOMIC_RELAXED);
+			break;
+		}
+	}
 	pthread_mutex_unlock (&multipart_t_mut);
+	return temp;
+}
+
+void releaseMpDoc(multipartdocs_t *mp_doc)
+{
+	if(mp_doc == NULL)
+	{
+		return;
+	}
+	if(__atomic_sub_fetch(&mp_doc->refcount, 1, __ATOMIC_ACQ_REL) == 0)
+	{
+		WEBCFG_FREE(mp_doc->name_space);
+		WEBCFG_FREE(mp_doc->data);
+		free(mp_doc);
+	}
+}
+
+//Decode mp_doc once per version and share the result, release it with releaseMpDocParams().
+mpdoc_params_t * acquireMpDocParams(multipartdocs_t *mp_doc, uint16_t *err)
+{
+	mpdoc_params_t *entry = NULL;
+	mpdoc_params_t *prev = NULL;
+	mpdoc_params_t *stale = NULL;
+	webcfgparam_t *pm = NULL;
+
+	if(mp_doc == NULL)
+	{
+		return NULL;
+	}
+	pthread_mutex_lock (&mp_params_mut);
+	for(entry = g_mp_params_head; entry != NULL; prev = entry, entry = entry->next)
+	{
+		if(strcmp(entry->name_space, mp_doc->name_space) == 0)
+		{
+			break;
+		}
+	}
+	if(entry != NULL && entry->etag == mp_doc->etag)
+	{
+		entry->refcount++;
+		pthread_mutex_unlock (&mp_params_mut);
+		WebcfgDebug("Using cached params for %s\n", mp_doc->name_space);
+		return entry;
+	}
+	//An entry of an older version is unlinked here and freed by its last reader.
+	if(entry != NULL)
+	{
+		if(prev == NULL)
+		{
+			g_mp_params_head = entry->next;
+		}
+		else
+		{
+			prev->next = entry->next;
+		}
+		if(--entry->refcount == 0)
+		{
+			stale = entry;
+		}
+	}
+	pthread_mutex_unlock (&mp_params_mut);
+	freeMpDocParams(stale);
+
+	WebcfgDebug("--------------decode root doc-------------\n");
+	pm = webcfgparam_convert( mp_doc->data, mp_doc->data_size+1 );
+	*err = errno;
+	if(pm == NULL)
+	{
+		return NULL;
+	}
+	pthread_mutex_lock (&mp_params_mut);
+	//Another retry may have decoded the same version meanwhile.
+	for(entry = g_mp_params_head; entry != NULL; entry = entry->next)
+	{
+		if(strcmp(entry->name_space, mp_doc->name_space) == 0 && entry->etag == mp_doc->etag)
+		{
+			entry->refcount++;
+			pthread_mutex_unlock (&mp_params_mut);
+			webcfgparam_destroy(pm);
+			return entry;
+		}
+	}
+	entry = (mpdoc_params_t *)malloc(sizeof(mpdoc_params_t));
+	if(entry == NULL)
+	{
+		pthread_mutex_unlock (&mp_params_mut);
+		webcfgparam_destroy(pm);
+		return NULL;
+	}
+	entry->name_space = strdup(mp_doc->name_space);
+	entry->etag = mp_doc->etag;
+	entry->params = pm;
+	//One reference for the cache, one for the caller.
+	entry->refcount = 2;
+	entry->next = g_mp_params_head;
+	g_mp_params_head = entry;
+	pthread_mutex_unlock (&mp_params_mut);
+	return entry;
+}
+
+void releaseMpDocParams(mpdoc_params_t *params)
+{
+	int refcount = 0;
+
+	if(params == NULL)
+	{
+		return;
+	}
+	pthread_mutex_lock (&mp_params_mut);
+	refcount = --params->refcount;
+	pthread_mutex_unlock (&mp_params_mut);
+	if(refcount == 0)
+	{
+		freeMpDocParams(params);
+	}
 }
 
 //Segregation of each subdoc elements line by line
@@ -2135,6 +2341,7 @@ void addToMpList(uint32_t etag, char *name_space, char *data, size_t data_size)
 		mp_node->data = memcpy(mp_node->data, data, data_size );
 		mp_node->data_size = data_size;
 		mp_node->isSupplementarySync = get_global_supplementarySync();
+		mp_node->refcount = 1;
 		mp_node->next = NULL;
 
 		WebcfgDebug("mp_node->etag is %ld\n",(long)mp_node->etag);
@@ -2143,14 +2350,15 @@ void addToMpList(uint32_t etag, char *name_space, char *data, size_t data_size)
 		WebcfgDebug("mp_node->data_size is %zu\n", mp_node->data_size);
 		WebcfgDebug("mp_node->isSupplementarySync is %d\n", mp_node->isSupplementarySync);
 
-		if(get_global_mp() == NULL)
+		pthread_mutex_lock (&multipart_t_mut);
+		if(g_mp_head == NULL)
 		{
-			set_global_mp(mp_node);
+			g_mp_head = mp_node;
 		}
 		else
 		{
 			multipartdocs_t *temp = NULL;
-			temp = get_global_mp();
+			temp = g_mp_head;
 			while( temp->next != NULL)
 			{
 				WebcfgDebug("The temp->name_space is %s\n", temp->name_space);
@@ -2158,6 +2366,7 @@ void addToMpList(uint32_t etag, char *name_space, char *data, size_t data_size)
 			}
 			temp->next = mp_node;
 		}
+		pthread_mutex_unlock (&multipart_t_mut);
 	}
 
 }
@@ -2165,16 +2374,18 @@ void addToMpList(uint32_t etag, char *name_space, char *data, size_t data_size)
 void delete_mp_doc()
 {
 	multipartdocs_t *temp = NULL;
+	multipartdocs_t *next = NULL;
 	temp = get_global_mp();
 
 	while(temp != NULL)
 	{
+		next = temp->next;
 		if(temp->isSupplementarySync == get_global_supplementarySync())
 		{
 			WebcfgDebug("Delete mp node--> mp_node->name_space is %s mp_node->etag is %lu mp_node->isSupplementarySync %d\n", temp->name_space, (long)temp->etag, temp->isSupplementarySync);
 			deleteFromMpList(temp->name_space);
 		}
-		temp = temp->next;
+		temp = next;
 	}
 
 }
@@ -2213,12 +2424,11 @@ WEBCFG_STATUS deleteFromMpList(char* doc_name)
 			}
 
 			WebcfgDebug("Deleting the node entries\n");
-			WEBCFG_FREE( curr_node->name_space );
-			WEBCFG_FREE( curr_node->data );
-			WEBCFG_FREE( curr_node );
+			pthread_mutex_unlock (&multipart_t_mut);
+			dropMpDocParams(doc_name);
+			releaseMpDoc(curr_node);
 			curr_node = NULL;
 			WebcfgDebug("Deleted successfully and returning..\n");
-			pthread_mutex_unlock (&multipart_t_mut);
 			return WEBCFG_SUCCESS;
 		}
 
@@ -2234,11 +2444,12 @@ WEBCFG_STATUS print_tmp_doc_list(size_t mp_count)
 {
 	int count =0;
 	webconfig_tmp_data_t *temp = NULL;
-	temp = get_global_tmp_node();
+	webcfg_db_snapshot_t *snap = acquireDBSnapshot();
+	temp = (snap != NULL) ? snap->tmp_list : NULL;
 	while (NULL != temp)
 	{
 		count = count+1;
-		WebcfgInfo("node is pointing to temp->name %s temp->version %lu temp->status %s temp->error_details %s\n",temp->name, (long)temp->version, temp->status, temp->error_details);
+		WebcfgInfo("node is pointing to temp->name %s temp->version %lu temp->status %s temp->error_details %s\n",temp->name, (long)temp->version, tmpStatusToString(temp->status), temp->error_details);
 		temp= temp->next;
 		WebcfgDebug("count %d mp_count %zu\n", count, mp_count);
 		if(count == (int)mp_count)
@@ -2247,6 +2458,7 @@ WEBCFG_STATUS print_tmp_doc_list(size_t mp_count)
 			break;
 		}
 	}
+	releaseDBSnapshot(snap);
 	return WEBCFG_SUCCESS;
 }
 
@@ -2375,7 +2587,7 @@ WEBCFG_STATUS checkRootDelete()
 		WebcfgDebug("Root check ====> temp->name %s\n", temp->name);
 		if( strcmp("root", temp->name) != 0)
 		{
-			if(strcmp("success", temp->status) == 0)
+			if(temp->status == TMP_STATUS_SUCCESS)
 			{
 				docSuccess = 1;
 			}
@@ -2422,7 +2634,7 @@ WEBCFG_STATUS checkRootUpdate()
 		}
 		else if( strcmp("root", temp->name) != 0)
 		{
-			if(strcmp("success", temp->status) == 0)
+			if(temp->status == TMP_STATUS_SUCCESS)
 			{
 				docSuccess = 1;
 			}			
@@ -2496,39 +2708,41 @@ WEBCFG_STATUS deleteRootAndMultipartDocs()
 void failedDocsRetry()
 {
 	webconfig_tmp_data_t *temp = NULL;
-	temp = get_global_tmp_node();
+	struct timespec ct;
+	char *docname = NULL;
+	long long deadline = 0;
 
-	while (NULL != temp)
+	clock_gettime(CLOCK_REALTIME, &ct);
+	//Only docs whose retry deadline has passed are visited, earliest first.
+	while(popDueRetryDoc((long long)ct.tv_sec, &docname, &deadline))
 	{
-		if((temp->error_code == CCSP_CRASH_STATUS_CODE) || (temp->error_code == 204 && (temp->error_details != NULL && strstr(temp->error_details, "doc_unsupported") == NULL)) || (temp->error_code == 191) || (temp->error_code == 193) || (temp->error_code == 190))
+		temp = getTmpNode(docname);
+		if(temp == NULL || temp->retry_timestamp != deadline)
+		{
+			WebcfgDebug("Dropping stale retry entry for %s\n", docname);
+		}
+		else if((temp->error_code == CCSP_CRASH_STATUS_CODE) || (temp->error_code == 204 && (temp->error_details != NULL && strstr(temp->error_details, "doc_unsupported") == NULL)) || (temp->error_code == 191) || (temp->error_code == 193) || (temp->error_code == 190))
 		{
-			if(checkRetryTimer(temp->retry_timestamp))
+			WebcfgInfo("Retrying for subdoc %s error_code %lu\n", temp->name, (long)temp->error_code);
+			if(retryMultipartSubdoc(temp, temp->name) == WEBCFG_SUCCESS)
 			{
-				WebcfgInfo("Retrying for subdoc %s error_code %lu\n", temp->name, (long)temp->error_code);
-				if(retryMultipartSubdoc(temp, temp->name) == WEBCFG_SUCCESS)
-				{
-					WebcfgDebug("The subdoc %s set is success\n", temp->name);
-				}
-				else
-				{
-					WebcfgDebug("The subdoc %s set is failed\n", temp->name);
-				}
+				WebcfgDebug("The subdoc %s set is success\n", temp->name);
 			}
 			else
 			{
-				int time_diff = 0;
-
-				//To get the exact time diff for retry from present time do the below
-				time_diff = updateRetryTimeDiff(temp->retry_timestamp);
-				WebcfgDebug("The docname is %s and diff is %d retry time stamp is %s\n", temp->name, time_diff, printTime(temp->retry_timestamp));
-				set_doc_fail(1);
+				WebcfgDebug("The subdoc %s set is failed\n", temp->name);
 			}
 		}
 		else
 		{
 			WebcfgDebug("Retry skipped for %s (%s)\n",temp->name,temp->error_details);
 		}
-		temp= temp->next;
+		WEBCFG_FREE(docname);
+	}
+	if(getNextRetryDeadline() != 0)
+	{
+		WebcfgDebug("Next retry is at %s\n", printTime(getNextRetryDeadline()));
+		set_doc_fail(1);
 	}
 }
 
@@ -2587,3 +2801,114 @@ void setForceSyncTransID(char *ForceSyncTransID)
 const char* getForceSyncTransID() {
     return g_ForceSyncTransID;
 }
+
+//Called after webconfig.properties is reloaded so the next request carries the new supported docs and versions.
+void resetSupportedHeaders(void)
+{
+#if !defined (FEATURE_SUPPORT_MQTTCM)
+	pthread_mutex_lock(&supported_headers_mut);
+	supported_headers_stale = 1;
+	pthread_mutex_unlock(&supported_headers_mut);
+#endif
+}
+
+#if !defined (FEATURE_SUPPORT_MQTTCM)
+static void dropStaleSupportedHeaders(void)
+{
+	pthread_mutex_lock(&supported_headers_mut);
+	if(supported_headers_stale)
+	{
+		if(supportedVersion_header != NULL)
+		{
+			WEBCFG_FREE(supportedVersion_header);
+		}
+		if(supportedDocs_header != NULL)
+		{
+			WEBCFG_FREE(supportedDocs_header);
+		}
+		if(supplementaryDocs_header != NULL)
+		{
+			WEBCFG_FREE(supplementaryDocs_header);
+		}
+		supported_headers_stale = 0;
+		WebcfgInfo("Supported docs headers reset after properties reload\n");
+	}
+	pthread_mutex_unlock(&supported_headers_mut);
+}
+#endif
+
+//Copies the value of a header line without the name, surrounding spaces and CRLF.
+static void getHeaderValue(const char *buffer, size_t nitems, size_t name_len, char *value, size_t value_size)
+{
+	const char *start = buffer + name_len;
+	const char *end = buffer + nitems;
+	size_t len = 0;
+
+	while(start < end && (*start == ' ' || *start == '\t'))
+	{
+		start++;
+	}
+	while(end > start && (end[-1] == '\r' || end[-1] == '\n' || end[-1] == ' ' || end[-1] == '\t'))
+	{
+		end--;
+	}
+	len = (size_t)(end - start);
+	if(len >= value_size)
+	{
+		len = value_size - 1;
+	}
+	memcpy(value, start, len);
+	value[len] = '\0';
+}
+
+//Unlinks the cached params of doc_name, or of every doc when doc_name is NULL.
+static void dropMpDocParams(const char *doc_name)
+{
+	mpdoc_params_t *entry = NULL;
+	mpdoc_params_t *prev = NULL;
+	mpdoc_params_t *next = NULL;
+	mpdoc_params_t *freed = NULL;
+
+	pthread_mutex_lock (&mp_params_mut);
+	for(entry = g_mp_params_head; entry != NULL; entry = next)
+	{
+		next = entry->next;
+		if(doc_name != NULL && strcmp(entry->name_space, doc_name) != 0)
+		{
+			prev = entry;
+			continue;
+		}
+		if(prev == NULL)
+		{
+			g_mp_params_head = next;
+		}
+		else
+		{
+			prev->next = next;
+		}
+		if(--entry->refcount == 0)
+		{
+			entry->next = freed;
+			freed = entry;
+		}
+	}
+	pthread_mutex_unlock (&mp_params_mut);
+
+	while(freed != NULL)
+	{
+		entry = freed;
+		freed = freed->next;
+		freeMpDocParams(entry);
+	}
+}
+
+static void freeMpDocParams(mpdoc_params_t *params)
+{
+	if(params == NULL)
+	{
+		return;
+	}
+	webcfgparam_destroy(params->params);
+	WEBCFG_FREE(params->name_space);
+	WEBCFG_FREE(params);
+}
@@ -21,6 +21,7 @@
 #include <curl/curl.h>
 #endif
 #include "webcfg.h"
+#include "webcfg_param.h"
 #include <wdmp-c.h>
 
 #define WEBCFG_FREE(__x__) if(__x__ != NULL) { free((void*)(__x__)); __x__ = NULL;} else {printf("Trying to free null pointer\n");}
@@ -38,6 +39,8 @@
 #define FORCED_FW_UPGRADE_REBOOT_REASON  "UPGRADE"
 #endif
 
+/* The list holds one reference, readers outside the sync thread borrow a
+ * node with acquireMpDoc() so it survives a concurrent delete. */
 typedef struct multipartdocs
 {
     uint32_t  etag;
@@ -45,11 +48,25 @@ typedef struct multipartdocs
     char  *data;
     size_t data_size;
     int isSupplementarySync; 
+    int refcount;
     struct multipartdocs *next;
 } multipartdocs_t;
 
+/* Decoded params of one mp doc version, shared by retries of that doc and
+ * borrowed with acquireMpDocParams(). */
+typedef struct mpdoc_params
+{
+    char *name_space;
+    uint32_t etag;
+    webcfgparam_t *params;
+    int refcount;
+    struct mpdoc_params *next;
+} mpdoc_params_t;
+
 int readFromFile(char *filename, char **data, int *len);
 WEBCFG_STATUS parseMultipartDocument(void *config_data, char *ct , size_t data_size, char* trans_uuid);
+//Same as parseMultipartDocument for the data_size bytes at body, a slice of config_data which is freed once split.
+WEBCFG_STATUS parseMultipartBody(void *config_data, char *body, size_t data_size, char *ct, char* trans_uuid);
 WEBCFG_STATUS print_tmp_doc_list(size_t mp_count);
 void loadInitURLFromFile(char **url);
 uint32_t get_global_root();
@@ -94,9 +111,14 @@ int get_multipartdoc_count();
 WEBCFG_STATUS deleteFromMpList(char* doc_name);
 void addToMpList(uint32_t etag, char *name_space, char *data, size_t data_size);
 void delete_mp_doc();
+multipartdocs_t * acquireMpDoc(const char *doc_name);
+void releaseMpDoc(multipartdocs_t *mp_doc);
+mpdoc_params_t * acquireMpDocParams(multipartdocs_t *mp_doc, uint16_t *err);
+void releaseMpDocParams(mpdoc_params_t *params);
 #if !defined FEATURE_SUPPORT_MQTTCM
 void createCurlHeader( struct curl_slist *list, struct curl_slist **header_list, int status, char ** trans_uuid);
 #endif
+void resetSupportedHeaders(void);
 char *replaceMacWord(const char *s, const char *macW, const char *deviceMACW);
 void checkValidURL(char **s);
 #endif
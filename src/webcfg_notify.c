@@ -19,27 +19,126 @@
 #include "webcfg_generic.h"
 #include "webcfg.h"
 #include <pthread.h>
-#include <cJSON.h>
 #include <unistd.h>
+#include <time.h>
+#include <stdio.h>
+#include <sys/stat.h>
 /*----------------------------------------------------------------------------*/
 /*                                   Macros                                   */
 /*----------------------------------------------------------------------------*/
-
+#define NOTIFY_PAYLOAD_INIT_SIZE	1024
+#define NOTIFY_WRITER_MAX_DEPTH		4
+//Free notify records kept for reuse, beyond this they are released.
+#define NOTIFY_POOL_MAX			32
+//Pending records in notifyMsgQ, further messages go straight to the spill file.
+#define NOTIFY_QUEUE_MAX		256
+#define NOTIFY_SPILL_MAX_SIZE		(256 * 1024)
+#define NOTIFY_RETRY_MIN_SEC		2
+#define NOTIFY_RETRY_MAX_SEC		300
+//Coalesced force sync transactions remembered for fan out, the oldest slot is reused.
+#define NOTIFY_TRANS_ALIAS_MAX		8
 /*----------------------------------------------------------------------------*/
 /*                               Data Structures                              */
 /*----------------------------------------------------------------------------*/
+//Subdoc reports of one sync transaction, held until the batch window closes.
+typedef struct _notify_batch
+{
+	char transaction_uuid[NOTIFY_TRANS_ID_LEN];
+	notify_params_t *msgs;
+	int count;
+	struct timespec deadline;
+	struct _notify_batch *next;
+} notify_batch_t;
+
+//Transaction ids merged into the sync that ran under trans_id, they get a copy of its reports.
+typedef struct _notify_trans_alias
+{
+	char trans_id[NOTIFY_TRANS_ID_LEN];
+	char *aliases;
+} notify_trans_alias_t;
+
+//Fixed schema JSON writer over the per thread payload buffer.
+typedef struct _notify_writer
+{
+	size_t len;
+	int depth;
+	int first[NOTIFY_WRITER_MAX_DEPTH];
+} notify_writer_t;
+
+//One spilled report, pointing into the replay buffer.
+typedef struct _notify_spill_rec
+{
+	uint64_t seq;
+	size_t pos;
+	char *dest;
+	char *payload;
+} notify_spill_rec_t;
 /*----------------------------------------------------------------------------*/
 /*                            File Scoped Variables                           */
 /*----------------------------------------------------------------------------*/
 static pthread_t NotificationThreadId=0;
 pthread_mutex_t notify_mut=PTHREAD_MUTEX_INITIALIZER;
 pthread_cond_t notify_con=PTHREAD_COND_INITIALIZER;
+static pthread_once_t notify_con_once = PTHREAD_ONCE_INIT;
 notify_params_t *notifyMsgQ = NULL;
+static notify_params_t *notifyMsgQTail = NULL;
+static int notifyMsgQCount = 0;
+//Enqueue order of notify records and the redelivery kick, guarded by notify_mut.
+static uint64_t notify_next_seq = 1;
+static int notify_retry_now = 0;
+static int notify_retry_backoff = 0;
+//Spill file state, guarded by notify_spill_mut.
+pthread_mutex_t notify_spill_mut=PTHREAD_MUTEX_INITIALIZER;
+static char notify_spill_file[256] = WEBCFG_NOTIFY_SPILL_FILE;
+static long notify_spill_size = -1;
+static uint64_t notify_spill_max_seq = 0;
+static unsigned long notify_overflow = 0;
+static unsigned long notify_spilled = 0;
+static unsigned long notify_dropped = 0;
+//Redelivery backoff, accessed only from the notify thread.
+static struct timespec notify_retry_deadline;
+static int notify_retry_sec = 0;
+//Released records, guarded by notify_mut.
+static notify_params_t *notifyFreeQ = NULL;
+static int notifyFreeCount = 0;
+static unsigned int notify_batch_window_ms = 0;
+//Pending batches, accessed only from the notify thread.
+static notify_batch_t *notifyBatchQ = NULL;
+pthread_mutex_t notify_alias_mut=PTHREAD_MUTEX_INITIALIZER;
+static notify_trans_alias_t notifyTransAlias[NOTIFY_TRANS_ALIAS_MAX];
+static int notifyTransAliasNext = 0;
+//Payload buffer reused for every notification serialized on this thread.
+static __thread char *notify_payload_buf = NULL;
+static __thread size_t notify_payload_size = 0;
 /*----------------------------------------------------------------------------*/
 /*                             Function Prototypes                            */
 /*----------------------------------------------------------------------------*/
 void* processWebConfgNotification();
 void free_notify_params_struct(notify_params_t *param);
+static notify_params_t *getNotifyParamsStruct(void);
+static void copyNotifyField(char *dst, size_t size, const char *src, const char *field);
+static void writerPutRaw(notify_writer_t *w, const char *str, size_t len);
+static void writerPutString(notify_writer_t *w, const char *str);
+static void writerKey(notify_writer_t *w, const char *key);
+static void writerBegin(notify_writer_t *w, const char *key, char open);
+static void writerEnd(notify_writer_t *w, char close);
+static void writerKeyString(notify_writer_t *w, const char *key, const char *value);
+static void writerKeyNumber(notify_writer_t *w, const char *key, long value);
+static void writeNotifyParams(notify_writer_t *w, notify_params_t *msg);
+static int buildNotifyPayload(notify_writer_t *w, notify_params_t *msg, char *device_id, size_t id_len, char *dest, size_t dest_len);
+static int isNotifySpillPending(void);
+static char *parseSpillRecord(char *line, uint64_t *seq);
+static void spillNotifyPayload(uint64_t seq, const char *dest, const char *payload);
+static void scheduleNotifyRetry(int success);
+static void replayNotifySpill(void);
+static int compareSpillRecords(const void *a, const void *b);
+static void sendNotifyPayload(notify_writer_t *w, uint64_t seq, char *device_id, char *dest);
+static void addToNotifyBatch(notify_params_t *msg);
+static int getNextNotifyBatchDeadline(struct timespec *deadline);
+static void flushNotifyBatches(int flush_all);
+static char *getNotifyTransAliases(const char *trans_id);
+static void queueWebConfgNotifyMsg(char *docname, uint32_t version, char *status, char *error_details, char *transaction_uuid, uint32_t timeout, char *type, uint16_t error_code, char *root_string, long response_code);
+static void initNotifyCondition(void);
 /*----------------------------------------------------------------------------*/
 /*                             External Functions                             */
 /*----------------------------------------------------------------------------*/
@@ -62,10 +161,111 @@ pthread_mutex_t *get_global_notify_mut(void)
     return &notify_mut;
 }
 
+void set_global_notify_batch_window(unsigned int window_ms)
+{
+    notify_batch_window_ms = window_ms;
+}
+
+unsigned int get_global_notify_batch_window(void)
+{
+    return notify_batch_window_ms;
+}
+
+unsigned long get_global_notify_overflow(void)
+{
+    return notify_overflow;
+}
+
+unsigned long get_global_notify_spilled(void)
+{
+    return notify_spilled;
+}
+
+unsigned long get_global_notify_dropped(void)
+{
+    return notify_dropped;
+}
+
+void set_global_notify_spill_file(const char *path)
+{
+    pthread_mutex_lock (&notify_spill_mut);
+    snprintf(notify_spill_file, sizeof(notify_spill_file), "%s", (path != NULL) ? path : WEBCFG_NOTIFY_SPILL_FILE);
+    notify_spill_size = -1;
+    notify_spill_max_seq = 0;
+    pthread_mutex_unlock (&notify_spill_mut);
+}
+
+//Replay spilled notifications now instead of waiting for the redelivery backoff.
+void triggerNotifyRedelivery(void)
+{
+    pthread_mutex_lock (&notify_mut);
+    notify_retry_now = true;
+    pthread_cond_signal(&notify_con);
+    pthread_mutex_unlock (&notify_mut);
+}
+
+//Async transports report a failed publish after sendNotificationWithStatus returned, put the report back in the outbox.
+//It is numbered behind the queued reports and replayed after the redelivery backoff.
+void requeueNotification(const char *dest, const char *payload)
+{
+	uint64_t seq = 0;
+
+	if(dest == NULL || payload == NULL)
+	{
+		return;
+	}
+	pthread_mutex_lock (&notify_mut);
+	isNotifySpillPending();
+	seq = (notify_next_seq > notify_spill_max_seq) ? notify_next_seq : notify_spill_max_seq + 1;
+	notify_next_seq = seq + 1;
+	WebcfgError("Publish to %s failed, spill for redelivery\n", dest);
+	notify_spilled++;
+	spillNotifyPayload(seq, dest, payload);
+	//backoff state belongs to the notify thread, let it schedule the retry
+	notify_retry_backoff = true;
+	pthread_cond_signal(&notify_con);
+	pthread_mutex_unlock (&notify_mut);
+}
+
+void addNotifyTransAliases(const char *trans_id, const char *aliases)
+{
+	int i = 0;
+	int slot = -1;
+
+	if((trans_id == NULL) || (aliases == NULL) || (strlen(trans_id) == 0) || (strlen(aliases) == 0))
+	{
+		return;
+	}
+	pthread_mutex_lock (&notify_alias_mut);
+	for(i = 0; i < NOTIFY_TRANS_ALIAS_MAX; i++)
+	{
+		if(strcmp(notifyTransAlias[i].trans_id, trans_id) == 0)
+		{
+			slot = i;
+			break;
+		}
+	}
+	if(slot < 0)
+	{
+		slot = notifyTransAliasNext;
+		notifyTransAliasNext = (notifyTransAliasNext + 1) % NOTIFY_TRANS_ALIAS_MAX;
+	}
+	if(notifyTransAlias[slot].aliases != NULL)
+	{
+		WEBCFG_FREE(notifyTransAlias[slot].aliases);
+	}
+	snprintf(notifyTransAlias[slot].trans_id, sizeof(notifyTransAlias[slot].trans_id), "%s", trans_id);
+	notifyTransAlias[slot].aliases = strdup(aliases);
+	pthread_mutex_unlock (&notify_alias_mut);
+	WebcfgInfo("Notifications for %s are also sent for %s\n", trans_id, aliases);
+}
+
 //To handle webconfig notification tasks
 void initWebConfigNotifyTask()
 {
 	int err = 0;
+
+	pthread_once(&notify_con_once, initNotifyCondition);
 	err = pthread_create(&NotificationThreadId, NULL, processWebConfgNotification, NULL);
 	if (err != 0)
 	{
@@ -79,54 +279,69 @@ void initWebConfigNotifyTask()
 }
 
 void addWebConfgNotifyMsg(char *docname, uint32_t version, char *status, char *error_details, char *transaction_uuid, uint32_t timeout, char *type, uint16_t error_code, char *root_string, long response_code)
+{
+	char *aliases = NULL;
+	char *alias = NULL;
+	char *saveptr = NULL;
+
+	queueWebConfgNotifyMsg(docname, version, status, error_details, transaction_uuid, timeout, type, error_code, root_string, response_code);
+
+	//Pokes merged into this sync get the same report under their own transaction id.
+	if((transaction_uuid != NULL) && ((aliases = getNotifyTransAliases(transaction_uuid)) != NULL))
+	{
+		alias = strtok_r(aliases, ",", &saveptr);
+		while(alias != NULL)
+		{
+			queueWebConfgNotifyMsg(docname, version, status, error_details, alias, timeout, type, error_code, root_string, response_code);
+			alias = strtok_r(NULL, ",", &saveptr);
+		}
+		WEBCFG_FREE(aliases);
+	}
+}
+
+static void queueWebConfgNotifyMsg(char *docname, uint32_t version, char *status, char *error_details, char *transaction_uuid, uint32_t timeout, char *type, uint16_t error_code, char *root_string, long response_code)
 {
 	notify_params_t *args = NULL;
+	int spill = false;
 
-	args = (notify_params_t *)malloc(sizeof(notify_params_t));
-	char versionStr[32] = {'\0'};
+	args = getNotifyParamsStruct();
 
 	if(args)
 	{
-		memset(args, 0, sizeof(notify_params_t));
 		if(docname != NULL)
 		{
-			args->name = strdup(docname);
+			copyNotifyField(args->name, sizeof(args->name), docname, "name");
 		}
 
 		if(status != NULL)
 		{
-			args->application_status = strdup(status);
+			copyNotifyField(args->application_status, sizeof(args->application_status), status, "application_status");
 		}
 
 		args->timeout = timeout;
 
 		if(error_details != NULL)
 		{
-			args->error_details = strdup(error_details);
+			copyNotifyField(args->error_details, sizeof(args->error_details), error_details, "error_details");
 		}
 
 		if(version ==0 && root_string !=NULL)
 		{
-			snprintf(versionStr, sizeof(versionStr), "%s", root_string);
+			snprintf(args->version, sizeof(args->version), "%s", root_string);
 		}
 		else
 		{
-			snprintf(versionStr, sizeof(versionStr), "%lu", (long)version);
-		}
-
-		if(strlen(versionStr) > 0)
-		{
-			args->version = strdup(versionStr);
+			snprintf(args->version, sizeof(args->version), "%lu", (long)version);
 		}
 
 		if(transaction_uuid != NULL)
 		{
-			args->transaction_uuid = strdup(transaction_uuid);
+			copyNotifyField(args->transaction_uuid, sizeof(args->transaction_uuid), transaction_uuid, "transaction_uuid");
 		}
 
 		if(type != NULL)
 		{
-			args->type = strdup(type);
+			copyNotifyField(args->type, sizeof(args->type), type, "type");
 		}
 
 		args->error_code = error_code;
@@ -138,10 +353,37 @@ void addWebConfgNotifyMsg(char *docname, uint32_t version, char *status, char *e
 		args->next=NULL;
 
 		pthread_mutex_lock (&notify_mut);
+		//Records are numbered in enqueue order, replay of the spill file follows it.
+		spill = isNotifySpillPending();
+		args->seq = (notify_next_seq > notify_spill_max_seq) ? notify_next_seq : notify_spill_max_seq + 1;
+		notify_next_seq = args->seq + 1;
+		if(spill || (notifyMsgQCount >= NOTIFY_QUEUE_MAX))
+		{
+			//Outbox is full or older reports wait for redelivery, serialize on this thread and spill to file behind them.
+			notify_writer_t writer;
+			char device_id[32] = { '\0' };
+			char dest[512] = {'\0'};
+
+			if(!spill)
+			{
+				notify_overflow++;
+				WebcfgError("Notify queue full, spilling notification for %s\n", args->name);
+			}
+			memset(&writer, 0, sizeof(notify_writer_t));
+			if(buildNotifyPayload(&writer, args, device_id, sizeof(device_id), dest, sizeof(dest)) == WEBCFG_SUCCESS)
+			{
+				spillNotifyPayload(args->seq, dest, notify_payload_buf);
+			}
+			pthread_mutex_unlock (&notify_mut);
+			free_notify_params_struct(args);
+			return;
+		}
+		notifyMsgQCount++;
 		//Producer adds the notifyMsg into queue
 		if(notifyMsgQ == NULL)
 		{
 			notifyMsgQ = args;
+			notifyMsgQTail = args;
 			WebcfgDebug("Producer added notify message\n");
 			pthread_cond_signal(&notify_con);
 			pthread_mutex_unlock (&notify_mut);
@@ -149,12 +391,8 @@ void addWebConfgNotifyMsg(char *docname, uint32_t version, char *status, char *e
 		}
 		else
 		{
-			notify_params_t *temp = notifyMsgQ;
-			while(temp->next)
-			{
-			    temp = temp->next;
-			}
-			temp->next = args;
+			notifyMsgQTail->next = args;
+			notifyMsgQTail = args;
 			pthread_mutex_unlock (&notify_mut);
 		}
 	}
@@ -168,91 +406,50 @@ void addWebConfgNotifyMsg(char *docname, uint32_t version, char *status, char *e
 void* processWebConfgNotification()
 {
 	char device_id[32] = { '\0' };
-	cJSON *notifyPayload = NULL;
-	char  * stringifiedNotifyPayload = NULL;
+	notify_writer_t writer;
 	char dest[512] = {'\0'};
-	char *source = NULL;
+	struct timespec deadline, now;
+	int wait_deadline = 0;
+	int retry_now = false;
+	int retry_backoff = false;
+
+	pthread_once(&notify_con_once, initNotifyCondition);
+	//Undelivered notifications from a previous run are replayed right away.
+	if(isNotifySpillPending() && (notify_retry_sec == 0))
+	{
+		clock_gettime(CLOCK_MONOTONIC, &notify_retry_deadline);
+	}
 
 	while(1)
 	{
+		flushNotifyBatches(false);
 		pthread_mutex_lock (&notify_mut);
 		WebcfgDebug("mutex lock in notify consumer thread\n");
 		if(notifyMsgQ != NULL)
 		{
 			notify_params_t *msg = notifyMsgQ;
 			notifyMsgQ = notifyMsgQ->next;
+			notifyMsgQCount--;
 			pthread_mutex_unlock (&notify_mut);
 			WebcfgDebug("mutex unlock in notify consumer thread\n");
 
 			if((get_deviceMAC() !=NULL) && (strlen(get_deviceMAC()) == 0))
 			{
 				WebcfgError("deviceMAC is NULL, failed to send Webconfig Notification\n");
+				free_notify_params_struct(msg);
+			}
+			else if((notify_batch_window_ms > 0) && (msg->response_code == 200) && (msg->name[0] != '\0') && (msg->transaction_uuid[0] != '\0'))
+			{
+				//subdoc reports are aggregated per transaction_uuid, msg is owned by the batch
+				addToNotifyBatch(msg);
+				msg = NULL;
 			}
 			else
 			{
-				snprintf(device_id, sizeof(device_id), "mac:%s", get_deviceMAC());
-				WebcfgDebug("webconfig Device_id %s\n", device_id);
-
-				notifyPayload = cJSON_CreateObject();
-
-				if(notifyPayload != NULL)
-				{
-					cJSON_AddStringToObject(notifyPayload,"device_id", device_id);
-
-					if(msg)
-					{
-						if(msg->name !=NULL)
-						{
-							cJSON_AddStringToObject(notifyPayload,"namespace", (NULL != msg->name && (strlen(msg->name)!=0)) ? msg->name : "unknown");
-						}
-						if(msg->application_status !=NULL)
-						{
-							cJSON_AddStringToObject(notifyPayload,"application_status", msg->application_status);
-						}
-						WebcfgDebug("msg->timeout is %lu\n", (long)msg->timeout);
-						if(msg->timeout !=0)
-						{
-							cJSON_AddNumberToObject(notifyPayload,"timeout", msg->timeout);
-						}
-						WebcfgDebug("msg->error_code is %lu\n", (long)msg->error_code);
-						if(msg->error_code !=0)
-						{
-							cJSON_AddNumberToObject(notifyPayload,"error_code", msg->error_code);
-						}
-						if((msg->error_details !=NULL) && (strcmp(msg->error_details, "none")!=0))
-						{
-							cJSON_AddStringToObject(notifyPayload,"error_details", (NULL != msg->error_details) ? msg->error_details : "unknown");
-						}
-						if( msg->response_code != 200 )
-						{
-							cJSON_AddNumberToObject(notifyPayload,"http_status_code", msg->response_code);
-						}
-						cJSON_AddStringToObject(notifyPayload,"transaction_uuid", (NULL != msg->transaction_uuid && (strlen(msg->transaction_uuid)!=0)) ? msg->transaction_uuid : "unknown");
-						cJSON_AddStringToObject(notifyPayload,"version", (NULL != msg->version && (strlen(msg->version)!=0)) ? msg->version : "0");
-					
-					}
-					stringifiedNotifyPayload = cJSON_PrintUnformatted(notifyPayload);
-					cJSON_Delete(notifyPayload);
-				}
-
-				if(msg->response_code == 200)
-				{
-					snprintf(dest,sizeof(dest),"event:subdoc-report/%s/%s/%s",msg->name,device_id,msg->type);
-				}
-				else
+				memset(&writer, 0, sizeof(notify_writer_t));
+				if (buildNotifyPayload(&writer, msg, device_id, sizeof(device_id), dest, sizeof(dest)) == WEBCFG_SUCCESS)
 				{
-					snprintf(dest,sizeof(dest),"event:rootdoc-report/%s/%s",device_id,msg->type);
-				}
-				WebcfgInfo("dest is %s\n", dest);
-
-				if (stringifiedNotifyPayload != NULL && strlen(device_id) != 0)
-				{
-					source = (char*) malloc(sizeof(char) * sizeof(device_id));
-					strncpy(source, device_id, sizeof(device_id));
-					WebcfgDebug("source is %s\n", source);
-					WebcfgInfo("stringifiedNotifyPayload is %s\n", stringifiedNotifyPayload);
-					//stringifiedNotifyPayload, source to be freed by sendNotification
-					sendNotification(stringifiedNotifyPayload, source, dest);
+					sendNotifyPayload(&writer, msg->seq, device_id, dest);
 				}
 					free_notify_params_struct(msg);
 					msg = NULL;
@@ -260,14 +457,55 @@ void* processWebConfgNotification()
 		}
 		else
 		{
+			retry_now = notify_retry_now;
+			notify_retry_now = false;
+			retry_backoff = notify_retry_backoff;
+			notify_retry_backoff = false;
+			pthread_mutex_unlock (&notify_mut);
+			if(retry_backoff && !retry_now)
+			{
+				scheduleNotifyRetry(false);
+			}
+			//Queued reports went to the spill file behind older ones above, replay it once the queue is drained.
+			if(isNotifySpillPending())
+			{
+				clock_gettime(CLOCK_MONOTONIC, &now);
+				if(retry_now || (now.tv_sec > notify_retry_deadline.tv_sec) || ((now.tv_sec == notify_retry_deadline.tv_sec) && (now.tv_nsec >= notify_retry_deadline.tv_nsec)))
+				{
+					flushNotifyBatches(true);
+					replayNotifySpill();
+					continue;
+				}
+			}
+			pthread_mutex_lock (&notify_mut);
+			if((notifyMsgQ != NULL) || notify_retry_now || notify_retry_backoff)
+			{
+				pthread_mutex_unlock (&notify_mut);
+				continue;
+			}
 			if (get_global_shutdown())
 			{
 				WebcfgDebug("g_shutdown in notify consumer thread\n");
 				pthread_mutex_unlock (&notify_mut);
+				flushNotifyBatches(true);
 				break;
 			}
-			WebcfgDebug("Before pthread cond wait in notify thread\n");
-			pthread_cond_wait(&notify_con, &notify_mut);
+			wait_deadline = getNextNotifyBatchDeadline(&deadline);
+			if(isNotifySpillPending() && (!wait_deadline || (notify_retry_deadline.tv_sec < deadline.tv_sec) || ((notify_retry_deadline.tv_sec == deadline.tv_sec) && (notify_retry_deadline.tv_nsec < deadline.tv_nsec))))
+			{
+				deadline = notify_retry_deadline;
+				wait_deadline = true;
+			}
+			if(wait_deadline)
+			{
+				WebcfgDebug("Before pthread cond timedwait for notify batch window or redelivery\n");
+				pthread_cond_timedwait(&notify_con, &notify_mut, &deadline);
+			}
+			else
+			{
+				WebcfgDebug("Before pthread cond wait in notify thread\n");
+				pthread_cond_wait(&notify_con, &notify_mut);
+			}
 			pthread_mutex_unlock (&notify_mut);
 			WebcfgDebug("mutex unlock in notify thread after cond wait\n");
 		}
@@ -275,34 +513,39 @@ void* processWebConfgNotification()
 	return NULL;
 }
 
+//Bounded copy into a record field, a longer value is cut on a UTF-8 code point boundary so the payload stays valid.
+static void copyNotifyField(char *dst, size_t size, const char *src, const char *field)
+{
+	size_t len = strlen(src);
+
+	if(len >= size)
+	{
+		len = size - 1;
+		//back off continuation bytes so a multi byte sequence is dropped whole
+		while(len > 0 && (((unsigned char)src[len]) & 0xC0) == 0x80)
+		{
+			len--;
+		}
+		WebcfgError("Notify %s truncated from %zu to %zu bytes\n", field, strlen(src), len);
+	}
+	memcpy(dst, src, len);
+	dst[len] = '\0';
+}
+
+//Return record to the free pool for reuse by addWebConfgNotifyMsg.
 void free_notify_params_struct(notify_params_t *param)
 {
     if(param != NULL)
     {
-        if(param->name != NULL)
-        {
-            WEBCFG_FREE(param->name);
-        }
-        if(param->application_status != NULL)
-        {
-            WEBCFG_FREE(param->application_status);
-        }
-	if(param->error_details != NULL)
+        pthread_mutex_lock (&notify_mut);
+        if(notifyFreeCount < NOTIFY_POOL_MAX)
         {
-            WEBCFG_FREE(param->error_details);
-        }
-        if(param->version != NULL)
-        {
-            WEBCFG_FREE(param->version);
-        }
-	if(param->transaction_uuid != NULL)
-        {
-	    WEBCFG_FREE(param->transaction_uuid);
-        }
-	if(param->type != NULL)
-        {
-            WEBCFG_FREE(param->type);
+            param->next = notifyFreeQ;
+            notifyFreeQ = param;
+            notifyFreeCount++;
+            param = NULL;
         }
+        pthread_mutex_unlock (&notify_mut);
         WEBCFG_FREE(param);
     }
 }
@@ -394,3 +637,745 @@ uint16_t getStatusErrorCodeAndMessage(WEBCFG_ERROR_CODE status, char** result)
 
 	return ret;
 }
+
+/*----------------------------------------------------------------------------*/
+/*                             Internal functions                             */
+/*----------------------------------------------------------------------------*/
+
+//Take a cleared record from the free pool, allocate only when the pool is empty.
+static notify_params_t *getNotifyParamsStruct(void)
+{
+	notify_params_t *param = NULL;
+
+	pthread_mutex_lock (&notify_mut);
+	if(notifyFreeQ != NULL)
+	{
+		param = notifyFreeQ;
+		notifyFreeQ = notifyFreeQ->next;
+		notifyFreeCount--;
+	}
+	pthread_mutex_unlock (&notify_mut);
+
+	if(param == NULL)
+	{
+		param = (notify_params_t *)malloc(sizeof(notify_params_t));
+	}
+	if(param != NULL)
+	{
+		memset(param, 0, sizeof(notify_params_t));
+	}
+	return param;
+}
+
+//Append len bytes, growing the thread buffer only when the payload outgrows it.
+static void writerPutRaw(notify_writer_t *w, const char *str, size_t len)
+{
+	char *buf = NULL;
+	size_t size = 0;
+
+	if(w->len + len + 1 > notify_payload_size)
+	{
+		size = (notify_payload_size != 0) ? notify_payload_size : NOTIFY_PAYLOAD_INIT_SIZE;
+		while(w->len + len + 1 > size)
+		{
+			size *= 2;
+		}
+		buf = (char *)realloc(notify_payload_buf, size);
+		if(buf == NULL)
+		{
+			WebcfgError("failure in allocation for notify payload\n");
+			return;
+		}
+		notify_payload_buf = buf;
+		notify_payload_size = size;
+	}
+	memcpy(notify_payload_buf + w->len, str, len);
+	w->len += len;
+	notify_payload_buf[w->len] = '\0';
+}
+
+//Write str as a quoted JSON string, escaping quote, backslash and control characters.
+static void writerPutString(notify_writer_t *w, const char *str)
+{
+	const char *start = str;
+	char esc[8] = {'\0'};
+
+	writerPutRaw(w, "\"", 1);
+	for(; *str != '\0'; str++)
+	{
+		unsigned char c = (unsigned char)*str;
+		if(c >= 0x20 && c != '"' && c != '\\')
+		{
+			continue;
+		}
+		writerPutRaw(w, start, str - start);
+		switch(c)
+		{
+			case '"': writerPutRaw(w, "\\\"", 2); break;
+			case '\\': writerPutRaw(w, "\\\\", 2); break;
+			case '\b': writerPutRaw(w, "\\b", 2); break;
+			case '\f': writerPutRaw(w, "\\f", 2); break;
+			case '\n': writerPutRaw(w, "\\n", 2); break;
+			case '\r': writerPutRaw(w, "\\r", 2); break;
+			case '\t': writerPutRaw(w, "\\t", 2); break;
+			default:
+				snprintf(esc, sizeof(esc), "\\u%04x", c);
+				writerPutRaw(w, esc, 6);
+				break;
+		}
+		start = str + 1;
+	}
+	writerPutRaw(w, start, str - start);
+	writerPutRaw(w, "\"", 1);
+}
+
+//Separator and optional "key": prefix for the next member.
+static void writerKey(notify_writer_t *w, const char *key)
+{
+	if(w->depth > 0)
+	{
+		if(!w->first[w->depth - 1])
+		{
+			writerPutRaw(w, ",", 1);
+		}
+		w->first[w->depth - 1] = false;
+	}
+	if(key != NULL)
+	{
+		writerPutString(w, key);
+		writerPutRaw(w, ":", 1);
+	}
+}
+
+static void writerBegin(notify_writer_t *w, const char *key, char open)
+{
+	writerKey(w, key);
+	writerPutRaw(w, &open, 1);
+	if(w->depth < NOTIFY_WRITER_MAX_DEPTH)
+	{
+		w->first[w->depth] = true;
+		w->depth++;
+	}
+}
+
+static void writerEnd(notify_writer_t *w, char close)
+{
+	writerPutRaw(w, &close, 1);
+	if(w->depth > 0)
+	{
+		w->depth--;
+	}
+}
+
+static void writerKeyString(notify_writer_t *w, const char *key, const char *value)
+{
+	writerKey(w, key);
+	writerPutString(w, value);
+}
+
+static void writerKeyNumber(notify_writer_t *w, const char *key, long value)
+{
+	char num[24] = {'\0'};
+	int len = 0;
+
+	writerKey(w, key);
+	len = snprintf(num, sizeof(num), "%ld", value);
+	writerPutRaw(w, num, len);
+}
+
+//Writes the subdoc result fields shared by single and batched reports.
+static void writeNotifyParams(notify_writer_t *w, notify_params_t *msg)
+{
+	if(msg->name[0] != '\0')
+	{
+		writerKeyString(w, "namespace", msg->name);
+	}
+	if(msg->application_status[0] != '\0')
+	{
+		writerKeyString(w, "application_status", msg->application_status);
+	}
+	WebcfgDebug("msg->timeout is %lu\n", (long)msg->timeout);
+	if(msg->timeout !=0)
+	{
+		writerKeyNumber(w, "timeout", msg->timeout);
+	}
+	WebcfgDebug("msg->error_code is %lu\n", (long)msg->error_code);
+	if(msg->error_code !=0)
+	{
+		writerKeyNumber(w, "error_code", msg->error_code);
+	}
+	if((msg->error_details[0] != '\0') && (strcmp(msg->error_details, "none")!=0))
+	{
+		writerKeyString(w, "error_details", msg->error_details);
+	}
+}
+
+//Serialize a single notify record and its destination. Fails when device MAC is not known.
+static int buildNotifyPayload(notify_writer_t *w, notify_params_t *msg, char *device_id, size_t id_len, char *dest, size_t dest_len)
+{
+	if((get_deviceMAC() == NULL) || (strlen(get_deviceMAC()) == 0))
+	{
+		WebcfgError("deviceMAC is NULL, failed to send Webconfig Notification\n");
+		return WEBCFG_FAILURE;
+	}
+	snprintf(device_id, id_len, "mac:%s", get_deviceMAC());
+	WebcfgDebug("webconfig Device_id %s\n", device_id);
+
+	writerBegin(w, NULL, '{');
+	writerKeyString(w, "device_id", device_id);
+	writeNotifyParams(w, msg);
+	if( msg->response_code != 200 )
+	{
+		writerKeyNumber(w, "http_status_code", msg->response_code);
+	}
+	writerKeyString(w, "transaction_uuid", (strlen(msg->transaction_uuid)!=0) ? msg->transaction_uuid : "unknown");
+	writerKeyString(w, "version", (strlen(msg->version)!=0) ? msg->version : "0");
+	writerEnd(w, '}');
+
+	if(msg->response_code == 200)
+	{
+		snprintf(dest,dest_len,"event:subdoc-report/%s/%s/%s",msg->name,device_id,msg->type);
+	}
+	else
+	{
+		snprintf(dest,dest_len,"event:rootdoc-report/%s/%s",device_id,msg->type);
+	}
+	WebcfgInfo("dest is %s\n", dest);
+	return WEBCFG_SUCCESS;
+}
+
+//sendNotificationWithStatus implementations take ownership of payload and source, so hand over exact size copies.
+//Undelivered payloads, and new ones while older reports wait for redelivery, go to the spill file under their seq.
+static void sendNotifyPayload(notify_writer_t *w, uint64_t seq, char *device_id, char *dest)
+{
+	char *payload = NULL;
+	char *source = NULL;
+
+	if(notify_payload_buf == NULL || w->len == 0)
+	{
+		WebcfgError("notify payload is empty, skip sending\n");
+		return;
+	}
+	if(isNotifySpillPending())
+	{
+		WebcfgInfo("Notify redelivery pending, queue %s behind spilled reports\n", dest);
+		spillNotifyPayload(seq, dest, notify_payload_buf);
+		return;
+	}
+	payload = (char *)malloc(w->len + 1);
+	source = strdup(device_id);
+	if(payload == NULL || source == NULL)
+	{
+		WebcfgError("failure in allocation for notify payload\n");
+		WEBCFG_FREE(payload);
+		WEBCFG_FREE(source);
+		return;
+	}
+	memcpy(payload, notify_payload_buf, w->len + 1);
+	WebcfgDebug("source is %s\n", source);
+	WebcfgInfo("stringifiedNotifyPayload is %s\n", payload);
+	//stringifiedNotifyPayload, source to be freed by sendNotificationWithStatus
+	if(!sendNotificationWithStatus(payload, source, dest))
+	{
+		WebcfgError("Failed to send notification to %s, spill for redelivery\n", dest);
+		notify_spilled++;
+		spillNotifyPayload(seq, dest, notify_payload_buf);
+		scheduleNotifyRetry(false);
+	}
+}
+
+//True when undelivered notifications are waiting in the spill file.
+static int isNotifySpillPending(void)
+{
+	FILE *fp = NULL;
+	char *line = NULL;
+	size_t line_size = 0;
+	uint64_t seq = 0;
+	int pending = false;
+
+	pthread_mutex_lock (&notify_spill_mut);
+	if(notify_spill_size < 0)
+	{
+		//first use, pick up reports left over from a previous run and number new ones after them
+		notify_spill_size = 0;
+		fp = fopen(notify_spill_file, "r");
+		if(fp != NULL)
+		{
+			while(getline(&line, &line_size, fp) != -1)
+			{
+				parseSpillRecord(line, &seq);
+				if(seq > notify_spill_max_seq)
+				{
+					notify_spill_max_seq = seq;
+				}
+			}
+			notify_spill_size = ftell(fp);
+			fclose(fp);
+			if(line != NULL)
+			{
+				WEBCFG_FREE(line);
+			}
+		}
+	}
+	pending = (notify_spill_size > 0);
+	pthread_mutex_unlock (&notify_spill_mut);
+	return pending;
+}
+
+//Split "<seq>\t<dest>\t<payload>" in place, returns the payload or NULL when malformed.
+//Records without a seq are from older builds and replay first.
+static char *parseSpillRecord(char *line, uint64_t *seq)
+{
+	char *end = NULL;
+	char *tab = NULL;
+
+	*seq = 0;
+	if(line[0] >= '0' && line[0] <= '9')
+	{
+		*seq = strtoull(line, &end, 10);
+		if(*end == '\t')
+		{
+			memmove(line, end + 1, strlen(end + 1) + 1);
+		}
+		else
+		{
+			*seq = 0;
+		}
+	}
+	tab = strchr(line, '\t');
+	if(tab == NULL)
+	{
+		return NULL;
+	}
+	*tab = '\0';
+	return tab + 1;
+}
+
+//Append one "<seq>\t<dest>\t<payload>" line to the spill file. Payload has no raw newlines as the writer escapes them.
+static void spillNotifyPayload(uint64_t seq, const char *dest, const char *payload)
+{
+	FILE *fp = NULL;
+	int len = 0;
+
+	isNotifySpillPending();
+	pthread_mutex_lock (&notify_spill_mut);
+	len = snprintf(NULL, 0, "%llu\t%s\t%s\n", (unsigned long long)seq, dest, payload);
+	if(notify_spill_size + len > NOTIFY_SPILL_MAX_SIZE)
+	{
+		notify_dropped++;
+		pthread_mutex_unlock (&notify_spill_mut);
+		WebcfgError("Notify spill file full, dropping notification to %s\n", dest);
+		return;
+	}
+	fp = fopen(notify_spill_file, "a");
+	if(fp == NULL)
+	{
+		notify_dropped++;
+		pthread_mutex_unlock (&notify_spill_mut);
+		WebcfgError("Failed to open %s, dropping notification to %s\n", notify_spill_file, dest);
+		return;
+	}
+	fprintf(fp, "%llu\t%s\t%s\n", (unsigned long long)seq, dest, payload);
+	fclose(fp);
+	notify_spill_size += len;
+	pthread_mutex_unlock (&notify_spill_mut);
+}
+
+//Batch window and redelivery deadlines are on CLOCK_MONOTONIC so wall clock changes do not shift them.
+static void initNotifyCondition(void)
+{
+	pthread_condattr_t attr;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&notify_con, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+//Exponential redelivery backoff, reset once a replay succeeds.
+static void scheduleNotifyRetry(int success)
+{
+	if(success)
+	{
+		notify_retry_sec = 0;
+		return;
+	}
+	if(notify_retry_sec == 0)
+	{
+		notify_retry_sec = NOTIFY_RETRY_MIN_SEC;
+	}
+	else if(notify_retry_sec < NOTIFY_RETRY_MAX_SEC)
+	{
+		notify_retry_sec = (notify_retry_sec * 2 > NOTIFY_RETRY_MAX_SEC) ? NOTIFY_RETRY_MAX_SEC : notify_retry_sec * 2;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &notify_retry_deadline);
+	notify_retry_deadline.tv_sec += notify_retry_sec;
+	WebcfgInfo("Notify redelivery scheduled in %d sec\n", notify_retry_sec);
+}
+
+//Resend spilled notifications in enqueue order, stop at the first failure and keep the rest for the next attempt.
+//Sending happens outside notify_spill_mut, reports spilled meanwhile are kept behind the unsent ones.
+static void replayNotifySpill(void)
+{
+	FILE *fp = NULL, *rest = NULL;
+	char *buf = NULL, *line = NULL, *payload = NULL;
+	char tmp_file[sizeof(notify_spill_file) + 8] = {'\0'};
+	char device_id[32] = { '\0' };
+	char copy[4096];
+	notify_spill_rec_t *recs = NULL;
+	long snapshot = 0, rest_size = 0;
+	size_t count = 0, i = 0, n = 0;
+	int failed = false, sent = 0;
+	uint64_t seq = 0;
+
+	if((get_deviceMAC() == NULL) || (strlen(get_deviceMAC()) == 0))
+	{
+		scheduleNotifyRetry(false);
+		return;
+	}
+	snprintf(device_id, sizeof(device_id), "mac:%s", get_deviceMAC());
+
+	pthread_mutex_lock (&notify_spill_mut);
+	snprintf(tmp_file, sizeof(tmp_file), "%s.tmp", notify_spill_file);
+	fp = fopen(notify_spill_file, "r");
+	if(fp == NULL)
+	{
+		notify_spill_size = 0;
+		pthread_mutex_unlock (&notify_spill_mut);
+		return;
+	}
+	fseek(fp, 0, SEEK_END);
+	snapshot = ftell(fp);
+	rewind(fp);
+	buf = (snapshot > 0) ? (char *)malloc(snapshot + 1) : NULL;
+	if(buf != NULL)
+	{
+		snapshot = fread(buf, 1, snapshot, fp);
+		buf[snapshot] = '\0';
+	}
+	fclose(fp);
+	pthread_mutex_unlock (&notify_spill_mut);
+	if(buf == NULL)
+	{
+		scheduleNotifyRetry(false);
+		return;
+	}
+
+	for(i = 0; i < (size_t)snapshot; i++)
+	{
+		if(buf[i] == '\n')
+		{
+			count++;
+		}
+	}
+	recs = (notify_spill_rec_t *)calloc(count + 1, sizeof(notify_spill_rec_t));
+	if(recs == NULL)
+	{
+		WEBCFG_FREE(buf);
+		scheduleNotifyRetry(false);
+		return;
+	}
+	//Only complete lines are part of this replay, the rest of the file is kept as is.
+	for(line = buf, i = 0; (i < count) && ((payload = strchr(line, '\n')) != NULL); line = payload + 1)
+	{
+		*payload = '\0';
+		recs[i].payload = parseSpillRecord(line, &seq);
+		if(recs[i].payload == NULL)
+		{
+			WebcfgError("Skip malformed notify spill record\n");
+			continue;
+		}
+		recs[i].seq = seq;
+		recs[i].pos = i;
+		recs[i].dest = line;
+		i++;
+	}
+	snapshot = line - buf;
+	n = i;
+	qsort(recs, n, sizeof(notify_spill_rec_t), compareSpillRecords);
+
+	for(i = 0; i < n; i++)
+	{
+		payload = strdup(recs[i].payload);
+		if(payload != NULL && sendNotificationWithStatus(payload, strdup(device_id), recs[i].dest))
+		{
+			sent++;
+			continue;
+		}
+		failed = true;
+		break;
+	}
+
+	pthread_mutex_lock (&notify_spill_mut);
+	rest = fopen(tmp_file, "w");
+	if(rest == NULL)
+	{
+		//the file is left as is, delivered reports are sent again on the next replay
+		pthread_mutex_unlock (&notify_spill_mut);
+		WebcfgError("Failed to open %s, notify spill file not trimmed\n", tmp_file);
+		WEBCFG_FREE(recs);
+		WEBCFG_FREE(buf);
+		scheduleNotifyRetry(false);
+		return;
+	}
+	for(; i < n; i++)
+	{
+		fprintf(rest, "%llu\t%s\t%s\n", (unsigned long long)recs[i].seq, recs[i].dest, recs[i].payload);
+	}
+	fp = fopen(notify_spill_file, "r");
+	if(fp != NULL)
+	{
+		fseek(fp, snapshot, SEEK_SET);
+		while((count = fread(copy, 1, sizeof(copy), fp)) > 0)
+		{
+			fwrite(copy, 1, count, rest);
+		}
+		fclose(fp);
+	}
+	rest_size = ftell(rest);
+	fclose(rest);
+	if(rest_size > 0)
+	{
+		rename(tmp_file, notify_spill_file);
+	}
+	else
+	{
+		remove(tmp_file);
+		remove(notify_spill_file);
+	}
+	notify_spill_size = rest_size;
+	pthread_mutex_unlock (&notify_spill_mut);
+	WEBCFG_FREE(recs);
+	WEBCFG_FREE(buf);
+	WebcfgInfo("Replayed %d spilled notifications, %ld bytes pending\n", sent, rest_size);
+	scheduleNotifyRetry(!failed);
+}
+
+//Spilled reports replay by enqueue seq, ties keep file order.
+static int compareSpillRecords(const void *a, const void *b)
+{
+	const notify_spill_rec_t *ra = (const notify_spill_rec_t *)a;
+	const notify_spill_rec_t *rb = (const notify_spill_rec_t *)b;
+
+	if(ra->seq != rb->seq)
+	{
+		return (ra->seq < rb->seq) ? -1 : 1;
+	}
+	return (ra->pos < rb->pos) ? -1 : ((ra->pos > rb->pos) ? 1 : 0);
+}
+
+//Add subdoc report to the batch of its transaction. A newer report for the same doc replaces the older one.
+static void addToNotifyBatch(notify_params_t *msg)
+{
+	notify_batch_t *batch = notifyBatchQ, *last = NULL;
+	notify_params_t *temp = NULL, *prev = NULL;
+
+	while(batch != NULL)
+	{
+		if(strcmp(batch->transaction_uuid, msg->transaction_uuid) == 0)
+		{
+			break;
+		}
+		last = batch;
+		batch = batch->next;
+	}
+
+	if(batch == NULL)
+	{
+		batch = (notify_batch_t *)malloc(sizeof(notify_batch_t));
+		if(batch == NULL)
+		{
+			WebcfgError("failure in allocation for notify batch\n");
+			free_notify_params_struct(msg);
+			return;
+		}
+		memset(batch, 0, sizeof(notify_batch_t));
+		snprintf(batch->transaction_uuid, sizeof(batch->transaction_uuid), "%s", msg->transaction_uuid);
+		clock_gettime(CLOCK_MONOTONIC, &batch->deadline);
+		batch->deadline.tv_sec += notify_batch_window_ms / 1000;
+		batch->deadline.tv_nsec += (notify_batch_window_ms % 1000) * 1000000L;
+		if(batch->deadline.tv_nsec >= 1000000000L)
+		{
+			batch->deadline.tv_sec += 1;
+			batch->deadline.tv_nsec -= 1000000000L;
+		}
+		if(last == NULL)
+		{
+			notifyBatchQ = batch;
+		}
+		else
+		{
+			last->next = batch;
+		}
+		WebcfgDebug("New notify batch for transaction_uuid %s\n", batch->transaction_uuid);
+	}
+
+	temp = batch->msgs;
+	while(temp != NULL)
+	{
+		if(strcmp(temp->name, msg->name) == 0)
+		{
+			WebcfgDebug("Notify for %s status %s superseded by %s\n", temp->name, temp->application_status, msg->application_status);
+			msg->next = temp->next;
+			if(prev == NULL)
+			{
+				batch->msgs = msg;
+			}
+			else
+			{
+				prev->next = msg;
+			}
+			free_notify_params_struct(temp);
+			return;
+		}
+		prev = temp;
+		temp = temp->next;
+	}
+	msg->next = NULL;
+	if(prev == NULL)
+	{
+		batch->msgs = msg;
+	}
+	else
+	{
+		prev->next = msg;
+	}
+	batch->count++;
+}
+
+//Earliest batch window deadline, false when no batch is pending.
+static int getNextNotifyBatchDeadline(struct timespec *deadline)
+{
+	notify_batch_t *batch = notifyBatchQ;
+	int found = false;
+
+	while(batch != NULL)
+	{
+		if(!found || (batch->deadline.tv_sec < deadline->tv_sec) || ((batch->deadline.tv_sec == deadline->tv_sec) && (batch->deadline.tv_nsec < deadline->tv_nsec)))
+		{
+			*deadline = batch->deadline;
+			found = true;
+		}
+		batch = batch->next;
+	}
+	return found;
+}
+
+//Send batches whose window has closed, or all batches when flush_all is set.
+static void flushNotifyBatches(int flush_all)
+{
+	notify_batch_t *batch = notifyBatchQ, *prev = NULL, *next = NULL;
+	notify_params_t *msg = NULL;
+	struct timespec now;
+	char device_id[32] = { '\0' };
+	char dest[512] = {'\0'};
+	notify_writer_t writer;
+	uint64_t seq = 0;
+
+	if(batch == NULL)
+	{
+		return;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	//device_id stays empty without a MAC, due batches are dropped like single reports.
+	if((get_deviceMAC() != NULL) && (strlen(get_deviceMAC()) != 0))
+	{
+		snprintf(device_id, sizeof(device_id), "mac:%s", get_deviceMAC());
+	}
+
+	while(batch != NULL)
+	{
+		next = batch->next;
+		if(!flush_all && ((batch->deadline.tv_sec > now.tv_sec) || ((batch->deadline.tv_sec == now.tv_sec) && (batch->deadline.tv_nsec > now.tv_nsec))))
+		{
+			prev = batch;
+			batch = next;
+			continue;
+		}
+
+		if(prev == NULL)
+		{
+			notifyBatchQ = next;
+		}
+		else
+		{
+			prev->next = next;
+		}
+
+		if(device_id[0] == '\0')
+		{
+			WebcfgError("deviceMAC is NULL, failed to send Webconfig Notification batch of %d docs\n", batch->count);
+		}
+		else
+		{
+			memset(&writer, 0, sizeof(notify_writer_t));
+			writerBegin(&writer, NULL, '{');
+			writerKeyString(&writer, "device_id", device_id);
+			if(batch->count == 1)
+			{
+				//single doc in window, keep the per subdoc report format
+				msg = batch->msgs;
+				writeNotifyParams(&writer, msg);
+				writerKeyString(&writer, "transaction_uuid", batch->transaction_uuid);
+				writerKeyString(&writer, "version", (strlen(msg->version)!=0) ? msg->version : "0");
+				snprintf(dest,sizeof(dest),"event:subdoc-report/%s/%s/%s",msg->name,device_id,msg->type);
+			}
+			else
+			{
+				writerKeyString(&writer, "transaction_uuid", batch->transaction_uuid);
+				writerBegin(&writer, "subdocs", '[');
+				for(msg = batch->msgs; msg != NULL; msg = msg->next)
+				{
+					writerBegin(&writer, NULL, '{');
+					writeNotifyParams(&writer, msg);
+					writerKeyString(&writer, "version", (strlen(msg->version)!=0) ? msg->version : "0");
+					writerKeyString(&writer, "type", (strlen(msg->type)!=0) ? msg->type : "status");
+					writerEnd(&writer, '}');
+				}
+				writerEnd(&writer, ']');
+				snprintf(dest,sizeof(dest),"event:subdoc-report/batch/%s",device_id);
+			}
+			writerEnd(&writer, '}');
+			WebcfgInfo("Sending notify batch of %d docs for transaction_uuid %s, dest is %s\n", batch->count, batch->transaction_uuid, dest);
+			//A batch replays at the position of its oldest report.
+			seq = batch->msgs->seq;
+			for(msg = batch->msgs; msg != NULL; msg = msg->next)
+			{
+				seq = (msg->seq < seq) ? msg->seq : seq;
+			}
+			sendNotifyPayload(&writer, seq, device_id, dest);
+		}
+
+		while(batch->msgs != NULL)
+		{
+			msg = batch->msgs;
+			batch->msgs = msg->next;
+			free_notify_params_struct(msg);
+		}
+		WEBCFG_FREE(batch);
+		batch = next;
+	}
+}
+
+//Returns a copy of the ids merged into trans_id, NULL when there are none.
+static char *getNotifyTransAliases(const char *trans_id)
+{
+	int i = 0;
+	char *aliases = NULL;
+
+	if(strlen(trans_id) == 0)
+	{
+		return NULL;
+	}
+	pthread_mutex_lock (&notify_alias_mut);
+	for(i = 0; i < NOTIFY_TRANS_ALIAS_MAX; i++)
+	{
+		if((notifyTransAlias[i].aliases != NULL) && (strcmp(notifyTransAlias[i].trans_id, trans_id) == 0))
+		{
+			aliases = strdup(notifyTransAlias[i].aliases);
+			break;
+		}
+	}
+	pthread_mutex_unlock (&notify_alias_mut);
+	return aliases;
+}
@@ -22,17 +22,42 @@
 #include "webcfg.h"
 #include "webcfg_db.h"
 
+//Undelivered notifications are kept here and replayed once upstream is reachable.
+#if defined(DEVICE_CAMERA)
+#define WEBCFG_NOTIFY_SPILL_FILE    "/opt/webconfig_notify_spill.txt"
+#elif defined(BUILD_YOCTO) && ! defined(DEVICE_EXTENDER)
+#if defined(RDK_PERSISTENT_PATH_VIDEO)
+#define WEBCFG_NOTIFY_SPILL_FILE    "/opt/webconfig_notify_spill.txt"
+#else
+#define WEBCFG_NOTIFY_SPILL_FILE    "/nvram/webconfig_notify_spill.txt"
+#endif
+#elif defined(DEVICE_EXTENDER)
+#define WEBCFG_NOTIFY_SPILL_FILE    "/usr/opensync/data/webconfig_notify_spill.txt"
+#else
+#define WEBCFG_NOTIFY_SPILL_FILE    "/tmp/webconfig_notify_spill.txt"
+#endif
+
+#define NOTIFY_NAME_LEN			64
+#define NOTIFY_STATUS_LEN		32
+#define NOTIFY_VERSION_LEN		32
+#define NOTIFY_ERR_DETAILS_LEN		512
+#define NOTIFY_TRANS_ID_LEN		64
+#define NOTIFY_TYPE_LEN			16
+
+//Fields are stored inline so a notify record is a single allocation, empty string means not set.
 typedef struct _notify_params
 {
-	char * name;
-	char * application_status;
-	char * version;
-	char * error_details;
-	char * transaction_uuid;
-	char * type;
+	char name[NOTIFY_NAME_LEN];
+	char application_status[NOTIFY_STATUS_LEN];
+	char version[NOTIFY_VERSION_LEN];
+	char error_details[NOTIFY_ERR_DETAILS_LEN];
+	char transaction_uuid[NOTIFY_TRANS_ID_LEN];
+	char type[NOTIFY_TYPE_LEN];
 	uint32_t timeout;
 	uint16_t error_code;
 	long response_code;
+	//Enqueue order, spilled reports are replayed by it.
+	uint64_t seq;
 	struct _notify_params *next;
 } notify_params_t;
 
@@ -41,5 +66,14 @@ pthread_t get_global_notify_threadid();
 void addWebConfgNotifyMsg(char *docname, uint32_t version, char *status, char *error_details, char *transaction_uuid, uint32_t timeout,char* type, uint16_t error_code, char *root_string, long response_code);
 pthread_cond_t *get_global_notify_con(void);
 pthread_mutex_t *get_global_notify_mut(void);
+void set_global_notify_batch_window(unsigned int window_ms);
+unsigned int get_global_notify_batch_window(void);
+unsigned long get_global_notify_overflow(void);
+unsigned long get_global_notify_spilled(void);
+unsigned long get_global_notify_dropped(void);
+void set_global_notify_spill_file(const char *path);
+void triggerNotifyRedelivery(void);
+void requeueNotification(const char *dest, const char *payload);
+void addNotifyTransAliases(const char *trans_id, const char *aliases);
 uint16_t getStatusErrorCodeAndMessage(WEBCFG_ERROR_CODE status, char** result);
 #endif
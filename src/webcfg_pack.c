@@ -101,7 +101,7 @@ ssize_t webcfgdb_blob_pack(webconfig_db_data_t *webcfgdb, webconfig_tmp_data_t *
     while(temp_data != NULL)
     {
 	WebcfgDebug("The temp name is %s\n",temp_data->name);
-	if((temp_data->status != NULL) && (strcmp("success", temp_data->status) != 0))
+	if((temp_data->status != TMP_STATUS_NONE) && (temp_data->status != TMP_STATUS_SUCCESS))
 	{
         	tmp_count++;
 	}
@@ -188,7 +188,7 @@ ssize_t webcfgdb_blob_pack(webconfig_db_data_t *webcfgdb, webconfig_tmp_data_t *
       {
 	    while(temp_data != NULL) //1 element
 	    {
-		   if((temp_data->status != NULL) && (strcmp("success", temp_data->status) != 0)) //to avoid duplicate entries 
+		   if((temp_data->status != TMP_STATUS_NONE) && (temp_data->status != TMP_STATUS_SUCCESS)) //to avoid duplicate entries 
 		   {
                 	msgpack_pack_map( &pk, 5); //name, version
 
@@ -211,8 +211,8 @@ ssize_t webcfgdb_blob_pack(webconfig_db_data_t *webcfgdb, webconfig_tmp_data_t *
 
                 	WEBCFG_MAP_TEMP_STATUS.name = "status";
                 	WEBCFG_MAP_TEMP_STATUS.length = strlen( "status" );
-                	WebcfgDebug("The tmp status is %s\n",temp_data->status);
-                	__msgpack_pack_string_nvp( &pk, &WEBCFG_MAP_TEMP_STATUS, temp_data->status );
+                	WebcfgDebug("The tmp status is %s\n",tmpStatusToString(temp_data->status));
+                	__msgpack_pack_string_nvp( &pk, &WEBCFG_MAP_TEMP_STATUS, tmpStatusToString(temp_data->status) );
 
 			struct webcfg_token WEBCFG_MAP_TEMP_ERROR_DETAILS;
 
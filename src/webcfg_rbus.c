@@ -30,6 +30,8 @@
 
 #include "webcfg_metadata.h"
 #include "webcfg_multipart.h"
+#include "webcfg_db.h"
+#include "webcfg_notify.h"
 
 
 time_t start_time;
@@ -52,6 +54,28 @@ static char ForceSync[256]={'\0'};
 static char ForceSyncTransID[256]={'\0'};
 
 static int subscribed = 0;
+static int dbChangeSubscribers = 0;
+static unsigned int setBatchSize = SET_VALUES_BATCH_DEFAULT;
+//FetchCachedBlob requests queued to one worker, off the rbus dispatch thread.
+#define FETCH_BLOB_ASYNC_MAX	4
+
+typedef struct fetchBlobReq
+{
+    char *subdocName;
+    rbusMethodAsyncHandle_t asyncHandle;
+    struct fetchBlobReq *next;
+} fetchBlobReq_t;
+
+static fetchBlobReq_t *fetchBlobQ = NULL;
+static fetchBlobReq_t *fetchBlobQTail = NULL;
+static int fetchBlobQCount = 0;
+static int fetchBlobWorkerStarted = 0;
+static pthread_mutex_t fetchBlob_mut = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t fetchBlob_con = PTHREAD_COND_INITIALIZER;
+
+static rbusError_t fetchCachedBlob(const char *subdocName, rbusObject_t outParams);
+static int queueFetchCachedBlob(const char *subdocName, rbusMethodAsyncHandle_t asyncHandle);
+static void * fetchCachedBlobTask(void *arg);
 
 #ifdef WAN_FAILOVER_SUPPORTED
 static void eventReceiveHandler(
@@ -76,9 +100,22 @@ typedef struct
     rbusValueType_t type;
 } rbusParamVal_t;
 
+//Transaction ids a single queued sync can absorb, further ones are dropped.
+#define FORCESYNC_MERGE_MAX	16
+
 static ForceSyncMsg *ForceSyncMsgQ = NULL;
+static ForceSyncMsg *ForceSyncMsgQTail = NULL;
 pthread_mutex_t ForceSyncMsgQ_mut=PTHREAD_MUTEX_INITIALIZER;
 
+static char *getForceSyncKey(char *doc);
+static ForceSyncMsg *findForceSyncMsg(const char *key);
+static int isMergedTransID(const char *list, const char *trans_id);
+static void mergeForceSyncTransID(ForceSyncMsg *msg, char *trans_id);
+static ForceSyncMsg *createForceSyncMsg(char *ForceSync, char *ForceSyncTransID);
+static void appendForceSyncMsg(ForceSyncMsg *msg);
+static void freeForceSyncMsg(ForceSyncMsg *msg);
+static int enqueueForceSyncMsg(char *doc, char *trans_id);
+
 bool get_global_isRbus(void)
 {
     return isRbus;
@@ -137,6 +174,7 @@ WEBCFG_STATUS webconfigRbusInit(const char *pComponentName)
 	}
 	WebcfgInfo("webconfigRbusInit is success. ret is %d\n", ret);
 	ForceSyncMsgQ = NULL;
+	ForceSyncMsgQTail = NULL;
 	return WEBCFG_SUCCESS;
 }
 
@@ -651,11 +689,12 @@ rbusError_t webcfgSupportedDocsGetHandler(rbusHandle_t handle, rbusProperty_t pr
 		return 0;
 	}
 
-        SupportedDocsVal = getsupportedDocs();
+        SupportedDocsVal = copysupportedDocs();
 
         if(SupportedDocsVal)
         {
             rbusValue_SetString(value, SupportedDocsVal);
+            WEBCFG_FREE(SupportedDocsVal);
         }
         else
         {
@@ -696,11 +735,12 @@ rbusError_t webcfgSupportedVersionGetHandler(rbusHandle_t handle, rbusProperty_t
 		return 0;
 	}
 
-        SupportedVersionVal = getsupportedVersion();
+        SupportedVersionVal = copysupportedVersion();
 
         if(SupportedVersionVal)
         {
             rbusValue_SetString(value, SupportedVersionVal);
+            WEBCFG_FREE(SupportedVersionVal);
         }
         else
         {
@@ -808,10 +848,12 @@ webcfgError_t checkSubdocInDb(char *docname)
 {
         WebcfgDebug("Check subdoc - %s, present in webconfig DB\n", docname);
         webconfig_db_data_t *temp = NULL;
-        temp = get_global_db_node();
+        webcfg_db_snapshot_t *snap = acquireDBSnapshot();
+        temp = (snap != NULL) ? snap->db_list : NULL;
 
         if(temp == NULL)
         {
+                releaseDBSnapshot(snap);
                 WebcfgError("Webcfg DB is NULL\n");
                 return ERROR_FAILURE;
         }
@@ -821,10 +863,12 @@ webcfgError_t checkSubdocInDb(char *docname)
                 if(strcmp(temp->name, docname) == 0)
                 {
                         WebcfgDebug("Subdoc name - %s, is present in webconfig DB\n", temp->name);
+                        releaseDBSnapshot(snap);
                         return ERROR_SUCCESS;
                 }
                 temp = temp->next;
         }
+        releaseDBSnapshot(snap);
         WebcfgError("Subdoc not found\n");
         return ERROR_ELEMENT_DOES_NOT_EXIST;
 }
@@ -846,7 +890,7 @@ webcfgError_t resetSubdocVersion(char *docname)
 		if(tmp !=NULL)
 		{
 			WebcfgDebug("reset tmp list version for %s\n", docname);
-			updateTmpList(tmp, docname, 0, tmp->status, tmp->error_details, tmp->error_code, tmp->trans_id, tmp->retry_count);
+			updateTmpList(tmp, docname, 0, tmpStatusToString(tmp->status), tmp->error_details, tmp->error_code, tmp->trans_id, tmp->retry_count);
 		}
 		else
 		{
@@ -893,6 +937,52 @@ rbusError_t publishSubdocResetEvent(char *subdocName)
 	return rc;
 }
 
+//Publish the DB list version/status delta of a subdoc, skipped when nobody has subscribed.
+void publishDBChangeEvent(const char *subdocName, uint32_t version, const char *status)
+{
+	rbusValue_t value;
+	rbusObject_t data;
+	rbusEvent_t event = {0};
+	int rc = RBUS_ERROR_SUCCESS;
+
+	if(__atomic_load_n(&dbChangeSubscribers, __ATOMIC_RELAXED) <= 0 || !rbus_handle || subdocName == NULL || status == NULL)
+	{
+		return;
+	}
+
+	rbusObject_Init(&data, NULL);
+
+	rbusValue_Init(&value);
+	rbusValue_SetString(value, subdocName);
+	rbusObject_SetValue(data, "subdoc", value);
+	rbusValue_Release(value);
+
+	rbusValue_Init(&value);
+	rbusValue_SetUInt32(value, version);
+	rbusObject_SetValue(data, "version", value);
+	rbusValue_Release(value);
+
+	rbusValue_Init(&value);
+	rbusValue_SetString(value, status);
+	rbusObject_SetValue(data, "status", value);
+	rbusValue_Release(value);
+
+	event.name = WEBCFG_DB_CHANGE_EVENT;
+	event.data = data;
+	event.type = RBUS_EVENT_GENERAL;
+
+	rc = rbusEvent_Publish(rbus_handle, &event);
+	if(rc != RBUS_ERROR_SUCCESS)
+	{
+		WebcfgError("%s publish for %s failed: %d\n", WEBCFG_DB_CHANGE_EVENT, subdocName, rc);
+	}
+	else
+	{
+		WebcfgDebug("Published %s for %s version %lu status %s\n", WEBCFG_DB_CHANGE_EVENT, subdocName, (long)version, status);
+	}
+	rbusObject_Release(data);
+}
+
 rbusError_t webcfgSubdocForceResetGetHandler(rbusHandle_t handle, rbusProperty_t property, rbusGetHandlerOptions_t* opts) {
 
     (void) handle;
@@ -1103,6 +1193,35 @@ rbusError_t resetEventSubHandler(rbusHandle_t handle, rbusEventSubAction_t actio
 
 }
 
+/**
+ *Event subscription handler to count the DB change event subscribers
+ */
+rbusError_t dbChangeEventSubHandler(rbusHandle_t handle, rbusEventSubAction_t action, const char* eventName, rbusFilter_t filter, int32_t interval, bool* autoPublish)
+{
+	(void)handle;
+	(void)filter;
+	(void)interval;
+	*autoPublish = false;
+	WebcfgInfo("dbChangeEventSubHandler: action=%s eventName=%s\n", action == RBUS_EVENT_ACTION_SUBSCRIBE ? "subscribe" : "unsubscribe", eventName);
+
+	if(!strcmp(WEBCFG_DB_CHANGE_EVENT, eventName))
+	{
+		if(action == RBUS_EVENT_ACTION_SUBSCRIBE)
+		{
+			__atomic_add_fetch(&dbChangeSubscribers, 1, __ATOMIC_RELAXED);
+		}
+		else if(__atomic_sub_fetch(&dbChangeSubscribers, 1, __ATOMIC_RELAXED) < 0)
+		{
+			__atomic_store_n(&dbChangeSubscribers, 0, __ATOMIC_RELAXED);
+		}
+	}
+	else
+	{
+		WebcfgError("provider: dbChangeEventSubHandler unexpected eventName %s\n", eventName);
+	}
+	return RBUS_ERROR_SUCCESS;
+}
+
 char * webcfgError_ToString(webcfgError_t e)
 {
 
@@ -1157,30 +1276,28 @@ void setFetchCachedBlobErrCode(rbusObject_t outParams, webcfgError_t errorCode)
 }
 
 /**
- *Used to fetch the multipart blob from global cache
+ *Used to fetch the multipart blob from global cache, blobdata is borrowed
+ *from mp_doc which must be released with releaseMpDoc()
  */
-webcfgError_t fetchMpBlobData(char *docname, void **blobdata, int *len, uint32_t *etag)
+webcfgError_t fetchMpBlobData(char *docname, void **blobdata, int *len, uint32_t *etag, multipartdocs_t **mp_doc)
 {
 	multipartdocs_t *temp = NULL;
-	temp = get_global_mp();
 
-	if(temp == NULL)
+	if(get_global_mp() == NULL)
 	{
 		WebcfgError("Multipart Cache is NULL");
 		return ERROR_FAILURE;
 	}
-	while(temp != NULL)
+	temp = acquireMpDoc(docname);
+	if(temp != NULL)
 	{
-		if(strcmp(temp->name_space, docname) == 0)
-		{
-			*etag = temp->etag;
-			*blobdata = temp->data;
-			*len = (int)temp->data_size;
-			WebcfgDebug("Len is %d\n", *len);
-			WebcfgDebug("temp->data_size is %zu\n", temp->data_size);
-			return ERROR_SUCCESS;
-		}
-		temp = temp->next;
+		*etag = temp->etag;
+		*blobdata = temp->data;
+		*len = (int)temp->data_size;
+		*mp_doc = temp;
+		WebcfgDebug("Len is %d\n", *len);
+		WebcfgDebug("temp->data_size is %zu\n", temp->data_size);
+		return ERROR_SUCCESS;
 	}
 	WebcfgError("Subdoc not found \n");
 	return ERROR_ELEMENT_DOES_NOT_EXIST;
@@ -1192,8 +1309,6 @@ webcfgError_t fetchMpBlobData(char *docname, void **blobdata, int *len, uint32_t
 rbusError_t fetchCachedBlobHandler(rbusHandle_t handle, char const* methodName, rbusObject_t inParams, rbusObject_t outParams, rbusMethodAsyncHandle_t asyncHandle)
 {
 	(void) handle;
-	(void) outParams;
-	(void) asyncHandle;
 	WebcfgInfo("methodHandler called: %s\n", methodName);
 
 	//rbusObject_fwrite(inParams, 1, stdout);           //For Debug Purpose
@@ -1202,11 +1317,8 @@ rbusError_t fetchCachedBlobHandler(rbusHandle_t handle, char const* methodName,
 	{
 		rbusProperty_t tempProp;
 		rbusValue_t propValue;
-		int len, bloblen = 0;
+		int len = 0;
 		char * valueString = NULL;
-		void *blobData = NULL;
-		uint32_t etag = 0;
-		webcfgError_t ret = ERROR_FAILURE;
 
 		if(!isRfcEnabled())
 		{
@@ -1234,45 +1346,164 @@ rbusError_t fetchCachedBlobHandler(rbusHandle_t handle, char const* methodName,
 			return RBUS_ERROR_BUS_ERROR;
 		}
 
-		ret = fetchMpBlobData(valueString, &blobData, &bloblen, &etag);
-
-		if(ret == ERROR_SUCCESS)
+		//Complete on the worker so a burst of fetches at boot does not hold the dispatch thread.
+		if(asyncHandle != NULL && queueFetchCachedBlob(valueString, asyncHandle) == 0)
 		{
-			rbusValue_t value;
+			WebcfgDebug("%s for %s completes asynchronously\n", methodName, valueString);
+			return RBUS_ERROR_ASYNC_RESPONSE;
+		}
+		return fetchCachedBlob(valueString, outParams);
+	}
 
-			rbusValue_Init(&value);
-			rbusValue_SetUInt32(value, etag);
-			rbusObject_SetValue(outParams, "etag", value);
-			rbusValue_Release(value);
+	WebcfgError("Method %s received is not supported\n", methodName);
+	setFetchCachedBlobErrCode(outParams, ERROR_FAILURE);
+	return RBUS_ERROR_BUS_ERROR;
+}
 
-			WebcfgDebug("The etag value is %lu\n", (long)etag);
-			WebcfgDebug("The blob is %s\n", (char *)blobData);
+static rbusError_t fetchCachedBlob(const char *subdocName, rbusObject_t outParams)
+{
+	int bloblen = 0;
+	void *blobData = NULL;
+	uint32_t etag = 0;
+	webcfgError_t ret = ERROR_FAILURE;
+	multipartdocs_t *mp_doc = NULL;
+	blob_cache_ref_t cache_ref;
 
-			rbusValue_Init(&value);
-			rbusValue_SetBytes(value, (uint8_t *)blobData, bloblen);
-			rbusObject_SetValue(outParams, "data", value);
-			rbusValue_Release(value);
+	memset(&cache_ref, 0, sizeof(cache_ref));
+	ret = fetchMpBlobData((char *) subdocName, &blobData, &bloblen, &etag, &mp_doc);
+	//Fall back to the persistent cache when the subdoc is no longer in memory.
+	if(ret != ERROR_SUCCESS && fetchBlobCacheDoc(subdocName, &cache_ref) == WEBCFG_SUCCESS)
+	{
+		etag = cache_ref.etag;
+		blobData = (void *) cache_ref.data;
+		bloblen = (int)cache_ref.data_size;
+		ret = ERROR_SUCCESS;
+	}
 
-			WebcfgInfo("%s returns RBUS_ERROR_SUCCESS\n", methodName);
-			return RBUS_ERROR_SUCCESS;
-		}
-		else if(ret == ERROR_ELEMENT_DOES_NOT_EXIST)
+	if(ret == ERROR_SUCCESS)
+	{
+		rbusValue_t value;
+
+		rbusValue_Init(&value);
+		rbusValue_SetUInt32(value, etag);
+		rbusObject_SetValue(outParams, "etag", value);
+		rbusValue_Release(value);
+
+		WebcfgDebug("The etag value is %lu\n", (long)etag);
+		WebcfgDebug("The blob is %s\n", (char *)blobData);
+
+		rbusValue_Init(&value);
+		rbusValue_SetBytes(value, (uint8_t *)blobData, bloblen);
+		rbusObject_SetValue(outParams, "data", value);
+		rbusValue_Release(value);
+		releaseMpDoc(mp_doc);
+		releaseBlobCacheDoc(&cache_ref);
+
+		WebcfgInfo("%s returns RBUS_ERROR_SUCCESS\n", WEBCFG_UTIL_METHOD);
+		return RBUS_ERROR_SUCCESS;
+	}
+	else if(ret == ERROR_ELEMENT_DOES_NOT_EXIST)
+	{
+		WebcfgError("Mentioned %s subdoc is not found\n", subdocName);
+		setFetchCachedBlobErrCode(outParams, ERROR_ELEMENT_DOES_NOT_EXIST);
+		return RBUS_ERROR_BUS_ERROR;
+	}
+	WebcfgError("Multipart Cache is NULL\n");
+	setFetchCachedBlobErrCode(outParams, ERROR_FAILURE);
+	return RBUS_ERROR_BUS_ERROR;
+}
+
+//Queue a fetch for the worker, returns -1 when the queue is full or the worker can't start.
+static int queueFetchCachedBlob(const char *subdocName, rbusMethodAsyncHandle_t asyncHandle)
+{
+	pthread_t threadId;
+	fetchBlobReq_t *req = NULL;
+
+	pthread_mutex_lock(&fetchBlob_mut);
+	if(fetchBlobQCount >= FETCH_BLOB_ASYNC_MAX)
+	{
+		pthread_mutex_unlock(&fetchBlob_mut);
+		WebcfgDebug("FetchCachedBlob queue is full, serving %s inline\n", subdocName);
+		return -1;
+	}
+	if(!fetchBlobWorkerStarted)
+	{
+		if(pthread_create(&threadId, NULL, fetchCachedBlobTask, NULL) != 0)
 		{
-			WebcfgError("Mentioned %s subdoc is not found\n", valueString);
-			setFetchCachedBlobErrCode(outParams, ERROR_ELEMENT_DOES_NOT_EXIST);
-			return RBUS_ERROR_BUS_ERROR;
+			pthread_mutex_unlock(&fetchBlob_mut);
+			WebcfgError("Failed to start FetchCachedBlob worker, serving %s inline\n", subdocName);
+			return -1;
 		}
-		else if(ret == ERROR_FAILURE)
+		fetchBlobWorkerStarted = 1;
+	}
+
+	req = (fetchBlobReq_t *) malloc(sizeof(fetchBlobReq_t));
+	if(req == NULL || (req->subdocName = strdup(subdocName)) == NULL)
+	{
+		pthread_mutex_unlock(&fetchBlob_mut);
+		if(req != NULL)
 		{
-			WebcfgError("Multipart Cache is NULL\n");
-			setFetchCachedBlobErrCode(outParams, ERROR_FAILURE);
-			return RBUS_ERROR_BUS_ERROR;
+			WEBCFG_FREE(req);
 		}
+		WebcfgError("Failed to queue FetchCachedBlob for %s, serving inline\n", subdocName);
+		return -1;
 	}
+	req->asyncHandle = asyncHandle;
+	req->next = NULL;
+	if(fetchBlobQTail != NULL)
+	{
+		fetchBlobQTail->next = req;
+	}
+	else
+	{
+		fetchBlobQ = req;
+	}
+	fetchBlobQTail = req;
+	fetchBlobQCount++;
+	pthread_cond_signal(&fetchBlob_con);
+	pthread_mutex_unlock(&fetchBlob_mut);
+	return 0;
+}
 
-	WebcfgError("Method %s received is not supported\n", methodName);
-	setFetchCachedBlobErrCode(outParams, ERROR_FAILURE);
-	return RBUS_ERROR_BUS_ERROR;
+static void * fetchCachedBlobTask(void *arg)
+{
+	fetchBlobReq_t *req = NULL;
+	rbusObject_t outParams;
+	rbusError_t ret = RBUS_ERROR_BUS_ERROR;
+
+	(void) arg;
+	pthread_detach(pthread_self());
+	while(1)
+	{
+		pthread_mutex_lock(&fetchBlob_mut);
+		while(fetchBlobQ == NULL)
+		{
+			pthread_cond_wait(&fetchBlob_con, &fetchBlob_mut);
+		}
+		req = fetchBlobQ;
+		fetchBlobQ = req->next;
+		if(fetchBlobQ == NULL)
+		{
+			fetchBlobQTail = NULL;
+		}
+		pthread_mutex_unlock(&fetchBlob_mut);
+
+		rbusObject_Init(&outParams, NULL);
+		ret = fetchCachedBlob(req->subdocName, outParams);
+		if(rbusMethod_SendAsyncResponse(req->asyncHandle, ret, outParams) != RBUS_ERROR_SUCCESS)
+		{
+			WebcfgError("rbusMethod_SendAsyncResponse for %s failed\n", req->subdocName);
+		}
+		rbusObject_Release(outParams);
+		WEBCFG_FREE(req->subdocName);
+		WEBCFG_FREE(req);
+
+		//Count drops only once the reply is sent, so the cap covers in-flight work too.
+		pthread_mutex_lock(&fetchBlob_mut);
+		fetchBlobQCount--;
+		pthread_mutex_unlock(&fetchBlob_mut);
+	}
+	return NULL;
 }
 
 /**
@@ -1304,6 +1535,7 @@ WEBCFG_STATUS regWebConfigDataModel()
 		{WEBCFG_SUPPORTED_VERSION_PARAM, RBUS_ELEMENT_TYPE_PROPERTY, {webcfgSupportedVersionGetHandler, webcfgSupportedVersionSetHandler, NULL, NULL, NULL, NULL}},
 		{WEBCFG_SUBDOC_FORCERESET_PARAM, RBUS_ELEMENT_TYPE_PROPERTY, {webcfgSubdocForceResetGetHandler, webcfgSubdocForceResetSetHandler, NULL, NULL, resetEventSubHandler, NULL}},
 		{WEBCFG_UPSTREAM_EVENT, RBUS_ELEMENT_TYPE_EVENT, {NULL, NULL, NULL, NULL, eventSubHandler, NULL}},
+		{WEBCFG_DB_CHANGE_EVENT, RBUS_ELEMENT_TYPE_EVENT, {NULL, NULL, NULL, NULL, dbChangeEventSubHandler, NULL}},
 		{WEBCFG_UTIL_METHOD, RBUS_ELEMENT_TYPE_METHOD, {NULL, NULL, NULL, NULL, NULL, fetchCachedBlobHandler}}
 	};
 
@@ -1520,16 +1752,28 @@ void blobSet_rbus(char *name, void *bufVal, int len, WDMP_STATUS *retStatus, int
        *retStatus = mapStatus(*ccspRetStatus);
 }
 
+void set_global_set_batch_size(unsigned int size)
+{
+	__atomic_store_n(&setBatchSize, (size > 0) ? size : SET_VALUES_BATCH_DEFAULT, __ATOMIC_RELAXED);
+	WebcfgInfo("setValues_rbus batch size is %u\n", get_global_set_batch_size());
+}
+
+unsigned int get_global_set_batch_size(void)
+{
+	return __atomic_load_n(&setBatchSize, __ATOMIC_RELAXED);
+}
+
+//Docs above the batch size are sent as several rbus_setMulti calls in one session, committed by the last one.
+//rbus has no rollback for chunks already sent, so ATOMIC_SET_WEBCONFIG docs always go in a single call.
 void setValues_rbus(const param_t paramVal[], const unsigned int paramCount, const int setType,char *transactionId, money_trace_spans *timeSpan, WDMP_STATUS *retStatus, int *ccspRetStatus)
 {
 	unsigned int cnt = 0;
-	int isInvalid = 0;
-	bool isCommit = true;
-	int sessionId = 0;
+	unsigned int start = 0;
+	unsigned int batchCount = 0;
+	unsigned int batchSize = (setType == ATOMIC_SET_WEBCONFIG) ? paramCount : get_global_set_batch_size();
+	uint32_t sessionId = 0;
 	rbusError_t ret = RBUS_ERROR_BUS_ERROR;
 	rbusProperty_t properties = NULL, last = NULL;
-	rbusValue_t setVal[paramCount];
-	char const* setNames[paramCount];
 	*retStatus = WDMP_FAILURE;
 
 	if(!rbus_handle)
@@ -1542,69 +1786,91 @@ void setValues_rbus(const param_t paramVal[], const unsigned int paramCount, con
 	WebcfgDebug("setValues_rbus transactionId %s\n",transactionId);
 	WebcfgDebug("setValues_rbus timeSpan %p\n",timeSpan);
 
+	//Validate all types up front so no chunk is applied for a doc that cannot be set.
 	for(cnt=0; cnt<paramCount; cnt++)
 	{
-		rbusValue_Init(&setVal[cnt]);
+		if (mapWdmpToRbusDataType(paramVal[cnt].type) == RBUS_NONE)
+		{
+			WebcfgError("Invalid data type\n");
+			ret = RBUS_ERROR_INVALID_INPUT;
+			WebcfgError("Invalid input. ret %d\n", ret);
+			*ccspRetStatus = mapRbusToCcspStatus((int)ret);
+			*retStatus = mapStatus(*ccspRetStatus);
+			return;
+		}
+	}
 
-		setNames[cnt] = paramVal[cnt].name;
-		WebcfgDebug("paramName to be set is %s paramCount %d\n", paramVal[cnt].name, paramCount);
-		WebcfgDebug("paramVal is %s\n", paramVal[cnt].value);
+	if(paramCount > batchSize)
+	{
+		ret = rbus_createSession(rbus_handle, &sessionId);
+		if(ret != RBUS_ERROR_SUCCESS)
+		{
+			WebcfgError("rbus_createSession failed:%s\n", rbusError_ToString(ret));
+			*ccspRetStatus = mapRbusToCcspStatus((int)ret);
+			*retStatus = mapStatus(*ccspRetStatus);
+			return;
+		}
+		WebcfgInfo("Applying %u params in batches of %u, sessionId %lu\n", paramCount, batchSize, (long)sessionId);
+	}
 
-		rbusValueType_t type = mapWdmpToRbusDataType(paramVal[cnt].type);
+	for(start = 0; start < paramCount; start += batchCount)
+	{
+		batchCount = ((paramCount - start) > batchSize) ? batchSize : (paramCount - start);
+		properties = last = NULL;
 
-		if (type == RBUS_NONE)
+		for(cnt = start; cnt < start + batchCount; cnt++)
 		{
-			WebcfgError("Invalid data type\n");
-			isInvalid = 1;
-			break;
-		}
+			rbusValue_t setVal;
+			rbusProperty_t next;
 
-		rbusValue_SetFromString(setVal[cnt], type, paramVal[cnt].value);
+			WebcfgDebug("paramName to be set is %s paramCount %d\n", paramVal[cnt].name, paramCount);
+			WebcfgDebug("paramVal is %s\n", paramVal[cnt].value);
 
-		rbusProperty_t next;
-		rbusProperty_Init(&next, setNames[cnt], setVal[cnt]);
+			rbusValue_Init(&setVal);
+			rbusValue_SetFromString(setVal, mapWdmpToRbusDataType(paramVal[cnt].type), paramVal[cnt].value);
+			//The property keeps its own reference to the value.
+			rbusProperty_Init(&next, paramVal[cnt].name, setVal);
+			rbusValue_Release(setVal);
 
-		WebcfgDebug("Property Name[%d] is %s\n", cnt, rbusProperty_GetName(next));
-		WebcfgDebug("Value type[%d] is %d\n", cnt, rbusValue_GetType(setVal[cnt]));
+			WebcfgDebug("Property Name[%d] is %s\n", cnt, rbusProperty_GetName(next));
 
-		if(properties == NULL)
-		{
-			properties = last = next;
+			if(properties == NULL)
+			{
+				properties = last = next;
+			}
+			else
+			{
+				rbusProperty_SetNext(last, next);
+				rbusProperty_Release(next);
+				last=next;
+			}
 		}
-		else
+
+		rbusSetOptions_t opts = {((start + batchCount) == paramCount), sessionId};
+
+		ret = rbus_setMulti(rbus_handle, batchCount, properties, &opts);
+		rbusProperty_Release(properties);
+		WebcfgInfo("The ret status for rbus_setMulti is %d, params %u-%u of %u\n", ret, start, start + batchCount - 1, paramCount);
+		if(ret != RBUS_ERROR_SUCCESS)
 		{
-			rbusProperty_SetNext(last, next);
-			last=next;
+			if(start > 0)
+			{
+				WebcfgError("rbus_setMulti failed after %u of %u params were set, session %lu not committed\n", start, paramCount, (long)sessionId);
+			}
+			break;
 		}
 	}
 
-	if(!isInvalid)
+	if(sessionId != 0)
 	{
-		isCommit = true;
-		sessionId = 0;
-
-		rbusSetOptions_t opts = {isCommit,sessionId};
-
-		ret = rbus_setMulti(rbus_handle, paramCount, properties, &opts);
-		WebcfgInfo("The ret status for rbus_setMulti is %d\n", ret);
-	}
-	else
-	{
-		ret = RBUS_ERROR_INVALID_INPUT;
-		WebcfgError("Invalid input. ret %d\n", ret);
+		rbus_closeSession(rbus_handle, sessionId);
 	}
 
 	*ccspRetStatus = mapRbusToCcspStatus((int)ret);
 	WebcfgInfo("ccspRetStatus is %d\n", *ccspRetStatus);
 
         *retStatus = mapStatus(*ccspRetStatus);
-
 	WebcfgDebug("paramCount is %d\n", paramCount);
-        for (cnt = 0; cnt < paramCount; cnt++)
-        {
-            rbusValue_Release(setVal[cnt]);
-        }
-        rbusProperty_Release(properties);
 }
 
 void getValues_rbus(const char *paramName[], const unsigned int paramCount, int index, money_trace_spans *timeSpan, param_t ***paramArr, int *retValCount, int *retStatus)
@@ -1938,43 +2204,20 @@ int set_rbus_ForceSync(char* pString, int *pStatus)
 			WebcfgInfo("ForceSync transaction Id is NULL, generated uuid %s\n",transactionId);
 		}
 
-		if((strcmp(ForceSync,"root,telemetry") == 0) || (strcmp(ForceSync,"telemetry,root") == 0))
+		//Pokes coalesce per doc, each doc of a bundle like "root,telemetry" is merged under the same transaction id.
+		char *saveptr = NULL;
+		char *doc = strtok_r(ForceSync, ",", &saveptr);
+		while(doc != NULL)
 		{
-			char* str1 = strtok(ForceSync, ",");
-			char* str2 = strtok(NULL, ",");
-			WebcfgInfo("Received %s and %s bundle ForceSync, delete existing entries from queue and add new entries\n",str1,str2);
-			deleteForceSyncMsgQueue();
-
-			// Add "root" to the force sync message queue
-			ret = addForceSyncMsgToQueue(str1,transactionId);
-			if(ret)
-			{
-				WebcfgError("addForceSyncMsgToQueue for %s failed in bundle case\n", str1);
-				*pStatus = 2;
-				return 0;				
-			}
-			// Append "telemetry" to the force sync message queue
-			ret	= addForceSyncMsgToQueue(str2,transactionId);
+			ret = enqueueForceSyncMsg(doc, transactionId);
 			if(ret)
 			{
-				WebcfgError("addForceSyncMsgToQueue for %s failed in bundle case\n", str2);
+				WebcfgError("addForceSyncMsgToQueue for %s failed\n", doc);
 				*pStatus = 2;
+				WEBCFG_FREE(transactionId);
 				return 0;
 			}
-		}
-		else		
-		{
-			int Status = updateForceSyncMsgQueue(transactionId);
-			if(Status == 0)
-			{
-				ret = addForceSyncMsgToQueue(ForceSync,transactionId);
-				if(ret)
-				{
-					WebcfgError("addForceSyncMsgToQueue failed\n");
-					*pStatus = 2;
-					return 0;					
-				}
-			}
+			doc = strtok_r(NULL, ",", &saveptr);
 		}
 
 	if(!get_webcfgReady())
@@ -2058,9 +2301,10 @@ void DisplayQueue() {
     WebcfgDebug("/************DisplayQueue************/\n");
     // Traverse the list and print each node
     while (current != NULL) {
-		WebcfgDebug("ForceSyncVal:%s -> ForceSyncTransID:%s\n",
+		WebcfgDebug("ForceSyncVal:%s -> ForceSyncTransID:%s MergedTransIDs:%s\n",
            current->ForceSyncVal ? current->ForceSyncVal : "NULL", 
-           current->ForceSyncTransID ? current->ForceSyncTransID : "NULL");
+           current->ForceSyncTransID ? current->ForceSyncTransID : "NULL",
+           current->MergedTransIDs ? current->MergedTransIDs : "NULL");
         current = current->next;
     }
     WebcfgDebug("/************************************/\n");
@@ -2088,6 +2332,8 @@ int get_rbus_ForceSync(char** pString, char **transactionId )
 			if(current->ForceSyncTransID != NULL)
 			{
 				*transactionId = strdup(current->ForceSyncTransID);
+				//Merged pokes are reported through the notifications of this sync.
+				addNotifyTransAliases(current->ForceSyncTransID, current->MergedTransIDs);
 			}
 			else
 			{
@@ -2095,9 +2341,11 @@ int get_rbus_ForceSync(char** pString, char **transactionId )
 				WebcfgError("ForceSyncTransID is NULL in Queue.\n");
 			}
 			ForceSyncMsgQ = ForceSyncMsgQ->next;
-			WEBCFG_FREE(current->ForceSyncVal);
-			WEBCFG_FREE(current->ForceSyncTransID);
-			WEBCFG_FREE(current);
+			if(ForceSyncMsgQ == NULL)
+			{
+				ForceSyncMsgQTail = NULL;
+			}
+			freeForceSyncMsg(current);
 		}
 		pthread_mutex_unlock (&ForceSyncMsgQ_mut);
 		WebcfgDebug("get_rbus_ForceSync: mutex unlock\n");
@@ -2132,18 +2380,18 @@ void deleteForceSyncMsgQueue()
 	while (current != NULL)
 	{
 		next_node = current->next; // Save the next node
-		WEBCFG_FREE(current->ForceSyncVal);
-		WEBCFG_FREE(current->ForceSyncTransID);
-		WEBCFG_FREE(current);            // Free the current node
+		freeForceSyncMsg(current);
 		current = next_node;      // Move to the next node
 	}
 	ForceSyncMsgQ = NULL;
+	ForceSyncMsgQTail = NULL;
 	pthread_mutex_unlock (&ForceSyncMsgQ_mut);
 }
 
 int updateForceSyncMsgQueue(char* trans_id)
 {
 	int found = 0;
+	ForceSyncMsg *temp = NULL;
 
 	if(trans_id == NULL)
 	{
@@ -2152,37 +2400,142 @@ int updateForceSyncMsgQueue(char* trans_id)
 	}
 
 	pthread_mutex_lock (&ForceSyncMsgQ_mut);
+	temp = findForceSyncMsg(getForceSyncKey(ForceSync));
+	if(temp != NULL)
+	{
+		mergeForceSyncTransID(temp, trans_id);
+		found = 1;
+		WebcfgInfo("ForceSyncMsg %s updated with trans_id %s\n", temp->ForceSyncVal, temp->ForceSyncTransID);
+	}
+	pthread_mutex_unlock (&ForceSyncMsgQ_mut);
+
+	if (!found)
+	{
+		WebcfgDebug("Value %s not found in the Queue.\n", ForceSync);
+	}
+	return found;
+}
+
+int addForceSyncMsgToQueue(char *ForceSync, char *ForceSyncTransID)
+{
+	ForceSyncMsg *message = NULL;
+
+	message = createForceSyncMsg(ForceSync, ForceSyncTransID);
+	if(message == NULL)
+	{
+		//Memory allocation failed
+		WebcfgError("ForceSyncMsgQ Memory allocation is failed\n");
+		return WEBCFG_FAILURE;
+	}
+	pthread_mutex_lock (&ForceSyncMsgQ_mut);
+	appendForceSyncMsg(message);
+	pthread_mutex_unlock (&ForceSyncMsgQ_mut);
+	return WEBCFG_SUCCESS;
+}
+
+//Primary docs are all served by the root sync, so they share one queue entry.
+static char *getForceSyncKey(char *doc)
+{
+	if(isSupplementaryDoc(doc) == WEBCFG_SUCCESS)
+	{
+		return doc;
+	}
+	return "root";
+}
+
+//Caller holds ForceSyncMsgQ_mut, the queue has at most one entry per distinct sync.
+static ForceSyncMsg *findForceSyncMsg(const char *key)
+{
 	ForceSyncMsg *temp = ForceSyncMsgQ;
-	while (temp)
+
+	while(temp != NULL)
 	{
-		if ((temp->ForceSyncVal) && (strcmp(temp->ForceSyncVal,ForceSync) == 0))
+		if((temp->ForceSyncVal != NULL) && (strcmp(temp->ForceSyncVal, key) == 0))
 		{
-			WEBCFG_FREE(temp->ForceSyncTransID);
-			temp->ForceSyncTransID = strdup(trans_id);
-			found = 1;
-			break;
+			return temp;
 		}
 		temp = temp->next;
 	}
-	pthread_mutex_unlock (&ForceSyncMsgQ_mut);
+	return NULL;
+}
 
-	if (!found)
+static int isMergedTransID(const char *list, const char *trans_id)
+{
+	size_t len = strlen(trans_id);
+
+	while(list != NULL && *list != '\0')
 	{
-		WebcfgDebug("Value %s not found in the Queue.\n", ForceSync);
+		if((strncmp(list, trans_id, len) == 0) && (list[len] == ',' || list[len] == '\0'))
+		{
+			return 1;
+		}
+		list = strchr(list, ',');
+		if(list != NULL)
+		{
+			list++;
+		}
+	}
+	return 0;
+}
+
+//Latest poke drives the sync as before, the id it replaces is kept for notification.
+static void mergeForceSyncTransID(ForceSyncMsg *msg, char *trans_id)
+{
+	char *merged = NULL;
+	size_t len = 0;
+
+	if(msg->ForceSyncTransID == NULL)
+	{
+		msg->ForceSyncTransID = strdup(trans_id);
+		return;
+	}
+	if((strcmp(msg->ForceSyncTransID, trans_id) == 0) || isMergedTransID(msg->MergedTransIDs, trans_id))
+	{
+		return;
+	}
+	if(msg->MergedCount >= FORCESYNC_MERGE_MAX)
+	{
+		WebcfgError("ForceSyncMsg %s merge limit reached, dropping trans_id %s\n", msg->ForceSyncVal, msg->ForceSyncTransID);
 	}
 	else
 	{
-		WebcfgInfo("ForceSyncMsg %s updated with trans_id %s\n", temp->ForceSyncVal, temp->ForceSyncTransID);
+		len = strlen(msg->ForceSyncTransID) + 1;
+		if(msg->MergedTransIDs != NULL)
+		{
+			len += strlen(msg->MergedTransIDs) + 1;
+		}
+		merged = (char *)malloc(len);
+		if(merged == NULL)
+		{
+			WebcfgError("Failed to merge trans_id %s\n", msg->ForceSyncTransID);
+		}
+		else
+		{
+			if(msg->MergedTransIDs != NULL)
+			{
+				snprintf(merged, len, "%s,%s", msg->MergedTransIDs, msg->ForceSyncTransID);
+			}
+			else
+			{
+				snprintf(merged, len, "%s", msg->ForceSyncTransID);
+			}
+			if(msg->MergedTransIDs != NULL)
+			{
+				WEBCFG_FREE(msg->MergedTransIDs);
+			}
+			msg->MergedTransIDs = merged;
+			msg->MergedCount++;
+		}
 	}
-	return found;
+	WEBCFG_FREE(msg->ForceSyncTransID);
+	msg->ForceSyncTransID = strdup(trans_id);
 }
 
-int addForceSyncMsgToQueue(char *ForceSync, char *ForceSyncTransID)
+static ForceSyncMsg *createForceSyncMsg(char *ForceSync, char *ForceSyncTransID)
 {
 	ForceSyncMsg *message = NULL;
 
 	message = (ForceSyncMsg *)malloc(sizeof(ForceSyncMsg));
-
 	if(message)
 	{
 		memset(message, 0, sizeof(ForceSyncMsg));
@@ -2202,38 +2555,71 @@ int addForceSyncMsgToQueue(char *ForceSync, char *ForceSyncTransID)
 		{
 			WebcfgError("ForceSyncTransID is NULL\n");
 		}
-
-		WebcfgDebug("addForceSyncMsgToQueue : Producer added ForceSyncVal\n");
 		message->next = NULL;
+	}
+	return message;
+}
 
-		pthread_mutex_lock (&ForceSyncMsgQ_mut);
-		if(ForceSyncMsgQ == NULL)
-		{
-			ForceSyncMsgQ = message;
-			pthread_mutex_unlock (&ForceSyncMsgQ_mut);
-		}
-		else
+//Caller holds ForceSyncMsgQ_mut.
+static void appendForceSyncMsg(ForceSyncMsg *msg)
+{
+	if(ForceSyncMsgQTail == NULL)
+	{
+		ForceSyncMsgQ = msg;
+	}
+	else
+	{
+		ForceSyncMsgQTail->next = msg;
+	}
+	ForceSyncMsgQTail = msg;
+	WebcfgDebug("addForceSyncMsgToQueue : Producer added ForceSyncVal\n");
+}
+
+static void freeForceSyncMsg(ForceSyncMsg *msg)
+{
+	WEBCFG_FREE(msg->ForceSyncVal);
+	WEBCFG_FREE(msg->ForceSyncTransID);
+	if(msg->MergedTransIDs != NULL)
+	{
+		WEBCFG_FREE(msg->MergedTransIDs);
+	}
+	WEBCFG_FREE(msg);
+}
+
+//Merges the poke into the pending sync for its doc, or queues a new one.
+static int enqueueForceSyncMsg(char *doc, char *trans_id)
+{
+	ForceSyncMsg *message = NULL;
+	char *key = getForceSyncKey(doc);
+
+	pthread_mutex_lock (&ForceSyncMsgQ_mut);
+	message = findForceSyncMsg(key);
+	if(message != NULL)
+	{
+		if(trans_id != NULL)
 		{
-			ForceSyncMsg *temp = ForceSyncMsgQ;
-			while(temp->next)
-			{
-				temp = temp->next;
-			}
-			temp->next = message;
-			pthread_mutex_unlock (&ForceSyncMsgQ_mut);
+			mergeForceSyncTransID(message, trans_id);
 		}
+		WebcfgInfo("ForceSync %s merged into pending %s sync, trans_id %s\n", doc, key, message->ForceSyncTransID ? message->ForceSyncTransID : "NULL");
+		pthread_mutex_unlock (&ForceSyncMsgQ_mut);
+		return WEBCFG_SUCCESS;
 	}
-	else
+	message = createForceSyncMsg(key, trans_id);
+	if(message == NULL)
 	{
-		//Memory allocation failed
+		pthread_mutex_unlock (&ForceSyncMsgQ_mut);
 		WebcfgError("ForceSyncMsgQ Memory allocation is failed\n");
 		return WEBCFG_FAILURE;
 	}
+	appendForceSyncMsg(message);
+	pthread_mutex_unlock (&ForceSyncMsgQ_mut);
 	return WEBCFG_SUCCESS;
 }
 
-void sendNotification_rbus(char *payload, char *source, char *destination)
+//Returns 1 when the notification is published upstream, 0 otherwise.
+int sendNotification_rbus(char *payload, char *source, char *destination)
 {
+	int sent = 0;
 	wrp_msg_t *notif_wrp_msg = NULL;
 	char *contentType = NULL;
 	int rc = RBUS_ERROR_SUCCESS;
@@ -2272,12 +2658,13 @@ void sendNotification_rbus(char *payload, char *source, char *destination)
 			{
 				WebcfgInfo("sendNotification_mqtt . ret %d\n", ret);
 			}
+			sent = ret;
 			wrp_free_struct (notif_wrp_msg );
                         if(msg_bytes)
 			{
 				WEBCFG_FREE(msg_bytes);
 			}
-			return ;
+			return sent;
 		#endif
 			// 30s wait interval for subscription 	
 			if(!subscribed)
@@ -2302,7 +2689,10 @@ void sendNotification_rbus(char *payload, char *source, char *destination)
 				if(rc != RBUS_ERROR_SUCCESS)
 					WebcfgError("Failed to send Notification : %d, %s\n", rc, rbusError_ToString(rc));
 				else
+				{
 					WebcfgInfo("Notification successfully sent to %s\n", WEBCFG_UPSTREAM_EVENT);
+					sent = 1;
+				}
 			}
 			else
 				WebcfgError("Failed to send Notification as no subscription\n");
@@ -2315,6 +2705,7 @@ void sendNotification_rbus(char *payload, char *source, char *destination)
 			}
 		}
 	}
+	return sent;
 }
 
 // wait for upstream subscriber
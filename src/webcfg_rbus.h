@@ -34,16 +34,20 @@
 #include "webcfg_log.h"
 #include "webcfg_generic.h"
 #include "webcfg_event.h"
+#include "webcfg_multipart.h"
 
 #define buffLen 1024
 #define maxParamLen 128
 
-#define NUM_WEBCFG_ELEMENTS1 7
+#define NUM_WEBCFG_ELEMENTS1 8
 
 #if !defined (FEATURE_SUPPORT_MQTTCM)
 #define NUM_WEBCFG_ELEMENTS2 3
 #endif
 
+//Parameters per rbus_setMulti, larger docs are applied in chunks within one session.
+#define SET_VALUES_BATCH_DEFAULT	256
+
 #define MAX_FORCE_RESET_SET_COUNT 3
 #define MAX_FORCE_RESET_TIME_SECS 24*60*60
 
@@ -66,6 +70,8 @@
 #endif
 
 #define WEBCFG_UPSTREAM_EVENT  "Webconfig.Upstream"
+#define WEBCFG_DB_CHANGE_EVENT  "Device.X_RDK_WebConfig.DBChange"
+#define DB_CHANGE_STATUS_RESET "reset"
 #define PARAM_RFC_ENABLE "eRT.com.cisco.spvtg.ccsp.webpa.WebConfigRfcEnable"
 
 #define WEBCFG_UTIL_METHOD "Device.X_RDK_WebConfig.FetchCachedBlob"
@@ -94,9 +100,12 @@ typedef enum _webcfgError
 
 }webcfgError_t;
 
+//One pending sync per doc, later pokes for the same doc are merged into it.
 typedef struct ForceSyncMsg {
 	char *ForceSyncVal;
 	char *ForceSyncTransID;
+	char *MergedTransIDs;
+	int MergedCount;
     struct ForceSyncMsg* next;
 } ForceSyncMsg;
 
@@ -126,20 +135,24 @@ void set_global_supplementary_url(char *value);
 int parseForceSyncJson(char *jsonpayload, char **forceSyncVal, char **forceSynctransID);
 int get_rbus_ForceSync(char** pString, char **transactionId );
 bool get_rbus_RfcEnable();
-void sendNotification_rbus(char *payload, char *source, char *destination);
+int sendNotification_rbus(char *payload, char *source, char *destination);
 void waitForUpstreamEventSubscribe(int wait_time);
 void trigger_webcfg_forcedsync();
 void registerRbusLogger();
-webcfgError_t fetchMpBlobData(char *docname, void **blobdata, int *len, uint32_t *etag);
+webcfgError_t fetchMpBlobData(char *docname, void **blobdata, int *len, uint32_t *etag, multipartdocs_t **mp_doc);
 bool isRbusInitialized();
 void webpaRbus_Uninit();
 rbusError_t publishSubdocResetEvent(char *subdocName);
+void publishDBChangeEvent(const char *subdocName, uint32_t version, const char *status);
+void set_global_set_batch_size(unsigned int size);
+unsigned int get_global_set_batch_size(void);
 bool get_global_isRbus(void);
 char * webcfgError_ToString(webcfgError_t e);
 rbusValueType_t mapWdmpToRbusDataType(DATA_TYPE wdmpType);
 int mapRbusToCcspStatus(int Rbus_error_code);
 rbusError_t eventSubHandler(rbusHandle_t handle, rbusEventSubAction_t action, const char* eventName, rbusFilter_t filter, int32_t interval, bool* autoPublish);
 rbusError_t resetEventSubHandler(rbusHandle_t handle, rbusEventSubAction_t action, const char* eventName, rbusFilter_t filter, int32_t interval, bool* autoPublish);
+rbusError_t dbChangeEventSubHandler(rbusHandle_t handle, rbusEventSubAction_t action, const char* eventName, rbusFilter_t filter, int32_t interval, bool* autoPublish);
 void rbus_log_handler(rbusLogLevel level, const char* file, int line, int threadId, char* message);
 webcfgError_t checkSubdocInDb(char *docname);
 webcfgError_t resetSubdocVersion(char *docname);
@@ -34,20 +34,38 @@
 #define MIN_MAINTENANCE_TIME		3600					//1hrs in seconds
 #define MAX_MAINTENANCE_TIME		14400					//4hrs in seconds
 #define MAX_RETRY_TIMEOUT               900
+#define SYNC_BACKOFF_THROTTLED_BASE     60					//429 from server
+#define SYNC_BACKOFF_THROTTLED_CAP      3600
+#define SYNC_BACKOFF_SERVER_BASE        BACKOFF_SLEEP_DELAY_SEC			//5xx and transport errors
+#define SYNC_BACKOFF_SERVER_CAP         300
+#define MAX_RETRY_AFTER                 86400
 /*----------------------------------------------------------------------------*/
 /*                               Data Structures                              */
 /*----------------------------------------------------------------------------*/
-/* none */
+typedef enum
+{
+	SYNC_BACKOFF_THROTTLED = 0,
+	SYNC_BACKOFF_SERVER_ERROR,
+	SYNC_BACKOFF_CLASS_MAX
+} sync_backoff_class_t;
 
 /*----------------------------------------------------------------------------*/
 /*                            File Scoped Variables                           */
 /*----------------------------------------------------------------------------*/
 static int g_retry_timer = 900;
-static long g_retry_timestamp = 0;
 static long g_maintenance_time = 0;
+//Last delay per failure class, the next delay is drawn from [base, 3 * last].
+static int g_sync_backoff[SYNC_BACKOFF_CLASS_MAX] = {0};
+static long g_retry_after = 0;
+static long long g_sync_retry_time = 0;
+//Guards the backoff, Retry-After and deferred sync state, set from the sync thread and read by rbus handlers.
+static pthread_mutex_t sync_backoff_mut = PTHREAD_MUTEX_INITIALIZER;
+static long g_sync_window_start = -1;
+static long g_sync_window_end = -1;
 /*----------------------------------------------------------------------------*/
 /*                             Function Prototypes                            */
 /*----------------------------------------------------------------------------*/
+static void setRandomMaintenanceTime(long start_time, long end_time);
 
 /*----------------------------------------------------------------------------*/
 /*                             External Functions                             */
@@ -72,15 +90,6 @@ void set_retry_timer(int value)
 	g_retry_timer = value;
 }
 
-long get_global_retry_timestamp()
-{
-    return g_retry_timestamp;
-}
-
-void set_global_retry_timestamp(long value)
-{
-    g_retry_timestamp = value;
-}
 
 //To print the value in readable format
 char* printTime(long long time)
@@ -98,13 +107,19 @@ char* printTime(long long time)
 //To initialize maintenance random timer
 void initMaintenanceTimer()
 {
-	long time_val = 0;
 	long fw_start_time = 0;
 	long fw_end_time = 0;
-	uint16_t random_key = 0;
 	char *upgrade_start_time = NULL;
 	char *upgrade_end_time = NULL;
 
+	//A window provided by the server takes precedence over the firmware upgrade window
+	if( g_sync_window_start >= 0 && g_sync_window_end >= 0 )
+	{
+		WebcfgInfo("Using server sync window %ld to %ld\n", g_sync_window_start, g_sync_window_end);
+		setRandomMaintenanceTime(g_sync_window_start, g_sync_window_end);
+		return;
+	}
+
 	upgrade_start_time = getFirmwareUpgradeStartTime();
 
 	if( upgrade_start_time != NULL )
@@ -132,33 +147,131 @@ void initMaintenanceTimer()
 		fw_end_time = MAX_MAINTENANCE_TIME;
 	}
 
-	if( fw_start_time == fw_end_time )
+	WebcfgInfo("Firmware Upgrade start time is %ld\n",fw_start_time);
+	WebcfgInfo("Firmware Upgrade end time is %ld\n",fw_end_time);
+	setRandomMaintenanceTime(fw_start_time, fw_end_time);
+}
+
+//Sync window in seconds from local midnight, sent by the server to spread the fleet.
+void set_global_sync_window(long start_time, long end_time)
+{
+	if( start_time < 0 || start_time >= 86400 || end_time < 0 || end_time >= 86400 )
 	{
-		WebcfgDebug("start and end time values are equal\n");
-		fw_start_time = MIN_MAINTENANCE_TIME;
-		fw_end_time = MAX_MAINTENANCE_TIME;
+		WebcfgError("Invalid sync window %ld to %ld, ignored\n", start_time, end_time);
+		return;
 	}
-
-	if( fw_start_time > fw_end_time )
+	if( start_time == g_sync_window_start && end_time == g_sync_window_end )
 	{
-		WebcfgDebug("start time is greater than end time\n");
-		fw_start_time = fw_start_time - 86400;         //to get a time within the day
+		return;
 	}
+	g_sync_window_start = start_time;
+	g_sync_window_end = end_time;
+	WebcfgInfo("Server sync window updated to %ld to %ld\n", start_time, end_time);
+	setRandomMaintenanceTime(start_time, end_time);
+}
 
-        random_key = generateRandomId();
-        time_val = (random_key % (fw_end_time - fw_start_time+ 1)) + fw_start_time;
+void get_global_sync_window(long *start_time, long *end_time)
+{
+	*start_time = g_sync_window_start;
+	*end_time = g_sync_window_end;
+}
 
-	WebcfgInfo("Firmware Upgrade start time is %ld\n",fw_start_time);
-	WebcfgInfo("Firmware Upgrade end time is %ld\n",fw_end_time);
+void set_global_retry_after(long value)
+{
+	pthread_mutex_lock(&sync_backoff_mut);
+	g_retry_after = value;
+	pthread_mutex_unlock(&sync_backoff_mut);
+}
 
-	if( time_val <= 0)
+long get_global_retry_after()
+{
+	long value = 0;
+
+	pthread_mutex_lock(&sync_backoff_mut);
+	value = g_retry_after;
+	pthread_mutex_unlock(&sync_backoff_mut);
+	return value;
+}
+
+void set_global_sync_retry_time(long long value)
+{
+	pthread_mutex_lock(&sync_backoff_mut);
+	g_sync_retry_time = value;
+	pthread_mutex_unlock(&sync_backoff_mut);
+}
+
+long long get_global_sync_retry_time()
+{
+	long long value = 0;
+
+	pthread_mutex_lock(&sync_backoff_mut);
+	value = g_sync_retry_time;
+	pthread_mutex_unlock(&sync_backoff_mut);
+	return value;
+}
+
+//Decorrelated jitter backoff for the class of response_code, never shorter than the server Retry-After.
+int getSyncBackoffSeconds(long response_code)
+{
+	sync_backoff_class_t type = SYNC_BACKOFF_SERVER_ERROR;
+	int base = SYNC_BACKOFF_SERVER_BASE;
+	int cap = SYNC_BACKOFF_SERVER_CAP;
+	int upper = 0;
+	int delay = 0;
+
+	if(response_code == 429)
 	{
-		time_val = time_val + 86400;         //To set a time in next day
+		type = SYNC_BACKOFF_THROTTLED;
+		base = SYNC_BACKOFF_THROTTLED_BASE;
+		cap = SYNC_BACKOFF_THROTTLED_CAP;
 	}
 
-	WebcfgDebug("The value of maintenance_time_val is %ld\n",time_val);
-	set_global_maintenance_time(time_val);
+	//first draw is jittered too, otherwise the fleet retries in lockstep after an outage
+	pthread_mutex_lock(&sync_backoff_mut);
+	upper = ((g_sync_backoff[type] > 0) ? g_sync_backoff[type] : base) * 3;
+	if(upper > cap)
+	{
+		upper = cap;
+	}
+	delay = base + (generateRandomId() % (upper - base + 1));
+	g_sync_backoff[type] = delay;
+
+	if(g_retry_after > delay)
+	{
+		delay = (g_retry_after > MAX_RETRY_AFTER) ? MAX_RETRY_AFTER : g_retry_after;
+	}
+	pthread_mutex_unlock(&sync_backoff_mut);
+	WebcfgInfo("Sync backoff for response_code %ld is %d seconds\n", response_code, delay);
+	return delay;
+}
+
+//Called on a successful sync, clears the backoff state and any deferred sync.
+void resetSyncBackoff()
+{
+	pthread_mutex_lock(&sync_backoff_mut);
+	memset(g_sync_backoff, 0, sizeof(g_sync_backoff));
+	g_retry_after = 0;
+	g_sync_retry_time = 0;
+	pthread_mutex_unlock(&sync_backoff_mut);
+}
+
+//Defers the next primary sync by delay seconds, keeping an earlier one that is already pending.
+//With a server Retry-After the later deadline wins so the server window is honoured.
+void scheduleSyncRetry(int delay)
+{
+	struct timespec ct;
+	long long retry_time = 0;
 
+	clock_gettime(CLOCK_REALTIME, &ct);
+	retry_time = (long long)ct.tv_sec + delay;
+	pthread_mutex_lock(&sync_backoff_mut);
+	if(g_sync_retry_time == 0 || ((g_retry_after > 0) ? (retry_time > g_sync_retry_time) : (retry_time < g_sync_retry_time)))
+	{
+		g_sync_retry_time = retry_time;
+	}
+	retry_time = g_sync_retry_time;
+	pthread_mutex_unlock(&sync_backoff_mut);
+	WebcfgInfo("Deferred sync scheduled at %s\n", printTime(retry_time));
 }
 
 //To Check whether the Maintenance time is at current time
@@ -225,33 +338,6 @@ int getMaintenanceSyncSeconds(int maintenance_count)
 	return maintenance_secs;
 }
 
-//To get the wait seconds for doc retry
-int retrySyncSeconds()
-{
-	struct timespec ct;
-	long retry_secs = 0;
-	long current_time_in_sec = 0;
-	long long current_time = 0;
-	clock_gettime(CLOCK_REALTIME, &ct);
-
-	current_time = ct.tv_sec;
-	current_time_in_sec = getTimeInSeconds(current_time);
-
-	retry_secs =  get_global_retry_timestamp() - current_time_in_sec;
-
-	WebcfgDebug("The current time in retrySyncSeconds is %lld at %s\n",current_time, printTime(current_time));
-	WebcfgDebug("The random timer in retrySyncSeconds is %ld\n",get_global_retry_timestamp());
-
-	if (retry_secs < 0)
-	{
-		retry_secs = 0;
-	}
-
-	WebcfgDebug("The retry Seconds is %ld\n", retry_secs);
-
-	return retry_secs;
-}
-
 //To get the Seconds from Epoch Time
 long getTimeInSeconds(long long time)
 {
@@ -273,31 +359,6 @@ long getTimeInSeconds(long long time)
 	return sec_of_cur_time;
 }
 
-int updateRetryTimeDiff(long long expiry_time)
-{
-	struct timespec ct;
-	int time_diff = 0;
-	long long present_time = 0;
-
-	clock_gettime(CLOCK_REALTIME, &ct);
-	present_time = ct.tv_sec;
-
-	time_diff = expiry_time - present_time;
-
-	//To set the lowest retry timeout of all the docs
-	if(get_retry_timer() > time_diff)
-	{
-		set_retry_timer(time_diff);
-		set_global_retry_timestamp(getTimeInSeconds(expiry_time));
-		WebcfgDebug("The retry_timer is %d after set\n", get_retry_timer());
-	}
-	if(get_global_retry_timestamp() == 0)
-	{
-		set_global_retry_timestamp(getTimeInSeconds(present_time+900));
-	}
-	return time_diff;
-}
-
 //To set the retry_timestamp to 15 min from current time
 long long getRetryExpiryTimeout()
 {
@@ -334,3 +395,37 @@ int checkRetryTimer( long long timestamp)
 	}
 	return 0;
 }
+
+/*----------------------------------------------------------------------------*/
+/*                             Internal functions                             */
+/*----------------------------------------------------------------------------*/
+//Picks a random second of the day in [start_time, end_time] as the maintenance sync time.
+static void setRandomMaintenanceTime(long start_time, long end_time)
+{
+	long time_val = 0;
+	uint16_t random_key = 0;
+
+	if( start_time == end_time )
+	{
+		WebcfgDebug("start and end time values are equal\n");
+		start_time = MIN_MAINTENANCE_TIME;
+		end_time = MAX_MAINTENANCE_TIME;
+	}
+
+	if( start_time > end_time )
+	{
+		WebcfgDebug("start time is greater than end time\n");
+		start_time = start_time - 86400;         //to get a time within the day
+	}
+
+        random_key = generateRandomId();
+        time_val = (random_key % (end_time - start_time+ 1)) + start_time;
+
+	if( time_val <= 0)
+	{
+		time_val = time_val + 86400;         //To set a time in next day
+	}
+
+	WebcfgDebug("The value of maintenance_time_val is %ld\n",time_val);
+	set_global_maintenance_time(time_val);
+}
@@ -35,13 +35,18 @@ void set_retry_timer(int value);
 int get_retry_timer();
 int checkMaintenanceTimer();
 int getMaintenanceSyncSeconds(int maintenance_count);
-int retrySyncSeconds();
 long getTimeInSeconds(long long time);
 void set_global_maintenance_time(long value);
 long get_global_maintenance_time();
-void set_global_retry_timestamp(long value);
-long get_global_retry_timestamp();
-int updateRetryTimeDiff(long long expiry_time);
 int checkRetryTimer( long long timestamp);
 long long getRetryExpiryTimeout();
+void set_global_sync_window(long start_time, long end_time);
+void get_global_sync_window(long *start_time, long *end_time);
+void set_global_retry_after(long value);
+long get_global_retry_after();
+void set_global_sync_retry_time(long long value);
+long long get_global_sync_retry_time();
+int getSyncBackoffSeconds(long response_code);
+void resetSyncBackoff();
+void scheduleSyncRetry(int delay);
 #endif
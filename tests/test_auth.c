@@ -209,6 +209,57 @@ void test_getAuthToken_error()
     remove(WEBPA_READ_HEADER);
 }
 
+static void writeTokenScript(const char *name, const char *output)
+{
+    FILE *testFile = fopen(name, "w");
+
+    CU_ASSERT_PTR_NOT_NULL(testFile);
+
+    if (testFile != NULL) {
+        fprintf(testFile, "#!/bin/bash\n");
+        fprintf(testFile, "echo -n %s", output);
+        fclose(testFile);
+
+        chmod(name, S_IRWXU);
+    }
+}
+
+void test_getAuthToken_cached()
+{
+    //exp claims are 4102444800 and 1000000000
+    char *validToken = "eyJhbGciOiJub25lIn0.eyJleHAiOjQxMDI0NDQ4MDAsInN1YiI6ImNwIn0.sig";
+    char *expiredToken = "eyJhbGciOiJub25lIn0.eyJleHAiOjEwMDAwMDAwMDB9.sig";
+
+    serialNumber = strdup("1234");
+    deviceMac = strdup("b42xxxxxxxxx");
+    writeTokenScript(WEBPA_CREATE_HEADER, "SUCCESS");
+    writeTokenScript(WEBPA_READ_HEADER, validToken);
+
+    //Rejected token is replaced through the create script
+    invalidateAuthToken();
+    getAuthToken();
+    CU_ASSERT_STRING_EQUAL(get_global_auth_token(), validToken);
+    CU_ASSERT_EQUAL(get_global_auth_token_expiry(), 4102444800);
+
+    //Token is valid, read script is not run again
+    writeTokenScript(WEBPA_READ_HEADER, "newtoken");
+    getAuthToken();
+    CU_ASSERT_STRING_EQUAL(get_global_auth_token(), validToken);
+
+    //Expired token is read again on every fetch
+    writeTokenScript(WEBPA_READ_HEADER, expiredToken);
+    invalidateAuthToken();
+    getAuthToken();
+    CU_ASSERT_STRING_EQUAL(get_global_auth_token(), expiredToken);
+    writeTokenScript(WEBPA_READ_HEADER, "newtoken");
+    getAuthToken();
+    CU_ASSERT_STRING_EQUAL(get_global_auth_token(), "newtoken");
+    CU_ASSERT_TRUE(get_global_auth_token_expiry() > 0);
+
+    remove(WEBPA_CREATE_HEADER);
+    remove(WEBPA_READ_HEADER);
+}
+
 void add_suites( CU_pSuite *suite )
 {
     *suite = CU_add_suite( "tests", NULL, NULL );
@@ -217,6 +268,7 @@ void add_suites( CU_pSuite *suite )
     CU_add_test( *suite, "test getAuthToken_no_file", test_getAuthToken_no_file);
     CU_add_test( *suite, "test getAuthToken_failue", test_getAuthToken_failure);
     CU_add_test( *suite, "test getAuthToken_error", test_getAuthToken_error);
+    CU_add_test( *suite, "test getAuthToken_cached", test_getAuthToken_cached);
 }
 
 int main( int argc, char *argv[] )
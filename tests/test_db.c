@@ -70,6 +70,16 @@ pthread_mutex_t *get_global_event_mut(void)
     return 0;
 }
 
+pthread_cond_t *get_global_expire_timer_con(void)
+{
+    return 0;
+}
+
+pthread_mutex_t *get_global_expire_timer_mut(void)
+{
+    return 0;
+}
+
 void retryMultipartSubdoc(){
 	return ;
 }
@@ -96,10 +106,11 @@ void test_blobPackUnpack(){
 	webcfgdb->next=NULL;
 	//temp data
 	webcfgtemp=(webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(webcfgtemp, 0, sizeof(webconfig_tmp_data_t));
 	webcfgtemp->name = strdup("wan");
 	webcfgtemp->version = 410448631;
-	webcfgtemp->status = strdup("pending");
-	webcfgtemp->error_details = strdup("none");
+	webcfgtemp->status = TMP_STATUS_PENDING;
+	webcfgtemp->error_details = "none";
 	webcfgtemp->error_code = 0;
 	webcfgtemp->trans_id = 0;
 	webcfgtemp->retry_count = 0;
@@ -49,13 +49,14 @@ char * getConnClientParamName()
 void test_eventACK()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("privatessid");
 	tmpData->version = 410448631;
-	tmpData->status = strdup("ACK");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -71,13 +72,14 @@ void test_eventACK()
 void test_invalidVersionACK()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("privatessid");
 	tmpData->version = 4210448631;
-	tmpData->status = strdup("ACK");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -91,8 +93,6 @@ void test_invalidVersionACK()
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData->cloud_trans_id);
 		WEBCFG_FREE(tmpData);
 	}
@@ -104,13 +104,14 @@ homessid,14464,410448631,ACK,60 (Timeout event)
 void test_eventTimeout()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("homessid");
 	tmpData->version = 410448631;
-	tmpData->status = strdup("ACK");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -124,8 +125,6 @@ void test_eventTimeout()
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData->cloud_trans_id);
 		WEBCFG_FREE(tmpData);
 	}
@@ -134,13 +133,14 @@ void test_eventTimeout()
 void test_invalidVersionTimeout()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("privatessid");
 	tmpData->version = 4210448631;
-	tmpData->status = strdup("ACK");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -154,8 +154,6 @@ void test_invalidVersionTimeout()
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData->cloud_trans_id);
 		WEBCFG_FREE(tmpData);
 	}
@@ -165,13 +163,14 @@ void test_invalidVersionTimeout()
 void test_eventNACK()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("portforwarding");
 	tmpData->version = 410448631;
-	tmpData->status = strdup("NACK");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -186,8 +185,6 @@ void test_eventNACK()
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData->cloud_trans_id);
 		WEBCFG_FREE(tmpData);
 	}
@@ -196,13 +193,14 @@ void test_eventNACK()
 void test_invalidVersionNACK()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("privatessid");
 	tmpData->version = 4210448631;
-	tmpData->status = strdup("NACK");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -216,8 +214,6 @@ void test_invalidVersionNACK()
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData->cloud_trans_id);
 		WEBCFG_FREE(tmpData);
 	}
@@ -227,19 +223,21 @@ void test_invalidVersionNACK()
 void test_eventEXPIRE()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("portforwarding");
 	tmpData->version = 0;
-	tmpData->status = strdup("EXPIRE");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
 	tmpData->next = NULL;
 
 	multipartdocs_t *multipartdocs = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
+	multipartdocs->refcount = 1;
 	multipartdocs->name_space = strdup("portforwarding");
 	multipartdocs->data = (char* )malloc(64);
 	multipartdocs->isSupplementarySync = 0;
@@ -277,13 +275,14 @@ void test_eventEXPIRE()
 void test_eventEXPIREWithoutRetry()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("homessid");
 	tmpData->version = 0;
-	tmpData->status = strdup("EXPIRE");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -299,8 +298,6 @@ void test_eventEXPIREWithoutRetry()
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData->cloud_trans_id);
 		WEBCFG_FREE(tmpData);
 	}
@@ -310,13 +307,14 @@ void test_eventEXPIREWithoutRetry()
 void test_eventCrash()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("privatessid");
 	tmpData->version = 3097089542;
-	tmpData->status = strdup("CRASH");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("crash");
+	tmpData->error_details = "crash";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -332,19 +330,21 @@ void test_eventCrash()
 void test_eventCrashNewVersion()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("privatessid");
 	tmpData->version = 3097089542;
-	tmpData->status = strdup("CRASH");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("crash");
+	tmpData->error_details = "crash";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
 	tmpData->next = NULL;
 
 	multipartdocs_t *multipartdocs = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
+	multipartdocs->refcount = 1;
 	multipartdocs->name_space = strdup("privatessid");
 	multipartdocs->data = (char *)malloc(64);
 	multipartdocs->isSupplementarySync = 0;
@@ -381,13 +381,14 @@ void test_eventCrashNewVersion()
 void test_eventCrashNewVersionWithoutRetry()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("homessid");
 	tmpData->version = 3097089542;
-	tmpData->status = strdup("CRASH");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("crash");
+	tmpData->error_details = "crash";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -401,8 +402,6 @@ void test_eventCrashNewVersionWithoutRetry()
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData->cloud_trans_id);
 		WEBCFG_FREE(tmpData);
 
@@ -412,19 +411,21 @@ void test_eventCrashNewVersionWithoutRetry()
 void test_eventCrashSameVersion()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("portforwarding");
 	tmpData->version = 3097089542;
-	tmpData->status = strdup("CRASH");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("crash");
+	tmpData->error_details = "crash";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
 	tmpData->next = NULL;
 
 	multipartdocs_t *multipartdocs = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
+	multipartdocs->refcount = 1;
 	multipartdocs->name_space = strdup("portforwarding");
 	multipartdocs->data = (char *)malloc(64);
 	multipartdocs->isSupplementarySync = 0;
@@ -461,13 +462,14 @@ void test_eventCrashSameVersion()
 void test_eventCrashSameVersionWithoutRetry()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("privatessid");
 	tmpData->version = 3097089542;
-	tmpData->status = strdup("CRASH");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("crash");
+	tmpData->error_details = "crash";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -482,8 +484,6 @@ void test_eventCrashSameVersionWithoutRetry()
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData->cloud_trans_id);
 		WEBCFG_FREE(tmpData);
 	}
@@ -492,13 +492,14 @@ void test_eventCrashSameVersionWithoutRetry()
 void test_eventCrashLatestVersion()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("privatessid");
 	tmpData->version = 12345;
-	tmpData->status = strdup("CRASH");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("crash");
+	tmpData->error_details = "crash";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -513,8 +514,6 @@ void test_eventCrashLatestVersion()
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData->cloud_trans_id);
 		WEBCFG_FREE(tmpData);
 	}
@@ -523,13 +522,14 @@ void test_eventCrashLatestVersion()
 void err_invalidACK()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("privatessid");
 	tmpData->version = 4210448631;
-	tmpData->status = strdup("ACK");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 1464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -543,8 +543,6 @@ void err_invalidACK()
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData->cloud_trans_id);
 		WEBCFG_FREE(tmpData);
 	}
@@ -555,13 +553,14 @@ void err_invalidACK()
 void test_eventACKEnabled()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("mesh");
 	tmpData->version = 410448631;
-	tmpData->status = strdup("ACK;enabled");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -578,13 +577,14 @@ void test_eventACKEnabled()
 void test_eventACKDisabled()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("mesh");
 	tmpData->version = 410448631;
-	tmpData->status = strdup("ACK;disabled");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 1234;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -601,13 +601,14 @@ void test_eventACKDisabled()
 void test_adveventACKEnabled()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("advsecurity");
 	tmpData->version = 410448631;
-	tmpData->status = strdup("ACK;enabled");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -624,13 +625,14 @@ void test_adveventACKEnabled()
 void test_adveventACKDisabled()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("advsecurity");
 	tmpData->version = 410448631;
-	tmpData->status = strdup("ACK;disabled");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=0;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -43,13 +43,14 @@ int numLoops;
 void test_eventACK()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("telemetry");
 	tmpData->version = 410448631;
-	tmpData->status = strdup("ACK");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=1;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -69,13 +70,14 @@ homessid,14464,410448631,ACK,60 (Timeout event)
 void test_eventTimeout()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("telemetry");
 	tmpData->version = 410448631;
-	tmpData->status = strdup("ACK");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=1;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -89,8 +91,6 @@ void test_eventTimeout()
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData->cloud_trans_id);
 		WEBCFG_FREE(tmpData);
 	}
@@ -102,13 +102,14 @@ void test_eventTimeout()
 void test_eventNACK()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("telemetry");
 	tmpData->version = 410448631;
-	tmpData->status = strdup("NACK");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=1;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -123,8 +124,6 @@ void test_eventNACK()
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData->cloud_trans_id);
 		WEBCFG_FREE(tmpData);
 	}
@@ -135,13 +134,14 @@ void test_eventNACK()
 void test_eventEXPIRE()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("telemetry");
 	tmpData->version = 0;
-	tmpData->status = strdup("EXPIRE");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=1;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -149,6 +149,7 @@ void test_eventEXPIRE()
 
 
 	multipartdocs_t *multipartdocs = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
+	multipartdocs->refcount = 1;
 	multipartdocs->name_space = strdup("telemetry");
 	multipartdocs->data = (char *)malloc(64);
 	multipartdocs->isSupplementarySync = 1;
@@ -189,13 +190,14 @@ void test_eventEXPIRE()
 void test_eventCrash()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("telemetry");
 	tmpData->version = 3097089542;
-	tmpData->status = strdup("CRASH");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("crash");
+	tmpData->error_details = "crash";
 	tmpData->isSupplementarySync=1;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -211,13 +213,14 @@ void test_eventCrash()
 void test_eventCrashNewVersion()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("telemetry");
 	tmpData->version = 3097089542;
-	tmpData->status = strdup("CRASH");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("crash");
+	tmpData->error_details = "crash";
 	
 	tmpData->isSupplementarySync=1;
 	tmpData->retry_timestamp=0;
@@ -225,6 +228,7 @@ void test_eventCrashNewVersion()
 	tmpData->next = NULL;
 	
 	multipartdocs_t *multipartdocs = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
+	multipartdocs->refcount = 1;
 	multipartdocs->name_space = strdup("telemetry");
 	multipartdocs->data = (char*)malloc(64);
 	multipartdocs->isSupplementarySync = 1;
@@ -263,19 +267,21 @@ void test_eventCrashNewVersion()
 void test_eventCrashSameVersion()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("telemetry");
 	tmpData->version = 3097089542;
-	tmpData->status = strdup("CRASH");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("crash");
+	tmpData->error_details = "crash";
 	tmpData->isSupplementarySync=1;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
 	tmpData->next = NULL;
 
 	multipartdocs_t *multipartdocs = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
+	multipartdocs->refcount = 1;
 	multipartdocs->name_space = strdup("telemetry");
 	multipartdocs->data = (char *)malloc(64);
 	multipartdocs->isSupplementarySync = 1;
@@ -313,13 +319,14 @@ void test_eventCrashSameVersion()
 void err_invalidACK()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("telemetry");
 	tmpData->version = 4210448631;
-	tmpData->status = strdup("ACK");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 1464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=1;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("a2b3c4d5e6f");
@@ -333,8 +340,6 @@ void err_invalidACK()
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData->cloud_trans_id);
 		WEBCFG_FREE(tmpData);
 	}
@@ -346,13 +351,14 @@ void err_invalidACK()
 void test_adveventACKEnabled()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("advsecurity");
 	tmpData->version = 410448631;
-	tmpData->status = strdup("ACK;enabled");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=1;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
@@ -369,13 +375,14 @@ void test_adveventACKEnabled()
 void test_adveventACKDisabled()
 {
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("advsecurity");
 	tmpData->version = 410448631;
-	tmpData->status = strdup("ACK;disabled");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("success");
+	tmpData->error_details = "success";
 	tmpData->isSupplementarySync=1;
 	tmpData->retry_timestamp=0;
 	tmpData->cloud_trans_id=strdup("abcdef");
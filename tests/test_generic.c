@@ -45,11 +45,12 @@ void setValues_rbus(const param_t paramVal[], const unsigned int paramCount, con
     UNUSED(retStatus);
     UNUSED(ccspRetStatus);
 }
-void sendNotification_rbus(char *payload, char *source, char *destination)
+int sendNotification_rbus(char *payload, char *source, char *destination)
 {
     UNUSED(payload);
     UNUSED(source);
     UNUSED(destination);
+    return 1;
 }
 
 #ifdef WEBCONFIG_BIN_SUPPORT
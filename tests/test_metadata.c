@@ -26,6 +26,17 @@
 /*----------------------------------------------------------------------------*/
 /*                             Mock Functions                             */
 /*----------------------------------------------------------------------------*/
+static unsigned int notify_batch_window = 0;
+
+void set_global_notify_batch_window(unsigned int window_ms)
+{
+    notify_batch_window = window_ms;
+}
+
+void resetSupportedHeaders(void)
+{
+}
+
 void webcfgStrncpy(char *destStr, const char *srcStr, size_t destSize)
 {
     strncpy(destStr, srcStr, destSize-1);
@@ -436,6 +447,112 @@ SubDocSupportMap_t *test = NULL;
 	CU_ASSERT_EQUAL(0,result);
 }
 #endif
+void test_getSubDocMeta(void)
+{
+	SubDocMeta_t meta;
+	SubDocSupportMap_t docs[3];
+	SupplementaryDocs_t sp[2];
+
+	memset(docs, 0, sizeof(docs));
+	strcpy(docs[0].name,"homessid");
+	strcpy(docs[0].support,"true");
+	strcpy(docs[1].name,"radio");
+	strcpy(docs[1].support,"false");
+	//Duplicate entry, the first one is used
+	strcpy(docs[2].name,"homessid");
+	strcpy(docs[2].support,"false");
+	#ifdef WEBCONFIG_BIN_SUPPORT
+	strcpy(docs[0].rbus_listener,"true");
+	strcpy(docs[0].dest,"webconfig.pam.portforwarding");
+	strcpy(docs[1].rbus_listener,"false");
+	#endif
+	docs[0].next = &docs[1];
+	docs[1].next = &docs[2];
+	set_global_sdInfoHead(docs);
+	set_global_sdInfoTail(&docs[2]);
+
+	CU_ASSERT_EQUAL(WEBCFG_SUCCESS, getSubDocMeta("homessid", &meta));
+	CU_ASSERT_TRUE(meta.supported);
+	#ifdef WEBCONFIG_BIN_SUPPORT
+	CU_ASSERT_TRUE(meta.rbus_listener);
+	CU_ASSERT_STRING_EQUAL("webconfig.pam.portforwarding", meta.dest);
+	#endif
+	CU_ASSERT_EQUAL(WEBCFG_SUCCESS, getSubDocMeta("radio", &meta));
+	CU_ASSERT_FALSE(meta.supported);
+	CU_ASSERT_EQUAL(WEBCFG_FAILURE, isSubDocSupported("radio"));
+	//Lookups match the whole name
+	CU_ASSERT_EQUAL(WEBCFG_FAILURE, getSubDocMeta("home", &meta));
+	CU_ASSERT_EQUAL(WEBCFG_FAILURE, getSubDocMeta("wan", &meta));
+
+	//Index follows list updates
+	strcpy(docs[1].support,"true");
+	set_global_sdInfoHead(docs);
+	CU_ASSERT_EQUAL(WEBCFG_SUCCESS, isSubDocSupported("radio"));
+	set_global_sdInfoHead(NULL);
+	set_global_sdInfoTail(NULL);
+	CU_ASSERT_EQUAL(WEBCFG_FAILURE, getSubDocMeta("homessid", &meta));
+
+	sp[0].name = "moca";
+	sp[0].next = &sp[1];
+	sp[1].name = "mesh";
+	sp[1].next = NULL;
+	set_global_spInfoHead(sp);
+	set_global_spInfoTail(&sp[1]);
+	CU_ASSERT_EQUAL(WEBCFG_SUCCESS, isSupplementaryDoc("moca"));
+	CU_ASSERT_EQUAL(WEBCFG_SUCCESS, isSupplementaryDoc("mesh"));
+	CU_ASSERT_EQUAL(WEBCFG_FAILURE, isSupplementaryDoc("wifi"));
+	set_global_spInfoHead(NULL);
+	set_global_spInfoTail(NULL);
+}
+
+void test_reloadWebcfgProperties(void)
+{
+	char buf[512] = {'\0'};
+	int out = 0;
+
+	snprintf(buf,sizeof(buf),"WEBCONFIG_SUPPORTED_DOCS_BIT=00000001000000000000000000000001\nWEBCONFIG_SUBDOC_MAP=privatessid:1:true,radio:3:false\nWEBCONFIG_SUPPLEMENTARY_DOCS=telemetry\n");
+	out = writeToFile(WEBCFG_PROPERTIES_FILE, buf, strlen(buf));
+	CU_ASSERT_EQUAL(out, 1);
+	CU_ASSERT_EQUAL(WEBCFG_SUCCESS, reloadWebcfgProperties(WEBCFG_PROPERTIES_FILE));
+	CU_ASSERT_STRING_EQUAL("00000001000000000000000000000001", getsupportedDocs());
+	CU_ASSERT_EQUAL(WEBCFG_SUCCESS, isSubDocSupported("privatessid"));
+	CU_ASSERT_EQUAL(WEBCFG_FAILURE, isSubDocSupported("radio"));
+	CU_ASSERT_EQUAL(WEBCFG_SUCCESS, isSupplementaryDoc("telemetry"));
+
+	//Copies taken before a reload outlive the table they came from
+	char *docs = copysupportedDocs();
+	SupplementaryDocs_t *spList = copySupplementaryDocsList();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(docs);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(spList);
+	CU_ASSERT_PTR_NOT_EQUAL(spList, get_global_spInfoHead());
+
+	//The new file replaces the previous table, its tunables apply with it
+	notify_batch_window = 0;
+	snprintf(buf,sizeof(buf),"WEBCONFIG_SUPPORTED_DOCS_BIT=00000000000000000000000000000011\nWEBCONFIG_SUBDOC_MAP=privatessid:1:false,radio:3:true\nWEBCONFIG_NOTIFY_BATCH_WINDOW_MS=250\n");
+	out = writeToFile(WEBCFG_PROPERTIES_FILE, buf, strlen(buf));
+	CU_ASSERT_EQUAL(out, 1);
+	CU_ASSERT_EQUAL(WEBCFG_SUCCESS, reloadWebcfgProperties(WEBCFG_PROPERTIES_FILE));
+	CU_ASSERT_EQUAL(250, notify_batch_window);
+	CU_ASSERT_STRING_EQUAL("00000001000000000000000000000001", docs);
+	CU_ASSERT_STRING_EQUAL("telemetry", spList->name);
+	CU_ASSERT_PTR_NULL(spList->next);
+	WEBCFG_FREE(docs);
+	freeSupplementaryDocsList(spList);
+	CU_ASSERT_STRING_EQUAL("00000000000000000000000000000011", getsupportedDocs());
+	CU_ASSERT_EQUAL(WEBCFG_FAILURE, isSubDocSupported("privatessid"));
+	CU_ASSERT_EQUAL(WEBCFG_SUCCESS, isSubDocSupported("radio"));
+	CU_ASSERT_EQUAL(WEBCFG_FAILURE, isSupplementaryDoc("telemetry"));
+	CU_ASSERT_PTR_NULL(get_global_spInfoHead());
+
+	//A missing file keeps the current table and tunables
+	remove(WEBCFG_PROPERTIES_FILE);
+	notify_batch_window = 0;
+	CU_ASSERT_EQUAL(WEBCFG_FAILURE, reloadWebcfgProperties(WEBCFG_PROPERTIES_FILE));
+	CU_ASSERT_EQUAL(0, notify_batch_window);
+	CU_ASSERT_EQUAL(WEBCFG_SUCCESS, isSubDocSupported("radio"));
+	CU_ASSERT_STRING_EQUAL("00000000000000000000000000000011", getsupportedDocs());
+}
+
 void add_suites( CU_pSuite *suite )
 {
     *suite = CU_add_suite( "tests", NULL, NULL );
@@ -449,6 +566,8 @@ void add_suites( CU_pSuite *suite )
 	CU_add_test( *suite, "Test isSupplementaryDoc\n", test_isSupplementaryDoc);
 	CU_add_test( *suite, "Test get_spInfoHead\n", test_get_spInfoHead);
 	CU_add_test( *suite, "Test get_spInfoTail\n", test_get_spInfotail);
+	CU_add_test( *suite, "Test getSubDocMeta\n", test_getSubDocMeta);
+	CU_add_test( *suite, "Test reloadWebcfgProperties\n", test_reloadWebcfgProperties);
 	CU_add_test( *suite, "Test displaystruct\n", test_displaystruct);
 #ifdef WEBCONFIG_BIN_SUPPORT	
 	CU_add_test( *suite, "Test get_destination\n", test_get_destination);
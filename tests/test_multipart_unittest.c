@@ -613,13 +613,14 @@ void test_validateParam()
 
 void test_checkRootUpdate(){
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("wan");
 	tmpData->version = 410448631;
-	tmpData->status = strdup("success");
+	tmpData->status = TMP_STATUS_SUCCESS;
 	tmpData->trans_id = 14464;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("none");
+	tmpData->error_details = "none";
 	tmpData->next = NULL;
 	set_global_tmp_node(tmpData);
 	int m=checkRootUpdate();
@@ -627,8 +628,6 @@ void test_checkRootUpdate(){
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData);
 	}
 }
@@ -730,13 +729,14 @@ void test_akerWait(){
 
 void test_checkRootDelete(){
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("moca");
 	tmpData->version = 1234;
-	tmpData->status = strdup("success");
+	tmpData->status = TMP_STATUS_SUCCESS;
 	tmpData->trans_id = 4104;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("none");
+	tmpData->error_details = "none";
 	tmpData->next = NULL;
 	set_global_tmp_node(tmpData);
 	int m=checkRootDelete();
@@ -744,8 +744,6 @@ void test_checkRootDelete(){
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData);
 	}
 
@@ -753,13 +751,14 @@ void test_checkRootDelete(){
 
 void test_checkRootDeleteFailure(){
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("privatessid");
 	tmpData->version = 1234;
-	tmpData->status = strdup("pending");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 4104;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("failed");
+	tmpData->error_details = "failed";
 	tmpData->next = NULL;
 	set_global_tmp_node(tmpData);
 	int m=checkRootDelete();
@@ -767,20 +766,19 @@ void test_checkRootDeleteFailure(){
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData);
 	}
 }
 void test_updateRootVersionToDB(){
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("root");
 	tmpData->version = 232323;
-	tmpData->status = strdup("pending");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 4104;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("none");
+	tmpData->error_details = "none";
 	tmpData->cloud_trans_id = NULL;
 	tmpData->next = NULL;
 	set_global_tmp_node(tmpData);
@@ -790,8 +788,6 @@ void test_updateRootVersionToDB(){
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData);
 	}
 
@@ -799,13 +795,14 @@ void test_updateRootVersionToDB(){
 
 void test_updateRootVersionToDBNoroot(){
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("wan");
 	tmpData->version = 232323;
-	tmpData->status = strdup("pending");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 4104;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("none");
+	tmpData->error_details = "none";
 	tmpData->next = NULL;
 	set_global_tmp_node(tmpData);
 	set_global_ETAG("123");
@@ -814,8 +811,6 @@ void test_updateRootVersionToDBNoroot(){
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData);
 	}
 
@@ -876,21 +871,20 @@ void test_get_global_interface(){
 #endif
 void test_print_tmp_doc_list(){
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("wan");
 	tmpData->version = 232323;
-	tmpData->status = strdup("pending");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 4104;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("none");
+	tmpData->error_details = "none";
 	tmpData->next = NULL;
 	int m=print_tmp_doc_list(1);
 	CU_ASSERT_EQUAL(0,m);
 	if(tmpData)
 	{
 		WEBCFG_FREE(tmpData->name);
-		WEBCFG_FREE(tmpData->status);
-		WEBCFG_FREE(tmpData->error_details);
 		WEBCFG_FREE(tmpData);
 	}
 
@@ -901,6 +895,7 @@ void test_get_global_mp_null(){
 
 void test_get_global_mp(){
 	multipartdocs_t *multipartdocs = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
+	multipartdocs->refcount = 1;
 	multipartdocs->name_space = strdup("portforwarding");
 	multipartdocs->data = (char* )malloc(64);
 	multipartdocs->isSupplementarySync = 0;
@@ -919,6 +914,7 @@ void test_get_global_mp(){
 
 void test_deleteRootAndMultipartDocs(){
 	multipartdocs_t *multipartdocs = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
+	multipartdocs->refcount = 1;
 	multipartdocs->name_space = strdup("moca");
 	multipartdocs->data = (char* )malloc(64);
 	multipartdocs->isSupplementarySync = 0;
@@ -926,13 +922,14 @@ void test_deleteRootAndMultipartDocs(){
 	set_global_mp(multipartdocs);
 	CU_ASSERT_FATAL( NULL !=get_global_mp());
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("moca");
 	tmpData->version = 1234;
-	tmpData->status = strdup("success");
+	tmpData->status = TMP_STATUS_SUCCESS;
 	tmpData->trans_id = 4104;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("none");
+	tmpData->error_details = "none";
 	tmpData->cloud_trans_id = NULL;
 	tmpData->next = NULL;
 	set_global_tmp_node(tmpData);
@@ -944,6 +941,7 @@ void test_deleteRootAndMultipartDocs(){
 
 void test_deleteRootAndMultipartDocs_fail(){
 	multipartdocs_t *multipartdocs = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
+	multipartdocs->refcount = 1;
 	multipartdocs->name_space = strdup("wan");
 	multipartdocs->data = (char* )malloc(64);
 	multipartdocs->isSupplementarySync = 0;
@@ -951,13 +949,14 @@ void test_deleteRootAndMultipartDocs_fail(){
 	set_global_mp(multipartdocs);
 	CU_ASSERT_FATAL( NULL !=get_global_mp());
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("wan");
 	tmpData->version = 3456;
-	tmpData->status = strdup("pending");
+	tmpData->status = TMP_STATUS_PENDING;
 	tmpData->trans_id = 1231;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 0;
-	tmpData->error_details = strdup("failed");
+	tmpData->error_details = "failed";
 	tmpData->next = NULL;
 	set_global_tmp_node(tmpData);
 	int m=deleteRootAndMultipartDocs();
@@ -968,6 +967,7 @@ void test_deleteRootAndMultipartDocs_fail(){
 
 void test_deleteFromMpList(){
 	multipartdocs_t *multipartdocs = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
+	multipartdocs->refcount = 1;
 	multipartdocs->name_space = strdup("wan");
 	multipartdocs->data = (char* )malloc(64);
 	multipartdocs->isSupplementarySync = 0;
@@ -980,6 +980,7 @@ void test_deleteFromMpList(){
 
 void test_deleteFromMpListFailure(){
 	multipartdocs_t *multipartdocs = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
+	multipartdocs->refcount = 1;
 	multipartdocs->name_space = strdup("wan");
 	multipartdocs->data = (char* )malloc(64);
 	multipartdocs->isSupplementarySync = 0;
@@ -992,6 +993,7 @@ void test_deleteFromMpListFailure(){
 
 void test_deleteFromMpListInvalidDoc(){
 	multipartdocs_t *multipartdocs = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
+	multipartdocs->refcount = 1;
 	multipartdocs->name_space = strdup("wan");
 	multipartdocs->data = (char* )malloc(64);
 	multipartdocs->isSupplementarySync = 0;
@@ -1055,6 +1057,26 @@ void test_parseMultipartDocument_ValidBoundary() {
     } 
 }
 
+//MQTT hands over only the body after the envelope, the whole buffer is still freed by the parser
+void test_parseMultipartBody() {
+    WEBCFG_STATUS result;
+	const char config_data[] = "HTTP 200 OK\r\nContent-Type: multipart/mixed; boundary=+CeB5yCWds7LeVP4oibmKefQ091Vpt2x4g99cJfDCmXpFxt5d\r\nEtag: 345431215\r\n\n--+CeB5yCWds7LeVP4oibmKefQ091Vpt2x4g99cJfDCmXpFxt5d\r\nContent-type: application/msgpack\r\nEtag: 2132354\r\nNamespace: value\r\n\r\nparameter: somedata\r\n--+CeB5yCWds7LeVP4oibmKefQ091Vpt2x4g99cJfDCmXpFxt5d--\r\n";
+    size_t data_size = strlen(config_data);
+    char ct[] = "Content-Type: multipart/mixed; boundary=+CeB5yCWds7LeVP4oibmKefQ091Vpt2x4g99cJfDCmXpFxt5d";
+    char *trans_uuid = strdup("1234");
+    char *config_data_copy = (char *)malloc(data_size + 1);
+    char *body = NULL;
+
+    if (config_data_copy != NULL) {
+        strcpy(config_data_copy, config_data);
+        body = strstr(config_data_copy, "\n--") + 1;
+        result = parseMultipartBody(config_data_copy, body, data_size - (body - config_data_copy), ct, trans_uuid);
+        CU_ASSERT_EQUAL(result, WEBCFG_FAILURE);
+    } else {
+        CU_FAIL("Memory allocation for config_data_copy (body) failed");
+    }
+}
+
 void test_parseMultipartDocument_InvalidBoundary() {
     WEBCFG_STATUS result;
     const char config_data[] = "HTTP 200 OK\nContent-Type: multipart/mixed; boundary=\nEtag: 345431215\n\n--\nContent-type: application/msgpack\nEtag: 2132354\nNamespace: value\nparameter: somedata\n--";
@@ -1096,6 +1118,7 @@ void test_loadInitURLFromFile()
 void test_failedDocsRetry()
 {
 	multipartdocs_t *multipartdocs = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
+	multipartdocs->refcount = 1;
 	multipartdocs->name_space = strdup("moca");
 	multipartdocs->data = (char* )malloc(64);
 	multipartdocs->isSupplementarySync = 0;
@@ -1103,25 +1126,34 @@ void test_failedDocsRetry()
 	set_global_mp(multipartdocs);
 	//checkRetryTimer returns true
 	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
 	tmpData->name = strdup("moca");
 	tmpData->version = 1234;
-	tmpData->status = strdup("success");
+	tmpData->status = TMP_STATUS_SUCCESS;
 	tmpData->trans_id = 4104;
 	tmpData->retry_count = 0;
 	tmpData->error_code = 192;
-	tmpData->error_details = strdup("none");
-	tmpData->retry_timestamp = 1;
+	tmpData->error_details = "none";
+	tmpData->retry_timestamp = 0;
 	tmpData->cloud_trans_id = strdup("abc123");
 	tmpData->next = NULL;
 	set_global_tmp_node(tmpData);
+	updateFailureTimeStamp(tmpData, "moca", 1);
+	CU_ASSERT_EQUAL(1, getNextRetryDeadline());
 
-	//subdoc set fails
+	//due entry is popped and the subdoc retried
 	failedDocsRetry();
 	CU_ASSERT_STRING_EQUAL("moca",tmpData->name);
+	CU_ASSERT_EQUAL(0, getNextRetryDeadline());
 
-	//retry skip
+	//superseded deadline is dropped, the later one stays queued
+	updateFailureTimeStamp(tmpData, "moca", 2);
+	updateFailureTimeStamp(tmpData, "moca", getRetryExpiryTimeout());
 	failedDocsRetry();
+	CU_ASSERT_EQUAL(tmpData->retry_timestamp, getNextRetryDeadline());
 	CU_ASSERT_PTR_NOT_NULL(tmpData->error_details);
+	deleteRetryQueue();
+	CU_ASSERT_EQUAL(0, getNextRetryDeadline());
 
 }
 
@@ -1374,6 +1406,7 @@ void test_processMsgpackSubdoc_msgpack_failure()
 		multipartdocs_t *node = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
 		if (node != NULL)
     	{
+			node->refcount = 1;
 			node->etag = 345431215;
 			node->name_space = strdup("value"); // Assuming strdup is available
 			node->data = (char *)malloc(encodedLen);
@@ -1434,6 +1467,7 @@ void test_processMsgpackSubdoc_setValues_rbus()
 		multipartdocs_t *node = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
 		if (node != NULL)
     	{
+			node->refcount = 1;
 			node->etag = 345431215;
 			node->name_space = strdup("value"); 
 			node->data = (char *)malloc(encodedLen);
@@ -1505,6 +1539,7 @@ void add_suites( CU_pSuite *suite )
       CU_add_test( *suite, "test  delete_mp_doc", test_delete_mp_doc);
       CU_add_test( *suite, "test  get_multipartdoc_count", test_get_multipartdoc_count);
       CU_add_test( *suite, "test  parseMultipartDocument_ValidBoundary", test_parseMultipartDocument_ValidBoundary);
+      CU_add_test( *suite, "test  parseMultipartBody", test_parseMultipartBody);
       CU_add_test( *suite, "test  parseMultipartDocument_InvalidBoundary", test_parseMultipartDocument_InvalidBoundary);
 	  CU_add_test( *suite, "test loadInitURLFromFile", test_loadInitURLFromFile);
       CU_add_test( *suite, "test failedDocsRetry", test_failedDocsRetry);
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include <CUnit/Basic.h>
 #include "../src/webcfg_notify.h"
 extern void free_notify_params_struct(notify_params_t *param);
@@ -19,17 +20,38 @@ char *get_deviceMAC(void)
 char *global_payload=NULL;
 char *global_source=NULL;
 char *global_destination=NULL;
-void sendNotification_rbus(char *payload, char *source, char *destination)
+//Number of upcoming sends that fail.
+int send_fail = 0;
+int send_count = 0;
+int sent_versions[512];
+int sendNotification_rbus(char *payload, char *source, char *destination)
 {
+    char *version = NULL;
+
+    if(send_fail > 0)
+    {
+        send_fail--;
+        free(payload);
+        free(source);
+        return 0;
+    }
+    version = strstr(payload, "\"version\":\"");
+    if(send_count < 512)
+    {
+        sent_versions[send_count] = (version != NULL) ? atoi(version + strlen("\"version\":\"")) : -1;
+    }
+    send_count++;
     global_payload = payload;
     global_source = source;
-    global_destination = destination;
+    free(global_destination);
+    global_destination = strdup(destination);
+    return 1;
 }
 
-void sendNotification(char *payload, char *source, char *destination)
+int sendNotificationWithStatus(char *payload, char *source, char *destination)
 {
 	WebcfgDebug("B4 sendNotification_rbus\n");
-	sendNotification_rbus(payload, source, destination);
+	return sendNotification_rbus(payload, source, destination);
 }
 
 bool get_global_shutdown()
@@ -123,29 +145,172 @@ void test_addWebConfgNotifyMsg()
     CU_ASSERT_STRING_EQUAL(global_payload,"{\"device_id\":\"mac:123456789000\",\"namespace\":\"moca\",\"application_status\":\"xyz\",\"timeout\":10,\"error_code\":400,\"http_status_code\":404,\"transaction_uuid\":\"1122334455\",\"version\":\"123\"}");   
 }
 
+void test_notifyBatch()
+{
+    int count = 0;
+    char *mac = NULL;
+
+    set_global_notify_batch_window(1000);
+    CU_ASSERT_EQUAL(1000, get_global_notify_batch_window());
+    addWebConfgNotifyMsg("moca",1,"pending",NULL,"tx1",60,"ack",0,NULL,200);
+    addWebConfgNotifyMsg("wan",2,"success","none","tx1",0,"status",0,NULL,200);
+    addWebConfgNotifyMsg("moca",1,"success","none","tx1",0,"status",0,NULL,200);
+    shutdown_flag=1;
+    //batches are flushed on shutdown, pending moca report is superseded by success
+    processWebConfgNotification();
+    CU_ASSERT_STRING_EQUAL(global_destination,"event:subdoc-report/batch/mac:123456789000");
+    CU_ASSERT_STRING_EQUAL(global_payload,"{\"device_id\":\"mac:123456789000\",\"transaction_uuid\":\"tx1\",\"subdocs\":[{\"namespace\":\"moca\",\"application_status\":\"success\",\"version\":\"1\",\"type\":\"status\"},{\"namespace\":\"wan\",\"application_status\":\"success\",\"version\":\"2\",\"type\":\"status\"}]}");
+
+    //single doc in a batch keeps the subdoc report format
+    addWebConfgNotifyMsg("lan",3,"success","none","tx2",0,"status",0,NULL,200);
+    processWebConfgNotification();
+    CU_ASSERT_STRING_EQUAL(global_destination,"event:subdoc-report/lan/mac:123456789000/status");
+    CU_ASSERT_STRING_EQUAL(global_payload,"{\"device_id\":\"mac:123456789000\",\"namespace\":\"lan\",\"application_status\":\"success\",\"transaction_uuid\":\"tx2\",\"version\":\"3\"}");
+
+    //without a device MAC the due batch is dropped, nothing is sent
+    count = send_count;
+    mac = test_mac;
+    test_mac = NULL;
+    addWebConfgNotifyMsg("lan",4,"success","none","tx3",0,"status",0,NULL,200);
+    processWebConfgNotification();
+    CU_ASSERT_EQUAL(count, send_count);
+    test_mac = mac;
+    set_global_notify_batch_window(0);
+}
+
+void test_notifyOutbox()
+{
+    int i = 0;
+    int in_order = 1;
+    char version[16] = {'\0'};
+    char dir[] = "notify_outboxXXXXXX";
+    char spill_file[64] = {'\0'};
+    FILE *fp = NULL;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(dir));
+    snprintf(spill_file, sizeof(spill_file), "%s/notify_spill.txt", dir);
+    set_global_notify_spill_file(spill_file);
+    test_mac = strdup("123456789000");
+    shutdown_flag=1;
+
+    //outbox overflow spills the report beyond the queue limit, later reports queue behind it in the spill file
+    send_fail = 0;
+    send_count = 0;
+    for(i = 0; i <= 257; i++)
+    {
+        snprintf(version, sizeof(version), "%d", i);
+        addWebConfgNotifyMsg("wan",0,"success","none",version,0,"status",0,version,200);
+    }
+    CU_ASSERT_EQUAL(1, get_global_notify_overflow());
+    fp = fopen(spill_file, "r");
+    CU_ASSERT_PTR_NOT_NULL(fp);
+    if(fp != NULL)
+    {
+        fclose(fp);
+    }
+
+    //queued reports are delivered before the spilled ones, in enqueue order
+    processWebConfgNotification();
+    CU_ASSERT_EQUAL(258, send_count);
+    for(i = 0; i < 258; i++)
+    {
+        in_order = in_order && (sent_versions[i] == i);
+    }
+    CU_ASSERT_TRUE(in_order);
+    CU_ASSERT_PTR_NULL(fopen(spill_file, "r"));
+
+    //upstream down, the failed report and the ones queued after it wait in the spill file
+    send_fail = 1;
+    send_count = 0;
+    addWebConfgNotifyMsg("moca",1,"success","none","tx4",0,"status",0,NULL,200);
+    addWebConfgNotifyMsg("moca",2,"success","none","tx5",0,"status",0,NULL,200);
+    processWebConfgNotification();
+    CU_ASSERT_EQUAL(1, get_global_notify_spilled());
+    CU_ASSERT_EQUAL(0, send_count);
+    addWebConfgNotifyMsg("moca",3,"success","none","tx6",0,"status",0,NULL,200);
+
+    //redelivery replays everything in enqueue order and removes the spill file
+    triggerNotifyRedelivery();
+    processWebConfgNotification();
+    CU_ASSERT_EQUAL(3, send_count);
+    CU_ASSERT_EQUAL(1, sent_versions[0]);
+    CU_ASSERT_EQUAL(2, sent_versions[1]);
+    CU_ASSERT_EQUAL(3, sent_versions[2]);
+    CU_ASSERT_STRING_EQUAL(global_destination,"event:subdoc-report/moca/mac:123456789000/status");
+    CU_ASSERT_PTR_NULL(fopen(spill_file, "r"));
+    CU_ASSERT_EQUAL(0, get_global_notify_dropped());
+
+    set_global_notify_spill_file(NULL);
+    rmdir(dir);
+}
+
 void test_initWebConfigNotifyTask()
 {
     initWebConfigNotifyTask();
 }
 
+extern notify_params_t *notifyMsgQ;
 void test_free_notify_params_struct()
 {
 	notify_params_t *msg = NULL;
 	msg = (notify_params_t *)malloc(sizeof(notify_params_t));
 	memset(msg, 0, sizeof(notify_params_t));    
-    msg->name = strdup("test1");
-    msg->application_status = strdup("test2");
-    msg->error_details = strdup("test3"); 
+    snprintf(msg->name, sizeof(msg->name), "%s", "test1");
+    snprintf(msg->application_status, sizeof(msg->application_status), "%s", "test2");
+    snprintf(msg->error_details, sizeof(msg->error_details), "%s", "test3");
     free_notify_params_struct(msg);  
-    CU_ASSERT_EQUAL(msg->name,NULL);  
-
+    free_notify_params_struct(NULL);
+
+    //released record is reused and cleared by the next notify message
+    addWebConfgNotifyMsg(NULL,123,NULL,NULL,NULL,0,"status",0,NULL,200);
+    CU_ASSERT_PTR_EQUAL(notifyMsgQ, msg);
+    CU_ASSERT_STRING_EQUAL(msg->name, "");
+    CU_ASSERT_STRING_EQUAL(msg->error_details, "");
+    CU_ASSERT_STRING_EQUAL(msg->version, "123");
+    //drain the queue, record is released as device mac is not set
+    shutdown_flag=1;
+    processWebConfgNotification();
+    CU_ASSERT_PTR_NULL(notifyMsgQ);
+    shutdown_flag=0;
+}
 
-	msg = (notify_params_t *)malloc(sizeof(notify_params_t));
-	memset(msg, 0, sizeof(notify_params_t));
-    msg->version = strdup("test4");
-    free_notify_params_struct(msg);    
-    CU_ASSERT_EQUAL(msg->version,NULL);     
+void test_notifyPayloadEscape()
+{
+    test_mac = strdup("123456789000");
+    addWebConfgNotifyMsg("moca",1,"failed","bad \"value\"\n\\","tx3",0,"status",0,NULL,200);
+    shutdown_flag=1;
+    processWebConfgNotification();
+    CU_ASSERT_STRING_EQUAL(global_payload,"{\"device_id\":\"mac:123456789000\",\"namespace\":\"moca\",\"application_status\":\"failed\",\"error_details\":\"bad \\\"value\\\"\\n\\\\\",\"transaction_uuid\":\"tx3\",\"version\":\"1\"}");
+}
 
+void test_notifyFieldTruncate()
+{
+    char details[NOTIFY_ERR_DETAILS_LEN + 8];
+    char name[NOTIFY_NAME_LEN + 8];
+    size_t i = 0;
+
+    //one ASCII byte then 3 byte code points, so the field limit falls inside a code point
+    details[0] = 'a';
+    for(i = 1; i + 3 < sizeof(details); i += 3)
+    {
+        memcpy(details + i, "\xe2\x82\xac", 3);
+    }
+    details[i] = '\0';
+    name[0] = 'a';
+    for(i = 1; i + 3 < sizeof(name); i += 3)
+    {
+        memcpy(name + i, "\xe2\x82\xac", 3);
+    }
+    name[i] = '\0';
+    addWebConfgNotifyMsg(name,1,"failed",details,"tx4",0,"status",0,NULL,200);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(notifyMsgQ);
+    CU_ASSERT_EQUAL(1 + (NOTIFY_ERR_DETAILS_LEN - 2) / 3 * 3, strlen(notifyMsgQ->error_details));
+    CU_ASSERT_EQUAL(1 + (NOTIFY_NAME_LEN - 2) / 3 * 3, strlen(notifyMsgQ->name));
+    CU_ASSERT_EQUAL(0, strncmp(notifyMsgQ->name, name, strlen(notifyMsgQ->name)));
+    CU_ASSERT_EQUAL(0, strncmp(notifyMsgQ->error_details, details, strlen(notifyMsgQ->error_details)));
+    shutdown_flag=1;
+    processWebConfgNotification();
+    CU_ASSERT_PTR_NULL(notifyMsgQ);
 }
 
 void test_get_global_notify_threadid()
@@ -171,6 +336,10 @@ void add_suites( CU_pSuite *suite )
     CU_add_test( *suite, "test getStatusErrorCodeAndMessage", test_getStatusErrorCodeAndMessage);
     CU_add_test( *suite, "test free_notify_params_struct", test_free_notify_params_struct);        
     CU_add_test( *suite, "test addWebConfgNotifyMsg", test_addWebConfgNotifyMsg);      
+    CU_add_test( *suite, "test notifyBatch", test_notifyBatch);
+    CU_add_test( *suite, "test notifyPayloadEscape", test_notifyPayloadEscape);
+    CU_add_test( *suite, "test notifyFieldTruncate", test_notifyFieldTruncate);
+    CU_add_test( *suite, "test notifyOutbox", test_notifyOutbox);
     CU_add_test( *suite, "test get_global_notify_threadid", test_get_global_notify_threadid);       
     CU_add_test( *suite, "test get_global_notify_con", test_get_global_notify_con);       
     CU_add_test( *suite, "test get_global_notify_mut", test_get_global_notify_mut);   
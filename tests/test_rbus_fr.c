@@ -36,6 +36,7 @@
 #include "../src/webcfg_multipart.h"
 #include "../src/webcfg_param.h"
 #include "../src/webcfg_generic.h"
+#include "../src/webcfg_metadata.h"
 #define FILE_URL "/tmp/webcfg_url"
 
 #define UNUSED(x) (void )(x)
@@ -235,6 +236,11 @@ void test_updateForceSyncMsgQueue_found(void)
 void test_setForceSync()
 {
 	int session_status = 0;
+	SupplementaryDocs_t sp;
+	memset(&sp, 0, sizeof(SupplementaryDocs_t));
+	sp.name = "telemetry";
+	set_global_spInfoHead(&sp);
+	set_global_spInfoTail(&sp);
 	int ret = set_rbus_ForceSync("root", &session_status);
 	CU_ASSERT_EQUAL(0,session_status);
 	CU_ASSERT_EQUAL(1,ret);
@@ -278,17 +284,73 @@ void test_setForceSync()
 	CU_ASSERT_EQUAL(0,ret);
 	ForceSyncMsg* head = getForceSyncMsgQueue();
 	CU_ASSERT_PTR_NOT_NULL(head); // Ensure queue is not null
-	// Check the first node contains "telemetry"
+	// Earlier root pokes and the bundles are merged into the first node
 	CU_ASSERT_PTR_NOT_NULL(head->ForceSyncVal);
-	CU_ASSERT_STRING_EQUAL(head->ForceSyncVal, "telemetry");
-	// Move to the next node and check it contains "root"
+	CU_ASSERT_STRING_EQUAL(head->ForceSyncVal, "root");
+	CU_ASSERT_PTR_NOT_NULL(head->MergedTransIDs);
+	// Move to the next node and check it contains "telemetry"
 	ForceSyncMsg* second = head->next;
 	CU_ASSERT_PTR_NOT_NULL(second); // Ensure the second node exists
 	CU_ASSERT_PTR_NOT_NULL(second->ForceSyncVal);
-	CU_ASSERT_STRING_EQUAL(second->ForceSyncVal, "root");
+	CU_ASSERT_STRING_EQUAL(second->ForceSyncVal, "telemetry");
+	// Both bundles carry their transaction id to the telemetry node
+	CU_ASSERT_EQUAL(1, second->MergedCount);
 	// Ensure there are no more nodes in the queue
 	CU_ASSERT_PTR_NULL(second->next);
 	deleteForceSyncMsgQueue();
+	set_global_spInfoHead(NULL);
+	set_global_spInfoTail(NULL);
+}
+
+void test_forceSyncCoalesce()
+{
+	int session_status = 0;
+	char *str = NULL;
+	char* transID = NULL;
+	SupplementaryDocs_t sp;
+	memset(&sp, 0, sizeof(SupplementaryDocs_t));
+	sp.name = "telemetry";
+	set_global_spInfoHead(&sp);
+	set_global_spInfoTail(&sp);
+	deleteForceSyncMsgQueue();
+
+	set_rbus_ForceSync("{ \"value\":\"root\", \"transaction_id\":\"T1\"}", &session_status);
+	set_rbus_ForceSync("{ \"value\":\"telemetry\", \"transaction_id\":\"T2\"}", &session_status);
+	// Primary subdoc poke folds into the pending root sync
+	set_rbus_ForceSync("{ \"value\":\"wan\", \"transaction_id\":\"T3\"}", &session_status);
+	set_rbus_ForceSync("{ \"value\":\"root\", \"transaction_id\":\"T1\"}", &session_status);
+	set_rbus_ForceSync("{ \"value\":\"telemetry,root\", \"transaction_id\":\"T4\"}", &session_status);
+
+	ForceSyncMsg* head = getForceSyncMsgQueue();
+	CU_ASSERT_PTR_NOT_NULL(head);
+	CU_ASSERT_STRING_EQUAL(head->ForceSyncVal, "root");
+	CU_ASSERT_STRING_EQUAL(head->ForceSyncTransID, "T4");
+	CU_ASSERT_STRING_EQUAL(head->MergedTransIDs, "T1,T3");
+	CU_ASSERT_EQUAL(2, head->MergedCount);
+	CU_ASSERT_PTR_NOT_NULL(head->next);
+	CU_ASSERT_STRING_EQUAL(head->next->ForceSyncVal, "telemetry");
+	CU_ASSERT_STRING_EQUAL(head->next->ForceSyncTransID, "T4");
+	CU_ASSERT_STRING_EQUAL(head->next->MergedTransIDs, "T2");
+	CU_ASSERT_PTR_NULL(head->next->next);
+
+	CU_ASSERT_EQUAL(1, get_rbus_ForceSync(&str, &transID));
+	CU_ASSERT_STRING_EQUAL(str, "root");
+	CU_ASSERT_STRING_EQUAL(transID, "T4");
+	WEBCFG_FREE(str);
+	WEBCFG_FREE(transID);
+	CU_ASSERT_EQUAL(1, get_rbus_ForceSync(&str, &transID));
+	CU_ASSERT_STRING_EQUAL(str, "telemetry");
+	WEBCFG_FREE(str);
+	WEBCFG_FREE(transID);
+	CU_ASSERT_PTR_NULL(getForceSyncMsgQueue());
+
+	// Queue keeps appending after it drained
+	CU_ASSERT_EQUAL(0, addForceSyncMsgToQueue("root", "T5"));
+	CU_ASSERT_EQUAL(0, addForceSyncMsgToQueue("telemetry", "T6"));
+	CU_ASSERT_STRING_EQUAL(getForceSyncMsgQueue()->next->ForceSyncVal, "telemetry");
+	deleteForceSyncMsgQueue();
+	set_global_spInfoHead(NULL);
+	set_global_spInfoTail(NULL);
 }
 
 void test_setForceSync_failure()
@@ -1087,6 +1149,27 @@ void test_resetEventSubHandler()
 	CU_ASSERT_EQUAL(ret, 0);
 }
 
+// Test case for dbChangeEventSubHandler & publishDBChangeEvent
+void test_dbChangeEventSubHandler()
+{
+	bool autopublish = true;
+	rbusError_t ret = RBUS_ERROR_BUS_ERROR;
+	//No subscriber, publish is skipped
+	publishDBChangeEvent("moca", 1234, "pending");
+
+	ret = dbChangeEventSubHandler(handle, RBUS_EVENT_ACTION_SUBSCRIBE, WEBCFG_DB_CHANGE_EVENT, NULL, 0, &autopublish);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_FALSE(autopublish);
+	publishDBChangeEvent("moca", 1234, "success");
+	publishDBChangeEvent(NULL, 1234, "success");
+
+	ret = dbChangeEventSubHandler(handle, RBUS_EVENT_ACTION_SUBSCRIBE, WEBCFG_UPSTREAM_EVENT, NULL, 0, &autopublish);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	ret = dbChangeEventSubHandler(handle, RBUS_EVENT_ACTION_UNSUBSCRIBE, WEBCFG_DB_CHANGE_EVENT, NULL, 0, &autopublish);
+	CU_ASSERT_EQUAL(ret, 0);
+}
+
 // Test case for set_rbus_RfcEnable & get_rbus_RfcEnable
 void test_set_get_rbus_RfcEnable()
 {
@@ -1202,13 +1285,14 @@ void test_resetSubdocVersion()
 	CU_ASSERT_EQUAL(result, ERROR_SUCCESS);
 
     	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    	memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
     	tmpData->name = strdup("doc1");
     	tmpData->version = 567843562;
-    	tmpData->status = strdup("pending");
+    	tmpData->status = TMP_STATUS_PENDING;
     	tmpData->trans_id = 4104;
     	tmpData->retry_count = 0;
     	tmpData->error_code = 0;
-    	tmpData->error_details = strdup("none");
+    	tmpData->error_details = "none";
     	tmpData->next = NULL;
 	set_global_tmp_node(tmpData);
 	
@@ -1292,11 +1376,13 @@ void test_fetchMpBlobData()
 	int bloblen = 0;
 	void *blobData = NULL;
 	uint32_t etag = 0;
+	multipartdocs_t *mp_doc = NULL;
 	//Multipart Cache is NULL
-	result = fetchMpBlobData("moca", &blobData, &bloblen, &etag);
+	result = fetchMpBlobData("moca", &blobData, &bloblen, &etag, &mp_doc);
 	CU_ASSERT_EQUAL(result, ERROR_FAILURE);
        
 	multipartdocs_t *multipartdocs = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
+	multipartdocs->refcount = 1;
    	multipartdocs->name_space = strdup("moca");
     	multipartdocs->data = strdup("mocaBLOB");
 	multipartdocs->data_size = sizeof(multipartdocs->data);
@@ -1307,15 +1393,23 @@ void test_fetchMpBlobData()
     	CU_ASSERT_FATAL(NULL != get_global_mp());
 
 	//Subdoc not found
-	result = fetchMpBlobData("wan", &blobData, &bloblen, &etag);
+	result = fetchMpBlobData("wan", &blobData, &bloblen, &etag, &mp_doc);
 	CU_ASSERT_EQUAL(result, ERROR_ELEMENT_DOES_NOT_EXIST);
 
 	//Subdoc found and fetch blob data success
-	result = fetchMpBlobData("moca", &blobData, &bloblen, &etag);
+	result = fetchMpBlobData("moca", &blobData, &bloblen, &etag, &mp_doc);
 	CU_ASSERT_EQUAL(result, ERROR_SUCCESS);
 	CU_ASSERT_STRING_EQUAL(blobData, "mocaBLOB");
 	CU_ASSERT_EQUAL(bloblen, 8);
 	CU_ASSERT_EQUAL(etag, 11573827);
+	CU_ASSERT_PTR_EQUAL(mp_doc, get_global_mp());
+	CU_ASSERT_EQUAL(mp_doc->refcount, 2);
+
+	//Borrowed doc stays valid after it is removed from the list
+	deleteFromMpList("moca");
+	CU_ASSERT_PTR_NULL(get_global_mp());
+	CU_ASSERT_STRING_EQUAL(mp_doc->data, "mocaBLOB");
+	releaseMpDoc(mp_doc);
 
 	set_global_mp(NULL);
 	CU_ASSERT_FATAL(NULL == get_global_mp());
@@ -1405,6 +1499,7 @@ void test_webcfg_util_method()
 	rbusProperty_Release(checkParams);
 
 	multipartdocs_t *multipartdocs = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
+	multipartdocs->refcount = 1;
    	multipartdocs->name_space = strdup("moca");
     	multipartdocs->data = strdup("mocaBLOB");
 	multipartdocs->data_size = sizeof(multipartdocs->data);
@@ -1579,6 +1674,87 @@ void test_webcfgSubdocForceResetSet_GetHandler(void)
     	webpaRbus_Uninit();
 }
 
+static char dbChangeSubdoc[64];
+static char dbChangeStatus[32];
+static uint32_t dbChangeVersion = 0;
+static int dbChangeCount = 0;
+
+static void dbChangeEventHandler(
+    rbusHandle_t handle,
+    rbusEvent_t const* event,
+    rbusEventSubscription_t* subscription)
+{
+	rbusValue_t value = NULL;
+
+	(void)handle;
+	(void)subscription;
+	value = rbusObject_GetValue(event->data, "subdoc");
+	snprintf(dbChangeSubdoc, sizeof(dbChangeSubdoc), "%s", value ? rbusValue_GetString(value, NULL) : "");
+	value = rbusObject_GetValue(event->data, "status");
+	snprintf(dbChangeStatus, sizeof(dbChangeStatus), "%s", value ? rbusValue_GetString(value, NULL) : "");
+	value = rbusObject_GetValue(event->data, "version");
+	dbChangeVersion = value ? rbusValue_GetUInt32(value) : 0;
+	dbChangeCount++;
+	WebcfgInfo("DBChange event received for %s version %lu status %s\n", dbChangeSubdoc, (long)dbChangeVersion, dbChangeStatus);
+}
+
+// Test case for DBChange payloads published on add & reset, not on tmp list delete
+void test_dbChangeEventPayload(void)
+{
+	webconfigRbusInit("providerComponent");
+	regWebConfigDataModel();
+
+	int res = rbus_open(&handle, "consumerComponent");
+	if(res != RBUS_ERROR_SUCCESS)
+	{
+		CU_FAIL("rbus_open failed for consumerComponent");
+	}
+	int ret = rbusEvent_Subscribe(handle, WEBCFG_DB_CHANGE_EVENT, dbChangeEventHandler, NULL, 0);
+	if(ret != RBUS_ERROR_SUCCESS)
+	{
+		CU_FAIL("subscribe to DBChange event failed");
+	}
+	dbChangeCount = 0;
+
+	//New subdoc added to DB
+	CU_ASSERT_EQUAL(checkDBList("moca", 1234, NULL), WEBCFG_SUCCESS);
+	sleep(1);
+	CU_ASSERT_EQUAL(dbChangeCount, 1);
+	CU_ASSERT_STRING_EQUAL(dbChangeSubdoc, "moca");
+	CU_ASSERT_EQUAL(dbChangeVersion, 1234);
+	CU_ASSERT_STRING_EQUAL(dbChangeStatus, "success");
+
+	//Subdoc force reset to version 0
+	CU_ASSERT_EQUAL(resetSubdocVersion("moca"), ERROR_SUCCESS);
+	sleep(1);
+	CU_ASSERT_EQUAL(dbChangeCount, 2);
+	CU_ASSERT_STRING_EQUAL(dbChangeSubdoc, "moca");
+	CU_ASSERT_EQUAL(dbChangeVersion, 0);
+	CU_ASSERT_STRING_EQUAL(dbChangeStatus, DB_CHANGE_STATUS_RESET);
+
+	//Tmp list cleanup is not a DB change, nothing is published
+	webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)calloc(1, sizeof(webconfig_tmp_data_t));
+	CU_ASSERT_FATAL(NULL != tmpData);
+	tmpData->name = strdup("moca");
+	tmpData->version = 1235;
+	tmpData->status = TMP_STATUS_SUCCESS;
+	tmpData->cloud_trans_id = strdup("cloud_trans_id");
+	set_global_tmp_node(tmpData);
+	webconfig_tmp_data_t *next_node = NULL;
+	CU_ASSERT_EQUAL(deleteFromTmpList("moca", &next_node), WEBCFG_SUCCESS);
+	sleep(1);
+	CU_ASSERT_EQUAL(dbChangeCount, 2);
+	CU_ASSERT_PTR_NULL(get_global_tmp_node());
+	reset_numOfMpDocs();
+
+	webcfgdb_destroy(get_global_db_node());
+	reset_successDocCount();
+	reset_db_node();
+	rbusEvent_Unsubscribe(handle, WEBCFG_DB_CHANGE_EVENT);
+	rbus_close(handle);
+	webpaRbus_Uninit();
+}
+
 #ifdef WAN_FAILOVER_SUPPORTED
 rbusError_t webcfgInterfaceSubscribeHandler(rbusHandle_t handle, rbusEventSubAction_t action, const char* eventName, rbusFilter_t filter, int32_t interval, bool* autoPublish)
 {
@@ -1770,6 +1946,71 @@ void test_setValues_rbus()
 	free(reqParam);
 }
 
+void test_setValues_rbus_batched()
+{
+	WDMP_STATUS ret = WDMP_FAILURE;
+	int ccspStatus = 0;
+	int paramCount = 2;
+	param_t *reqParam = NULL;
+	reqParam = (param_t *) malloc(sizeof(param_t) * paramCount);
+	memset(reqParam,0,(sizeof(param_t) * paramCount));
+	reqParam[0].name = WEBCFG_SUPPLEMENTARY_TELEMETRY_PARAM;
+	reqParam[0].value = "telemetry";
+	reqParam[0].type = WDMP_BASE64;
+	reqParam[1].name = WEBCFG_URL_PARAM;
+	reqParam[1].value = "webcfgurl";
+	reqParam[1].type = WDMP_BASE64;
+
+	//One param per rbus_setMulti within a session
+	set_global_set_batch_size(1);
+	CU_ASSERT_EQUAL(1, get_global_set_batch_size());
+	setValues_rbus(reqParam, paramCount, 0, NULL, NULL, &ret, &ccspStatus);
+	CU_ASSERT_EQUAL(CCSP_Msg_Bus_OK, ccspStatus);
+	CU_ASSERT_EQUAL(WDMP_SUCCESS, ret);
+
+	//Invalid type fails before any chunk is sent
+	reqParam[1].type = WDMP_NONE;
+	setValues_rbus(reqParam, paramCount, 0, NULL, NULL, &ret, &ccspStatus);
+	CU_ASSERT_EQUAL(CCSP_ERR_INVALID_PARAMETER_VALUE, ccspStatus);
+
+	//Second chunk fails, the doc is reported as failed
+	reqParam[0].name = WEBCFG_URL_PARAM;
+	reqParam[0].value = "webcfgurl-chunked";
+	reqParam[1].name = "Device.X_RDK_WebConfig_Missing.Param";
+	reqParam[1].value = "missing";
+	reqParam[1].type = WDMP_BASE64;
+	setValues_rbus(reqParam, paramCount, 0, NULL, NULL, &ret, &ccspStatus);
+	CU_ASSERT_NOT_EQUAL(CCSP_Msg_Bus_OK, ccspStatus);
+	CU_ASSERT_NOT_EQUAL(WDMP_SUCCESS, ret);
+
+	//An atomic doc is never split, so a failing param leaves the others untouched
+	reqParam[0].value = "webcfgurl-atomic";
+	setValues_rbus(reqParam, paramCount, ATOMIC_SET_WEBCONFIG, NULL, NULL, &ret, &ccspStatus);
+	CU_ASSERT_NOT_EQUAL(CCSP_Msg_Bus_OK, ccspStatus);
+	CU_ASSERT_NOT_EQUAL(WDMP_SUCCESS, ret);
+
+	const char *getParamList[1] = { WEBCFG_URL_PARAM };
+	int count = 0;
+	int getStatus = WDMP_FAILURE;
+	param_t **parametervalArr = (param_t **) malloc(sizeof(param_t *));
+	getValues_rbus(getParamList, 1, 0, NULL, &parametervalArr, &count, &getStatus);
+	CU_ASSERT_EQUAL(1, count);
+	if(count == 1)
+	{
+		CU_ASSERT_STRING_NOT_EQUAL("webcfgurl-atomic", parametervalArr[0]->value);
+	}
+	free(parametervalArr);
+
+	//Restore the value checked by test_getVlues_rbus
+	reqParam[0].value = "webcfgurl";
+	setValues_rbus(reqParam, 1, ATOMIC_SET_WEBCONFIG, NULL, NULL, &ret, &ccspStatus);
+	CU_ASSERT_EQUAL(WDMP_SUCCESS, ret);
+
+	set_global_set_batch_size(0);
+	CU_ASSERT_EQUAL(SET_VALUES_BATCH_DEFAULT, get_global_set_batch_size());
+	free(reqParam);
+}
+
 void test_getVlues_rbus()
 {
 	int paramCount=0;
@@ -1892,6 +2133,7 @@ void add_suites( CU_pSuite *suite )
 	*suite = CU_add_suite( "tests", NULL, NULL );
      	CU_add_test( *suite, "test rbus_forcesync", test_setForceSync);
      	CU_add_test( *suite, "test rbus_forcesync_failure", test_setForceSync_failure);
+     	CU_add_test( *suite, "test rbus_forcesync_coalesce", test_forceSyncCoalesce);
      	CU_add_test( *suite, "test rbus_forcesync_json", test_setForceSync_json);
      	CU_add_test( *suite, "test isRbusEnabled_success", test_isRbusEnabled_success);
      	CU_add_test( *suite, "test get_global_isRbus_success", test_get_global_isRbus_success);
@@ -1927,6 +2169,7 @@ void add_suites( CU_pSuite *suite )
      	CU_add_test( *suite, "test waitForUpstreamEventSubscribe", test_waitForUpstreamEventSubscribe);
      	CU_add_test( *suite, "test eventSubHandler", test_eventSubHandler);
      	CU_add_test( *suite, "test resetEventSubHandler", test_resetEventSubHandler);
+     	CU_add_test( *suite, "test dbChangeEventSubHandler", test_dbChangeEventSubHandler);
      	CU_add_test( *suite, "test set_get_rbus_RfcEnable", test_set_get_rbus_RfcEnable);
      	CU_add_test( *suite, "test set_global_webconfig_url", test_set_global_webconfig_url);
      	CU_add_test( *suite, "test set_global_supplementary_url", test_set_global_supplementary_url);
@@ -1947,7 +2190,9 @@ void add_suites( CU_pSuite *suite )
      	CU_add_test( *suite, "test subscribeTo_CurrentActiveInterface_Event", test_subscribeTo_CurrentActiveInterface_Event);
 	#endif
      	CU_add_test( *suite, "test webcfgSubdocForceResetSet_GetHandler", test_webcfgSubdocForceResetSet_GetHandler);	
+     	CU_add_test( *suite, "test dbChangeEventPayload", test_dbChangeEventPayload);
 	CU_add_test( *suite, "test setValues_rbus", test_setValues_rbus);
+	CU_add_test( *suite, "test setValues_rbus_batched", test_setValues_rbus_batched);
 	CU_add_test( *suite, "test getVlues_rbus", test_getVlues_rbus);
 	CU_add_test( *suite, "test sendNotification_rbus", test_sendNotification_rbus);
 	CU_add_test( *suite, "test blobSet_rbus", test_blobSet_rbus); 
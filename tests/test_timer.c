@@ -173,32 +173,6 @@ void test_getTimeInSeconds()
 	}
 }
 
-void test_updateRetryTimeDiff()
-{
-	struct timespec ct;
-      	clock_gettime(CLOCK_REALTIME, &ct);
-     	long long present_time = ct.tv_sec;
-
-	//expire time 10 sec in the future
-    	long long expiry_time = present_time + 10;
-	
-	//get_retry_timer > time_diff
-	set_retry_timer(60);
-	
-	//retry_timer updated but global_retry_timestamp remains same
-	int time_diff = updateRetryTimeDiff(expiry_time);
-	int expected_retry_timer = (get_retry_timer() > time_diff) ? time_diff : get_retry_timer();
-	CU_ASSERT_EQUAL(get_retry_timer(), expected_retry_timer);
-	
-	//global_retry_timestamp equal to 0
-	set_global_retry_timestamp(0);
-	time_diff = updateRetryTimeDiff(expiry_time);		
-	
-	WebcfgInfo("The get_global_retry_timestamp is %ld\n",get_global_retry_timestamp());
-	WebcfgInfo("The getTimeInSeconds is %ld\n",getTimeInSeconds(expiry_time + 900));	
-	CU_ASSERT_EQUAL(get_global_retry_timestamp(), getTimeInSeconds(present_time + 900));
-}
-
 void test_getRetryExpiryTimeout()
 {
 	// Get the actual retry timestamp using the function
@@ -233,30 +207,6 @@ void test_checkRetryTimer_future()
         CU_ASSERT_EQUAL(result_future, 0);
 }
 
-void test_retrySyncSeconds()
-{
-	struct timespec ct;
-	clock_gettime(CLOCK_REALTIME, &ct);
-	long long current_time = 0;
-	current_time = ct.tv_sec;
-	long current_time_in_sec = getTimeInSeconds(current_time);	
-	long retry_secs = 0;
-	retry_secs =  get_global_retry_timestamp() - current_time_in_sec;
-	int get = retrySyncSeconds();
-	WebcfgInfo("The value of retry is %ld\n",retry_secs);
-	CU_ASSERT_EQUAL(retry_secs,get);
-
-	//retry_secs = 0
-	set_global_retry_timestamp(current_time_in_sec);
-	get = retrySyncSeconds();
-	CU_ASSERT_EQUAL(0,get);
-
-	//retry_sec < 0
-	set_global_retry_timestamp(current_time_in_sec - 10);
-	get = retrySyncSeconds();
-	CU_ASSERT_EQUAL(0,get);
-}
-
 void test_set_get_maintenance_time()
 {
         long unixTimestamp = 1635626400;
@@ -273,12 +223,86 @@ void test_set_get_retry_timer()
 	CU_ASSERT_EQUAL(time, get_retry_timer());
 }
 
-void test_set_get_retry_timestamp()
+void test_getSyncBackoffSeconds()
 {
-	long retry_time = 1635626400;
-	set_global_retry_timestamp(retry_time);
-	
-	CU_ASSERT_EQUAL(retry_time, get_global_retry_timestamp());
+	int first = 0;
+	int next = 0;
+
+	resetSyncBackoff();
+	//First throttled delay is jittered above the class base, later ones grow with jitter up to the cap
+	first = getSyncBackoffSeconds(429);
+	CU_ASSERT_TRUE(first >= 60 && first <= 180);
+	next = getSyncBackoffSeconds(429);
+	CU_ASSERT_TRUE(next >= 60 && next <= 3 * first);
+
+	first = getSyncBackoffSeconds(503);
+	CU_ASSERT_TRUE(first > 0 && first <= 300);
+
+	//Retry-After from the server is a lower bound
+	set_global_retry_after(1200);
+	CU_ASSERT_EQUAL(1200, getSyncBackoffSeconds(503));
+	set_global_retry_after(200000);
+	CU_ASSERT_EQUAL(86400, getSyncBackoffSeconds(429));
+
+	resetSyncBackoff();
+	CU_ASSERT_EQUAL(0, get_global_retry_after());
+	first = getSyncBackoffSeconds(429);
+	CU_ASSERT_TRUE(first >= 60 && first <= 180);
+}
+
+void test_scheduleSyncRetry()
+{
+	struct timespec ct;
+	long long retry_time = 0;
+
+	resetSyncBackoff();
+	clock_gettime(CLOCK_REALTIME, &ct);
+	scheduleSyncRetry(100);
+	retry_time = get_global_sync_retry_time();
+	CU_ASSERT_TRUE(retry_time >= ct.tv_sec + 100 && retry_time <= ct.tv_sec + 101);
+
+	//An earlier pending sync is kept
+	scheduleSyncRetry(500);
+	CU_ASSERT_EQUAL(retry_time, get_global_sync_retry_time());
+	scheduleSyncRetry(10);
+	CU_ASSERT_TRUE(get_global_sync_retry_time() < retry_time);
+
+	//A server Retry-After keeps the later deadline
+	set_global_retry_after(500);
+	scheduleSyncRetry(500);
+	retry_time = get_global_sync_retry_time();
+	CU_ASSERT_TRUE(retry_time >= ct.tv_sec + 500);
+	scheduleSyncRetry(10);
+	CU_ASSERT_EQUAL(retry_time, get_global_sync_retry_time());
+
+	resetSyncBackoff();
+	CU_ASSERT_EQUAL(0, get_global_sync_retry_time());
+}
+
+void test_set_get_sync_window()
+{
+	long start = 0;
+	long end = 0;
+
+	//Invalid windows are ignored
+	set_global_sync_window(-1, 3600);
+	set_global_sync_window(3600, 86400);
+	get_global_sync_window(&start, &end);
+	CU_ASSERT_EQUAL(-1, start);
+	CU_ASSERT_EQUAL(-1, end);
+
+	set_global_sync_window(7200, 10800);
+	get_global_sync_window(&start, &end);
+	CU_ASSERT_EQUAL(7200, start);
+	CU_ASSERT_EQUAL(10800, end);
+	CU_ASSERT_EQUAL(7201, get_global_maintenance_time());
+
+	//Server window is used instead of the firmware upgrade window
+	set_global_maintenance_time(0);
+	setFirmwareUpgradeStartTime(NULL);
+	setFirmwareUpgradeEndTime(NULL);
+	initMaintenanceTimer();
+	CU_ASSERT_EQUAL(7201, get_global_maintenance_time());
 }
 
 void add_suites( CU_pSuite *suite )
@@ -289,14 +313,14 @@ void add_suites( CU_pSuite *suite )
 	CU_add_test( *suite, "test checkMaintenanceTimer", test_checkMaintenanceTimer);
 	CU_add_test( *suite, "test getMaintenanceSyncSeconds", test_getMaintenanceSyncSeconds);
 	CU_add_test( *suite, "test getTimeInSeconds", test_getTimeInSeconds);
-	CU_add_test( *suite, "test updateRetryTimeDiff", test_updateRetryTimeDiff);
 	CU_add_test( *suite, "test getRetryExpiryTimeout", test_getRetryExpiryTimeout);
 	CU_add_test( *suite, "test checkRetryTimer_past", test_checkRetryTimer_past);
 	CU_add_test( *suite, "test checkRetryTimer_future", test_checkRetryTimer_future);
-	CU_add_test( *suite, "test retrySyncSeconds", test_retrySyncSeconds);
 	CU_add_test( *suite, "test set_get_maintenance_time", test_set_get_maintenance_time);
 	CU_add_test( *suite, "test set_get_retry_timer", test_set_get_retry_timer);
-	CU_add_test( *suite, "test set_get_retry_timestamp", test_set_get_retry_timestamp);
+	CU_add_test( *suite, "test getSyncBackoffSeconds", test_getSyncBackoffSeconds);
+	CU_add_test( *suite, "test scheduleSyncRetry", test_scheduleSyncRetry);
+	CU_add_test( *suite, "test set_get_sync_window", test_set_get_sync_window);
 }
 
 int main( int argc, char *argv[] )
@@ -17,6 +17,7 @@
 #include <stdint.h>
 #include <errno.h>
 #include <stdio.h>
+#include <unistd.h>
 #include <CUnit/Basic.h>
 #include "../src/webcfg_db.h"
 #include "../src/webcfg_pack.h"
@@ -75,6 +76,16 @@ pthread_mutex_t *get_global_event_mut(void)
     return 0;
 }
 
+pthread_cond_t *get_global_expire_timer_con(void)
+{
+    return 0;
+}
+
+pthread_mutex_t *get_global_expire_timer_mut(void)
+{
+    return 0;
+}
+
 /*----------------------------------------------------------------------------*/
 /*                             Test Functions                             */
 /*----------------------------------------------------------------------------*/
@@ -82,6 +93,7 @@ pthread_mutex_t *get_global_event_mut(void)
 void test_reset_numOfMpDocs()
 {
     multipartdocs_t *multipartdocs = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
+    multipartdocs->refcount = 1;
     multipartdocs->name_space = strdup("moca");
     multipartdocs->data = (char* )malloc(64);
     multipartdocs->isSupplementarySync = 1;
@@ -110,22 +122,24 @@ void test_reset_numOfMpDocs()
 void test_delete_tmp_list()
 {
     webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
     tmpData->name = strdup("moca");
     tmpData->version = 1234;
-    tmpData->status = strdup("success");
+    tmpData->status = TMP_STATUS_SUCCESS;
     tmpData->trans_id = 4104;
     tmpData->retry_count = 0;
     tmpData->error_code = 0;
-    tmpData->error_details = strdup("none");
+    tmpData->error_details = "none";
     //tmpData->next = NULL;
     webconfig_tmp_data_t *tmp = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmp, 0, sizeof(webconfig_tmp_data_t));
     tmp->name = strdup("wan");
     tmp->version = 5678;
-    tmp->status = strdup("success");
+    tmp->status = TMP_STATUS_SUCCESS;
     tmp->trans_id = 4204;
     tmp->retry_count = 0;
     tmp->error_code = 0;
-    tmp->error_details = strdup("none");
+    tmp->error_details = "none";
     tmp->next = NULL;
     tmpData->next = tmp;
     set_global_tmp_node(tmpData);
@@ -138,6 +152,7 @@ void test_delete_tmp_list()
 void test_get_numOfMpDocs()
 {
     multipartdocs_t *multipartdocs = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
+    multipartdocs->refcount = 1;
     multipartdocs->name_space = strdup("moca");
     multipartdocs->data = (char* )malloc(64);
     multipartdocs->isSupplementarySync = 1;
@@ -163,6 +178,7 @@ void test_get_numOfMpDocs()
 void test_addToTmpList() 
 {
     multipartdocs_t *multipartdocs = (multipartdocs_t *)malloc(sizeof(multipartdocs_t));
+    multipartdocs->refcount = 1;
     multipartdocs->name_space = strdup("moca");
     multipartdocs->data = (char* )malloc(64);
     multipartdocs->isSupplementarySync = 1;
@@ -188,13 +204,14 @@ void test_addToTmpList()
 void test_set_global_tmp_node()
 {
     webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
     tmpData->name = strdup("moca");
     tmpData->version = 1234;
-    tmpData->status = strdup("success");
+    tmpData->status = TMP_STATUS_SUCCESS;
     tmpData->trans_id = 4104;
     tmpData->retry_count = 0;
     tmpData->error_code = 0;
-    tmpData->error_details = strdup("none");
+    tmpData->error_details = "none";
     tmpData->next = NULL;
     set_global_tmp_node(tmpData);
     CU_ASSERT_FATAL( NULL != get_global_tmp_node());
@@ -205,13 +222,14 @@ void test_set_global_tmp_node()
 void test_get_global_tmp_node()
 {
     webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
     tmpData->name = strdup("moca");
     tmpData->version = 1234;
-    tmpData->status = strdup("success");
+    tmpData->status = TMP_STATUS_SUCCESS;
     tmpData->trans_id = 4104;
     tmpData->retry_count = 0;
     tmpData->error_code = 0;
-    tmpData->error_details = strdup("none");
+    tmpData->error_details = "none";
     tmpData->next = NULL;
     set_global_tmp_node(tmpData);
     CU_ASSERT_FATAL( NULL != get_global_tmp_node());
@@ -222,32 +240,35 @@ void test_get_global_tmp_node()
 void test_getTmpNode()
 {
     webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
     tmpData->name = strdup("root");
     tmpData->version = 232323;
-    tmpData->status = strdup("pending");
+    tmpData->status = TMP_STATUS_PENDING;
     tmpData->trans_id = 4104;
     tmpData->retry_count = 0;
     tmpData->error_code = 0;
-    tmpData->error_details = strdup("none");
+    tmpData->error_details = "none";
     tmpData->next = NULL;
     webconfig_tmp_data_t *tmp = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmp, 0, sizeof(webconfig_tmp_data_t));
     tmp->name = strdup("privatessid");
     tmp->version = 1234;
-    tmp->status = strdup("pending");
+    tmp->status = TMP_STATUS_PENDING;
     tmp->trans_id = 4204;
     tmp->retry_count = 0;
     tmp->error_code = 0;
-    tmp->error_details = strdup("none");
+    tmp->error_details = "none";
     tmp->next = NULL;
     tmpData->next = tmp;
     webconfig_tmp_data_t *tmp1 = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmp1, 0, sizeof(webconfig_tmp_data_t));
     tmp1->name = strdup("moca");
     tmp1->version = 5678;
-    tmp1->status = strdup("success");
+    tmp1->status = TMP_STATUS_SUCCESS;
     tmp1->trans_id = 4304;
     tmp1->retry_count = 0;
     tmp1->error_code = 0;
-    tmp1->error_details = strdup("none");
+    tmp1->error_details = "none";
     tmp1->next = NULL;
     tmp->next = tmp1;
     set_global_tmp_node(tmpData);
@@ -261,32 +282,35 @@ void test_getTmpNode()
 void test_updateTmpList()
 {
     webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
     tmpData->name = strdup("root");
     tmpData->version = 232323;
-    tmpData->status = strdup("pending");
+    tmpData->status = TMP_STATUS_PENDING;
     tmpData->trans_id = 4104;
     tmpData->retry_count = 0;
     tmpData->error_code = 0;
-    tmpData->error_details = strdup("none");
+    tmpData->error_details = "none";
     tmpData->next = NULL;
     webconfig_tmp_data_t *tmp = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmp, 0, sizeof(webconfig_tmp_data_t));
     tmp->name = strdup("privatessid");
     tmp->version = 1234;
-    tmp->status = strdup("pending");
+    tmp->status = TMP_STATUS_PENDING;
     tmp->trans_id = 4204;
     tmp->retry_count = 0;
     tmp->error_code = 0;
-    tmp->error_details = strdup("none");
+    tmp->error_details = "none";
     tmp->next = NULL;
     tmpData->next = tmp;
     webconfig_tmp_data_t *tmp1 = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmp1, 0, sizeof(webconfig_tmp_data_t));
     tmp1->name = strdup("moca");
     tmp1->version = 5678;
-    tmp1->status = strdup("failed");
+    tmp1->status = TMP_STATUS_FAILED;
     tmp1->trans_id = 4304;
     tmp1->retry_count = 0;
     tmp1->error_code = 0;
-    tmp1->error_details = strdup("none");
+    tmp1->error_details = "none";
     tmp1->next = NULL;
     tmp->next = tmp1;
     set_global_tmp_node(tmpData);
@@ -310,34 +334,37 @@ void test_deleteFromTmpList()
 {
     int count = 0;
     webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
     tmpData->name = strdup("root");
     tmpData->version = 232323;
-    tmpData->status = strdup("pending");
+    tmpData->status = TMP_STATUS_PENDING;
     tmpData->trans_id = 4104;
     tmpData->retry_count = 0;
     tmpData->error_code = 0;
-    tmpData->error_details = strdup("none");
+    tmpData->error_details = "none";
     tmpData->next = NULL;
     count++;
     webconfig_tmp_data_t *tmp = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmp, 0, sizeof(webconfig_tmp_data_t));
     tmp->name = strdup("privatessid");
     tmp->version = 1234;
-    tmp->status = strdup("pending");
+    tmp->status = TMP_STATUS_PENDING;
     tmp->trans_id = 4204;
     tmp->retry_count = 0;
     tmp->error_code = 0;
-    tmp->error_details = strdup("none");
+    tmp->error_details = "none";
     tmp->next = NULL;
     tmpData->next = tmp;
     count++;
     webconfig_tmp_data_t *tmp1 = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmp1, 0, sizeof(webconfig_tmp_data_t));
     tmp1->name = strdup("moca");
     tmp1->version = 5678;
-    tmp1->status = strdup("success");
+    tmp1->status = TMP_STATUS_SUCCESS;
     tmp1->trans_id = 4304;
     tmp1->retry_count = 0;
     tmp1->error_code = 0;
-    tmp1->error_details = strdup("none");
+    tmp1->error_details = "none";
     tmp1->next = NULL;
     tmp->next = tmp1;
     count++;
@@ -363,34 +390,37 @@ void test_delete_tmp_docs_list()
 {
     int count = 0;
     webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
     tmpData->name = strdup("root");
     tmpData->version = 232323;
-    tmpData->status = strdup("pending");
+    tmpData->status = TMP_STATUS_PENDING;
     tmpData->trans_id = 4104;
     tmpData->retry_count = 0;
     tmpData->error_code = 0;
-    tmpData->error_details = strdup("none");
+    tmpData->error_details = "none";
     tmpData->next = NULL;
     count++;
     webconfig_tmp_data_t *tmp = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmp, 0, sizeof(webconfig_tmp_data_t));
     tmp->name = strdup("privatessid");
     tmp->version = 1234;
-    tmp->status = strdup("pending");
+    tmp->status = TMP_STATUS_PENDING;
     tmp->trans_id = 4204;
     tmp->retry_count = 0;
     tmp->error_code = 0;
-    tmp->error_details = strdup("none");
+    tmp->error_details = "none";
     tmp->next = NULL;
     tmpData->next = tmp;
     count++;
     webconfig_tmp_data_t *tmp1 = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmp1, 0, sizeof(webconfig_tmp_data_t));
     tmp1->name = strdup("moca");
     tmp1->version = 5678;
-    tmp1->status = strdup("success");
+    tmp1->status = TMP_STATUS_SUCCESS;
     tmp1->trans_id = 4304;
     tmp1->retry_count = 0;
     tmp1->error_code = 0;
-    tmp1->error_details = strdup("none");
+    tmp1->error_details = "none";
     tmp1->next = NULL;
     tmp->next = tmp1;
     count++;
@@ -411,34 +441,37 @@ void test_release_success_docs_tmplist()
 {
     int count = 0;
     webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
     tmpData->name = strdup("root");
     tmpData->version = 232323;
-    tmpData->status = strdup("pending");
+    tmpData->status = TMP_STATUS_PENDING;
     tmpData->trans_id = 4104;
     tmpData->retry_count = 0;
     tmpData->error_code = 0;
-    tmpData->error_details = strdup("none");
+    tmpData->error_details = "none";
     tmpData->next = NULL;
     count++;
     webconfig_tmp_data_t *tmp = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmp, 0, sizeof(webconfig_tmp_data_t));
     tmp->name = strdup("privatessid");
     tmp->version = 1234;
-    tmp->status = strdup("success");
+    tmp->status = TMP_STATUS_SUCCESS;
     tmp->trans_id = 4204;
     tmp->retry_count = 0;
     tmp->error_code = 0;
-    tmp->error_details = strdup("none");
+    tmp->error_details = "none";
     tmp->next = NULL;
     tmpData->next = tmp;
     count++;
     webconfig_tmp_data_t *tmp1 = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmp1, 0, sizeof(webconfig_tmp_data_t));
     tmp1->name = strdup("moca");
     tmp1->version = 5678;
-    tmp1->status = strdup("success");
+    tmp1->status = TMP_STATUS_SUCCESS;
     tmp1->trans_id = 4304;
     tmp1->retry_count = 0;
     tmp1->error_code = 0;
-    tmp1->error_details = strdup("none");
+    tmp1->error_details = "none";
     tmp1->next = NULL;
     tmp->next = tmp1;
     count++;
@@ -565,34 +598,37 @@ void test_checkTmpRootUpdate()
 {
     int count = 0;
     webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
     tmpData->name = strdup("root");
     tmpData->version = 232323;
-    tmpData->status = strdup("failed");
+    tmpData->status = TMP_STATUS_FAILED;
     tmpData->trans_id = 4104;
     tmpData->retry_count = 0;
     tmpData->error_code = 0;
-    tmpData->error_details = strdup("invalid");
+    tmpData->error_details = "invalid";
     tmpData->next = NULL;
     count++;
     webconfig_tmp_data_t *tmp = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmp, 0, sizeof(webconfig_tmp_data_t));
     tmp->name = strdup("privatessid");
     tmp->version = 1234;
-    tmp->status = strdup("success");
+    tmp->status = TMP_STATUS_SUCCESS;
     tmp->trans_id = 4204;
     tmp->retry_count = 0;
     tmp->error_code = 0;
-    tmp->error_details = strdup("none");
+    tmp->error_details = "none";
     tmp->next = NULL;
     tmpData->next = tmp;
     count++;
     webconfig_tmp_data_t *tmp1 = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmp1, 0, sizeof(webconfig_tmp_data_t));
     tmp1->name = strdup("moca");
     tmp1->version = 5678;
-    tmp1->status = strdup("success");
+    tmp1->status = TMP_STATUS_SUCCESS;
     tmp1->trans_id = 4304;
     tmp1->retry_count = 0;
     tmp1->error_code = 0;
-    tmp1->error_details = strdup("none");
+    tmp1->error_details = "none";
     tmp1->next = NULL;
     tmp->next = tmp1;
     count++;
@@ -644,13 +680,14 @@ void test_updateFailureTimeStamp()
 {
     long long expiry_time = 0;
     webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
     tmpData->name = strdup("privatessid");
     tmpData->version = 1234;
-    tmpData->status = strdup("pending");
+    tmpData->status = TMP_STATUS_PENDING;
     tmpData->trans_id = 4204;
     tmpData->retry_count = 0;
     tmpData->error_code = 0;
-    tmpData->error_details = strdup("none");
+    tmpData->error_details = "none";
     tmpData->next = NULL;
     set_global_tmp_node(tmpData);
     expiry_time = getRetryExpiryTimeout();
@@ -665,6 +702,37 @@ void test_updateFailureTimeStamp()
     CU_ASSERT_FATAL( NULL == get_global_tmp_node());
 }
 
+void test_popDueRetryDoc()
+{
+    char *name = NULL;
+    long long deadline = 0;
+    webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
+    tmpData->name = strdup("wan");
+    tmpData->cloud_trans_id = strdup("abc123");
+    set_global_tmp_node(tmpData);
+    updateFailureTimeStamp(tmpData, "wan", 300);
+    updateFailureTimeStamp(tmpData, "wan", 100);
+    updateFailureTimeStamp(tmpData, "wan", 200);
+    //unchanged deadline is not queued twice
+    updateFailureTimeStamp(tmpData, "wan", 200);
+    CU_ASSERT_EQUAL(100, getNextRetryDeadline());
+    //nothing due before the earliest deadline
+    CU_ASSERT_EQUAL(0, popDueRetryDoc(99, &name, &deadline));
+    CU_ASSERT_EQUAL(1, popDueRetryDoc(250, &name, &deadline));
+    CU_ASSERT_STRING_EQUAL("wan", name);
+    CU_ASSERT_EQUAL(100, deadline);
+    WEBCFG_FREE(name);
+    CU_ASSERT_EQUAL(1, popDueRetryDoc(250, &name, &deadline));
+    CU_ASSERT_EQUAL(200, deadline);
+    WEBCFG_FREE(name);
+    CU_ASSERT_EQUAL(0, popDueRetryDoc(250, &name, &deadline));
+    CU_ASSERT_EQUAL(300, getNextRetryDeadline());
+    //deleting the tmp list empties the queue
+    delete_tmp_list();
+    CU_ASSERT_EQUAL(0, getNextRetryDeadline());
+}
+
 void test_writeToDBFile()
 {
     size_t webcfgdbPackSize = -1;
@@ -739,10 +807,11 @@ void test_webcfgdbblob_destroy()
     CU_ASSERT_PTR_NOT_NULL(webcfgdb);
     //temp data
     webcfgtemp=(webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(webcfgtemp, 0, sizeof(webconfig_tmp_data_t));
     webcfgtemp->name = strdup("wan");
     webcfgtemp->version = 410448631;
-    webcfgtemp->status = strdup("pending");
-    webcfgtemp->error_details = strdup("none");
+    webcfgtemp->status = TMP_STATUS_PENDING;
+    webcfgtemp->error_details = "none";
     webcfgtemp->error_code = 0;
     webcfgtemp->trans_id = 0;
     webcfgtemp->retry_count = 0;
@@ -776,8 +845,6 @@ void test_webcfgdbblob_destroy()
     {
         WEBCFG_FREE(webcfgtemp->name);
         webcfgtemp->version = 0;
-        WEBCFG_FREE(webcfgtemp->status);
-        WEBCFG_FREE(webcfgtemp->error_details);
         WEBCFG_FREE(webcfgtemp);
     }
     CU_ASSERT_PTR_NULL(webcfgtemp);
@@ -836,13 +903,14 @@ void test_get_DB_BLOB()
 
     //temp data
     webcfgtemp=(webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(webcfgtemp, 0, sizeof(webconfig_tmp_data_t));
     webcfgtemp->name = strdup("wan");
     webcfgtemp->version = 5678;
-    webcfgtemp->status = strdup("success");
+    webcfgtemp->status = TMP_STATUS_SUCCESS;
     webcfgtemp->trans_id = 4204;
     webcfgtemp->retry_count = 0;
     webcfgtemp->error_code = 0;
-    webcfgtemp->error_details = strdup("none");
+    webcfgtemp->error_details = "none";
     webcfgtemp->next=NULL;
     CU_ASSERT_PTR_NOT_NULL(webcfgtemp);
     set_global_tmp_node(webcfgtemp);
@@ -864,8 +932,6 @@ void test_get_DB_BLOB()
     {
         WEBCFG_FREE(webcfgtemp->name);
         webcfgtemp->version = 0;
-        WEBCFG_FREE(webcfgtemp->status);
-        WEBCFG_FREE(webcfgtemp->error_details);
         WEBCFG_FREE(webcfgtemp);
     }
     CU_ASSERT_PTR_NULL(webcfgtemp);
@@ -888,6 +954,361 @@ void test_get_DB_BLOB()
 
     CU_ASSERT_FATAL( NULL == get_DB_BLOB());
 }
+static void destroyTestDBList(void)
+{
+    webconfig_db_data_t *db_node = get_global_db_node();
+    webconfig_db_data_t *next = NULL;
+
+    reset_successDocCount();
+    reset_db_node();
+    while(db_node != NULL)
+    {
+        next = db_node->next;
+        if(db_node->root_string != NULL)
+        {
+            WEBCFG_FREE(db_node->root_string);
+        }
+        webcfgdb_destroy(db_node);
+        db_node = next;
+    }
+}
+
+void test_generateBlobCache()
+{
+    blob_t *blob = NULL;
+    blob_t *blob1 = NULL;
+    char *old_data = NULL;
+    size_t old_len = 0;
+    webconfig_db_data_t *wd = (webconfig_db_data_t *) malloc (sizeof(webconfig_db_data_t));
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(wd);
+    memset(wd, 0, sizeof(webconfig_db_data_t));
+    wd->name = strdup("wan");
+    wd->version = 410448631;
+    addToDBList(wd);
+
+    //cache hit, blob is not packed again while the lists are unchanged
+    blob = get_DB_BLOB();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(blob);
+    old_data = blob->data;
+    old_len = blob->len;
+    blob1 = get_DB_BLOB();
+    CU_ASSERT_PTR_EQUAL(blob, blob1);
+    CU_ASSERT_PTR_EQUAL(old_data, blob1->data);
+    CU_ASSERT_EQUAL(old_len, blob1->len);
+
+    //DB write invalidates the cached blob
+    old_data = (char *) malloc(old_len);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(old_data);
+    memcpy(old_data, blob->data, old_len);
+    CU_ASSERT_EQUAL(WEBCFG_SUCCESS, updateDBlist("wan", 1234, NULL));
+    blob = get_DB_BLOB();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(blob);
+    CU_ASSERT_TRUE((blob->len != old_len) || (memcmp(blob->data, old_data, old_len) != 0));
+    WEBCFG_FREE(old_data);
+
+    //new doc added to DB is packed on the next get
+    old_len = blob->len;
+    CU_ASSERT_EQUAL(WEBCFG_SUCCESS, checkDBList("moca", 5678, NULL));
+    blob = get_DB_BLOB();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(blob);
+    CU_ASSERT_TRUE(blob->len > old_len);
+
+    destroyTestDBList();
+    CU_ASSERT_PTR_NULL(get_DB_BLOB());
+}
+
+static void *initDBTestTask(void *path)
+{
+    initDB((char *) path);
+    return NULL;
+}
+
+//DB decode runs on its own thread at startup while Data gets may already come in
+void test_generateBlobParallelInit()
+{
+    char *path = "/tmp/webcfg_parallel_db.bin";
+    size_t dbPackSize = -1;
+    void *dbData = NULL;
+    pthread_t threadId;
+    blob_t *blob = NULL;
+    int i = 0;
+    webconfig_db_data_t wd1, wd2;
+
+    memset(&wd1, 0, sizeof(wd1));
+    memset(&wd2, 0, sizeof(wd2));
+    wd1.name = "wan";
+    wd1.version = 410448631;
+    wd1.next = &wd2;
+    wd2.name = "moca";
+    wd2.version = 5678;
+    dbPackSize = webcfgdb_pack(&wd1, &dbData, 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(dbData);
+    CU_ASSERT_EQUAL(1, writeToDBFile(path, (char *)dbData, dbPackSize));
+    WEBCFG_FREE(dbData);
+
+    CU_ASSERT_EQUAL_FATAL(0, pthread_create(&threadId, NULL, initDBTestTask, (void *) path));
+    for(i = 0; i < 100; i++)
+    {
+        get_DB_BLOB();
+    }
+    pthread_join(threadId, NULL);
+
+    //blob packed during the load is stale, the next get packs the loaded DB
+    CU_ASSERT_EQUAL(2, get_successDocCount());
+    blob = get_DB_BLOB();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(blob);
+    CU_ASSERT_PTR_EQUAL(blob, get_DB_BLOB());
+    webcfg_db_snapshot_t *snap = acquireDBSnapshot();
+    CU_ASSERT_FATAL(NULL != snap && NULL != snap->db_list && NULL != snap->db_list->next);
+    CU_ASSERT_STRING_EQUAL("wan", snap->db_list->name);
+    CU_ASSERT_STRING_EQUAL("moca", snap->db_list->next->name);
+    releaseDBSnapshot(snap);
+
+    destroyTestDBList();
+    remove(path);
+}
+
+void test_acquireDBSnapshot()
+{
+    webcfg_db_snapshot_t *snap = NULL;
+    webcfg_db_snapshot_t *snap1 = NULL;
+    webconfig_db_data_t *wd;
+    wd = (webconfig_db_data_t *) malloc (sizeof(webconfig_db_data_t));
+    CU_ASSERT_PTR_NOT_NULL(wd);
+    wd->name = strdup("wan");
+    wd->version = 410448631;
+    wd->root_string = NULL;
+    wd->next=NULL;
+    addToDBList(wd);
+
+    snap = acquireDBSnapshot();
+    CU_ASSERT_FATAL( NULL != snap);
+    CU_ASSERT_FATAL( NULL != snap->db_list);
+    CU_ASSERT_PTR_NOT_EQUAL(wd, snap->db_list);
+    CU_ASSERT_STRING_EQUAL("wan", snap->db_list->name);
+    CU_ASSERT_EQUAL(410448631, snap->db_list->version);
+    CU_ASSERT_PTR_NULL(snap->tmp_list);
+
+    //snapshot is reused until the lists change
+    snap1 = acquireDBSnapshot();
+    CU_ASSERT_PTR_EQUAL(snap, snap1);
+    releaseDBSnapshot(snap1);
+
+    //update is not visible in the snapshot already held by reader
+    CU_ASSERT_EQUAL(WEBCFG_SUCCESS, updateDBlist("wan", 1234, NULL));
+    snap1 = acquireDBSnapshot();
+    CU_ASSERT_FATAL( NULL != snap1);
+    CU_ASSERT_PTR_NOT_EQUAL(snap, snap1);
+    CU_ASSERT_EQUAL(410448631, snap->db_list->version);
+    CU_ASSERT_EQUAL(1234, snap1->db_list->version);
+    CU_ASSERT_EQUAL(2, snap1->refcount);
+    //snap is no longer published, the reader holds the last reference
+    CU_ASSERT_EQUAL(1, snap->refcount);
+    releaseDBSnapshot(snap1);
+    releaseDBSnapshot(snap);
+
+    //tmp nodes are copied field by field, cloud_trans_id included
+    webconfig_tmp_data_t *tmp = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(tmp);
+    memset(tmp, 0, sizeof(webconfig_tmp_data_t));
+    tmp->name = strdup("wan");
+    tmp->version = 1234;
+    tmp->status = TMP_STATUS_PENDING;
+    tmp->error_details = "none";
+    tmp->cloud_trans_id = strdup("cloud-1234");
+    set_global_tmp_node(tmp);
+    CU_ASSERT_EQUAL(1, incrementTmpRetryCount(tmp));
+    snap = acquireDBSnapshot();
+    CU_ASSERT_FATAL( NULL != snap && NULL != snap->tmp_list);
+    CU_ASSERT_PTR_NOT_EQUAL(tmp->cloud_trans_id, snap->tmp_list->cloud_trans_id);
+    CU_ASSERT_STRING_EQUAL("cloud-1234", snap->tmp_list->cloud_trans_id);
+    CU_ASSERT_EQUAL(1, snap->tmp_list->retry_count);
+    releaseDBSnapshot(snap);
+    delete_tmp_list();
+
+    webconfig_db_data_t *db_node = get_global_db_node();
+    reset_successDocCount();
+    reset_db_node();
+    webcfgdb_destroy(db_node);
+    snap = acquireDBSnapshot();
+    CU_ASSERT_FATAL( NULL != snap);
+    CU_ASSERT_PTR_NULL(snap->db_list);
+    releaseDBSnapshot(snap);
+}
+
+static void *snapshotReaderTask(void *arg)
+{
+    int i;
+    webcfg_db_snapshot_t *snap = NULL;
+    (void) arg;
+
+    for(i = 0; i < 10000; i++)
+    {
+        snap = acquireDBSnapshot();
+        //a published snapshot is never modified, the db list always has "wan"
+        if((snap->db_list == NULL) || (strcmp("wan", snap->db_list->name) != 0))
+        {
+            releaseDBSnapshot(snap);
+            return (void *) 1;
+        }
+        releaseDBSnapshot(snap);
+    }
+    return NULL;
+}
+
+//Readers only take references while the writer republishes on every update
+void test_acquireDBSnapshotConcurrent()
+{
+    pthread_t readers[4];
+    void *ret = NULL;
+    webcfg_db_snapshot_t *snap = NULL;
+    webconfig_db_data_t *wd;
+    uint32_t i;
+
+    wd = (webconfig_db_data_t *) malloc (sizeof(webconfig_db_data_t));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(wd);
+    wd->name = strdup("wan");
+    wd->version = 1;
+    wd->root_string = NULL;
+    wd->next = NULL;
+    addToDBList(wd);
+
+    for(i = 0; i < 4; i++)
+    {
+        CU_ASSERT_EQUAL_FATAL(0, pthread_create(&readers[i], NULL, snapshotReaderTask, NULL));
+    }
+    for(i = 2; i < 2000; i++)
+    {
+        updateDBlist("wan", i, NULL);
+    }
+    for(i = 0; i < 4; i++)
+    {
+        pthread_join(readers[i], &ret);
+        CU_ASSERT_PTR_NULL(ret);
+    }
+
+    //the last update is visible without another write, only the published reference is left
+    snap = acquireDBSnapshot();
+    CU_ASSERT_EQUAL(1999, snap->db_list->version);
+    CU_ASSERT_EQUAL(2, snap->refcount);
+    releaseDBSnapshot(snap);
+
+    webconfig_db_data_t *db_node = get_global_db_node();
+    reset_successDocCount();
+    reset_db_node();
+    webcfgdb_destroy(db_node);
+}
+
+void test_tmpStatusString()
+{
+    CU_ASSERT_EQUAL(TMP_STATUS_PENDING_APPLY, tmpStatusFromString("pending_apply"));
+    CU_ASSERT_EQUAL(TMP_STATUS_PENDING, tmpStatusFromString("pending"));
+    CU_ASSERT_EQUAL(TMP_STATUS_SUCCESS, tmpStatusFromString("success"));
+    CU_ASSERT_EQUAL(TMP_STATUS_FAILED, tmpStatusFromString("failed"));
+    CU_ASSERT_EQUAL(TMP_STATUS_NONE, tmpStatusFromString("invalid"));
+    CU_ASSERT_EQUAL(TMP_STATUS_NONE, tmpStatusFromString(NULL));
+    CU_ASSERT_STRING_EQUAL("pending_apply", tmpStatusToString(TMP_STATUS_PENDING_APPLY));
+    CU_ASSERT_STRING_EQUAL("failed", tmpStatusToString(TMP_STATUS_FAILED));
+}
+
+void test_internErrorDetails()
+{
+    char details[32] = {0};
+    const char *interned = NULL;
+
+    CU_ASSERT_PTR_NULL(internErrorDetails(NULL));
+    CU_ASSERT_PTR_EQUAL(internErrorDetails("none"), internErrorDetails("none"));
+
+    snprintf(details, sizeof(details), "%s", "NACK:wifi apply failed");
+    interned = internErrorDetails(details);
+    CU_ASSERT_PTR_NOT_EQUAL(details, interned);
+    CU_ASSERT_STRING_EQUAL("NACK:wifi apply failed", interned);
+    memset(details, 0, sizeof(details));
+    CU_ASSERT_STRING_EQUAL("NACK:wifi apply failed", interned);
+    CU_ASSERT_PTR_EQUAL(interned, internErrorDetails("NACK:wifi apply failed"));
+    //Two references taken, the string stays until both are dropped.
+    releaseErrorDetails(interned);
+    CU_ASSERT_STRING_EQUAL("NACK:wifi apply failed", interned);
+    releaseErrorDetails(interned);
+    releaseErrorDetails("none");
+    CU_ASSERT_STRING_EQUAL("none", internErrorDetails("none"));
+
+    //No cap, every distinct detail keeps its own text.
+    const char *many[300];
+    int i;
+    for(i = 0; i < 300; i++)
+    {
+        snprintf(details, sizeof(details), "NACK:doc %d", i);
+        many[i] = internErrorDetails(details);
+        CU_ASSERT_STRING_EQUAL(details, many[i]);
+    }
+    for(i = 0; i < 300; i++)
+    {
+        releaseErrorDetails(many[i]);
+    }
+}
+
+void test_blobCacheDoc()
+{
+    blob_cache_ref_t ref;
+    char path[128] = {0};
+    FILE *fp = NULL;
+
+    CU_ASSERT_EQUAL(WEBCFG_FAILURE, writeBlobCacheDoc("../moca", 1, "parameters", 10));
+    CU_ASSERT_EQUAL(WEBCFG_FAILURE, writeBlobCacheDoc("moca", 1, NULL, 0));
+
+    snprintf(path, sizeof(path), "%s/moca.blob", WEBCFG_BLOB_CACHE_DIR);
+    reset_db_node();
+    CU_ASSERT_EQUAL(WEBCFG_SUCCESS, writeBlobCacheDoc("moca", 1001, "parameters-v1", 13));
+    //DB not loaded yet at boot, the entry is not served but kept.
+    set_global_db_loaded(0);
+    CU_ASSERT_EQUAL(WEBCFG_FAILURE, fetchBlobCacheDoc("moca", &ref));
+    CU_ASSERT_EQUAL(0, access(path, F_OK));
+    //Not committed to the DB, not served and kept.
+    set_global_db_loaded(1);
+    CU_ASSERT_EQUAL(WEBCFG_FAILURE, fetchBlobCacheDoc("moca", &ref));
+    CU_ASSERT_EQUAL(0, access(path, F_OK));
+
+    CU_ASSERT_EQUAL(WEBCFG_SUCCESS, checkDBList("moca", 1002, NULL));
+    CU_ASSERT_EQUAL(WEBCFG_SUCCESS, writeBlobCacheDoc("moca", 1001, "parameters-v1", 13));
+    //Older etag than the DB, not served and removed.
+    CU_ASSERT_EQUAL(WEBCFG_FAILURE, fetchBlobCacheDoc("moca", &ref));
+    CU_ASSERT_EQUAL(-1, access(path, F_OK));
+    CU_ASSERT_EQUAL(WEBCFG_SUCCESS, writeBlobCacheDoc("moca", 1002, "parameters-v2!", 14));
+    CU_ASSERT_EQUAL(WEBCFG_SUCCESS, fetchBlobCacheDoc("moca", &ref));
+    CU_ASSERT_EQUAL(1002, ref.etag);
+    CU_ASSERT_EQUAL(14, ref.data_size);
+    CU_ASSERT_EQUAL(0, memcmp(ref.data, "parameters-v2!", 14));
+    releaseBlobCacheDoc(&ref);
+    CU_ASSERT_PTR_NULL(ref.map);
+
+    //A corrupted entry is reported as a miss and removed.
+    fp = fopen(path, "r+b");
+    CU_ASSERT_PTR_NOT_NULL(fp);
+    if(fp != NULL)
+    {
+        fseek(fp, -1, SEEK_END);
+        fputc('?', fp);
+        fclose(fp);
+    }
+    CU_ASSERT_EQUAL(WEBCFG_FAILURE, fetchBlobCacheDoc("moca", &ref));
+    CU_ASSERT_EQUAL(-1, access(path, F_OK));
+
+    CU_ASSERT_EQUAL(WEBCFG_FAILURE, fetchBlobCacheDoc("wan", &ref));
+    CU_ASSERT_EQUAL(WEBCFG_SUCCESS, deleteBlobCacheDoc("moca"));
+
+    //Without a DB file every cached entry is dropped.
+    CU_ASSERT_EQUAL(WEBCFG_SUCCESS, writeBlobCacheDoc("moca", 1002, "parameters-v2!", 14));
+    CU_ASSERT_EQUAL(0, access(path, F_OK));
+    CU_ASSERT_EQUAL(WEBCFG_FAILURE, initDB("/tmp/webcfg_no_such_db.bin"));
+    CU_ASSERT_EQUAL(-1, access(path, F_OK));
+
+    webconfig_db_data_t *db_node = get_global_db_node();
+    reset_db_node();
+    webcfgdb_destroy(db_node);
+}
+
 void add_suites( CU_pSuite *suite )
 {
     *suite = CU_add_suite( "tests", NULL, NULL );
@@ -911,12 +1332,20 @@ void add_suites( CU_pSuite *suite )
     CU_add_test( *suite, "test get_doc_fail", test_get_doc_fail);
     CU_add_test( *suite, "test webcfgdbparam_strerror", test_webcfgdbparam_strerror);
     CU_add_test( *suite, "test updateFailureTimeStamp", test_updateFailureTimeStamp); 
+    CU_add_test( *suite, "test popDueRetryDoc", test_popDueRetryDoc);
     CU_add_test( *suite, "test writeToDBFile", test_writeToDBFile);
     CU_add_test( *suite, "test webcfgdb_destroy", test_webcfgdb_destroy);
     CU_add_test( *suite, "test webcfgdbblob_destroy", test_webcfgdbblob_destroy);
     CU_add_test( *suite, "test webcfgdbblob_strerror", test_webcfgdbblob_strerror);
     CU_add_test( *suite, "test writebase64ToDBFile", test_writebase64ToDBFile);
     CU_add_test( *suite, "test get_DB_BLOB", test_get_DB_BLOB);
+    CU_add_test( *suite, "test generateBlobCache", test_generateBlobCache);
+    CU_add_test( *suite, "test generateBlobParallelInit", test_generateBlobParallelInit);
+    CU_add_test( *suite, "test acquireDBSnapshot", test_acquireDBSnapshot);
+    CU_add_test( *suite, "test acquireDBSnapshotConcurrent", test_acquireDBSnapshotConcurrent);
+    CU_add_test( *suite, "test tmpStatusString", test_tmpStatusString);
+    CU_add_test( *suite, "test internErrorDetails", test_internErrorDetails);
+    CU_add_test( *suite, "test blobCacheDoc", test_blobCacheDoc);
 }
 
 /*----------------------------------------------------------------------------*/
@@ -75,13 +75,14 @@ void test_get_global_event_threadid()
 void test_getDocVersionFromTmpList()
 {
     webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
     tmpData->name = strdup("moca");
     tmpData->version = 1234;
-    tmpData->status = strdup("success");
+    tmpData->status = TMP_STATUS_SUCCESS;
     tmpData->trans_id = 4104;
     tmpData->retry_count = 0;
     tmpData->error_code = 0;
-    tmpData->error_details = strdup("none");
+    tmpData->error_details = "none";
     tmpData->next = NULL;
     CU_ASSERT_PTR_NOT_NULL(tmpData);
     CU_ASSERT_EQUAL(getDocVersionFromTmpList(tmpData,"moca"),1234);
@@ -90,9 +91,7 @@ void test_getDocVersionFromTmpList()
     {
         WEBCFG_FREE(tmpData->name);
         tmpData->version = 0;
-        WEBCFG_FREE(tmpData->status);
         tmpData->trans_id = 0;
-        WEBCFG_FREE(tmpData->error_details);
         WEBCFG_FREE(tmpData);
     }
     CU_ASSERT_PTR_NULL(tmpData);
@@ -389,16 +388,43 @@ void test_checkTimerExpired()
     CU_ASSERT_FATAL( NULL == get_global_timer_node());
 }
 
+void test_checkTimerExpired_deadline()
+{
+    char *expired_doc= NULL;
+
+    CU_ASSERT_FATAL( NULL == get_global_timer_node());
+    //timer armed with future deadline is not expired
+    int m = startWebcfgTimer(NULL,"moca",1234,60);
+    CU_ASSERT_EQUAL(0,m);
+    CU_ASSERT_EQUAL(0,checkTimerExpired(&expired_doc));
+    CU_ASSERT_PTR_NULL(expired_doc);
+
+    //re-arm with zero timeout, deadline is now
+    int n = updateTimerList(getTimerNode("moca"),true,"moca",5678,0);
+    CU_ASSERT_EQUAL(0,n);
+    CU_ASSERT_EQUAL(1,checkTimerExpired(&expired_doc));
+    CU_ASSERT_STRING_EQUAL("moca",expired_doc);
+    WEBCFG_FREE(expired_doc);
+
+    //stopped timer never expires
+    updateTimerList(getTimerNode("moca"),false,"moca",5678,0);
+    CU_ASSERT_EQUAL(0,checkTimerExpired(&expired_doc));
+
+    CU_ASSERT_EQUAL(0,deleteFromTimerList("moca"));
+    CU_ASSERT_FATAL( NULL == get_global_timer_node());
+}
+
 void test_validateEvent()
 {
     webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
     tmpData->name = strdup("moca");
     tmpData->version = 1234;
-    tmpData->status = strdup("success");
+    tmpData->status = TMP_STATUS_SUCCESS;
     tmpData->trans_id = 4104;
     tmpData->retry_count = 0;
     tmpData->error_code = 0;
-    tmpData->error_details = strdup("none");
+    tmpData->error_details = "none";
     tmpData->next = NULL;
     CU_ASSERT_PTR_NOT_NULL(tmpData);
 
@@ -409,9 +435,7 @@ void test_validateEvent()
     {
         WEBCFG_FREE(tmpData->name);
         tmpData->version = 0;
-        WEBCFG_FREE(tmpData->status);
         tmpData->trans_id = 0;
-        WEBCFG_FREE(tmpData->error_details);
         WEBCFG_FREE(tmpData);
     }
     CU_ASSERT_PTR_NULL(tmpData);
@@ -436,6 +460,229 @@ void test_parseEventData()
     CU_ASSERT_EQUAL(1,n);
     free_event_params_struct(eventParam);
 }
+void test_parseEventString()
+{
+    webcfg_event_t event;
+    char reason[600];
+    char data[700];
+
+    CU_ASSERT_EQUAL(0,parseEventString("telemetry,14464,410448631,NACK,0,pam,192,failed",&event));
+    CU_ASSERT_STRING_EQUAL(event.subdoc_name,"telemetry");
+    CU_ASSERT_EQUAL(14464,event.trans_id);
+    CU_ASSERT_EQUAL(410448631,event.version);
+    CU_ASSERT_STRING_EQUAL(event.status,"NACK");
+    CU_ASSERT_EQUAL(0,event.timeout);
+    CU_ASSERT_STRING_EQUAL(event.process_name,"pam");
+    CU_ASSERT_EQUAL(192,event.err_code);
+    CU_ASSERT_STRING_EQUAL(event.failure_reason,"failed");
+    clearWebcfgEvent(&event);
+    CU_ASSERT_PTR_NULL(event.failure_reason);
+
+    //free-form reason is kept whole
+    memset(reason, 'x', sizeof(reason) - 1);
+    reason[sizeof(reason) - 1] = '\0';
+    snprintf(data, sizeof(data), "telemetry,14464,410448631,NACK,0,pam,192,%s", reason);
+    CU_ASSERT_EQUAL(0,parseEventString(data,&event));
+    CU_ASSERT_STRING_EQUAL(event.failure_reason,reason);
+    clearWebcfgEvent(&event);
+
+    //no subdoc name, nothing to apply the event to
+    CU_ASSERT_EQUAL(1,parseEventString(",14464,410448631,ACK,0",&event));
+
+    CU_ASSERT_EQUAL(0,parseEventString("moca,4104,1234,ACK,60",&event));
+    CU_ASSERT_EQUAL(60,event.timeout);
+    CU_ASSERT_STRING_EQUAL(event.process_name,"");
+    CU_ASSERT_EQUAL(1,parseEventString(NULL,&event));
+
+    setWebcfgEvent(&event,"wan",10,20,"EXPIRE",0);
+    CU_ASSERT_STRING_EQUAL(event.subdoc_name,"wan");
+    CU_ASSERT_STRING_EQUAL(event.status,"EXPIRE");
+    CU_ASSERT_EQUAL(20,event.version);
+}
+
+extern notify_params_t *notifyMsgQ;
+void test_webcfgCallback_parseFailure()
+{
+    char info[] = ",14464,410448631,ACK,0";
+    notify_params_t *msg = NULL;
+    unsigned long hwm = get_global_event_queue_hwm();
+
+    //unparsable event is not queued, cloud gets a parse failure report instead
+    webcfgCallback(info, NULL);
+    CU_ASSERT_EQUAL(hwm,get_global_event_queue_hwm());
+    CU_ASSERT_PTR_NOT_NULL_FATAL(notifyMsgQ);
+    for(msg = notifyMsgQ; msg->next != NULL; msg = msg->next);
+    CU_ASSERT_STRING_EQUAL(msg->application_status,"failed");
+    CU_ASSERT_STRING_EQUAL(msg->error_details,"component_event_parse_failure");
+    CU_ASSERT_EQUAL(511,msg->error_code);
+}
+
+void* processSubdocEvents();
+
+//Queue one component event and run the consumer for exactly that event.
+static void processOneEvent(const char *info)
+{
+    char buf[128];
+
+    snprintf(buf, sizeof(buf), "%s", info);
+    webcfgCallback(buf, NULL);
+    numLoops = 1;
+    processSubdocEvents();
+}
+
+static int getNotifyQueueLen()
+{
+    notify_params_t *msg = NULL;
+    int len = 0;
+
+    for(msg = notifyMsgQ; msg != NULL; msg = msg->next)
+    {
+        len++;
+    }
+    return len;
+}
+
+static webconfig_tmp_data_t *createTestTmpNode(const char *name, uint32_t version, uint16_t trans_id)
+{
+    webconfig_tmp_data_t *tmpData = (webconfig_tmp_data_t *)malloc(sizeof(webconfig_tmp_data_t));
+    memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
+
+    memset(tmpData, 0, sizeof(webconfig_tmp_data_t));
+    tmpData->name = strdup(name);
+    tmpData->version = version;
+    tmpData->status = TMP_STATUS_PENDING;
+    tmpData->trans_id = trans_id;
+    tmpData->error_details = "none";
+    tmpData->isSupplementarySync = 1;
+    tmpData->cloud_trans_id = strdup("abcdef");
+    return tmpData;
+}
+
+void test_subdocStateApplied()
+{
+    resetSubdocStates();
+    set_global_tmp_node(createTestTmpNode("lan", 100, 1));
+    CU_ASSERT_EQUAL(SUBDOC_STATE_PENDING_APPLY,getSubdocState("lan"));
+
+    processOneEvent("lan,1,100,ACK,60");
+    CU_ASSERT_EQUAL(SUBDOC_STATE_PENDING,getSubdocState("lan"));
+    processOneEvent("lan,1,100,ACK,0");
+    CU_ASSERT_EQUAL(SUBDOC_STATE_APPLIED,getSubdocState("lan"));
+
+    //expiry of the stopped timer is stale, the applied doc is not retried
+    processOneEvent("lan,1,0,EXPIRE,0");
+    CU_ASSERT_EQUAL(SUBDOC_STATE_APPLIED,getSubdocState("lan"));
+    set_global_tmp_node(NULL);
+}
+
+void test_subdocStateFailed()
+{
+    webconfig_tmp_data_t *tmpData = createTestTmpNode("wan", 200, 2);
+    int len = 0;
+
+    resetSubdocStates();
+    set_global_tmp_node(tmpData);
+    processOneEvent("wan,2,200,NACK,0,pam,192,failed");
+    CU_ASSERT_EQUAL(SUBDOC_STATE_FAILED,getSubdocState("wan"));
+
+    //the NACKed version is not re-applied, the handlers do not run
+    len = getNotifyQueueLen();
+    processOneEvent("wan,2,0,EXPIRE,0");
+    processOneEvent("wan,0,200,COMP_INIT,0");
+    processOneEvent("wan,0,200");
+    CU_ASSERT_EQUAL(SUBDOC_STATE_FAILED,getSubdocState("wan"));
+    CU_ASSERT_EQUAL(len,getNotifyQueueLen());
+
+    //a newer version in the tmp list gets through, its expiry is reported as pending
+    updateTmpList(tmpData, "wan", 201, "pending", tmpData->error_details, 192, 3, 0);
+    processOneEvent("wan,3,0,EXPIRE,0");
+    CU_ASSERT_EQUAL(len + 1,getNotifyQueueLen());
+    CU_ASSERT_EQUAL(SUBDOC_STATE_FAILED,getSubdocState("wan"));
+    set_global_tmp_node(NULL);
+
+    resetSubdocStates();
+    CU_ASSERT_EQUAL(SUBDOC_STATE_PENDING_APPLY,getSubdocState("wan"));
+}
+
+//a doc that failed on retry, not on a component NACK, is re-applied after a restart
+void test_subdocStateRetryFailed()
+{
+    int len = 0;
+
+    resetSubdocStates();
+    set_global_tmp_node(createTestTmpNode("voice", 300, 4));
+    processOneEvent("voice,4,0,EXPIRE,0");
+    CU_ASSERT_EQUAL(SUBDOC_STATE_FAILED,getSubdocState("voice"));
+
+    //COMP_INIT reaches the handler, which retries the tmp version and reports the outcome
+    len = getNotifyQueueLen();
+    processOneEvent("voice,0,299,COMP_INIT,0");
+    CU_ASSERT_TRUE(getNotifyQueueLen() > len);
+    len = getNotifyQueueLen();
+    processOneEvent("voice,0,299");
+    CU_ASSERT_TRUE(getNotifyQueueLen() > len);
+    set_global_tmp_node(NULL);
+    resetSubdocStates();
+}
+
+//a repeated ACK is dropped before its handler runs
+void test_subdocDuplicateACK()
+{
+    unsigned long suppressed = 0;
+
+    resetSubdocStates();
+    set_global_tmp_node(createTestTmpNode("advsecurity", 410448631, 14464));
+    suppressed = get_global_event_suppressed();
+    processOneEvent("advsecurity,14464,410448631,ACK;disabled,0");
+    CU_ASSERT_EQUAL(suppressed,get_global_event_suppressed());
+    processOneEvent("advsecurity,14464,410448631,ACK;disabled,0");
+    CU_ASSERT_EQUAL(suppressed + 1,get_global_event_suppressed());
+    set_global_tmp_node(NULL);
+}
+
+void test_getEventType()
+{
+    CU_ASSERT_EQUAL(EVENT_TYPE_ACK,getEventType("ACK",0));
+    CU_ASSERT_EQUAL(EVENT_TYPE_ACK,getEventType("ACK;disabled",0));
+    CU_ASSERT_EQUAL(EVENT_TYPE_TIMEOUT,getEventType("ACK",60));
+    CU_ASSERT_EQUAL(EVENT_TYPE_NACK,getEventType("NACK",0));
+    CU_ASSERT_EQUAL(EVENT_TYPE_EXPIRE,getEventType("EXPIRE",0));
+    CU_ASSERT_EQUAL(EVENT_TYPE_COMP_INIT,getEventType("COMP_INIT",0));
+    CU_ASSERT_EQUAL(EVENT_TYPE_CRASH,getEventType("",0));
+    CU_ASSERT_EQUAL(SUBDOC_STATE_PENDING_APPLY,getSubdocState("unknown_doc"));
+    CU_ASSERT_STRING_EQUAL("retrying",subdocStateToString(SUBDOC_STATE_RETRYING));
+}
+
+void test_addToEventQueue_overflow()
+{
+    int i = 0;
+    char data[64] = {0};
+
+    CU_ASSERT_EQUAL(0,get_global_event_queue_dropped());
+    for(i = 0; i < WEBCFG_EVENT_QUEUE_SIZE; i++)
+    {
+        snprintf(data,sizeof(data),"moca,%d,1234,ACK,0",i);
+        CU_ASSERT_EQUAL(0,addToEventQueue(strdup(data)));
+    }
+    CU_ASSERT_EQUAL(WEBCFG_EVENT_QUEUE_SIZE,get_global_event_queue_hwm());
+
+    //queue full, a restart notice is dropped and freed
+    CU_ASSERT_EQUAL(1,addToEventQueue(strdup("wan,0,1234,COMP_INIT,0")));
+    CU_ASSERT_EQUAL(1,get_global_event_queue_dropped());
+
+    //apply outcomes are kept in the overflow list, later events queue behind them
+    CU_ASSERT_EQUAL(0,addToEventQueue(strdup("wan,1,1234,NACK,0,pam,192,failed")));
+    CU_ASSERT_EQUAL(0,addToEventQueue(strdup("wan,0,1234,COMP_INIT,0")));
+    CU_ASSERT_EQUAL(1,get_global_event_queue_dropped());
+
+    //leave an empty queue for the following tests
+    CU_ASSERT_EQUAL(WEBCFG_EVENT_QUEUE_SIZE + 2,resetEventQueue());
+    CU_ASSERT_EQUAL(0,get_global_event_queue_dropped());
+    CU_ASSERT_EQUAL(0,get_global_event_queue_hwm());
+    CU_ASSERT_EQUAL(0,addToEventQueue(strdup("moca,1,1234,ACK,0")));
+    CU_ASSERT_EQUAL(1,resetEventQueue());
+}
+
 void add_suites( CU_pSuite *suite )
 {
     *suite = CU_add_suite( "tests", NULL, NULL );
@@ -453,8 +700,17 @@ void add_suites( CU_pSuite *suite )
     CU_add_test( *suite, "test getTimerNode",test_getTimerNode);
     CU_add_test( *suite, "test startWebcfgTimer",test_startWebcfgTimer);
     CU_add_test( *suite, "test checkTimerExpired",test_checkTimerExpired);
+    CU_add_test( *suite, "test checkTimerExpired_deadline",test_checkTimerExpired_deadline);
     CU_add_test( *suite, "test validateEvent",test_validateEvent);
     CU_add_test( *suite, "test parseEventData",test_parseEventData);
+    CU_add_test( *suite, "test parseEventString",test_parseEventString);
+    CU_add_test( *suite, "test webcfgCallback_parseFailure",test_webcfgCallback_parseFailure);
+    CU_add_test( *suite, "test getEventType",test_getEventType);
+    CU_add_test( *suite, "test subdocStateApplied",test_subdocStateApplied);
+    CU_add_test( *suite, "test subdocStateFailed",test_subdocStateFailed);
+    CU_add_test( *suite, "test subdocStateRetryFailed",test_subdocStateRetryFailed);
+    CU_add_test( *suite, "test subdocDuplicateACK",test_subdocDuplicateACK);
+    CU_add_test( *suite, "test addToEventQueue_overflow",test_addToEventQueue_overflow);
 }
 
 /*----------------------------------------------------------------------------*/